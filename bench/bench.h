@@ -0,0 +1,22 @@
+#ifndef BENCH_H_Q2TZ7WKD
+#define BENCH_H_Q2TZ7WKD
+
+#include "trb-types.h"
+
+#include <stdio.h>
+#include <time.h>
+
+/* Returns monotonic time in seconds */
+static inline f64 bench_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (f64) ts.tv_sec + (f64) ts.tv_nsec * 1e-9;
+}
+
+/* Prevents the compiler from optimizing away the computation of the value */
+#define bench_keep(value) __asm__ volatile("" : : "g"(value) : "memory")
+
+#define bench_header(title) printf("\n== %s ==\n", (title))
+
+#endif /* end of include guard: BENCH_H_Q2TZ7WKD */
@@ -0,0 +1,101 @@
+#include "bench.h"
+#include "trb-extsort.h"
+#include "trb-rand.h"
+
+#include <stdlib.h>
+
+#define DATA_SIZE (256 << 20)
+#define COPY_BLOCK (1 << 20)
+
+typedef struct {
+	u64 key;
+	u64 payload;
+} Record;
+
+static i32 record_cmp(const Record *a, const Record *b)
+{
+	return (a->key > b->key) - (a->key < b->key);
+}
+
+static FILE *make_input(usize len)
+{
+	FILE *file = tmpfile();
+	Record *block = malloc(COPY_BLOCK);
+	usize block_len = COPY_BLOCK / sizeof(Record);
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0x2545f4914f6cdd1d);
+
+	for (usize i = 0; i < len; i += block_len) {
+		for (usize j = 0; j < block_len; ++j) {
+			block[j].key = trb_pcg64_next_u64(&rng);
+			block[j].payload = i + j;
+		}
+
+		fwrite(block, sizeof(Record), block_len, file);
+	}
+
+	fflush(file);
+	free(block);
+
+	return file;
+}
+
+/* Sequential read and write of the same amount of data, the lower bound for one pass */
+static f64 bench_copy(FILE *input)
+{
+	FILE *output = tmpfile();
+	char *block = malloc(COPY_BLOCK);
+
+	rewind(input);
+	f64 start = bench_now();
+
+	usize n;
+	while ((n = fread(block, 1, COPY_BLOCK, input)) != 0)
+		fwrite(block, 1, n, output);
+
+	fflush(output);
+	f64 elapsed = bench_now() - start;
+
+	free(block);
+	fclose(output);
+
+	return elapsed;
+}
+
+static void bench_extsort(void)
+{
+	bench_header("external sort of 16-byte records, MB/s");
+	printf("%12s %12s %12s\n", "data MB", "memory MB", "MB/s");
+
+	usize len = DATA_SIZE / sizeof(Record);
+	FILE *input = make_input(len);
+
+	printf("%12d %12s %12.1f\n", DATA_SIZE >> 20, "copy", DATA_SIZE / (1 << 20) / bench_copy(input));
+
+	const usize memories[] = { 4 << 20, 16 << 20, 64 << 20, DATA_SIZE + 1 };
+
+	for (usize m = 0; m < sizeof(memories) / sizeof(memories[0]); ++m) {
+		FILE *output = tmpfile();
+		rewind(input);
+
+		TrbExtSort sort;
+		trb_extsort_init(&sort, sizeof(Record), memories[m], (TrbCmpFunc) record_cmp);
+
+		f64 start = bench_now();
+		trb_extsort_sort_file(&sort, input, output);
+		f64 elapsed = bench_now() - start;
+
+		printf("%12d %12zu %12.1f\n", DATA_SIZE >> 20, memories[m] >> 20, DATA_SIZE / (1 << 20) / elapsed);
+
+		fclose(output);
+	}
+
+	fclose(input);
+}
+
+int main(void)
+{
+	bench_extsort();
+	return 0;
+}
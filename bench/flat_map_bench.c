@@ -0,0 +1,146 @@
+#include "bench.h"
+#include "trb-flat-map.h"
+#include "trb-hash-table.h"
+#include "trb-hash.h"
+#include "trb-rand.h"
+#include "trb-utils.h"
+
+#include <stdlib.h>
+
+#define N_QUERIES 1000000
+
+static void fill_keys(u64 *keys, usize n, u64 seed)
+{
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, seed);
+
+	for (usize i = 0; i < n; ++i)
+		keys[i] = trb_pcg64_next_u64(&rng);
+}
+
+static void bench_insert(usize n, const u64 *keys)
+{
+	TrbFlatMap map;
+	TrbHashTable ht;
+
+	f64 start = bench_now();
+	trb_flat_map_init(&map, sizeof(u64), sizeof(u64), (TrbCmpFunc) trb_u64cmp);
+
+	for (usize i = 0; i < n; ++i)
+		trb_flat_map_insert(&map, &keys[i], &keys[i]);
+
+	f64 one_by_one = bench_now() - start;
+	trb_flat_map_destroy(&map, NULL, NULL);
+
+	/* Ten batches, so that every batch after the first one is merged */
+	start = bench_now();
+	trb_flat_map_init(&map, sizeof(u64), sizeof(u64), (TrbCmpFunc) trb_u64cmp);
+
+	for (usize i = 0; i < 10; ++i)
+		trb_flat_map_insert_many(&map, &keys[i * n / 10], &keys[i * n / 10], (i + 1) * n / 10 - i * n / 10);
+
+	f64 batches = bench_now() - start;
+	trb_flat_map_destroy(&map, NULL, NULL);
+
+	start = bench_now();
+	trb_flat_map_init(&map, sizeof(u64), sizeof(u64), (TrbCmpFunc) trb_u64cmp);
+	trb_flat_map_build_from_unsorted(&map, keys, keys, n);
+	f64 build = bench_now() - start;
+	trb_flat_map_destroy(&map, NULL, NULL);
+
+	start = bench_now();
+	trb_hash_table_init(&ht, sizeof(u64), sizeof(u64), 0x9e3779b9, trb_murmurhash3, (TrbCmpFunc) trb_u64cmp);
+
+	for (usize i = 0; i < n; ++i)
+		trb_hash_table_insert(&ht, &keys[i], &keys[i]);
+
+	f64 hash = bench_now() - start;
+	trb_hash_table_destroy(&ht, NULL, NULL);
+
+	printf(
+		"%10zu %14.1f %14.1f %14.1f %14.1f\n", n, one_by_one * 1e9 / n,
+		batches * 1e9 / n, build * 1e9 / n, hash * 1e9 / n
+	);
+}
+
+static void bench_lookup(usize n, const u64 *keys, const usize *queries)
+{
+	TrbFlatMap map;
+	trb_flat_map_init(&map, sizeof(u64), sizeof(u64), (TrbCmpFunc) trb_u64cmp);
+	trb_flat_map_build_from_unsorted(&map, keys, keys, n);
+
+	TrbHashTable ht;
+	trb_hash_table_init(&ht, sizeof(u64), sizeof(u64), 0x9e3779b9, trb_murmurhash3, (TrbCmpFunc) trb_u64cmp);
+
+	for (usize i = 0; i < n; ++i)
+		trb_hash_table_insert(&ht, &keys[i], &keys[i]);
+
+	u64 sum = 0, value;
+
+	f64 start = bench_now();
+	for (usize i = 0; i < N_QUERIES; ++i) {
+		trb_flat_map_lookup(&map, &keys[queries[i] % n], &value);
+		sum += value;
+	}
+	f64 flat = bench_now() - start;
+
+	start = bench_now();
+	for (usize i = 0; i < N_QUERIES; ++i) {
+		trb_hash_table_lookup(&ht, &keys[queries[i] % n], &value);
+		sum += value;
+	}
+	f64 hash = bench_now() - start;
+
+	/* An in-order scan of all the values */
+	start = bench_now();
+	for (usize r = 0; r < N_QUERIES / n + 1; ++r) {
+		for (usize i = 0; i < map.len; ++i)
+			sum += *(u64 *) trb_flat_map_value(&map, i);
+	}
+	f64 scan = (bench_now() - start) / (N_QUERIES / n + 1);
+
+	bench_keep(sum);
+
+	printf(
+		"%10zu %14.1f %14.1f %14.2f %14.1f %14.1f\n", n, flat * 1e9 / N_QUERIES, hash * 1e9 / N_QUERIES,
+		scan * 1e9 / n, (f64) map.len * map.entrysize / n, (f64) ht.slots * ht.bucketsize / n
+	);
+
+	trb_flat_map_destroy(&map, NULL, NULL);
+	trb_hash_table_destroy(&ht, NULL, NULL);
+}
+
+int main(void)
+{
+	usize max_n = 1 << 20;
+	u64 *keys = malloc(max_n * sizeof(u64));
+	usize *queries = malloc(N_QUERIES * sizeof(usize));
+
+	fill_keys(keys, max_n, 49);
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 4949);
+
+	for (usize i = 0; i < N_QUERIES; ++i)
+		queries[i] = trb_pcg64_next_u32(&rng);
+
+	bench_header("u64 -> u64 inserts, ns per entry");
+	printf("%10s %14s %14s %14s %14s\n", "n", "insert", "insert_many", "build", "hash table");
+
+	for (usize n = 1 << 10; n <= max_n; n <<= 2) {
+		/* One-by-one insertion is quadratic */
+		if (n <= 1 << 16)
+			bench_insert(n, keys);
+	}
+
+	bench_header("u64 -> u64 lookups, ns per lookup; scan, ns per entry; memory, bytes per entry");
+	printf("%10s %14s %14s %14s %14s %14s\n", "n", "flat map", "hash table", "flat scan", "flat bytes", "hash bytes");
+
+	for (usize n = 1 << 10; n <= max_n; n <<= 2)
+		bench_lookup(n, keys, queries);
+
+	free(keys);
+	free(queries);
+
+	return 0;
+}
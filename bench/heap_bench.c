@@ -0,0 +1,173 @@
+#include "bench.h"
+#include "trb-heap.h"
+#include "trb-indexed-heap.h"
+#include "trb-rand.h"
+#include "trb-slice.h"
+#include "trb-utils.h"
+
+#include <stdlib.h>
+
+#define N_OPS 100000
+#define N_SLOW_OPS 200
+
+/* What trb_heap_insert did before: append and heapify the whole array */
+static void heapify_insert(TrbHeap *heap, const u64 *value)
+{
+	trb_vector_push_back(&heap->vector, value);
+	trb_heap_fix(heap);
+}
+
+static void heapify_pop(TrbHeap *heap)
+{
+	usize last = heap->vector.len - 1;
+	trb_memswap(trb_heap_ptr(heap, u64, 0), trb_heap_ptr(heap, u64, last), sizeof(u64));
+	trb_vector_pop_back(&heap->vector, NULL);
+	trb_heap_fix(heap);
+}
+
+static void bench_heap(void)
+{
+	bench_header("u64 heap, ns/op after n elements");
+	printf("%10s %12s %12s %12s %12s %12s\n", "n", "heapify ins", "heapify pop", "insert", "pop", "replace_top");
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0x853c49e6748fea9b);
+
+	for (usize n = 1 << 10; n <= 1 << 20; n <<= 2) {
+		u64 *values = malloc(n * sizeof(u64));
+
+		for (usize i = 0; i < n; ++i)
+			values[i] = trb_pcg64_next_u64(&rng);
+
+		TrbHeap heap;
+		trb_heap_init(&heap, sizeof(u64), (TrbCmpFunc) trb_u64cmp);
+		trb_heap_push_many(&heap, values, n);
+
+		f64 start = bench_now();
+		for (usize i = 0; i < N_SLOW_OPS; ++i)
+			heapify_insert(&heap, &values[i % n]);
+		f64 old_insert = bench_now() - start;
+
+		start = bench_now();
+		for (usize i = 0; i < N_SLOW_OPS; ++i)
+			heapify_pop(&heap);
+		f64 old_pop = bench_now() - start;
+
+		start = bench_now();
+		for (usize i = 0; i < N_OPS; ++i)
+			trb_heap_insert(&heap, &values[i % n]);
+		f64 insert = bench_now() - start;
+
+		start = bench_now();
+		for (usize i = 0; i < N_OPS; ++i)
+			trb_heap_pop_front(&heap, NULL);
+		f64 pop = bench_now() - start;
+
+		start = bench_now();
+		for (usize i = 0; i < N_OPS; ++i)
+			trb_heap_replace_top(&heap, &values[i % n], NULL);
+		f64 replace = bench_now() - start;
+
+		printf("%10zu %12.1f %12.1f %12.1f %12.1f %12.1f\n", n,
+			old_insert * 1e9 / N_SLOW_OPS, old_pop * 1e9 / N_SLOW_OPS,
+			insert * 1e9 / N_OPS, pop * 1e9 / N_OPS, replace * 1e9 / N_OPS);
+
+		trb_heap_destroy(&heap, NULL);
+		free(values);
+	}
+}
+
+static void bench_update(void)
+{
+	bench_header("u64 priority change, ns/op");
+	printf("%10s %16s %16s\n", "n", "search+reinsert", "indexed update");
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0xda3e39cb94b95bdb);
+
+	for (usize n = 1 << 10; n <= 1 << 20; n <<= 2) {
+		TrbHeap heap;
+		trb_heap_init(&heap, sizeof(u64), (TrbCmpFunc) trb_u64cmp);
+
+		TrbIndexedHeap iheap;
+		trb_indexed_heap_init(&iheap, sizeof(u64), (TrbCmpFunc) trb_u64cmp);
+
+		for (usize i = 0; i < n; ++i) {
+			u64 value = trb_pcg64_next_u64(&rng);
+			trb_heap_insert(&heap, &value);
+			trb_indexed_heap_insert(&iheap, &value, NULL);
+		}
+
+		/* Without handles the element has to be found first */
+		f64 start = bench_now();
+		for (usize i = 0; i < N_SLOW_OPS; ++i) {
+			u64 target = trb_heap_get(&heap, u64, trb_pcg64_next_u32(&rng) % n);
+			u64 value = trb_pcg64_next_u64(&rng);
+			usize index;
+
+			trb_heap_search(&heap, &target, NULL, &index);
+			trb_heap_remove(&heap, index, NULL);
+			trb_heap_insert(&heap, &value);
+		}
+		f64 search = bench_now() - start;
+
+		start = bench_now();
+		for (usize i = 0; i < N_OPS; ++i) {
+			u64 value = trb_pcg64_next_u64(&rng);
+			trb_indexed_heap_update(&iheap, trb_pcg64_next_u32(&rng) % n, &value);
+		}
+		f64 update = bench_now() - start;
+
+		printf("%10zu %16.1f %16.1f\n", n, search * 1e9 / N_SLOW_OPS, update * 1e9 / N_OPS);
+
+		trb_heap_destroy(&heap, NULL);
+		trb_indexed_heap_destroy(&iheap, NULL);
+	}
+}
+
+static void bench_arity(void)
+{
+	bench_header("u64 heap by arity, ns/op to fill with n elements and to drain it");
+	printf("%10s %8s %12s %12s\n", "n", "arity", "insert", "pop");
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0x9e3779b97f4a7c15);
+
+	for (usize n = 1 << 16; n <= 1 << 24; n <<= 4) {
+		u64 *values = malloc(n * sizeof(u64));
+
+		for (usize i = 0; i < n; ++i)
+			values[i] = trb_pcg64_next_u64(&rng);
+
+		for (usize arity = 2; arity <= 8; arity <<= 1) {
+			TrbHeap heap;
+			trb_heap_init(&heap, sizeof(u64), (TrbCmpFunc) trb_u64cmp);
+			trb_heap_set_arity(&heap, arity);
+			trb_vector_require(&heap.vector, n);
+
+			f64 start = bench_now();
+			for (usize i = 0; i < n; ++i)
+				trb_heap_insert(&heap, &values[i]);
+			f64 insert = bench_now() - start;
+
+			start = bench_now();
+			for (usize i = 0; i < n; ++i)
+				trb_heap_pop_front(&heap, NULL);
+			f64 pop = bench_now() - start;
+
+			printf("%10zu %8zu %12.1f %12.1f\n", n, arity, insert * 1e9 / n, pop * 1e9 / n);
+
+			trb_heap_destroy(&heap, NULL);
+		}
+
+		free(values);
+	}
+}
+
+int main(void)
+{
+	bench_heap();
+	bench_update();
+	bench_arity();
+	return 0;
+}
@@ -0,0 +1,81 @@
+#include "bench.h"
+#include "trb-vector.h"
+
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define CHUNK_LEN 4096
+#define MAP_THRESHOLD (1 << 20)
+
+typedef enum {
+	MODE_HEAP,
+	MODE_MMAP,
+	MODE_HUGEPAGES,
+} Mode;
+
+static const char *mode_names[] = { "realloc", "mmap", "mmap+thp" };
+
+/* Runs in a child process, so that the peak RSS belongs to this run only */
+static void grow(Mode mode, usize size)
+{
+	static u64 chunk[CHUNK_LEN];
+
+	for (usize i = 0; i < CHUNK_LEN; ++i)
+		chunk[i] = i;
+
+	TrbVector vec;
+	trb_vector_init(&vec, FALSE, sizeof(u64));
+
+	if (mode != MODE_HEAP)
+		trb_vector_set_mmap(&vec, MAP_THRESHOLD, mode == MODE_HUGEPAGES);
+
+	usize n_chunks = size / sizeof(chunk);
+
+	f64 start = bench_now();
+
+	for (usize i = 0; i < n_chunks; ++i)
+		trb_vector_push_back_many(&vec, chunk, CHUNK_LEN);
+
+	f64 elapsed = bench_now() - start;
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	printf(
+		"%10zu %10s %12.1f %12.1f %14.2f\n",
+		size >> 20, mode_names[mode], elapsed * 1e3,
+		(f64) usage.ru_maxrss / 1024, (f64) usage.ru_maxrss * 1024 / (f64) size
+	);
+
+	trb_vector_destroy(&vec, NULL);
+}
+
+static void bench_grow(void)
+{
+	bench_header("growing a u64 vector with push_back_many");
+	printf("%10s %10s %12s %12s %14s\n", "size, MiB", "mode", "time, ms", "peak RSS, MiB", "RSS / size");
+
+	for (usize size = (usize) 64 << 20; size <= (usize) 1 << 30; size <<= 2) {
+		for (Mode mode = MODE_HEAP; mode <= MODE_HUGEPAGES; ++mode) {
+			fflush(stdout);
+
+			pid_t pid = fork();
+
+			if (pid == 0) {
+				grow(mode, size);
+				fflush(stdout);
+				_exit(0);
+			}
+
+			waitpid(pid, NULL, 0);
+		}
+	}
+}
+
+int main(void)
+{
+	bench_grow();
+	return 0;
+}
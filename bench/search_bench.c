@@ -0,0 +1,173 @@
+#include "bench.h"
+#include "trb-eytzinger.h"
+#include "trb-prim.h"
+#include "trb-rand.h"
+#include "trb-slice.h"
+#include "trb-utils.h"
+#include "trb-vector.h"
+
+#include <stdlib.h>
+
+#define N_QUERIES 2000000
+
+/* The search that trb_binary_search used before it became branchless */
+static usize branchy_lower_bound(const TrbSlice *slice, const void *target, TrbCmpFunc cmp_func)
+{
+	usize left = 0;
+	usize right = trb_slice_len(slice);
+
+	while (left < right) {
+		usize mid = left + ((right - left) >> 1);
+
+		if (cmp_func(slice->at(slice, mid), target) < 0)
+			left = mid + 1;
+		else
+			right = mid;
+	}
+
+	return left;
+}
+
+static void bench_search(void)
+{
+	bench_header("u64 lower bound, ns/query");
+	printf("%12s %12s %12s %12s %12s\n", "n", "branchy", "branchless", "eytzinger", "batched");
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0x94d049bb133111eb);
+
+	u64 *queries = malloc(N_QUERIES * sizeof(u64));
+	const void **results = malloc(N_QUERIES * sizeof(void *));
+
+	for (usize n = 1 << 10; n <= 1 << 26; n <<= 4) {
+		u64 *arr = malloc(n * sizeof(u64));
+
+		for (usize i = 0; i < n; ++i)
+			arr[i] = 2 * i;
+
+		for (usize i = 0; i < N_QUERIES; ++i)
+			queries[i] = trb_pcg64_next_u64(&rng) % (2 * n);
+
+		TrbSlice slice;
+		trb_slice_init(&slice, arr, sizeof(u64), 0, n);
+
+		TrbEytzinger tree;
+		trb_eytzinger_init(&tree, &slice, (TrbCmpFunc) trb_u64cmp);
+
+		usize sum = 0;
+
+		f64 start = bench_now();
+		for (usize i = 0; i < N_QUERIES; ++i)
+			sum += branchy_lower_bound(&slice, &queries[i], (TrbCmpFunc) trb_u64cmp);
+		f64 t_branchy = bench_now() - start;
+
+		start = bench_now();
+		for (usize i = 0; i < N_QUERIES; ++i)
+			sum += trb_lower_bound(&slice, &queries[i], (TrbCmpFunc) trb_u64cmp);
+		f64 t_branchless = bench_now() - start;
+
+		start = bench_now();
+		for (usize i = 0; i < N_QUERIES; ++i)
+			sum += (usize) trb_eytzinger_lower_bound(&tree, &queries[i]);
+		f64 t_eytzinger = bench_now() - start;
+
+		start = bench_now();
+		trb_eytzinger_lower_bound_many(&tree, queries, N_QUERIES, results);
+		f64 t_batched = bench_now() - start;
+
+		bench_keep(sum);
+		bench_keep(results);
+
+		printf(
+			"%12zu %12.1f %12.1f %12.1f %12.1f\n", n,
+			t_branchy * 1e9 / N_QUERIES, t_branchless * 1e9 / N_QUERIES,
+			t_eytzinger * 1e9 / N_QUERIES, t_batched * 1e9 / N_QUERIES
+		);
+
+		trb_eytzinger_destroy(&tree);
+		free(arr);
+	}
+
+	free(queries);
+	free(results);
+}
+
+#define SCAN_BYTES ((usize) 1 << 30)
+
+/* The plain loop that compilers can't vectorize because of the early exit */
+static usize scalar_find_u64(const u64 *arr, usize len, u64 value)
+{
+	for (usize i = 0; i < len; ++i) {
+		if (arr[i] == value)
+			return i;
+	}
+
+	return len;
+}
+
+static void bench_scan(void)
+{
+	bench_header("full scans of u64 IDs for an absent value, GB/s");
+	printf("%10s %14s %14s %14s %14s\n", "n", "search", "scalar", "trb_find_u64", "trb_count_u64");
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 47);
+
+	for (usize n = 1 << 10; n <= 1 << 24; n <<= 2) {
+		TrbVector vec;
+		trb_vector_init(&vec, FALSE, sizeof(u64));
+
+		for (usize i = 0; i < n; ++i) {
+			u64 id = trb_pcg64_next_u64(&rng) | 1;
+			trb_vector_push_back(&vec, &id);
+		}
+
+		TrbSlice slice;
+		trb_vector_slice(&vec, &slice, 0, n);
+
+		usize repeats = SCAN_BYTES / (n * sizeof(u64));
+		u64 absent = 0;
+		usize index = 0;
+
+		f64 start = bench_now();
+		for (usize r = 0; r < repeats; ++r) {
+			trb_vector_search(&vec, &absent, (TrbCmpFunc) trb_u64cmp, &index);
+			bench_keep(index);
+		}
+		f64 search = bench_now() - start;
+
+		start = bench_now();
+		for (usize r = 0; r < repeats; ++r) {
+			index = scalar_find_u64(vec.data, n, absent);
+			bench_keep(index);
+		}
+		f64 scalar = bench_now() - start;
+
+		start = bench_now();
+		for (usize r = 0; r < repeats; ++r) {
+			trb_find_u64(&slice, absent, &index);
+			bench_keep(index);
+		}
+		f64 find = bench_now() - start;
+
+		start = bench_now();
+		for (usize r = 0; r < repeats; ++r) {
+			index = trb_count_u64(&slice, absent);
+			bench_keep(index);
+		}
+		f64 count = bench_now() - start;
+
+		f64 bytes = (f64) repeats * n * sizeof(u64) / 1e9;
+		printf("%10zu %14.2f %14.2f %14.2f %14.2f\n", n, bytes / search, bytes / scalar, bytes / find, bytes / count);
+
+		trb_vector_destroy(&vec, NULL);
+	}
+}
+
+int main()
+{
+	bench_search();
+	bench_scan();
+
+	return 0;
+}
@@ -0,0 +1,556 @@
+#define _GNU_SOURCE
+
+#include "bench.h"
+#include "trb-heap.h"
+#include "trb-macros.h"
+#include "trb-merge-iter.h"
+#include "trb-prim.h"
+#include "trb-rand.h"
+#include "trb-slice.h"
+#include "trb-utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define N_ELEMS 200000
+#define N_SWAPS 20000000
+
+static const usize elemsizes[] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+
+/* The swap that trb_memswap used before it became size-specialized */
+static void byte_swap(void *a, void *b, usize size)
+{
+	char *ca = a;
+	char *cb = b;
+
+	do {
+		char tmp = *ca;
+		*ca++ = *cb;
+		*cb++ = tmp;
+	} while (--size > 0);
+}
+
+static i32 record_cmp(const void *a, const void *b, void *data)
+{
+	usize keysize = *(usize *) data;
+	u64 ka = 0, kb = 0;
+
+	memcpy(&ka, a, keysize);
+	memcpy(&kb, b, keysize);
+
+	return (ka > kb) - (ka < kb);
+}
+
+static void fill_random(TrbPcg64 *rng, u8 *buf, usize len)
+{
+	for (usize i = 0; i < len; ++i)
+		buf[i] = trb_pcg64_next_u32(rng);
+}
+
+static void bench_swap(void)
+{
+	bench_header("swap, ns/swap");
+	printf("%8s %12s %12s\n", "size", "byte loop", "trb_memswap");
+
+	u8 *buf = malloc(2 * 128 * 64);
+
+	for (usize s = 0; s < sizeof(elemsizes) / sizeof(elemsizes[0]); ++s) {
+		usize size = elemsizes[s];
+		memset(buf, 1, 2 * 128 * 64);
+
+		f64 start = bench_now();
+		for (usize i = 0; i < N_SWAPS; ++i) {
+			usize k = i & 63;
+			byte_swap(&buf[k * 2 * size], &buf[(k * 2 + 1) * size], size);
+			bench_keep(buf);
+		}
+		f64 t_byte = bench_now() - start;
+
+		start = bench_now();
+		for (usize i = 0; i < N_SWAPS; ++i) {
+			usize k = i & 63;
+			trb_memswap(&buf[k * 2 * size], &buf[(k * 2 + 1) * size], size);
+			bench_keep(buf);
+		}
+		f64 t_kernel = bench_now() - start;
+
+		printf("%8zu %12.2f %12.2f\n", size, t_byte * 1e9 / N_SWAPS, t_kernel * 1e9 / N_SWAPS);
+	}
+
+	free(buf);
+}
+
+static void bench_sort(void)
+{
+	bench_header("sort of random records, ns/element");
+	printf("%8s %12s %12s %12s\n", "size", "quicksort", "heapsort", "qsort(3)");
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0xb5ad4eceda1ce2a9);
+
+	for (usize s = 0; s < sizeof(elemsizes) / sizeof(elemsizes[0]); ++s) {
+		usize size = elemsizes[s];
+		usize keysize = (size < 8) ? size : 8;
+
+		u8 *orig = malloc(N_ELEMS * size);
+		u8 *work = malloc(N_ELEMS * size);
+		fill_random(&rng, orig, N_ELEMS * size);
+
+		TrbSlice slice;
+		trb_slice_init(&slice, work, size, 0, N_ELEMS);
+
+		memcpy(work, orig, N_ELEMS * size);
+		f64 start = bench_now();
+		trb_quicksort_data(&slice, record_cmp, &keysize);
+		f64 t_quick = bench_now() - start;
+
+		memcpy(work, orig, N_ELEMS * size);
+		start = bench_now();
+		trb_heapsort_data(&slice, record_cmp, &keysize);
+		f64 t_heap = bench_now() - start;
+
+		memcpy(work, orig, N_ELEMS * size);
+		start = bench_now();
+		qsort_r(work, N_ELEMS, size, record_cmp, &keysize);
+		f64 t_libc = bench_now() - start;
+
+		printf(
+			"%8zu %12.2f %12.2f %12.2f\n", size,
+			t_quick * 1e9 / N_ELEMS, t_heap * 1e9 / N_ELEMS, t_libc * 1e9 / N_ELEMS
+		);
+
+		free(orig);
+		free(work);
+	}
+}
+
+static void bench_contiguous(void)
+{
+	bench_header("u32 sort, contiguous vs at() callback, ns/element");
+	printf("%10s %12s %12s %12s %12s\n", "n", "quick/ptr", "quick/at", "heap/ptr", "heap/at");
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0x853c49e6748fea9b);
+
+	for (usize n = 1000; n <= 1000000; n *= 10) {
+		u32 *orig = malloc(n * sizeof(u32));
+		u32 *work = malloc(n * sizeof(u32));
+
+		for (usize i = 0; i < n; ++i)
+			orig[i] = trb_pcg64_next_u32(&rng);
+
+		f64 times[4];
+
+		for (usize k = 0; k < 4; ++k) {
+			TrbSlice slice;
+			trb_slice_init(&slice, work, sizeof(u32), 0, n);
+			slice.contiguous = (k % 2 == 0);
+
+			memcpy(work, orig, n * sizeof(u32));
+			f64 start = bench_now();
+
+			if (k < 2)
+				trb_quicksort(&slice, (TrbCmpFunc) trb_u32cmp);
+			else
+				trb_heapsort(&slice, (TrbCmpFunc) trb_u32cmp);
+
+			times[k] = (bench_now() - start) * 1e9 / n;
+		}
+
+		printf("%10zu %12.2f %12.2f %12.2f %12.2f\n", n, times[0], times[1], times[2], times[3]);
+
+		free(orig);
+		free(work);
+	}
+}
+
+static const char *const pattern_names[] = {
+	"random",
+	"sorted",
+	"reverse",
+	"sawtooth",
+	"few unique",
+	"nearly sorted",
+};
+
+#define N_PATTERNS (sizeof(pattern_names) / sizeof(pattern_names[0]))
+
+static void fill_pattern(TrbPcg64 *rng, u64 *arr, usize len, usize pattern)
+{
+	for (usize i = 0; i < len; ++i) {
+		switch (pattern) {
+		case 0:
+			arr[i] = trb_pcg64_next_u64(rng);
+			break;
+		case 1:
+			arr[i] = i;
+			break;
+		case 2:
+			arr[i] = len - i;
+			break;
+		case 3:
+			arr[i] = i % 1000;
+			break;
+		case 4:
+			arr[i] = trb_pcg64_next_u32(rng) % 16;
+			break;
+		default:
+			arr[i] = (trb_pcg64_next_u32(rng) % 100 == 0) ? trb_pcg64_next_u64(rng) : i;
+			break;
+		}
+	}
+}
+
+static int u64_qsort_cmp(const void *a, const void *b)
+{
+	return trb_u64cmp(a, b);
+}
+
+static void bench_patterns(void)
+{
+	usize n = 1000000;
+
+	bench_header("u64 sort by input distribution, n = 1000000, ns/element");
+	printf("%14s %12s %12s %12s %12s\n", "pattern", "quicksort", "heapsort", "stablesort", "qsort(3)");
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0xda3e39cb94b95bdb);
+
+	u64 *orig = malloc(n * sizeof(u64));
+	u64 *work = malloc(n * sizeof(u64));
+
+	for (usize p = 0; p < N_PATTERNS; ++p) {
+		fill_pattern(&rng, orig, n, p);
+
+		TrbSlice slice;
+		trb_slice_init(&slice, work, sizeof(u64), 0, n);
+
+		memcpy(work, orig, n * sizeof(u64));
+		f64 start = bench_now();
+		trb_quicksort(&slice, (TrbCmpFunc) trb_u64cmp);
+		f64 t_quick = bench_now() - start;
+
+		memcpy(work, orig, n * sizeof(u64));
+		start = bench_now();
+		trb_heapsort(&slice, (TrbCmpFunc) trb_u64cmp);
+		f64 t_heap = bench_now() - start;
+
+		memcpy(work, orig, n * sizeof(u64));
+		start = bench_now();
+		trb_stablesort(&slice, (TrbCmpFunc) trb_u64cmp, NULL);
+		f64 t_stable = bench_now() - start;
+
+		memcpy(work, orig, n * sizeof(u64));
+		start = bench_now();
+		qsort(work, n, sizeof(u64), u64_qsort_cmp);
+		f64 t_libc = bench_now() - start;
+
+		printf(
+			"%14s %12.2f %12.2f %12.2f %12.2f\n", pattern_names[p],
+			t_quick * 1e9 / n, t_heap * 1e9 / n, t_stable * 1e9 / n, t_libc * 1e9 / n
+		);
+	}
+
+	free(orig);
+	free(work);
+}
+
+static void bench_radix(void)
+{
+	bench_header("u64 sort, radix vs comparison, ns/element");
+	printf("%10s %12s %12s %12s %12s\n", "n", "keys", "radixsort", "quicksort", "qsort(3)");
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0x5851f42d4c957f2d);
+
+	for (usize n = 10000; n <= 10000000; n *= 10) {
+		u64 *orig = malloc(n * sizeof(u64));
+		u64 *work = malloc(n * sizeof(u64));
+		u64 *buffer = malloc(n * sizeof(u64));
+
+		for (usize k = 0; k < 2; ++k) {
+			/* Random keys and microsecond timestamps within about an hour */
+			for (usize i = 0; i < n; ++i)
+				orig[i] = (k == 0) ? trb_pcg64_next_u64(&rng) : 1700000000000000ull + trb_pcg64_next_u32(&rng);
+
+			TrbSlice slice;
+			trb_slice_init(&slice, work, sizeof(u64), 0, n);
+
+			memcpy(work, orig, n * sizeof(u64));
+			f64 start = bench_now();
+			trb_radixsort_u64(&slice, buffer);
+			f64 t_radix = bench_now() - start;
+
+			memcpy(work, orig, n * sizeof(u64));
+			start = bench_now();
+			trb_quicksort(&slice, (TrbCmpFunc) trb_u64cmp);
+			f64 t_quick = bench_now() - start;
+
+			memcpy(work, orig, n * sizeof(u64));
+			start = bench_now();
+			qsort(work, n, sizeof(u64), u64_qsort_cmp);
+			f64 t_libc = bench_now() - start;
+
+			printf(
+				"%10zu %12s %12.2f %12.2f %12.2f\n", n, (k == 0) ? "random" : "timestamps",
+				t_radix * 1e9 / n, t_quick * 1e9 / n, t_libc * 1e9 / n
+			);
+		}
+
+		free(orig);
+		free(work);
+		free(buffer);
+	}
+}
+
+static void bench_parallel(void)
+{
+	usize n = 10000000;
+
+	bench_header("parallel u64 sort, n = 10000000, ms");
+	printf("%10s %12s %12s %12s %12s\n", "threads", "quicksort", "speedup", "stablesort", "speedup");
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0x9e3779b97f4a7c15);
+
+	u64 *orig = malloc(n * sizeof(u64));
+	u64 *work = malloc(n * sizeof(u64));
+	u64 *buffer = malloc(n * sizeof(u64));
+
+	for (usize i = 0; i < n; ++i)
+		orig[i] = trb_pcg64_next_u64(&rng);
+
+	TrbSlice slice;
+	trb_slice_init(&slice, work, sizeof(u64), 0, n);
+
+	f64 t_quick_1 = 0;
+	f64 t_stable_1 = 0;
+
+	for (usize n_threads = 1; n_threads <= 64; n_threads *= 2) {
+		memcpy(work, orig, n * sizeof(u64));
+		f64 start = bench_now();
+		trb_quicksort_parallel(&slice, (TrbCmpFunc) trb_u64cmp, n_threads);
+		f64 t_quick = bench_now() - start;
+
+		memcpy(work, orig, n * sizeof(u64));
+		start = bench_now();
+		trb_stablesort_parallel(&slice, (TrbCmpFunc) trb_u64cmp, n_threads, buffer);
+		f64 t_stable = bench_now() - start;
+
+		if (n_threads == 1) {
+			t_quick_1 = t_quick;
+			t_stable_1 = t_stable;
+		}
+
+		printf(
+			"%10zu %12.1f %12.2f %12.1f %12.2f\n", n_threads,
+			t_quick * 1e3, t_quick_1 / t_quick, t_stable * 1e3, t_stable_1 / t_stable
+		);
+	}
+
+	free(orig);
+	free(work);
+	free(buffer);
+}
+
+static int u32_qsort_cmp(const void *a, const void *b)
+{
+	return trb_u32cmp(a, b);
+}
+
+static void bench_prim(void)
+{
+	bench_header("u32 sort of many small arrays, ns/element");
+	printf("%10s %12s %12s %12s\n", "n", "trb_sort_u32", "quicksort", "qsort(3)");
+
+	const usize total = 4000000;
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0x2545f4914f6cdd1d);
+
+	u32 *orig = malloc(total * sizeof(u32));
+	u32 *work = malloc(total * sizeof(u32));
+
+	for (usize i = 0; i < total; ++i)
+		orig[i] = trb_pcg64_next_u32(&rng);
+
+	for (usize n = 8; n <= total; n *= 8) {
+		usize n_arrays = total / n;
+		f64 times[3];
+
+		for (usize k = 0; k < 3; ++k) {
+			memcpy(work, orig, total * sizeof(u32));
+			f64 start = bench_now();
+
+			for (usize a = 0; a < n_arrays; ++a) {
+				u32 *arr = work + a * n;
+
+				if (k == 0) {
+					trb_sort_u32(arr, n);
+				} else if (k == 1) {
+					TrbSlice slice;
+					trb_slice_init(&slice, arr, sizeof(u32), 0, n);
+					trb_quicksort(&slice, (TrbCmpFunc) trb_u32cmp);
+				} else {
+					qsort(arr, n, sizeof(u32), u32_qsort_cmp);
+				}
+			}
+
+			bench_keep(work);
+			times[k] = (bench_now() - start) * 1e9 / (n_arrays * n);
+		}
+
+		printf("%10zu %12.2f %12.2f %12.2f\n", n, times[0], times[1], times[2]);
+	}
+
+	free(orig);
+	free(work);
+}
+
+static void bench_select(void)
+{
+	usize n = 10000000;
+	usize k = 100;
+
+	bench_header("top 100 of 10000000 u64, ms");
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0xbf58476d1ce4e5b9);
+
+	u64 *orig = malloc(n * sizeof(u64));
+	u64 *work = malloc(n * sizeof(u64));
+	u64 top[100];
+
+	for (usize i = 0; i < n; ++i)
+		orig[i] = trb_pcg64_next_u64(&rng);
+
+	TrbSlice slice;
+	trb_slice_init(&slice, work, sizeof(u64), 0, n);
+
+	memcpy(work, orig, n * sizeof(u64));
+	f64 start = bench_now();
+	trb_quicksort(&slice, (TrbCmpFunc) trb_u64cmp);
+	printf("%16s %10.1f\n", "quicksort", (bench_now() - start) * 1e3);
+
+	memcpy(work, orig, n * sizeof(u64));
+	start = bench_now();
+	trb_partial_sort(&slice, k, (TrbCmpFunc) trb_u64cmp);
+	printf("%16s %10.1f\n", "partial_sort", (bench_now() - start) * 1e3);
+
+	memcpy(work, orig, n * sizeof(u64));
+	start = bench_now();
+	trb_nth_element(&slice, k, (TrbCmpFunc) trb_u64cmp);
+	printf("%16s %10.1f\n", "nth_element", (bench_now() - start) * 1e3);
+
+	memcpy(work, orig, n * sizeof(u64));
+	start = bench_now();
+	trb_topk(&slice, k, (TrbCmpFunc) trb_u64cmp, top);
+	printf("%16s %10.1f\n", "topk", (bench_now() - start) * 1e3);
+
+	free(orig);
+	free(work);
+}
+
+typedef struct {
+	const u64 *head;
+	const u64 *end;
+} MergeRun;
+
+static i32 merge_run_cmp(const MergeRun *a, const MergeRun *b)
+{
+	return (*a->head < *b->head) - (*a->head > *b->head);
+}
+
+/* A k-way merge with the smallest head on top of a TrbHeap */
+static void heap_merge(const u64 *arr, usize n, usize k, u64 *out)
+{
+	TrbHeap heap;
+	trb_heap_init(&heap, sizeof(MergeRun), (TrbCmpFunc) merge_run_cmp);
+
+	for (usize r = 0; r < k; ++r) {
+		MergeRun run = { arr + r * (n / k), arr + (r + 1) * (n / k) };
+		trb_heap_insert(&heap, &run);
+	}
+
+	while (heap.vector.len != 0) {
+		MergeRun run = trb_heap_get(&heap, MergeRun, 0);
+		*out++ = *run.head++;
+
+		if (run.head != run.end)
+			trb_heap_replace_top(&heap, &run, NULL);
+		else
+			trb_heap_pop_front(&heap, NULL);
+	}
+
+	trb_heap_destroy(&heap, NULL);
+}
+
+static void bench_merge(void)
+{
+	const usize n = N_ELEMS * 40;
+
+	bench_header("merge of k sorted u64 runs, ms");
+	printf("%8s %12s %12s %12s\n", "k", "quicksort", "heap merge", "merge iter");
+
+	u64 *arr = malloc(n * sizeof(u64));
+	u64 *out = malloc(n * sizeof(u64));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0x5851f42d4c957f2d);
+
+	for (usize k = 2; k <= 512; k <<= 2) {
+		usize run_len = n / k;
+		TrbSlice *slices = malloc(k * sizeof(TrbSlice));
+
+		for (usize i = 0; i < n; ++i)
+			arr[i] = trb_pcg64_next_u64(&rng);
+
+		for (usize r = 0; r < k; ++r) {
+			trb_slice_init(&slices[r], arr, sizeof(u64), r * run_len, (r + 1) * run_len);
+			trb_quicksort(&slices[r], (TrbCmpFunc) trb_u64cmp);
+		}
+
+		/* What callers did before: concatenate the runs and sort again */
+		memcpy(out, arr, n * sizeof(u64));
+		TrbSlice all;
+		trb_slice_init(&all, out, sizeof(u64), 0, n);
+
+		f64 start = bench_now();
+		trb_quicksort(&all, (TrbCmpFunc) trb_u64cmp);
+		f64 resort = bench_now() - start;
+
+		start = bench_now();
+		heap_merge(arr, n, k, out);
+		f64 heap = bench_now() - start;
+
+		start = bench_now();
+		TrbMergeIter iter;
+		trb_merge_iter_init(&iter, slices, k, (TrbCmpFunc) trb_u64cmp);
+		while (trb_merge_iter_next_many(&iter, out, 4096) != 0)
+			bench_keep(out[0]);
+		trb_merge_iter_destroy(&iter);
+		f64 merge = bench_now() - start;
+
+		printf("%8zu %12.1f %12.1f %12.1f\n", k, resort * 1e3, heap * 1e3, merge * 1e3);
+
+		free(slices);
+	}
+
+	free(arr);
+	free(out);
+}
+
+int main()
+{
+	bench_swap();
+	bench_sort();
+	bench_contiguous();
+	bench_patterns();
+	bench_radix();
+	bench_prim();
+	bench_select();
+	bench_merge();
+	bench_parallel();
+
+	return 0;
+}
@@ -0,0 +1,127 @@
+#include "bench.h"
+#include "trb-indexed-heap.h"
+#include "trb-list.h"
+#include "trb-macros.h"
+#include "trb-rand.h"
+#include "trb-timer-wheel.h"
+
+#include <stdlib.h>
+
+#define N_TICKS 2000
+#define CHURN_PER_TICK 2000
+#define MIN_TIMEOUT 1000
+#define MAX_TIMEOUT 30000
+
+typedef struct {
+	TrbTimer timer;
+	usize handle;
+} Conn;
+
+/* The heap needs the earliest timer on top */
+static i32 expires_cmp(const u64 *a, const u64 *b)
+{
+	return (*a < *b) - (*a > *b);
+}
+
+static u64 random_timeout(TrbPcg64 *rng)
+{
+	return MIN_TIMEOUT + trb_pcg64_next_u32(rng) % (MAX_TIMEOUT - MIN_TIMEOUT);
+}
+
+/* Every tick some connections see activity and have their timeouts pushed back */
+static f64 bench_wheel(Conn *conns, usize n_conns)
+{
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 7);
+
+	TrbTimerWheel wheel;
+	trb_timer_wheel_init(&wheel, 0);
+
+	for (usize i = 0; i < n_conns; ++i) {
+		trb_timer_init(&conns[i].timer);
+		trb_timer_wheel_add(&wheel, &conns[i].timer, random_timeout(&rng));
+	}
+
+	f64 start = bench_now();
+
+	for (u64 tick = 1; tick <= N_TICKS; ++tick) {
+		for (usize i = 0; i < CHURN_PER_TICK; ++i) {
+			Conn *conn = &conns[trb_pcg64_next_u32(&rng) % n_conns];
+			trb_timer_wheel_cancel(&wheel, &conn->timer);
+			trb_timer_wheel_add(&wheel, &conn->timer, tick + random_timeout(&rng));
+		}
+
+		TrbList expired;
+		trb_list_init(&expired);
+		trb_timer_wheel_advance(&wheel, tick, &expired);
+
+		TrbList *node;
+		while ((node = trb_list_pop_front(&expired)) != NULL) {
+			Conn *conn = trb_container_of(node, Conn, timer.node);
+			trb_timer_wheel_add(&wheel, &conn->timer, tick + random_timeout(&rng));
+		}
+	}
+
+	return bench_now() - start;
+}
+
+static f64 bench_heap(Conn *conns, usize n_conns)
+{
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 7);
+
+	TrbIndexedHeap heap;
+	trb_indexed_heap_init(&heap, sizeof(u64), (TrbCmpFunc) expires_cmp);
+
+	for (usize i = 0; i < n_conns; ++i) {
+		u64 expires = random_timeout(&rng);
+		trb_indexed_heap_insert(&heap, &expires, &conns[i].handle);
+	}
+
+	f64 start = bench_now();
+
+	for (u64 tick = 1; tick <= N_TICKS; ++tick) {
+		for (usize i = 0; i < CHURN_PER_TICK; ++i) {
+			Conn *conn = &conns[trb_pcg64_next_u32(&rng) % n_conns];
+			u64 expires = tick + random_timeout(&rng);
+			trb_indexed_heap_update(&heap, conn->handle, &expires);
+		}
+
+		const u64 *top;
+		usize handle;
+
+		while ((top = trb_indexed_heap_top(&heap, &handle)) != NULL && *top <= tick) {
+			u64 expires = tick + random_timeout(&rng);
+			trb_indexed_heap_update(&heap, handle, &expires);
+		}
+	}
+
+	f64 elapsed = bench_now() - start;
+	trb_indexed_heap_destroy(&heap, NULL);
+
+	return elapsed;
+}
+
+static void bench_churn(void)
+{
+	bench_header("timer reschedule churn, ns per reschedule");
+	printf("%10s %14s %14s\n", "timers", "indexed heap", "timer wheel");
+
+	for (usize n = 1 << 14; n <= 1 << 20; n <<= 2) {
+		Conn *conns = malloc(n * sizeof(Conn));
+
+		f64 heap = bench_heap(conns, n);
+		f64 wheel = bench_wheel(conns, n);
+
+		f64 ops = (f64) N_TICKS * CHURN_PER_TICK;
+		printf("%10zu %14.1f %14.1f\n", n, heap * 1e9 / ops, wheel * 1e9 / ops);
+
+		free(conns);
+	}
+}
+
+int main(void)
+{
+	bench_churn();
+	return 0;
+}
@@ -0,0 +1,550 @@
+#include "bench.h"
+#include "trb-growth.h"
+#include "trb-macros.h"
+#include "trb-seg-vector.h"
+#include "trb-small-vector.h"
+#include "trb-string.h"
+#include "trb-vector-define.h"
+#include "trb-vector.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define N_REPEATS 5
+
+TRB_VECTOR_DEFINE(U32Vector, u32_vector, u32)
+
+typedef struct {
+	u64 id;
+	u8 payload[248];
+} Record;
+
+static const TrbGrowth policies[] = { TRB_GROWTH_CONSERVATIVE, TRB_GROWTH_1_5X, TRB_GROWTH_2X };
+
+static f64 push_back_vector(TrbGrowth growth, usize n, usize *n_reallocs)
+{
+	TrbVector vec;
+	trb_vector_init(&vec, FALSE, sizeof(u64));
+	trb_vector_set_growth(&vec, growth, NULL);
+
+	usize capacity = vec.capacity;
+	*n_reallocs = 0;
+
+	f64 start = bench_now();
+
+	for (u64 i = 0; i < n; ++i) {
+		trb_vector_push_back(&vec, &i);
+
+		if (vec.capacity != capacity) {
+			capacity = vec.capacity;
+			(*n_reallocs)++;
+		}
+	}
+
+	f64 elapsed = bench_now() - start;
+	bench_keep(vec.data);
+	trb_vector_destroy(&vec, NULL);
+
+	return elapsed;
+}
+
+static f64 push_back_string(TrbGrowth growth, usize n)
+{
+	TrbString str;
+	trb_string_init0(&str);
+	trb_string_set_growth(&str, growth, NULL);
+
+	f64 start = bench_now();
+
+	for (usize i = 0; i < n; ++i)
+		trb_string_push_back_c(&str, 'a' + i % 26);
+
+	f64 elapsed = bench_now() - start;
+	bench_keep(str.data);
+	trb_string_destroy(&str);
+
+	return elapsed;
+}
+
+static void bench_vector(void)
+{
+	bench_header("u64 vector push_back, ns per element (reallocations)");
+	printf("%10s %20s %20s %20s\n", "n", "conservative", "1.5x", "2x");
+
+	for (usize n = 1 << 10; n <= 1 << 24; n <<= 2) {
+		printf("%10zu", n);
+
+		for (usize p = 0; p < sizeof(policies) / sizeof(policies[0]); ++p) {
+			f64 best = 1e30;
+			usize n_reallocs = 0;
+
+			for (usize r = 0; r < N_REPEATS; ++r) {
+				f64 elapsed = push_back_vector(policies[p], n, &n_reallocs);
+				best = (elapsed < best) ? elapsed : best;
+			}
+
+			printf(" %12.2f (%5zu)", best * 1e9 / n, n_reallocs);
+		}
+
+		printf("\n");
+	}
+}
+
+static void bench_string(void)
+{
+	bench_header("string push_back_c, ns per char");
+	printf("%10s %14s %14s %14s\n", "n", "conservative", "1.5x", "2x");
+
+	for (usize n = 1 << 10; n <= 1 << 24; n <<= 2) {
+		printf("%10zu", n);
+
+		for (usize p = 0; p < sizeof(policies) / sizeof(policies[0]); ++p) {
+			f64 best = 1e30;
+
+			for (usize r = 0; r < N_REPEATS; ++r) {
+				f64 elapsed = push_back_string(policies[p], n);
+				best = (elapsed < best) ? elapsed : best;
+			}
+
+			printf(" %14.2f", best * 1e9 / n);
+		}
+
+		printf("\n");
+	}
+}
+
+static f64 push_generic(usize n)
+{
+	TrbVector vec;
+	trb_vector_init(&vec, FALSE, sizeof(u32));
+
+	f64 start = bench_now();
+
+	for (u32 i = 0; i < n; ++i)
+		trb_vector_push_back(&vec, &i);
+
+	f64 elapsed = bench_now() - start;
+	bench_keep(vec.data);
+	trb_vector_destroy(&vec, NULL);
+
+	return elapsed;
+}
+
+static f64 push_typed(usize n)
+{
+	U32Vector vec;
+	u32_vector_init(&vec, FALSE);
+
+	f64 start = bench_now();
+
+	for (u32 i = 0; i < n; ++i)
+		u32_vector_push(&vec, i);
+
+	f64 elapsed = bench_now() - start;
+	bench_keep(vec.data);
+	u32_vector_destroy(&vec);
+
+	return elapsed;
+}
+
+/* The lower bound: a plain array that never has to grow */
+static f64 push_array(usize n)
+{
+	u32 *data = malloc(n * sizeof(u32));
+
+	f64 start = bench_now();
+
+	for (u32 i = 0; i < n; ++i) {
+		data[i] = i;
+		bench_keep(data);
+	}
+
+	f64 elapsed = bench_now() - start;
+	free(data);
+
+	return elapsed;
+}
+
+static void bench_typed(void)
+{
+	bench_header("u32 push_back, ns per element");
+	printf("%10s %14s %14s %14s\n", "n", "TrbVector", "typed", "array");
+
+	for (usize n = 1 << 10; n <= 1 << 24; n <<= 2) {
+		f64 generic = 1e30, typed = 1e30, array = 1e30;
+
+		for (usize r = 0; r < N_REPEATS; ++r) {
+			f64 elapsed = push_generic(n);
+			generic = (elapsed < generic) ? elapsed : generic;
+
+			elapsed = push_typed(n);
+			typed = (elapsed < typed) ? elapsed : typed;
+
+			elapsed = push_array(n);
+			array = (elapsed < array) ? elapsed : array;
+		}
+
+		printf("%10zu %14.2f %14.2f %14.2f\n", n, generic * 1e9 / n, typed * 1e9 / n, array * 1e9 / n);
+	}
+}
+
+static void fill_record(Record *record, u64 id)
+{
+	record->id = id;
+	memset(record->payload, (u8) id, sizeof(record->payload));
+}
+
+static f64 fill_push_back(usize n)
+{
+	TrbVector vec;
+	trb_vector_init(&vec, FALSE, sizeof(Record));
+	trb_vector_require(&vec, n);
+
+	f64 start = bench_now();
+
+	for (usize i = 0; i < n; ++i) {
+		Record record;
+		fill_record(&record, i);
+		trb_vector_push_back(&vec, &record);
+	}
+
+	f64 elapsed = bench_now() - start;
+	bench_keep(vec.data);
+	trb_vector_destroy(&vec, NULL);
+
+	return elapsed;
+}
+
+static f64 fill_emplace_back(usize n)
+{
+	TrbVector vec;
+	trb_vector_init(&vec, FALSE, sizeof(Record));
+	trb_vector_require(&vec, n);
+
+	f64 start = bench_now();
+
+	for (usize i = 0; i < n; ++i)
+		fill_record(trb_vector_emplace_back(&vec, 1), i);
+
+	f64 elapsed = bench_now() - start;
+	bench_keep(vec.data);
+	trb_vector_destroy(&vec, NULL);
+
+	return elapsed;
+}
+
+static void bench_emplace(void)
+{
+	bench_header("256-byte records, ns per element");
+	printf("%10s %14s %14s\n", "n", "push_back", "emplace_back");
+
+	for (usize n = 1 << 10; n <= 1 << 20; n <<= 2) {
+		f64 push = 1e30, emplace = 1e30;
+
+		for (usize r = 0; r < N_REPEATS; ++r) {
+			f64 elapsed = fill_push_back(n);
+			push = (elapsed < push) ? elapsed : push;
+
+			elapsed = fill_emplace_back(n);
+			emplace = (elapsed < emplace) ? elapsed : emplace;
+		}
+
+		printf("%10zu %14.2f %14.2f\n", n, push * 1e9 / n, emplace * 1e9 / n);
+	}
+}
+
+#define N_TINY 1000000
+
+/* Short-lived vectors of a few elements, like the ones built per request */
+static f64 tiny_vector(usize n_elems)
+{
+	f64 start = bench_now();
+
+	for (u32 r = 0; r < N_TINY; ++r) {
+		TrbVector vec;
+		trb_vector_init(&vec, FALSE, sizeof(u32));
+
+		for (u32 i = 0; i < n_elems; ++i)
+			trb_vector_push_back(&vec, trb_get_ptr(u32, r + i));
+
+		bench_keep(trb_vector_get(&vec, u32, n_elems - 1));
+		trb_vector_destroy(&vec, NULL);
+	}
+
+	return bench_now() - start;
+}
+
+static f64 tiny_small_vector(usize n_elems)
+{
+	f64 start = bench_now();
+
+	for (u32 r = 0; r < N_TINY; ++r) {
+		TrbSmallVector vec;
+		trb_small_vector_init(&vec, FALSE, sizeof(u32));
+
+		for (u32 i = 0; i < n_elems; ++i)
+			trb_small_vector_push_back(&vec, trb_get_ptr(u32, r + i));
+
+		bench_keep(trb_small_vector_get(&vec, u32, n_elems - 1));
+		trb_small_vector_destroy(&vec, NULL);
+	}
+
+	return bench_now() - start;
+}
+
+static void bench_tiny(void)
+{
+	bench_header("short-lived u32 vectors, ns per vector");
+	printf("%10s %14s %14s\n", "elements", "TrbVector", "small vector");
+
+	for (usize n_elems = 1; n_elems <= 32; n_elems <<= 1) {
+		f64 vector = 1e30, small = 1e30;
+
+		for (usize r = 0; r < N_REPEATS; ++r) {
+			f64 elapsed = tiny_vector(n_elems);
+			vector = (elapsed < vector) ? elapsed : vector;
+
+			elapsed = tiny_small_vector(n_elems);
+			small = (elapsed < small) ? elapsed : small;
+		}
+
+		printf("%10zu %14.2f %14.2f\n", n_elems, vector * 1e9 / N_TINY, small * 1e9 / N_TINY);
+	}
+}
+
+/* Grows from empty, so the vector pays for every reallocation */
+static void grow_vector(usize n, f64 *push, f64 *scan)
+{
+	TrbVector vec;
+	trb_vector_init(&vec, FALSE, sizeof(u64));
+
+	f64 start = bench_now();
+
+	for (u64 i = 0; i < n; ++i)
+		trb_vector_push_back(&vec, &i);
+
+	*push = bench_now() - start;
+
+	u64 *data = vec.data;
+	u64 sum = 0;
+	start = bench_now();
+
+	for (usize i = 0; i < vec.len; ++i)
+		sum += data[i];
+
+	bench_keep(sum);
+	*scan = bench_now() - start;
+
+	trb_vector_destroy(&vec, NULL);
+}
+
+static void grow_seg_vector(usize n, f64 *push, f64 *chunks, f64 *index)
+{
+	TrbSegVector vec;
+	trb_seg_vector_init(&vec, FALSE, sizeof(u64));
+
+	f64 start = bench_now();
+
+	for (u64 i = 0; i < n; ++i)
+		trb_seg_vector_push_back(&vec, &i);
+
+	*push = bench_now() - start;
+
+	u64 *chunk;
+	u64 sum = 0;
+	start = bench_now();
+
+	for (usize i = 0, len; (len = trb_seg_vector_chunk(&vec, i, (void **) &chunk)) != 0; i += len) {
+		for (usize j = 0; j < len; ++j)
+			sum += chunk[j];
+	}
+
+	bench_keep(sum);
+	*chunks = bench_now() - start;
+
+	sum = 0;
+	start = bench_now();
+
+	for (usize i = 0; i < vec.len; ++i)
+		sum += trb_seg_vector_get(&vec, u64, i);
+
+	bench_keep(sum);
+	*index = bench_now() - start;
+
+	trb_seg_vector_destroy(&vec, NULL);
+}
+
+static void bench_segmented(void)
+{
+	bench_header("u64 TrbVector vs TrbSegVector, ns per element");
+	printf(
+		"%10s %12s %12s %12s %12s %12s\n",
+		"n", "vec push", "seg push", "vec scan", "seg chunks", "seg index"
+	);
+
+	for (usize n = 1 << 10; n <= 1 << 24; n <<= 2) {
+		f64 best[5] = { 1e30, 1e30, 1e30, 1e30, 1e30 };
+
+		for (usize r = 0; r < N_REPEATS; ++r) {
+			f64 times[5];
+			grow_vector(n, &times[0], &times[2]);
+			grow_seg_vector(n, &times[1], &times[3], &times[4]);
+
+			for (usize i = 0; i < 5; ++i)
+				best[i] = (times[i] < best[i]) ? times[i] : best[i];
+		}
+
+		printf(
+			"%10zu %12.2f %12.2f %12.3f %12.3f %12.3f\n", n, best[0] * 1e9 / n,
+			best[1] * 1e9 / n, best[2] * 1e9 / n, best[3] * 1e9 / n, best[4] * 1e9 / n
+		);
+	}
+}
+
+static bool keep_even(const void *data, TRB_UNUSED void *userdata)
+{
+	return *(const u32 *) data % 2 == 0;
+}
+
+/* Random values, so that the predicate result is unpredictable */
+static void fill_random(TrbVector *vec, usize n)
+{
+	u32 state = 2463534242;
+
+	for (usize i = 0; i < n; ++i) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		trb_vector_push_back(vec, &state);
+	}
+}
+
+static f64 filter_remove(usize n)
+{
+	TrbVector vec;
+	trb_vector_init(&vec, FALSE, sizeof(u32));
+	fill_random(&vec, n);
+
+	f64 start = bench_now();
+
+	for (usize i = 0; i < vec.len;) {
+		if (keep_even(trb_vector_ptr(&vec, u32, i), NULL))
+			i++;
+		else
+			trb_vector_remove(&vec, i, NULL);
+	}
+
+	f64 elapsed = bench_now() - start;
+	trb_vector_destroy(&vec, NULL);
+
+	return elapsed;
+}
+
+static f64 filter_retain(usize n)
+{
+	TrbVector vec;
+	trb_vector_init(&vec, FALSE, sizeof(u32));
+	fill_random(&vec, n);
+
+	f64 start = bench_now();
+	trb_vector_retain(&vec, keep_even, NULL);
+	f64 elapsed = bench_now() - start;
+
+	trb_vector_destroy(&vec, NULL);
+
+	return elapsed;
+}
+
+static void bench_retain(void)
+{
+	bench_header("dropping odd u32 values, ns per element");
+	printf("%10s %14s %14s\n", "n", "remove loop", "retain");
+
+	for (usize n = 1 << 10; n <= 1 << 22; n <<= 2) {
+		f64 remove = 1e30, retain = 1e30;
+
+		for (usize r = 0; r < N_REPEATS; ++r) {
+			/* The remove loop is quadratic */
+			if (n <= 1 << 16) {
+				f64 elapsed = filter_remove(n);
+				remove = (elapsed < remove) ? elapsed : remove;
+			}
+
+			f64 elapsed = filter_retain(n);
+			retain = (elapsed < retain) ? elapsed : retain;
+		}
+
+		if (n <= 1 << 16)
+			printf("%10zu %14.2f %14.2f\n", n, remove * 1e9 / n, retain * 1e9 / n);
+		else
+			printf("%10zu %14s %14.2f\n", n, "-", retain * 1e9 / n);
+	}
+}
+
+/* A snapshot is taken and dropped, while the source vector stays untouched */
+static void bench_snapshot(void)
+{
+	bench_header("u64 vector snapshots, ns per snapshot");
+	printf("%10s %14s %14s %14s\n", "n", "copy", "copy_cow", "first write");
+
+	for (usize n = 1 << 10; n <= 1 << 22; n <<= 2) {
+		TrbVector vec, snap;
+		trb_vector_init(&vec, FALSE, sizeof(u64));
+		trb_vector_push_back_many(&vec, NULL, n);
+
+		usize n_snapshots = (1 << 24) / n;
+		f64 copy = 1e30, cow = 1e30, write = 1e30;
+
+		for (usize r = 0; r < N_REPEATS; ++r) {
+			f64 start = bench_now();
+
+			for (usize i = 0; i < n_snapshots; ++i) {
+				trb_vector_copy(&vec, &snap);
+				bench_keep(trb_vector_get(&snap, u64, i % n));
+				trb_vector_destroy(&snap, NULL);
+			}
+
+			f64 elapsed = (bench_now() - start) / n_snapshots;
+			copy = (elapsed < copy) ? elapsed : copy;
+
+			start = bench_now();
+
+			for (usize i = 0; i < n_snapshots; ++i) {
+				trb_vector_copy_cow(&vec, &snap);
+				bench_keep(trb_vector_get(&snap, u64, i % n));
+				trb_vector_destroy(&snap, NULL);
+			}
+
+			elapsed = (bench_now() - start) / n_snapshots;
+			cow = (elapsed < cow) ? elapsed : cow;
+
+			/* The writer pays for the copy while the snapshot is alive */
+			start = bench_now();
+
+			for (usize i = 0; i < n_snapshots; ++i) {
+				trb_vector_copy_cow(&vec, &snap);
+				trb_vector_unshare(&vec);
+				trb_vector_destroy(&snap, NULL);
+			}
+
+			elapsed = (bench_now() - start) / n_snapshots;
+			write = (elapsed < write) ? elapsed : write;
+		}
+
+		printf("%10zu %14.1f %14.1f %14.1f\n", n, copy * 1e9, cow * 1e9, write * 1e9);
+		trb_vector_destroy(&vec, NULL);
+	}
+}
+
+int main(void)
+{
+	bench_vector();
+	bench_string();
+	bench_typed();
+	bench_emplace();
+	bench_tiny();
+	bench_segmented();
+	bench_retain();
+	bench_snapshot();
+	return 0;
+}
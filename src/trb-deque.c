@@ -461,6 +461,30 @@ bool trb_deque_push_back(TrbDeque *self, const void *data)
 	return __trb_deque_push_back_many(self, data, 1);
 }
 
+void *trb_deque_emplace_back(TrbDeque *self, usize max_len, usize *len)
+{
+	trb_return_val_if_fail(self != NULL, NULL);
+	trb_return_val_if_fail(max_len != 0, NULL);
+	trb_return_val_if_fail(len != NULL, NULL);
+
+	if (trb_chk_add(self->len, 1, NULL) || trb_chk_add(self->offset, self->len + 1, NULL)) {
+		trb_msg_error("deque length overflow!");
+		return NULL;
+	}
+
+	if (__trb_deque_get_buckets_back(self, 1) == FALSE)
+		return NULL;
+
+	usize end = self->offset + self->len;
+	usize elem_index = end % self->bucketcap;
+	void *bucket = trb_vector_get(&self->buckets, void *, end / self->bucketcap);
+
+	*len = trb_min(max_len, self->bucketcap - elem_index);
+	self->len += *len;
+
+	return trb_array_cell(bucket, self->elemsize, elem_index);
+}
+
 bool trb_deque_push_front_many(TrbDeque *self, const void *data, usize len)
 {
 	trb_return_val_if_fail(self != NULL, FALSE);
@@ -806,6 +830,59 @@ bool trb_deque_search_data(const TrbDeque *self, const void *target, TrbCmpDataF
 	return FALSE;
 }
 
+usize trb_deque_retain(TrbDeque *self, TrbPredFunc pred, void *userdata)
+{
+	trb_return_val_if_fail(self != NULL, 0);
+	trb_return_val_if_fail(pred != NULL, 0);
+
+	if (self->len == 0)
+		return 0;
+
+	usize first_len = trb_min(self->len, self->bucketcap - self->offset);
+	usize other_len = self->len - first_len;
+
+	/* The write position trails the read position, both walk the buckets in order */
+	usize dst_bi = 0;
+	usize dst_j = self->offset;
+	char *dst_bucket = trb_vector_get(&self->buckets, void *, 0);
+	usize kept = 0;
+
+	for (usize bi = 0; bi < self->buckets.len; ++bi) {
+		char *bucket = trb_vector_get(&self->buckets, void *, bi);
+
+		usize offset = (bi == 0) ? self->offset : 0;
+		usize len = (bi == 0)
+						? first_len
+					: (bi == self->buckets.len - 1)
+						? (other_len - 1) % self->bucketcap + 1
+						: self->bucketcap;
+
+		for (usize j = offset; j < offset + len; ++j) {
+			char *src = trb_array_cell(bucket, self->elemsize, j);
+
+			if (!pred(src, userdata))
+				continue;
+
+			char *dst = trb_array_cell(dst_bucket, self->elemsize, dst_j);
+
+			if (dst != src)
+				memcpy(dst, src, self->elemsize);
+
+			kept++;
+
+			if (++dst_j == self->bucketcap && kept != self->len) {
+				dst_bucket = trb_vector_get(&self->buckets, void *, ++dst_bi);
+				dst_j = 0;
+			}
+		}
+	}
+
+	usize removed = self->len - kept;
+	__trb_deque_pop_back_many(self, removed, NULL);
+
+	return removed;
+}
+
 static void *__trb_deque_slice_at(const TrbSlice *self, usize index)
 {
 	TrbDeque *deque = self->data;
@@ -850,6 +927,7 @@ TrbSlice *trb_deque_slice(TrbDeque *self, TrbSlice *slice, usize start, usize en
 	slice->start = start;
 	slice->end = end;
 	slice->elemsize = self->elemsize;
+	slice->contiguous = FALSE;
 
 	return slice;
 }
@@ -90,6 +90,26 @@ bool trb_deque_insert(TrbDeque *self, usize index, const void *data);
  **/
 bool trb_deque_push_back_many(TrbDeque *self, const void *data, usize len);
 
+/**
+ * trb_deque_emplace_back:
+ * @self: The deque where to add the elements.
+ * @max_len: The maximum number of elements to be added.
+ * @len: (out): The pointer to retrieve the number of added elements.
+ *
+ * Adds up to @max_len uninitialized elements to the end of the deque
+ * and returns the pointer to them, so they can be written in place.
+ *
+ * The added elements are contiguous, so they never cross the end of the last bucket
+ * and fewer than @max_len elements may be added. At least one element is always added.
+ * Call the function again to get the space for the rest of the elements.
+ *
+ * The pointer is valid until the deque is modified.
+ *
+ * Returns: (nullable): The pointer to the first added element.
+ * Can return %NULL if an error occurs.
+ **/
+void *trb_deque_emplace_back(TrbDeque *self, usize max_len, usize *len);
+
 /**
  * trb_deque_push_front_many:
  * @self: The deque where to add elements.
@@ -226,6 +246,23 @@ bool trb_deque_search(const TrbDeque *self, const void *target, TrbCmpFunc cmp_f
  **/
 bool trb_deque_search_data(const TrbDeque *self, const void *target, TrbCmpDataFunc cmpd_func, void *data, usize *index);
 
+/**
+ * trb_deque_retain:
+ * @self: The deque to be filtered.
+ * @pred: (scope call): The predicate for the elements to be kept.
+ * @userdata: User data.
+ *
+ * Removes all elements for which @pred returns %FALSE, keeping the order of the others.
+ * Unlike removing elements one by one, moves each element at most once
+ * and releases the emptied buckets at the end.
+ *
+ * @pred is called exactly once for each element in order, so it may release
+ * the resources of the elements it drops.
+ *
+ * Returns: The number of removed elements.
+ **/
+usize trb_deque_retain(TrbDeque *self, TrbPredFunc pred, void *userdata);
+
 /**
  * trb_deque_slice:
  * @self: The deque to be sliced.
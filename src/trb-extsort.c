@@ -0,0 +1,506 @@
+#include "trb-extsort.h"
+
+#include "trb-deque.h"
+#include "trb-heap.h"
+#include "trb-macros.h"
+#include "trb-math.h"
+#include "trb-messages.h"
+#include "trb-slice.h"
+#include "trb-utils.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define EXTSORT_BLOCK_SIZE (1 << 20)
+
+typedef struct _TrbExtRun TrbExtRun;
+typedef struct _TrbExtEntry TrbExtEntry;
+typedef struct _TrbExtMerge TrbExtMerge;
+
+struct _TrbExtRun {
+	FILE *file;
+	char *block;
+	usize len;
+	usize pos;
+};
+
+struct _TrbExtEntry {
+	const char *record;
+	usize run;
+};
+
+struct _TrbExtMerge {
+	TrbExtSort *self;
+	TrbExtRun *runs;
+	usize n_runs;
+	char *out;
+	usize block_len;
+};
+
+static inline i32 __trb_extsort_cmp(const TrbExtSort *self, const void *a, const void *b)
+{
+	if (self->with_data)
+		return self->cmpd_func(a, b, self->data);
+
+	return self->cmp_func(a, b);
+}
+
+/* TrbHeap is a max-heap, so the order is reversed to get the smallest record on top */
+static i32 __trb_extsort_entry_cmp(const void *a, const void *b, void *data)
+{
+	const TrbExtEntry *ea = a;
+	const TrbExtEntry *eb = b;
+
+	i32 res = __trb_extsort_cmp(data, ea->record, eb->record);
+
+	if (res == 0)
+		res = (ea->run > eb->run) - (ea->run < eb->run);
+
+	return -res;
+}
+
+static TrbExtSort *__trb_extsort_init(TrbExtSort *self, usize elemsize, usize memory)
+{
+	if (self == NULL) {
+		self = trb_talloc(TrbExtSort, 1);
+
+		if (self == NULL) {
+			trb_msg_error("couldn't allocate memory for the external sort!");
+			return NULL;
+		}
+	}
+
+	self->elemsize = elemsize;
+	self->memory = memory;
+	self->tmpdir = NULL;
+
+	return self;
+}
+
+TrbExtSort *trb_extsort_init(TrbExtSort *self, usize elemsize, usize memory, TrbCmpFunc cmp_func)
+{
+	trb_return_val_if_fail(elemsize != 0, NULL);
+	trb_return_val_if_fail(memory / elemsize >= 3, NULL);
+	trb_return_val_if_fail(cmp_func != NULL, NULL);
+
+	self = __trb_extsort_init(self, elemsize, memory);
+
+	if (self == NULL)
+		return NULL;
+
+	self->cmp_func = cmp_func;
+	self->data = NULL;
+	self->with_data = FALSE;
+
+	return self;
+}
+
+TrbExtSort *trb_extsort_init_data(TrbExtSort *self, usize elemsize, usize memory, TrbCmpDataFunc cmpd_func, void *data)
+{
+	trb_return_val_if_fail(elemsize != 0, NULL);
+	trb_return_val_if_fail(memory / elemsize >= 3, NULL);
+	trb_return_val_if_fail(cmpd_func != NULL, NULL);
+
+	self = __trb_extsort_init(self, elemsize, memory);
+
+	if (self == NULL)
+		return NULL;
+
+	self->cmpd_func = cmpd_func;
+	self->data = data;
+	self->with_data = TRUE;
+
+	return self;
+}
+
+static FILE *__trb_extsort_tmpfile(const TrbExtSort *self)
+{
+	const char *dir = self->tmpdir ?: getenv("TMPDIR") ?: "/tmp";
+	usize dirlen = strlen(dir);
+
+	char *path = malloc(dirlen + sizeof("/tribble-XXXXXX"));
+
+	if (path == NULL) {
+		trb_msg_error("couldn't allocate memory for the temporary file path!");
+		return NULL;
+	}
+
+	memcpy(path, dir, dirlen);
+	memcpy(path + dirlen, "/tribble-XXXXXX", sizeof("/tribble-XXXXXX"));
+
+	int fd = mkstemp(path);
+
+	if (fd == -1) {
+		trb_msg_error("couldn't create a temporary file in '%s': %s", dir, strerror(errno));
+		free(path);
+		return NULL;
+	}
+
+	unlink(path);
+	free(path);
+
+	FILE *file = fdopen(fd, "w+b");
+
+	if (file == NULL) {
+		trb_msg_error("couldn't open a temporary file: %s", strerror(errno));
+		close(fd);
+		return NULL;
+	}
+
+	/* Runs are always read and written in whole blocks */
+	setvbuf(file, NULL, _IONBF, 0);
+
+	return file;
+}
+
+static void __trb_extsort_close_runs(TrbDeque *runs)
+{
+	FILE *file;
+
+	while (runs->len != 0) {
+		trb_deque_pop_front(runs, &file);
+		fclose(file);
+	}
+
+	trb_deque_destroy(runs, NULL);
+}
+
+static bool __trb_extsort_file_write(const void *buffer, usize n_records, void *userdata)
+{
+	TrbExtMerge *merge = userdata;
+	FILE *file = merge->runs[merge->n_runs].file;
+
+	if (fwrite(buffer, merge->self->elemsize, n_records, file) != n_records) {
+		trb_msg_error("couldn't write a run to the temporary file: %s", strerror(errno));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Reads until the buffer is full or the input ends */
+static bool __trb_extsort_fill(
+	TrbExtSortReadFunc read_func,
+	void *read_data,
+	char *buffer,
+	usize elemsize,
+	usize cap,
+	usize *len
+)
+{
+	*len = 0;
+
+	while (*len < cap) {
+		usize n_read = 0;
+
+		if (!read_func(buffer + *len * elemsize, cap - *len, &n_read, read_data))
+			return FALSE;
+
+		if (n_read == 0)
+			break;
+
+		*len += n_read;
+	}
+
+	return TRUE;
+}
+
+static bool __trb_extsort_refill(TrbExtMerge *merge, TrbExtRun *run)
+{
+	usize elemsize = merge->self->elemsize;
+
+	run->len = fread(run->block, elemsize, merge->block_len, run->file);
+	run->pos = 0;
+
+	if (run->len == 0 && ferror(run->file)) {
+		trb_msg_error("couldn't read a run from the temporary file: %s", strerror(errno));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static bool __trb_extsort_merge(TrbExtMerge *merge, TrbExtSortWriteFunc write_func, void *write_data)
+{
+	TrbExtSort *self = merge->self;
+	usize elemsize = self->elemsize;
+
+	TrbHeap heap;
+	if (trb_heap_init_data(&heap, sizeof(TrbExtEntry), __trb_extsort_entry_cmp, self) == NULL)
+		return FALSE;
+
+	bool ok = TRUE;
+
+	for (usize i = 0; i < merge->n_runs; ++i) {
+		TrbExtRun *run = &merge->runs[i];
+		rewind(run->file);
+
+		if (!__trb_extsort_refill(merge, run)) {
+			ok = FALSE;
+			goto out;
+		}
+
+		if (run->len != 0) {
+			TrbExtEntry entry = { run->block, i };
+
+			if (!trb_heap_insert(&heap, &entry)) {
+				ok = FALSE;
+				goto out;
+			}
+		}
+	}
+
+	usize out_len = 0;
+
+	while (heap.vector.len != 0) {
+		TrbExtEntry entry = trb_heap_get(&heap, TrbExtEntry, 0);
+		memcpy(merge->out + out_len * elemsize, entry.record, elemsize);
+
+		if (++out_len == merge->block_len) {
+			if (!write_func(merge->out, out_len, write_data)) {
+				ok = FALSE;
+				goto out;
+			}
+
+			out_len = 0;
+		}
+
+		TrbExtRun *run = &merge->runs[entry.run];
+
+		if (++run->pos == run->len && !__trb_extsort_refill(merge, run)) {
+			ok = FALSE;
+			goto out;
+		}
+
+		if (run->len != 0) {
+			entry.record = run->block + run->pos * elemsize;
+			trb_heap_replace_top(&heap, &entry, NULL);
+		} else
+			trb_heap_pop_front(&heap, NULL);
+	}
+
+	if (out_len != 0)
+		ok = write_func(merge->out, out_len, write_data);
+
+out:
+	trb_heap_destroy(&heap, NULL);
+	return ok;
+}
+
+/* Splits the buffer into a block for each run and one for the output */
+static void __trb_extsort_merge_init(TrbExtMerge *merge, TrbExtSort *self, TrbExtRun *runs, char *buffer, usize cap, usize n_runs)
+{
+	merge->self = self;
+	merge->runs = runs;
+	merge->n_runs = n_runs;
+	merge->block_len = cap / (n_runs + 1);
+
+	for (usize i = 0; i < n_runs; ++i)
+		runs[i].block = buffer + i * merge->block_len * self->elemsize;
+
+	merge->out = buffer + n_runs * merge->block_len * self->elemsize;
+}
+
+static bool __trb_extsort_spill(TrbExtSort *self, TrbDeque *runs, char *buffer, usize len)
+{
+	FILE *file = __trb_extsort_tmpfile(self);
+
+	if (file == NULL)
+		return FALSE;
+
+	if (fwrite(buffer, self->elemsize, len, file) != len) {
+		trb_msg_error("couldn't write a run to the temporary file: %s", strerror(errno));
+		fclose(file);
+		return FALSE;
+	}
+
+	if (!trb_deque_push_back(runs, &file)) {
+		fclose(file);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void __trb_extsort_sort_buffer(TrbExtSort *self, char *buffer, usize len)
+{
+	if (len <= 1)
+		return;
+
+	TrbSlice slice;
+	trb_slice_init(&slice, buffer, self->elemsize, 0, len);
+
+	if (self->with_data)
+		trb_quicksort_data(&slice, self->cmpd_func, self->data);
+	else
+		trb_quicksort(&slice, self->cmp_func);
+}
+
+bool trb_extsort_sort(
+	TrbExtSort *self,
+	TrbExtSortReadFunc read_func,
+	void *read_data,
+	TrbExtSortWriteFunc write_func,
+	void *write_data
+)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	trb_return_val_if_fail(read_func != NULL, FALSE);
+	trb_return_val_if_fail(write_func != NULL, FALSE);
+
+	usize elemsize = self->elemsize;
+	usize cap = self->memory / elemsize;
+
+	char *buffer = malloc(cap * elemsize);
+
+	if (buffer == NULL) {
+		trb_msg_error("couldn't allocate memory for the external sort!");
+		return FALSE;
+	}
+
+	TrbDeque runs;
+	if (trb_deque_init(&runs, FALSE, sizeof(FILE *)) == NULL) {
+		free(buffer);
+		return FALSE;
+	}
+
+	bool ok = FALSE;
+	TrbExtRun *merge_runs = NULL;
+
+	while (TRUE) {
+		usize len;
+
+		if (!__trb_extsort_fill(read_func, read_data, buffer, elemsize, cap, &len))
+			goto out;
+
+		__trb_extsort_sort_buffer(self, buffer, len);
+
+		/* Everything fits into memory */
+		if (runs.len == 0 && len < cap) {
+			ok = len == 0 || write_func(buffer, len, write_data);
+			goto out;
+		}
+
+		if (len != 0 && !__trb_extsort_spill(self, &runs, buffer, len))
+			goto out;
+
+		if (len < cap)
+			break;
+	}
+
+	/* Each block should be large enough for sequential I/O, but at least one record */
+	usize max_runs = trb_max(self->memory / EXTSORT_BLOCK_SIZE, 3) - 1;
+	max_runs = trb_min(max_runs, cap - 1);
+
+	usize n_merge_runs = trb_min(max_runs, runs.len) + 1;
+	merge_runs = trb_talloc(TrbExtRun, n_merge_runs);
+
+	if (merge_runs == NULL) {
+		trb_msg_error("couldn't allocate memory for the runs!");
+		goto out;
+	}
+
+	while (runs.len > max_runs) {
+		TrbExtMerge merge;
+		__trb_extsort_merge_init(&merge, self, merge_runs, buffer, cap, max_runs);
+
+		/* The output run is stored right after the input ones */
+		merge_runs[max_runs].file = __trb_extsort_tmpfile(self);
+
+		if (merge_runs[max_runs].file == NULL)
+			goto out;
+
+		for (usize i = 0; i < max_runs; ++i)
+			trb_deque_pop_front(&runs, &merge_runs[i].file);
+
+		bool merged = __trb_extsort_merge(&merge, __trb_extsort_file_write, &merge);
+
+		for (usize i = 0; i < max_runs; ++i)
+			fclose(merge_runs[i].file);
+
+		if (!merged || !trb_deque_push_back(&runs, &merge_runs[max_runs].file)) {
+			fclose(merge_runs[max_runs].file);
+			goto out;
+		}
+	}
+
+	TrbExtMerge merge;
+	usize n_runs = runs.len;
+	__trb_extsort_merge_init(&merge, self, merge_runs, buffer, cap, n_runs);
+
+	for (usize i = 0; i < n_runs; ++i)
+		merge_runs[i].file = *trb_deque_ptr(&runs, FILE *, i);
+
+	ok = __trb_extsort_merge(&merge, write_func, write_data);
+
+out:
+	free(merge_runs);
+	__trb_extsort_close_runs(&runs);
+	free(buffer);
+
+	return ok;
+}
+
+static bool __trb_extsort_fread(void *buffer, usize n_records, usize *n_read, void *userdata)
+{
+	TrbExtSort *self = ((void **) userdata)[0];
+	FILE *file = ((void **) userdata)[1];
+
+	usize size = n_records * self->elemsize;
+	usize got = fread(buffer, 1, size, file);
+
+	if (got < size && ferror(file)) {
+		trb_msg_error("couldn't read the input: %s", strerror(errno));
+		return FALSE;
+	}
+
+	if (got % self->elemsize != 0) {
+		trb_msg_error("the input ends with a partial record!");
+		return FALSE;
+	}
+
+	*n_read = got / self->elemsize;
+
+	return TRUE;
+}
+
+static bool __trb_extsort_fwrite(const void *buffer, usize n_records, void *userdata)
+{
+	TrbExtSort *self = ((void **) userdata)[0];
+	FILE *file = ((void **) userdata)[1];
+
+	if (fwrite(buffer, self->elemsize, n_records, file) != n_records) {
+		trb_msg_error("couldn't write the output: %s", strerror(errno));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+bool trb_extsort_sort_file(TrbExtSort *self, FILE *input, FILE *output)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	trb_return_val_if_fail(input != NULL, FALSE);
+	trb_return_val_if_fail(output != NULL, FALSE);
+
+	void *read_data[2] = { self, input };
+	void *write_data[2] = { self, output };
+
+	if (!trb_extsort_sort(self, __trb_extsort_fread, read_data, __trb_extsort_fwrite, write_data))
+		return FALSE;
+
+	if (fflush(output) != 0) {
+		trb_msg_error("couldn't write the output: %s", strerror(errno));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+void trb_extsort_free(TrbExtSort *self)
+{
+	trb_return_if_fail(self != NULL);
+	free(self);
+}
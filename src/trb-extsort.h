@@ -0,0 +1,140 @@
+#ifndef EXTSORT_H_R7XK2MQD
+#define EXTSORT_H_R7XK2MQD
+
+#include "trb-types.h"
+
+#include <stdio.h>
+
+typedef struct _TrbExtSort TrbExtSort;
+
+/**
+ * TrbExtSortReadFunc:
+ * @buffer: The buffer to be filled with records.
+ * @n_records: The maximum number of records to be read.
+ * @n_read: (out): The number of records that have been read. Zero means the end of the input.
+ * @userdata: User data.
+ *
+ * Specifies the type of the function that supplies records to trb_extsort_sort().
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ **/
+typedef bool (*TrbExtSortReadFunc)(void *buffer, usize n_records, usize *n_read, void *userdata);
+
+/**
+ * TrbExtSortWriteFunc:
+ * @buffer: The sorted records.
+ * @n_records: The number of records in @buffer.
+ * @userdata: User data.
+ *
+ * Specifies the type of the function that receives the sorted records from trb_extsort_sort().
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ **/
+typedef bool (*TrbExtSortWriteFunc)(const void *buffer, usize n_records, void *userdata);
+
+/**
+ * TrbExtSort:
+ * @cmp_func: The function for comparing records.
+ * @cmpd_func: The function for comparing records using user data.
+ * @data: User data.
+ * @with_data: Indicates whether #TrbExtSort has been initialized with data or not.
+ * @elemsize: The size of each record in bytes.
+ * @memory: The memory budget in bytes.
+ * @tmpdir: (nullable): The directory for temporary files.
+ * If %NULL, `TMPDIR` or `/tmp` is used.
+ *
+ * An external merge sort for fixed-size records that don't fit into memory.
+ *
+ * The input is read in chunks of @memory bytes, each chunk is sorted
+ * with trb_quicksort() and spilled to a temporary file as a sorted run.
+ * The runs are then merged with a #TrbHeap, reading each run in large sequential blocks.
+ * If there are too many runs for the blocks to be large, the runs are merged in several passes.
+ * Temporary files are unlinked right after they are created,
+ * so they are removed even if the process dies.
+ *
+ * The sort is not stable.
+ **/
+struct _TrbExtSort {
+	/* <public> */
+	union {
+		TrbCmpFunc cmp_func;
+		TrbCmpDataFunc cmpd_func;
+	};
+
+	void *data;
+	bool with_data;
+	usize elemsize;
+	usize memory;
+	const char *tmpdir;
+};
+
+/**
+ * trb_extsort_init:
+ * @self: (nullable): The pointer to the #TrbExtSort to be initialized.
+ * @elemsize: The size of each record in bytes.
+ * @memory: The memory budget in bytes. Must be at least three records.
+ * @cmp_func: The function for comparing records.
+ *
+ * Creates a new #TrbExtSort.
+ *
+ * Returns: A new #TrbExtSort. Can return %NULL if an error occurs.
+ **/
+TrbExtSort *trb_extsort_init(TrbExtSort *self, usize elemsize, usize memory, TrbCmpFunc cmp_func);
+
+/**
+ * trb_extsort_init_data:
+ * @self: (nullable): The pointer to the #TrbExtSort to be initialized.
+ * @elemsize: The size of each record in bytes.
+ * @memory: The memory budget in bytes. Must be at least three records.
+ * @cmpd_func: The function for comparing records.
+ * @data: User data.
+ *
+ * Creates a new #TrbExtSort with the comparison function that accepts user data.
+ *
+ * Returns: A new #TrbExtSort. Can return %NULL if an error occurs.
+ **/
+TrbExtSort *trb_extsort_init_data(TrbExtSort *self, usize elemsize, usize memory, TrbCmpDataFunc cmpd_func, void *data);
+
+/**
+ * trb_extsort_sort:
+ * @self: The #TrbExtSort.
+ * @read_func: (scope call): The function that supplies the records.
+ * @read_data: User data for @read_func.
+ * @write_func: (scope call): The function that receives the sorted records.
+ * @write_data: User data for @write_func.
+ *
+ * Reads all records with @read_func and passes them to @write_func in sorted order.
+ * At most @memory bytes are used for the records.
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ **/
+bool trb_extsort_sort(
+	TrbExtSort *self,
+	TrbExtSortReadFunc read_func,
+	void *read_data,
+	TrbExtSortWriteFunc write_func,
+	void *write_data
+);
+
+/**
+ * trb_extsort_sort_file:
+ * @self: The #TrbExtSort.
+ * @input: The file to read the records from.
+ * @output: The file to write the sorted records to.
+ *
+ * Sorts the records read from @input and writes them to @output.
+ * A trailing partial record in @input is an error.
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ **/
+bool trb_extsort_sort_file(TrbExtSort *self, FILE *input, FILE *output);
+
+/**
+ * trb_extsort_free:
+ * @self: The #TrbExtSort to be freed.
+ *
+ * Frees the heap-allocated #TrbExtSort.
+ **/
+void trb_extsort_free(TrbExtSort *self);
+
+#endif /* end of include guard: EXTSORT_H_R7XK2MQD */
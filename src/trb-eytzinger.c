@@ -0,0 +1,208 @@
+#include "trb-eytzinger.h"
+
+#include "trb-checked.h"
+#include "trb-macros.h"
+#include "trb-math.h"
+#include "trb-messages.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define EYTZINGER_ALIGN 64
+#define EYTZINGER_PREFETCH 16
+#define EYTZINGER_BATCH 16
+
+static inline i32 __trb_eytzinger_cmp(const TrbEytzinger *self, const void *a, const void *b)
+{
+	if (self->with_data)
+		return self->cmpd_func(a, b, self->data);
+
+	return self->cmp_func(a, b);
+}
+
+static inline const char *__trb_eytzinger_at(const TrbEytzinger *self, usize k)
+{
+	return (const char *) self->tree + k * self->elemsize;
+}
+
+/* Fills the subtree rooted at k with the elements of the slice in order */
+static void __trb_eytzinger_build(TrbEytzinger *self, const TrbSlice *sorted, usize *i, usize k)
+{
+	if (k > self->len)
+		return;
+
+	__trb_eytzinger_build(self, sorted, i, 2 * k);
+	trb_memcopy((char *) self->tree + k * self->elemsize, sorted->at(sorted, (*i)++), self->elemsize);
+	__trb_eytzinger_build(self, sorted, i, 2 * k + 1);
+}
+
+static TrbEytzinger *__trb_eytzinger_init(TrbEytzinger *self, const TrbSlice *sorted)
+{
+	bool was_allocated = FALSE;
+
+	if (self == NULL) {
+		self = trb_talloc(TrbEytzinger, 1);
+
+		if (self == NULL) {
+			trb_msg_error("couldn't allocate memory for the eytzinger tree!");
+			return NULL;
+		}
+
+		was_allocated = TRUE;
+	}
+
+	usize len = trb_slice_len(sorted);
+	usize size;
+
+	/* Position 0 is unused, the tree is 1-based */
+	if (trb_chk_mul(len + 1, sorted->elemsize, &size) || trb_chk_add(size, EYTZINGER_ALIGN - 1, &size)) {
+		trb_msg_error("the eytzinger tree is too large!");
+
+		if (was_allocated)
+			free(self);
+
+		return NULL;
+	}
+
+	self->tree = aligned_alloc(EYTZINGER_ALIGN, size / EYTZINGER_ALIGN * EYTZINGER_ALIGN);
+
+	if (self->tree == NULL) {
+		trb_msg_error("couldn't allocate memory for the eytzinger tree!");
+
+		if (was_allocated)
+			free(self);
+
+		return NULL;
+	}
+
+	self->len = len;
+	self->elemsize = sorted->elemsize;
+
+	usize i = 0;
+	__trb_eytzinger_build(self, sorted, &i, 1);
+
+	return self;
+}
+
+TrbEytzinger *trb_eytzinger_init(TrbEytzinger *self, const TrbSlice *sorted, TrbCmpFunc cmp_func)
+{
+	trb_return_val_if_fail(sorted != NULL, NULL);
+	trb_return_val_if_fail(cmp_func != NULL, NULL);
+
+	self = __trb_eytzinger_init(self, sorted);
+
+	if (self == NULL)
+		return NULL;
+
+	self->cmp_func = cmp_func;
+	self->data = NULL;
+	self->with_data = FALSE;
+
+	return self;
+}
+
+TrbEytzinger *trb_eytzinger_init_data(TrbEytzinger *self, const TrbSlice *sorted, TrbCmpDataFunc cmpd_func, void *data)
+{
+	trb_return_val_if_fail(sorted != NULL, NULL);
+	trb_return_val_if_fail(cmpd_func != NULL, NULL);
+
+	self = __trb_eytzinger_init(self, sorted);
+
+	if (self == NULL)
+		return NULL;
+
+	self->cmpd_func = cmpd_func;
+	self->data = data;
+	self->with_data = TRUE;
+
+	return self;
+}
+
+/* Going right on every step sets the low bits of k: they and the last left turn are dropped */
+static inline const void *__trb_eytzinger_result(const TrbEytzinger *self, usize k)
+{
+	k >>= __builtin_ctzll(~(unsigned long long) k) + 1;
+
+	if (k == 0)
+		return NULL;
+
+	return __trb_eytzinger_at(self, k);
+}
+
+const void *trb_eytzinger_lower_bound(const TrbEytzinger *self, const void *target)
+{
+	trb_return_val_if_fail(self != NULL, NULL);
+
+	usize k = 1;
+
+	while (k <= self->len) {
+		__builtin_prefetch(__trb_eytzinger_at(self, k * EYTZINGER_PREFETCH));
+		k = 2 * k + (__trb_eytzinger_cmp(self, __trb_eytzinger_at(self, k), target) < 0);
+	}
+
+	return __trb_eytzinger_result(self, k);
+}
+
+void trb_eytzinger_lower_bound_many(const TrbEytzinger *self, const void *targets, usize n_targets, const void **results)
+{
+	trb_return_if_fail(self != NULL);
+	trb_return_if_fail(targets != NULL || n_targets == 0);
+	trb_return_if_fail(results != NULL || n_targets == 0);
+
+	const char *target = targets;
+	usize depth = (self->len == 0) ? 0 : USIZE_WIDTH - trb_clz(self->len);
+
+	for (usize start = 0; start < n_targets; start += EYTZINGER_BATCH) {
+		usize batch = trb_min(EYTZINGER_BATCH, n_targets - start);
+		usize ks[EYTZINGER_BATCH];
+
+		for (usize j = 0; j < batch; ++j)
+			ks[j] = 1;
+
+		for (usize level = 0; level < depth; ++level) {
+			for (usize j = 0; j < batch; ++j) {
+				usize k = ks[j];
+
+				if (k > self->len)
+					continue;
+
+				__builtin_prefetch(__trb_eytzinger_at(self, k * EYTZINGER_PREFETCH));
+
+				const void *key = target + (start + j) * self->elemsize;
+				ks[j] = 2 * k + (__trb_eytzinger_cmp(self, __trb_eytzinger_at(self, k), key) < 0);
+			}
+		}
+
+		for (usize j = 0; j < batch; ++j)
+			results[start + j] = __trb_eytzinger_result(self, ks[j]);
+	}
+}
+
+const void *trb_eytzinger_search(const TrbEytzinger *self, const void *target)
+{
+	trb_return_val_if_fail(self != NULL, NULL);
+
+	const void *found = trb_eytzinger_lower_bound(self, target);
+
+	if (found == NULL || __trb_eytzinger_cmp(self, found, target) != 0)
+		return NULL;
+
+	return found;
+}
+
+void trb_eytzinger_destroy(TrbEytzinger *self)
+{
+	trb_return_if_fail(self != NULL);
+
+	free(self->tree);
+	self->tree = NULL;
+	self->len = 0;
+}
+
+void trb_eytzinger_free(TrbEytzinger *self)
+{
+	trb_return_if_fail(self != NULL);
+
+	trb_eytzinger_destroy(self);
+	free(self);
+}
@@ -0,0 +1,122 @@
+#ifndef EYTZINGER_H_W4NCJ7PB
+#define EYTZINGER_H_W4NCJ7PB
+
+#include "trb-slice.h"
+#include "trb-types.h"
+
+typedef struct _TrbEytzinger TrbEytzinger;
+
+/**
+ * TrbEytzinger:
+ * @cmp_func: The function for comparing elements.
+ * @cmpd_func: The function for comparing elements using user data.
+ * @data: User data.
+ * @with_data: Indicates whether #TrbEytzinger has been initialized with data or not.
+ * @len: The number of elements.
+ * @elemsize: The size of each element.
+ *
+ * A read-only copy of a sorted array stored in Eytzinger (BFS) order:
+ * the children of the element at 1-based position k are at 2k and 2k + 1.
+ *
+ * Searches touch the top levels of the implicit tree on every lookup, so they stay in cache.
+ * Each step prefetches position 16k, the start of the block of descendants four levels down.
+ * The whole block fits in one 64-byte cache line only for elements of 4 bytes or less;
+ * for larger elements the prefetch covers only its beginning.
+ * This makes lookups in arrays much larger than the cache several times faster
+ * than binary search.
+ **/
+struct _TrbEytzinger {
+	/* <private> */
+	void *tree;
+
+	/* <public> */
+	union {
+		TrbCmpFunc cmp_func;
+		TrbCmpDataFunc cmpd_func;
+	};
+
+	void *data;
+	bool with_data;
+	usize len;
+	usize elemsize;
+};
+
+/**
+ * trb_eytzinger_init:
+ * @self: (nullable): The pointer to the #TrbEytzinger to be initialized.
+ * @sorted: The sorted slice to be copied.
+ * @cmp_func: The function for comparing elements.
+ *
+ * Creates a new #TrbEytzinger from the sorted slice.
+ *
+ * Returns: A new #TrbEytzinger. Can return %NULL if an error occurs.
+ **/
+TrbEytzinger *trb_eytzinger_init(TrbEytzinger *self, const TrbSlice *sorted, TrbCmpFunc cmp_func);
+
+/**
+ * trb_eytzinger_init_data:
+ * @self: (nullable): The pointer to the #TrbEytzinger to be initialized.
+ * @sorted: The sorted slice to be copied.
+ * @cmpd_func: The function for comparing elements.
+ * @data: User data.
+ *
+ * Creates a new #TrbEytzinger from the sorted slice with the comparison function
+ * that accepts user data.
+ *
+ * Returns: A new #TrbEytzinger. Can return %NULL if an error occurs.
+ **/
+TrbEytzinger *trb_eytzinger_init_data(TrbEytzinger *self, const TrbSlice *sorted, TrbCmpDataFunc cmpd_func, void *data);
+
+/**
+ * trb_eytzinger_lower_bound:
+ * @self: The #TrbEytzinger to be searched.
+ * @target: The pointer to the data to be found.
+ *
+ * Finds the first element in sorted order that is not less than @target.
+ *
+ * Returns: (nullable): The pointer to the element,
+ * or %NULL if all elements are less than @target.
+ **/
+const void *trb_eytzinger_lower_bound(const TrbEytzinger *self, const void *target);
+
+/**
+ * trb_eytzinger_lower_bound_many:
+ * @self: The #TrbEytzinger to be searched.
+ * @targets: The array of @n_targets elements to be found.
+ * @n_targets: The number of elements to be found.
+ * @results: (out): The array of @n_targets pointers where to store the results.
+ *
+ * Does trb_eytzinger_lower_bound() for every element of @targets.
+ * The searches advance through the tree in lockstep, so cache misses
+ * of independent searches overlap instead of being paid one after another.
+ **/
+void trb_eytzinger_lower_bound_many(const TrbEytzinger *self, const void *targets, usize n_targets, const void **results);
+
+/**
+ * trb_eytzinger_search:
+ * @self: The #TrbEytzinger to be searched.
+ * @target: The pointer to the data to be found.
+ *
+ * Searches for the element equal to @target.
+ *
+ * Returns: (nullable): The pointer to the element, or %NULL if not found.
+ **/
+const void *trb_eytzinger_search(const TrbEytzinger *self, const void *target);
+
+/**
+ * trb_eytzinger_destroy:
+ * @self: The #TrbEytzinger which buffer is to be freed.
+ *
+ * Frees the buffer of the #TrbEytzinger.
+ **/
+void trb_eytzinger_destroy(TrbEytzinger *self);
+
+/**
+ * trb_eytzinger_free:
+ * @self: The #TrbEytzinger to be freed.
+ *
+ * Frees the #TrbEytzinger completely.
+ **/
+void trb_eytzinger_free(TrbEytzinger *self);
+
+#endif /* end of include guard: EYTZINGER_H_W4NCJ7PB */
@@ -0,0 +1,450 @@
+#include "trb-flat-map.h"
+
+#include "trb-checked.h"
+#include "trb-macros.h"
+#include "trb-math.h"
+#include "trb-messages.h"
+#include "trb-utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define FLAT_MAP_MAX_ALIGN 16
+
+/* The alignment of a field is assumed to be the largest power of two that divides its size */
+static usize __trb_flat_map_align(usize size)
+{
+	if (size == 0)
+		return 1;
+
+	usize align = size & -size;
+
+	return (align < FLAT_MAP_MAX_ALIGN) ? align : FLAT_MAP_MAX_ALIGN;
+}
+
+static bool __trb_flat_map_layout(TrbFlatMap *self, usize keysize, usize valuesize)
+{
+	usize key_align = __trb_flat_map_align(keysize);
+	usize value_align = __trb_flat_map_align(valuesize);
+	usize entry_align = trb_max(key_align, value_align);
+
+	usize valueoffset, entrysize;
+
+	if (
+		trb_chk_add(keysize, value_align - 1, &valueoffset) ||
+		trb_chk_add(valueoffset & ~(value_align - 1), valuesize, &entrysize) ||
+		trb_chk_add(entrysize, entry_align - 1, &entrysize)
+	) {
+		trb_msg_error("entry size overflow!");
+		return FALSE;
+	}
+
+	self->keysize = keysize;
+	self->valuesize = valuesize;
+	self->valueoffset = valueoffset & ~(value_align - 1);
+	self->entrysize = entrysize & ~(entry_align - 1);
+
+	return TRUE;
+}
+
+static TrbFlatMap *__trb_flat_map_init(TrbFlatMap *self, usize keysize, usize valuesize)
+{
+	trb_return_val_if_fail(keysize != 0, NULL);
+
+	TrbFlatMap layout;
+
+	if (!__trb_flat_map_layout(&layout, keysize, valuesize))
+		return NULL;
+
+	bool was_allocated = FALSE;
+
+	if (self == NULL) {
+		self = trb_talloc(TrbFlatMap, 1);
+
+		if (self == NULL) {
+			trb_msg_error("couldn't allocate memory for the flat map!");
+			return NULL;
+		}
+
+		was_allocated = TRUE;
+	}
+
+	if (trb_vector_init(&self->entries, FALSE, layout.entrysize) == NULL) {
+		if (was_allocated)
+			free(self);
+
+		trb_msg_error("couldn't allocate memory for the flat map entries!");
+		return NULL;
+	}
+
+	self->len = 0;
+	self->keysize = layout.keysize;
+	self->valuesize = layout.valuesize;
+	self->entrysize = layout.entrysize;
+	self->valueoffset = layout.valueoffset;
+
+	return self;
+}
+
+TrbFlatMap *trb_flat_map_init(TrbFlatMap *self, usize keysize, usize valuesize, TrbCmpFunc cmp_func)
+{
+	trb_return_val_if_fail(cmp_func != NULL, NULL);
+
+	self = __trb_flat_map_init(self, keysize, valuesize);
+
+	if (self == NULL)
+		return NULL;
+
+	self->cmp_func = cmp_func;
+	self->data = NULL;
+	self->with_data = FALSE;
+
+	return self;
+}
+
+TrbFlatMap *trb_flat_map_init_data(TrbFlatMap *self, usize keysize, usize valuesize, TrbCmpDataFunc cmpd_func, void *data)
+{
+	trb_return_val_if_fail(cmpd_func != NULL, NULL);
+
+	self = __trb_flat_map_init(self, keysize, valuesize);
+
+	if (self == NULL)
+		return NULL;
+
+	self->cmpd_func = cmpd_func;
+	self->data = data;
+	self->with_data = TRUE;
+
+	return self;
+}
+
+static inline i32 __trb_flat_map_cmp(const TrbFlatMap *self, const void *a, const void *b)
+{
+	if (self->with_data)
+		return self->cmpd_func(a, b, self->data);
+
+	return self->cmp_func(a, b);
+}
+
+static usize __trb_flat_map_bound(const TrbFlatMap *self, const void *key, bool upper)
+{
+	if (self->len == 0)
+		return 0;
+
+	TrbSlice slice;
+	trb_vector_slice_const(&self->entries, &slice, 0, self->len);
+
+	if (self->with_data) {
+		if (upper)
+			return trb_upper_bound_data(&slice, key, self->cmpd_func, self->data);
+
+		return trb_lower_bound_data(&slice, key, self->cmpd_func, self->data);
+	}
+
+	if (upper)
+		return trb_upper_bound(&slice, key, self->cmp_func);
+
+	return trb_lower_bound(&slice, key, self->cmp_func);
+}
+
+static bool __trb_flat_map_find(const TrbFlatMap *self, const void *key, usize *index)
+{
+	*index = __trb_flat_map_bound(self, key, FALSE);
+
+	return *index < self->len && __trb_flat_map_cmp(self, trb_flat_map_key(self, *index), key) == 0;
+}
+
+static void __trb_flat_map_set_value(TrbFlatMap *self, char *entry, const void *value)
+{
+	if (value == NULL)
+		memset(entry + self->valueoffset, 0, self->valuesize);
+	else
+		memcpy(entry + self->valueoffset, value, self->valuesize);
+}
+
+static bool __trb_flat_map_insert(TrbFlatMap *self, const void *key, const void *value, bool replace)
+{
+	usize index;
+
+	if (__trb_flat_map_find(self, key, &index)) {
+		if (!replace || !trb_vector_unshare(&self->entries))
+			return FALSE;
+
+		__trb_flat_map_set_value(self, trb_flat_map_key(self, index), value);
+		return TRUE;
+	}
+
+	char *entry = trb_vector_emplace_at(&self->entries, index, 1);
+
+	if (entry == NULL)
+		return FALSE;
+
+	memcpy(entry, key, self->keysize);
+	__trb_flat_map_set_value(self, entry, value);
+
+	self->len = self->entries.len;
+
+	return TRUE;
+}
+
+bool trb_flat_map_add(TrbFlatMap *self, const void *key, const void *value)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	trb_return_val_if_fail(key != NULL, FALSE);
+
+	return __trb_flat_map_insert(self, key, value, FALSE);
+}
+
+bool trb_flat_map_insert(TrbFlatMap *self, const void *key, const void *value)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	trb_return_val_if_fail(key != NULL, FALSE);
+
+	return __trb_flat_map_insert(self, key, value, TRUE);
+}
+
+/* Packs the batch into @batch, sorts it and keeps the last entry of each run of equal keys */
+static bool __trb_flat_map_sort_batch(
+	const TrbFlatMap *self,
+	char *batch,
+	const void *keys,
+	const void *values,
+	usize len,
+	usize *n_unique
+)
+{
+	usize entrysize = self->entrysize;
+
+	for (usize i = 0; i < len; ++i) {
+		char *entry = &batch[i * entrysize];
+		memcpy(entry, &((const char *) keys)[i * self->keysize], self->keysize);
+
+		if (values == NULL)
+			memset(entry + self->valueoffset, 0, self->valuesize);
+		else
+			memcpy(entry + self->valueoffset, &((const char *) values)[i * self->valuesize], self->valuesize);
+	}
+
+	TrbSlice slice;
+	trb_slice_init(&slice, batch, entrysize, 0, len);
+
+	bool sorted = (self->with_data)
+					  ? trb_stablesort_data(&slice, self->cmpd_func, self->data, NULL)
+					  : trb_stablesort(&slice, self->cmp_func, NULL);
+
+	if (!sorted)
+		return FALSE;
+
+	usize kept = 0;
+
+	for (usize i = 0; i < len; ++i) {
+		char *src = &batch[i * entrysize];
+
+		if (kept != 0 && __trb_flat_map_cmp(self, &batch[(kept - 1) * entrysize], src) == 0) {
+			memcpy(&batch[(kept - 1) * entrysize], src, entrysize);
+			continue;
+		}
+
+		if (kept != i)
+			memcpy(&batch[kept * entrysize], src, entrysize);
+
+		kept++;
+	}
+
+	*n_unique = kept;
+
+	return TRUE;
+}
+
+bool trb_flat_map_insert_many(TrbFlatMap *self, const void *keys, const void *values, usize len)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	trb_return_val_if_fail(keys != NULL || len == 0, FALSE);
+
+	if (len == 0)
+		return TRUE;
+
+	usize entrysize = self->entrysize;
+
+	if (trb_chk_mul(len, entrysize, NULL)) {
+		trb_msg_error("batch size overflow!");
+		return FALSE;
+	}
+
+	char *batch = malloc(len * entrysize);
+
+	if (batch == NULL) {
+		trb_msg_error("couldn't allocate memory for the batch!");
+		return FALSE;
+	}
+
+	usize m;
+
+	if (!__trb_flat_map_sort_batch(self, batch, keys, values, len, &m) || trb_vector_emplace_back(&self->entries, m) == NULL) {
+		free(batch);
+		return FALSE;
+	}
+
+	char *base = trb_flat_map_key(self, 0);
+	usize i = self->len;
+	usize j = m;
+	usize k = self->len + m;
+
+	/* Merging from the end writes every entry to its final place at most once */
+	while (j > 0) {
+		char *src = &batch[(j - 1) * entrysize];
+
+		if (i > 0) {
+			char *entry = &base[(i - 1) * entrysize];
+			i32 cmp = __trb_flat_map_cmp(self, entry, src);
+
+			if (cmp > 0) {
+				memcpy(&base[--k * entrysize], entry, entrysize);
+				i--;
+				continue;
+			}
+
+			/* The batch entry replaces the existing one */
+			if (cmp == 0)
+				i--;
+		}
+
+		memcpy(&base[--k * entrysize], src, entrysize);
+		j--;
+	}
+
+	/* Each replaced entry leaves a hole between the untouched prefix and the merged tail */
+	if (k != i) {
+		memmove(&base[i * entrysize], &base[k * entrysize], (self->len + m - k) * entrysize);
+		trb_vector_pop_back_many(&self->entries, k - i, NULL);
+	}
+
+	self->len = self->entries.len;
+	free(batch);
+
+	return TRUE;
+}
+
+bool trb_flat_map_build_from_unsorted(TrbFlatMap *self, const void *keys, const void *values, usize len)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	trb_return_val_if_fail(keys != NULL || len == 0, FALSE);
+
+	usize n = self->len;
+
+	if (len == 0) {
+		trb_vector_pop_back_many(&self->entries, n, NULL);
+		self->len = 0;
+		return TRUE;
+	}
+
+	/* The batch is sorted right after the old entries, which are then dropped from the front */
+	char *batch = trb_vector_emplace_back(&self->entries, len);
+
+	if (batch == NULL)
+		return FALSE;
+
+	usize m;
+
+	if (!__trb_flat_map_sort_batch(self, batch, keys, values, len, &m)) {
+		trb_vector_pop_back_many(&self->entries, len, NULL);
+		return FALSE;
+	}
+
+	trb_vector_pop_back_many(&self->entries, len - m, NULL);
+	trb_vector_remove_range(&self->entries, 0, n, NULL);
+
+	self->len = self->entries.len;
+
+	return TRUE;
+}
+
+bool trb_flat_map_remove(TrbFlatMap *self, const void *key, void *ret)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	trb_return_val_if_fail(key != NULL, FALSE);
+
+	usize index;
+
+	if (!__trb_flat_map_find(self, key, &index))
+		return FALSE;
+
+	if (ret != NULL)
+		memcpy(ret, trb_flat_map_value(self, index), self->valuesize);
+
+	trb_vector_remove(&self->entries, index, NULL);
+	self->len = self->entries.len;
+
+	return TRUE;
+}
+
+bool trb_flat_map_lookup(const TrbFlatMap *self, const void *key, void *ret)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	trb_return_val_if_fail(key != NULL, FALSE);
+
+	usize index;
+
+	if (!__trb_flat_map_find(self, key, &index))
+		return FALSE;
+
+	if (ret != NULL)
+		memcpy(ret, trb_flat_map_value(self, index), self->valuesize);
+
+	return TRUE;
+}
+
+usize trb_flat_map_lower_bound(const TrbFlatMap *self, const void *key)
+{
+	trb_return_val_if_fail(self != NULL, 0);
+	trb_return_val_if_fail(key != NULL, 0);
+
+	return __trb_flat_map_bound(self, key, FALSE);
+}
+
+usize trb_flat_map_upper_bound(const TrbFlatMap *self, const void *key)
+{
+	trb_return_val_if_fail(self != NULL, 0);
+	trb_return_val_if_fail(key != NULL, 0);
+
+	return __trb_flat_map_bound(self, key, TRUE);
+}
+
+usize trb_flat_map_range(const TrbFlatMap *self, const void *lo, const void *hi, usize *start)
+{
+	trb_return_val_if_fail(self != NULL, 0);
+	trb_return_val_if_fail(lo != NULL, 0);
+	trb_return_val_if_fail(hi != NULL, 0);
+	trb_return_val_if_fail(start != NULL, 0);
+
+	usize first = __trb_flat_map_bound(self, lo, FALSE);
+	usize last = __trb_flat_map_bound(self, hi, FALSE);
+
+	*start = first;
+
+	return (last > first) ? last - first : 0;
+}
+
+void trb_flat_map_destroy(TrbFlatMap *self, TrbFreeFunc key_free_func, TrbFreeFunc value_free_func)
+{
+	trb_return_if_fail(self != NULL);
+
+	if (key_free_func != NULL || value_free_func != NULL) {
+		for (usize i = 0; i < self->len; ++i) {
+			if (key_free_func != NULL)
+				key_free_func(trb_flat_map_key(self, i));
+			if (value_free_func != NULL)
+				value_free_func(trb_flat_map_value(self, i));
+		}
+	}
+
+	trb_vector_destroy(&self->entries, NULL);
+	self->len = 0;
+}
+
+void trb_flat_map_free(TrbFlatMap *self, TrbFreeFunc key_free_func, TrbFreeFunc value_free_func)
+{
+	trb_return_if_fail(self != NULL);
+	trb_flat_map_destroy(self, key_free_func, value_free_func);
+	free(self);
+}
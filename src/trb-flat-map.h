@@ -0,0 +1,246 @@
+#ifndef FLAT_MAP_H_W7PZ2NCA
+#define FLAT_MAP_H_W7PZ2NCA
+
+#include "trb-types.h"
+#include "trb-vector.h"
+
+typedef struct _TrbFlatMap TrbFlatMap;
+
+/**
+ * TrbFlatMap:
+ * @len: The number of entries.
+ * @keysize: The key size.
+ * @valuesize: The value size. Zero for sets.
+ * @entrysize: The size of each entry, including the padding.
+ * @valueoffset: The offset of the value in the entry.
+ * @cmp_func: The function for comparing keys.
+ * @cmpd_func: The function for comparing keys using user data.
+ * @data: User data.
+ * @with_data: Indicates whether #TrbFlatMap has been initialized with data or not.
+ *
+ * An ordered map stored as a sorted array of entries.
+ *
+ * Lookups use branchless binary search, and iteration walks a contiguous array,
+ * so for read-mostly maps of up to about 100k entries it is faster and smaller
+ * than #TrbTree and #TrbHashTable. A single insertion or removal moves
+ * the tail of the array; batches should be inserted with trb_flat_map_insert_many().
+ *
+ * The key is stored at the start of the entry and the value at @valueoffset.
+ * Both are aligned as if they were fields of a structure.
+ *
+ * This example shows how to scan a range of keys:
+ * ```c
+ * TrbFlatMap map;
+ * trb_flat_map_init(&map, sizeof(u64), sizeof(f64), (TrbCmpFunc) trb_u64cmp);
+ * ...
+ * usize start;
+ * usize len = trb_flat_map_range(&map, trb_get_ptr(u64, 100), trb_get_ptr(u64, 200), &start);
+ *
+ * for (usize i = start; i < start + len; ++i)
+ *     printf("%lu: %f\n", *(u64 *) trb_flat_map_key(&map, i), *(f64 *) trb_flat_map_value(&map, i));
+ * ```
+ **/
+struct _TrbFlatMap {
+	/* <private> */
+	TrbVector entries;
+
+	/* <public> */
+	usize len;
+	usize keysize;
+	usize valuesize;
+	usize entrysize;
+	usize valueoffset;
+
+	union {
+		TrbCmpFunc cmp_func;
+		TrbCmpDataFunc cmpd_func;
+	};
+
+	void *data;
+	bool with_data;
+};
+
+/**
+ * trb_flat_map_init:
+ * @self: (nullable): The pointer to the flat map to be initialized.
+ * @keysize: The size of keys in the map.
+ * @valuesize: The size of values in the map. Zero makes the map a set.
+ * @cmp_func: (scope call): The function for comparing keys.
+ *
+ * Creates a new #TrbFlatMap.
+ *
+ * Returns: (nullable): A new #TrbFlatMap.
+ * Can return %NULL if an error occurs.
+ **/
+TrbFlatMap *trb_flat_map_init(TrbFlatMap *self, usize keysize, usize valuesize, TrbCmpFunc cmp_func);
+
+/**
+ * trb_flat_map_init_data:
+ * @self: (nullable): The pointer to the flat map to be initialized.
+ * @keysize: The size of keys in the map.
+ * @valuesize: The size of values in the map. Zero makes the map a set.
+ * @cmpd_func: (scope call): The function for comparing keys using user data.
+ * @data: User data.
+ *
+ * Creates a new #TrbFlatMap with the comparison function that accepts user data.
+ *
+ * Returns: (nullable): A new #TrbFlatMap.
+ * Can return %NULL if an error occurs.
+ **/
+TrbFlatMap *trb_flat_map_init_data(TrbFlatMap *self, usize keysize, usize valuesize, TrbCmpDataFunc cmpd_func, void *data);
+
+/**
+ * trb_flat_map_add:
+ * @self: The map where to add a new entry.
+ * @key: The key of the entry.
+ * @value: (nullable): The value of the entry. If %NULL, the value is zeroed.
+ *
+ * Adds a new entry to the map. Fails if the key is already in the map.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_flat_map_add(TrbFlatMap *self, const void *key, const void *value);
+
+/**
+ * trb_flat_map_insert:
+ * @self: The map where to insert an entry.
+ * @key: The key of the entry.
+ * @value: (nullable): The value of the entry. If %NULL, the value is zeroed.
+ *
+ * Inserts an entry to the map.
+ * If the key is already in the map, replaces its value with the given one.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_flat_map_insert(TrbFlatMap *self, const void *key, const void *value);
+
+/**
+ * trb_flat_map_insert_many:
+ * @self: The map where to insert the entries.
+ * @keys: The array of keys.
+ * @values: (nullable): The array of values. If %NULL, the values are zeroed.
+ * @len: The number of entries.
+ *
+ * Inserts the entries to the map, replacing the values of the keys that are already in the map.
+ * If a key occurs several times in @keys, the last occurrence wins.
+ *
+ * The batch is sorted and then merged with the map in one pass from the end,
+ * so the whole insertion takes O(m log m + n) instead of m moves of the map tail.
+ *
+ * Returns: %TRUE on success. The map is left untouched on failure.
+ **/
+bool trb_flat_map_insert_many(TrbFlatMap *self, const void *keys, const void *values, usize len);
+
+/**
+ * trb_flat_map_build_from_unsorted:
+ * @self: The map to be filled.
+ * @keys: The array of keys.
+ * @values: (nullable): The array of values. If %NULL, the values are zeroed.
+ * @len: The number of entries.
+ *
+ * Replaces the entries of the map with the given ones, sorting them once.
+ * If a key occurs several times in @keys, the last occurrence wins.
+ * The previous entries are dropped without being freed.
+ *
+ * Returns: %TRUE on success. The map is left untouched on failure.
+ **/
+bool trb_flat_map_build_from_unsorted(TrbFlatMap *self, const void *keys, const void *values, usize len);
+
+/**
+ * trb_flat_map_remove:
+ * @self: The map where to remove the entry.
+ * @key: The key of the entry.
+ * @ret: (optional) (out): The pointer to retrieve the value of removed entry.
+ *
+ * Removes the entry from the map.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_flat_map_remove(TrbFlatMap *self, const void *key, void *ret);
+
+/**
+ * trb_flat_map_lookup:
+ * @self: The map where to search for the entry.
+ * @key: The key of the entry.
+ * @ret: (optional) (out): The pointer to retrieve the value of the entry.
+ *
+ * Searches for the entry in the map.
+ *
+ * Returns: %TRUE if entry is found.
+ **/
+bool trb_flat_map_lookup(const TrbFlatMap *self, const void *key, void *ret);
+
+/**
+ * trb_flat_map_lower_bound:
+ * @self: The map where to search.
+ * @key: The key to be found.
+ *
+ * Finds the first entry which key is not less than @key.
+ *
+ * Returns: The index of the entry, or the length of the map if there is no such entry.
+ **/
+usize trb_flat_map_lower_bound(const TrbFlatMap *self, const void *key);
+
+/**
+ * trb_flat_map_upper_bound:
+ * @self: The map where to search.
+ * @key: The key to be found.
+ *
+ * Finds the first entry which key is greater than @key.
+ *
+ * Returns: The index of the entry, or the length of the map if there is no such entry.
+ **/
+usize trb_flat_map_upper_bound(const TrbFlatMap *self, const void *key);
+
+/**
+ * trb_flat_map_range:
+ * @self: The map where to search.
+ * @lo: The lower bound of the keys, inclusive.
+ * @hi: The upper bound of the keys, exclusive.
+ * @start: (out): The pointer to retrieve the index of the first entry in the range.
+ *
+ * Finds the entries which keys belong to [@lo, @hi).
+ *
+ * Returns: The number of entries in the range.
+ **/
+usize trb_flat_map_range(const TrbFlatMap *self, const void *lo, const void *hi, usize *start);
+
+/**
+ * trb_flat_map_destroy:
+ * @self: The map which entries will be freed.
+ * @key_free_func: (scope call) (nullable): The function for freeing keys.
+ * @value_free_func: (scope call) (nullable): The function for freeing values.
+ *
+ * Frees the map entries.
+ **/
+void trb_flat_map_destroy(TrbFlatMap *self, TrbFreeFunc key_free_func, TrbFreeFunc value_free_func);
+
+/**
+ * trb_flat_map_free:
+ * @self: The map to be freed.
+ * @key_free_func: (scope call) (nullable): The function for freeing keys.
+ * @value_free_func: (scope call) (nullable): The function for freeing values.
+ *
+ * Frees the map completely.
+ **/
+void trb_flat_map_free(TrbFlatMap *self, TrbFreeFunc key_free_func, TrbFreeFunc value_free_func);
+
+/**
+ * trb_flat_map_key:
+ * @self: The map.
+ * @index: The position of the entry.
+ *
+ * Gets the pointer to the key of the entry at the given index.
+ **/
+#define trb_flat_map_key(self, index) ((void *) trb_vector_ptr(&(self)->entries, char, (index)))
+
+/**
+ * trb_flat_map_value:
+ * @self: The map.
+ * @index: The position of the entry.
+ *
+ * Gets the pointer to the value of the entry at the given index.
+ **/
+#define trb_flat_map_value(self, index) ((void *) (trb_vector_ptr(&(self)->entries, char, (index)) + (self)->valueoffset))
+
+#endif /* end of include guard: FLAT_MAP_H_W7PZ2NCA */
@@ -0,0 +1,58 @@
+#include "trb-growth.h"
+
+#include "trb-checked.h"
+#include "trb-math.h"
+#include "trb-messages.h"
+
+#define GROWTH_MIN_CAP 8
+
+static bool __trb_growth_conservative(usize required, usize *newcap)
+{
+	usize new_allocated = (required >> 3) + (required < 9 ? 3 : 6);
+	return !trb_chk_add(required, new_allocated, newcap);
+}
+
+bool trb_growth_capacity(TrbGrowth growth, TrbGrowthFunc growth_func, usize capacity, usize required, usize *newcap)
+{
+	trb_return_val_if_fail(newcap != NULL, FALSE);
+
+	usize grown;
+
+	switch (growth) {
+	case TRB_GROWTH_1_5X:
+		if (trb_chk_add(capacity, capacity >> 1, &grown))
+			grown = required;
+		break;
+	case TRB_GROWTH_2X:
+		if (trb_chk_mul(capacity, 2, &grown))
+			grown = required;
+		break;
+	case TRB_GROWTH_CONSERVATIVE:
+		if (!__trb_growth_conservative(required, newcap)) {
+			trb_msg_error("capacity overflow!");
+			return FALSE;
+		}
+
+		return TRUE;
+	case TRB_GROWTH_CUSTOM:
+		trb_return_val_if_fail(growth_func != NULL, FALSE);
+
+		grown = growth_func(capacity, required);
+
+		if (grown < required) {
+			trb_msg_error("growth function returned capacity less than required!");
+			return FALSE;
+		}
+
+		*newcap = grown;
+		return TRUE;
+	default:
+		trb_msg_error("unknown growth policy!");
+		return FALSE;
+	}
+
+	grown = trb_max(grown, GROWTH_MIN_CAP);
+	*newcap = trb_max(grown, required);
+
+	return TRUE;
+}
@@ -0,0 +1,54 @@
+#ifndef GROWTH_H_Q4NM7XKD
+#define GROWTH_H_Q4NM7XKD
+
+#include "trb-types.h"
+
+/**
+ * TrbGrowth:
+ * @TRB_GROWTH_1_5X: Grows the capacity by half of itself. This is the default.
+ * @TRB_GROWTH_2X: Doubles the capacity.
+ * @TRB_GROWTH_CONSERVATIVE: Grows the required capacity by an eighth plus a few elements.
+ * Uses the least memory, but large buffers are reallocated often.
+ * @TRB_GROWTH_CUSTOM: Uses the #TrbGrowthFunc set by the caller.
+ *
+ * The policy for growing the capacity of a container buffer.
+ *
+ * Geometric policies (%TRB_GROWTH_1_5X and %TRB_GROWTH_2X) grow the buffer proportionally
+ * to its current capacity, so appending an element takes amortized constant time.
+ * The new capacity is never less than the required one.
+ **/
+typedef enum {
+	TRB_GROWTH_1_5X = 0,
+	TRB_GROWTH_2X,
+	TRB_GROWTH_CONSERVATIVE,
+	TRB_GROWTH_CUSTOM,
+} TrbGrowth;
+
+/**
+ * TrbGrowthFunc:
+ * @capacity: The current capacity.
+ * @required: The capacity that is required. Always greater than @capacity.
+ *
+ * Computes the new capacity of a container buffer.
+ *
+ * Returns: The new capacity. Must not be less than @required.
+ **/
+typedef usize (*TrbGrowthFunc)(usize capacity, usize required);
+
+/**
+ * trb_growth_capacity:
+ * @growth: The growth policy.
+ * @growth_func: (nullable): The growth function. Used only if @growth is %TRB_GROWTH_CUSTOM.
+ * @capacity: The current capacity.
+ * @required: The capacity that is required.
+ * @newcap: (out): The pointer to retrieve the new capacity.
+ *
+ * Computes the new capacity of a container buffer according to the growth policy.
+ * Geometric policies fall back to @required if the grown capacity overflows.
+ *
+ * Returns: %TRUE on success, %FALSE if the capacity overflows
+ * or the growth function returns a capacity less than @required.
+ **/
+bool trb_growth_capacity(TrbGrowth growth, TrbGrowthFunc growth_func, usize capacity, usize required, usize *newcap);
+
+#endif /* end of include guard: GROWTH_H_Q4NM7XKD */
@@ -1,5 +1,6 @@
 #include "trb-heap.h"
 
+#include "trb-math.h"
 #include "trb-messages.h"
 #include "trb-utils.h"
 
@@ -31,6 +32,8 @@ TrbHeap *trb_heap_init(TrbHeap *self, usize elemsize, TrbCmpFunc cmp_func)
 	self->cmp_func = cmp_func;
 	self->data = NULL;
 	self->with_data = FALSE;
+	self->arity = 2;
+	self->shift = 1;
 
 	return self;
 }
@@ -61,43 +64,149 @@ TrbHeap *trb_heap_init_data(TrbHeap *self, usize elemsize, TrbCmpDataFunc cmpd_f
 	self->cmpd_func = cmpd_func;
 	self->data = data;
 	self->with_data = TRUE;
+	self->arity = 2;
+	self->shift = 1;
 
 	return self;
 }
 
+static inline i32 __trb_heap_cmp_at(const TrbHeap *self, usize a, usize b)
+{
+	const void *pa = trb_vector_ptr(&self->vector, void, a);
+	const void *pb = trb_vector_ptr(&self->vector, void, b);
+
+	if (self->with_data)
+		return self->cmpd_func(pa, pb, self->data);
+
+	return self->cmp_func(pa, pb);
+}
+
+static inline void __trb_heap_swap(TrbHeap *self, usize a, usize b)
+{
+	trb_memswap(trb_vector_ptr(&self->vector, void, a), trb_vector_ptr(&self->vector, void, b), self->vector.elemsize);
+}
+
+static usize __trb_heap_sift_up(TrbHeap *self, usize index)
+{
+	while (index != 0) {
+		usize parent = (index - 1) >> self->shift;
+
+		if (__trb_heap_cmp_at(self, parent, index) >= 0)
+			break;
+
+		__trb_heap_swap(self, parent, index);
+		index = parent;
+	}
+
+	return index;
+}
+
+static usize __trb_heap_sift_down(TrbHeap *self, usize index)
+{
+	usize len = self->vector.len;
+
+	while (TRUE) {
+		usize first = (index << self->shift) + 1;
+
+		if (first >= len)
+			break;
+
+		usize last = trb_min(first + self->arity, len);
+		usize child = first;
+
+		for (usize i = first + 1; i < last; ++i) {
+			if (__trb_heap_cmp_at(self, child, i) < 0)
+				child = i;
+		}
+
+		if (__trb_heap_cmp_at(self, index, child) >= 0)
+			break;
+
+		__trb_heap_swap(self, index, child);
+		index = child;
+	}
+
+	return index;
+}
+
 bool trb_heap_insert(TrbHeap *self, const void *data)
 {
 	trb_return_val_if_fail(self != NULL, FALSE);
 
-	if (trb_vector_push_back(&self->vector, data)) {
-		if (self->vector.len == 1)
-			return TRUE;
+	if (!trb_vector_push_back(&self->vector, data))
+		return FALSE;
+
+	__trb_heap_sift_up(self, self->vector.len - 1);
+
+	return TRUE;
+}
+
+bool trb_heap_push_many(TrbHeap *self, const void *data, usize len)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+
+	if (!trb_vector_push_back_many(&self->vector, data, len))
+		return FALSE;
 
-		TrbSlice heap_slice;
-		trb_vector_slice(&self->vector, &heap_slice, 0, self->vector.len);
+	trb_heap_fix(self);
 
-		if (self->with_data)
-			trb_heapify_data(&heap_slice, self->cmpd_func, self->data);
-		else
-			trb_heapify(&heap_slice, self->cmp_func);
+	return TRUE;
+}
 
-		return TRUE;
+bool trb_heap_replace_top(TrbHeap *self, const void *data, void *ret)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	trb_return_val_if_fail(data != NULL, FALSE);
+
+	if (self->vector.len == 0) {
+		trb_msg_warn("heap is empty!");
+		return FALSE;
 	}
 
-	return FALSE;
+	if (!trb_vector_unshare(&self->vector))
+		return FALSE;
+
+	void *top = trb_vector_ptr(&self->vector, void, 0);
+
+	if (ret != NULL)
+		trb_memcopy(ret, top, self->vector.elemsize);
+
+	trb_memcopy(top, data, self->vector.elemsize);
+	__trb_heap_sift_down(self, 0);
+
+	return TRUE;
 }
 
 void trb_heap_fix(TrbHeap *self)
 {
 	trb_return_if_fail(self != NULL);
 
-	TrbSlice heap_slice;
-	trb_vector_slice(&self->vector, &heap_slice, 0, self->vector.len);
+	usize len = self->vector.len;
+	if (len <= 1)
+		return;
 
-	if (self->with_data)
-		trb_heapify_data(&heap_slice, self->cmpd_func, self->data);
-	else
-		trb_heapify(&heap_slice, self->cmp_func);
+	if (!trb_vector_unshare(&self->vector))
+		return;
+
+	for (usize i = ((len - 2) >> self->shift) + 1; i-- > 0;)
+		__trb_heap_sift_down(self, i);
+}
+
+bool trb_heap_set_arity(TrbHeap *self, usize arity)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	trb_return_val_if_fail(arity >= 2 && arity <= TRB_HEAP_MAX_ARITY, FALSE);
+	trb_return_val_if_fail((arity & (arity - 1)) == 0, FALSE);
+
+	/* trb_heap_fix() can't report a failure, so the buffer is detached before the arity changes */
+	if (!trb_vector_unshare(&self->vector))
+		return FALSE;
+
+	self->arity = arity;
+	self->shift = USIZE_WIDTH - 1 - trb_clz(arity);
+	trb_heap_fix(self);
+
+	return TRUE;
 }
 
 static bool __trb_heap_remove(TrbHeap *self, usize index, void *ret)
@@ -107,26 +216,25 @@ static bool __trb_heap_remove(TrbHeap *self, usize index, void *ret)
 		return FALSE;
 	}
 
-	void *at_index = trb_vector_ptr(&self->vector, void, index);
-	void *last = trb_vector_ptr(&self->vector, void, self->vector.len - 1);
+	if (!trb_vector_unshare(&self->vector))
+		return FALSE;
 
-	trb_memswap(at_index, last, self->vector.elemsize);
+	usize last = self->vector.len - 1;
 
-	if (trb_vector_pop_back(&self->vector, ret)) {
-		TrbSlice heap_slice;
-		trb_vector_slice(&self->vector, &heap_slice, 0, self->vector.len);
+	if (index != last)
+		__trb_heap_swap(self, index, last);
 
-		if (self->with_data)
-			trb_heapify_data(&heap_slice, self->cmpd_func, self->data);
-		else
-			trb_heapify(&heap_slice, self->cmp_func);
+	if (!trb_vector_pop_back(&self->vector, ret)) {
+		if (index != last)
+			__trb_heap_swap(self, index, last);
 
-		return TRUE;
-	} else {
-		trb_memswap(at_index, last, self->vector.elemsize);
+		return FALSE;
 	}
 
-	return FALSE;
+	if (index != last && __trb_heap_sift_down(self, index) == index)
+		__trb_heap_sift_up(self, index);
+
+	return TRUE;
 }
 
 bool trb_heap_remove(TrbHeap *self, usize index, void *ret)
@@ -168,6 +276,12 @@ bool trb_heap_search_data(const TrbHeap *self, const void *target, TrbCmpDataFun
 	return trb_vector_search_data(&self->vector, target, cmpd_func, data, index);
 }
 
+bool trb_heap_find_bytes(const TrbHeap *self, const void *target, usize *index)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	return trb_vector_find_bytes(&self->vector, target, index);
+}
+
 void trb_heap_destroy(TrbHeap *self, TrbFreeFunc free_func)
 {
 	trb_return_if_fail(self != NULL);
@@ -14,10 +14,16 @@ typedef struct _TrbHeap TrbHeap;
  * @with_data: Indicates whether #TrbHeap has been initialized with data or not.
  *
  * A max-heap data structure represented as an array.
+ *
+ * The heap is binary by default, see trb_heap_set_arity(). A 4-ary or 8-ary heap is half or a third as deep,
+ * so popping from a large heap touches fewer cache lines at the cost of more
+ * comparisons per level, while insertion only gets cheaper.
  **/
 struct _TrbHeap {
 	/* <private> */
 	TrbVector vector;
+	usize arity;
+	usize shift;
 
 	/* <public> */
 	union {
@@ -29,6 +35,13 @@ struct _TrbHeap {
 	bool with_data;
 };
 
+/**
+ * TRB_HEAP_MAX_ARITY:
+ *
+ * The largest arity of #TrbHeap.
+ **/
+#define TRB_HEAP_MAX_ARITY 64
+
 /**
  * trb_heap_init:
  * @self: (nullable): The pointer to the #TrbHeap to be initialized.
@@ -59,19 +72,45 @@ TrbHeap *trb_heap_init_data(TrbHeap *self, usize elemsize, TrbCmpDataFunc cmpd_f
  * @self: The heap where to insert the element.
  * @data: The element to be inserted.
  *
- * Inserts the element in the heap.
+ * Inserts the element in the heap in O(log n).
  *
  * Returns: %TRUE on success.
  **/
 bool trb_heap_insert(TrbHeap *self, const void *data);
 
+/**
+ * trb_heap_push_many:
+ * @self: The heap where to insert the elements.
+ * @data: The elements to be inserted.
+ * @len: The number of elements to be inserted.
+ *
+ * Appends the elements to the heap and restores the heap ordering
+ * with a single bottom-up heapify in O(n).
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_heap_push_many(TrbHeap *self, const void *data, usize len);
+
+/**
+ * trb_heap_replace_top:
+ * @self: The heap where to replace the element.
+ * @data: The element to be inserted.
+ * @ret: (optional) (out): The pointer to retrieve the removed top element.
+ *
+ * Replaces the largest element of the heap with @data in O(log n).
+ * This is cheaper than trb_heap_pop_front() followed by trb_heap_insert().
+ *
+ * Returns: %TRUE on success, %FALSE if the heap is empty.
+ **/
+bool trb_heap_replace_top(TrbHeap *self, const void *data, void *ret);
+
 /**
  * trb_heap_remove:
  * @self: The heap where to remove the element.
  * @index: The index of the element to be removed.
  * @ret: (optional) (out): The pointer to retrieve removed data.
  *
- * Removes the element from the heap.
+ * Removes the element from the heap in O(log n).
  *
  * Returns: %TRUE on success.
  **/
@@ -93,7 +132,7 @@ bool trb_heap_pop_back(TrbHeap *self, void *ret);
  * @self: The heap where to remove the element.
  * @ret: (optional) (out): The pointer to retrieve removed data.
  *
- * Removes the first element from the heap.
+ * Removes the first (largest) element from the heap in O(log n).
  *
  * Returns: %TRUE on success.
  **/
@@ -107,6 +146,27 @@ bool trb_heap_pop_front(TrbHeap *self, void *ret);
  **/
 void trb_heap_fix(TrbHeap *self);
 
+/**
+ * trb_heap_set_arity:
+ * @self: The heap.
+ * @arity: The number of children of each node. Must be a power of two
+ * between 2 and %TRB_HEAP_MAX_ARITY.
+ *
+ * Changes the arity of the heap and restores the heap ordering.
+ *
+ * Returns: %TRUE on success, %FALSE if @arity is invalid.
+ **/
+bool trb_heap_set_arity(TrbHeap *self, usize arity);
+
+/**
+ * trb_heap_arity:
+ * @self: The heap.
+ *
+ * Gets the number of children of each node. The default arity is 2.
+ * Use trb_heap_set_arity() to change it.
+ **/
+#define trb_heap_arity(self) ((usize) (self)->arity)
+
 /**
  * trb_heap_search:
  * @self: The heap where to search.
@@ -136,6 +196,20 @@ bool trb_heap_search(const TrbHeap *self, const void *target, TrbCmpFunc cmp_fun
  **/
 bool trb_heap_search_data(const TrbHeap *self, const void *target, TrbCmpDataFunc cmpd_func, void *data, usize *index);
 
+/**
+ * trb_heap_find_bytes:
+ * @self: The heap where to search.
+ * @target: The pointer to the data to be found.
+ * @index: (optional) (out): The pointer to retrieve the index of found value.
+ *
+ * Searches for the entry which bytes are equal to the bytes of @target.
+ * The heap is stored in a single array, so it is scanned like a vector,
+ * without calling a comparison function for each entry. See trb_vector_find_bytes().
+ *
+ * Returns: %TRUE if found, %FALSE if not.
+ **/
+bool trb_heap_find_bytes(const TrbHeap *self, const void *target, usize *index);
+
 /**
  * trb_heap_destroy:
  * @self: The heap which buffer is to be freed.
@@ -0,0 +1,349 @@
+#include "trb-indexed-heap.h"
+
+#include "trb-macros.h"
+#include "trb-messages.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define INDEXED_HEAP_FREE USIZE_MAX
+
+#define __trb_indexed_heap_handle(self, index) (trb_vector_get(&(self)->heap, usize, index))
+#define __trb_indexed_heap_pos(self, handle) (trb_vector_get(&(self)->pos, usize, handle))
+#define __trb_indexed_heap_slot(self, handle) (trb_vector_ptr(&(self)->slots, void, handle))
+
+static TrbIndexedHeap *__trb_indexed_heap_init(TrbIndexedHeap *self, usize elemsize)
+{
+	bool was_allocated = FALSE;
+
+	if (self == NULL) {
+		self = trb_talloc(TrbIndexedHeap, 1);
+
+		if (self == NULL) {
+			trb_msg_error("couldn't allocate memory for the heap!");
+			return NULL;
+		}
+
+		was_allocated = TRUE;
+	}
+
+	if (trb_vector_init(&self->slots, FALSE, elemsize) == NULL)
+		goto fail_slots;
+
+	if (trb_vector_init(&self->heap, FALSE, sizeof(usize)) == NULL)
+		goto fail_heap;
+
+	if (trb_vector_init(&self->pos, FALSE, sizeof(usize)) == NULL)
+		goto fail_pos;
+
+	if (trb_vector_init(&self->free, FALSE, sizeof(usize)) == NULL)
+		goto fail_free;
+
+	self->len = 0;
+
+	return self;
+
+fail_free:
+	trb_vector_destroy(&self->pos, NULL);
+fail_pos:
+	trb_vector_destroy(&self->heap, NULL);
+fail_heap:
+	trb_vector_destroy(&self->slots, NULL);
+fail_slots:
+	if (was_allocated)
+		free(self);
+
+	return NULL;
+}
+
+TrbIndexedHeap *trb_indexed_heap_init(TrbIndexedHeap *self, usize elemsize, TrbCmpFunc cmp_func)
+{
+	trb_return_val_if_fail(cmp_func != NULL, NULL);
+	trb_return_val_if_fail(elemsize != 0, NULL);
+
+	self = __trb_indexed_heap_init(self, elemsize);
+
+	if (self == NULL)
+		return NULL;
+
+	self->cmp_func = cmp_func;
+	self->data = NULL;
+	self->with_data = FALSE;
+
+	return self;
+}
+
+TrbIndexedHeap *trb_indexed_heap_init_data(TrbIndexedHeap *self, usize elemsize, TrbCmpDataFunc cmpd_func, void *data)
+{
+	trb_return_val_if_fail(cmpd_func != NULL, NULL);
+	trb_return_val_if_fail(elemsize != 0, NULL);
+
+	self = __trb_indexed_heap_init(self, elemsize);
+
+	if (self == NULL)
+		return NULL;
+
+	self->cmpd_func = cmpd_func;
+	self->data = data;
+	self->with_data = TRUE;
+
+	return self;
+}
+
+static inline i32 __trb_indexed_heap_cmp_at(const TrbIndexedHeap *self, usize a, usize b)
+{
+	const void *pa = __trb_indexed_heap_slot(self, __trb_indexed_heap_handle(self, a));
+	const void *pb = __trb_indexed_heap_slot(self, __trb_indexed_heap_handle(self, b));
+
+	if (self->with_data)
+		return self->cmpd_func(pa, pb, self->data);
+
+	return self->cmp_func(pa, pb);
+}
+
+/* Puts the handle at the index of the heap and updates the position map */
+static inline void __trb_indexed_heap_place(TrbIndexedHeap *self, usize index, usize handle)
+{
+	__trb_indexed_heap_handle(self, index) = handle;
+	__trb_indexed_heap_pos(self, handle) = index;
+}
+
+static inline void __trb_indexed_heap_swap(TrbIndexedHeap *self, usize a, usize b)
+{
+	usize ha = __trb_indexed_heap_handle(self, a);
+	usize hb = __trb_indexed_heap_handle(self, b);
+
+	__trb_indexed_heap_place(self, a, hb);
+	__trb_indexed_heap_place(self, b, ha);
+}
+
+static usize __trb_indexed_heap_sift_up(TrbIndexedHeap *self, usize index)
+{
+	while (index != 0) {
+		usize parent = (index - 1) >> 1;
+
+		if (__trb_indexed_heap_cmp_at(self, parent, index) >= 0)
+			break;
+
+		__trb_indexed_heap_swap(self, parent, index);
+		index = parent;
+	}
+
+	return index;
+}
+
+static usize __trb_indexed_heap_sift_down(TrbIndexedHeap *self, usize index)
+{
+	usize len = self->len;
+
+	while (TRUE) {
+		usize child = (index << 1) + 1;
+
+		if (child >= len)
+			break;
+
+		if (child + 1 < len && __trb_indexed_heap_cmp_at(self, child, child + 1) < 0)
+			child++;
+
+		if (__trb_indexed_heap_cmp_at(self, index, child) >= 0)
+			break;
+
+		__trb_indexed_heap_swap(self, index, child);
+		index = child;
+	}
+
+	return index;
+}
+
+static void __trb_indexed_heap_sift(TrbIndexedHeap *self, usize index)
+{
+	if (__trb_indexed_heap_sift_down(self, index) == index)
+		__trb_indexed_heap_sift_up(self, index);
+}
+
+static inline bool __trb_indexed_heap_contains(const TrbIndexedHeap *self, usize handle)
+{
+	return handle < self->pos.len && __trb_indexed_heap_pos(self, handle) != INDEXED_HEAP_FREE;
+}
+
+static bool __trb_indexed_heap_check(const TrbIndexedHeap *self, usize handle)
+{
+	if (!__trb_indexed_heap_contains(self, handle)) {
+		trb_msg_warn("handle %zu is not in the heap!", handle);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+bool trb_indexed_heap_insert(TrbIndexedHeap *self, const void *data, usize *handle)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	trb_return_val_if_fail(data != NULL, FALSE);
+
+	if (!trb_vector_push_back(&self->heap, &self->len))
+		return FALSE;
+
+	usize slot;
+
+	if (self->free.len != 0) {
+		trb_vector_pop_back(&self->free, &slot);
+		trb_memcopy(__trb_indexed_heap_slot(self, slot), data, self->slots.elemsize);
+	} else {
+		slot = self->slots.len;
+
+		if (!trb_vector_push_back(&self->slots, data)) {
+			trb_vector_pop_back(&self->heap, NULL);
+			return FALSE;
+		}
+
+		if (!trb_vector_push_back(&self->pos, &self->len)) {
+			trb_vector_pop_back(&self->slots, NULL);
+			trb_vector_pop_back(&self->heap, NULL);
+			return FALSE;
+		}
+	}
+
+	__trb_indexed_heap_place(self, self->len, slot);
+	__trb_indexed_heap_sift_up(self, self->len++);
+
+	if (handle != NULL)
+		*handle = slot;
+
+	return TRUE;
+}
+
+bool trb_indexed_heap_update(TrbIndexedHeap *self, usize handle, const void *data)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	trb_return_val_if_fail(data != NULL, FALSE);
+
+	if (!__trb_indexed_heap_check(self, handle))
+		return FALSE;
+
+	trb_memcopy(__trb_indexed_heap_slot(self, handle), data, self->slots.elemsize);
+	__trb_indexed_heap_sift(self, __trb_indexed_heap_pos(self, handle));
+
+	return TRUE;
+}
+
+bool trb_indexed_heap_fix(TrbIndexedHeap *self, usize handle)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+
+	if (!__trb_indexed_heap_check(self, handle))
+		return FALSE;
+
+	__trb_indexed_heap_sift(self, __trb_indexed_heap_pos(self, handle));
+
+	return TRUE;
+}
+
+static bool __trb_indexed_heap_remove(TrbIndexedHeap *self, usize handle, void *ret)
+{
+	if (!trb_vector_push_back(&self->free, &handle))
+		return FALSE;
+
+	usize index = __trb_indexed_heap_pos(self, handle);
+	usize last = --self->len;
+
+	if (index != last)
+		__trb_indexed_heap_place(self, index, __trb_indexed_heap_handle(self, last));
+
+	trb_vector_pop_back(&self->heap, NULL);
+	__trb_indexed_heap_pos(self, handle) = INDEXED_HEAP_FREE;
+
+	if (index != last)
+		__trb_indexed_heap_sift(self, index);
+
+	if (ret != NULL)
+		trb_memcopy(ret, __trb_indexed_heap_slot(self, handle), self->slots.elemsize);
+
+	return TRUE;
+}
+
+bool trb_indexed_heap_remove(TrbIndexedHeap *self, usize handle, void *ret)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+
+	if (!__trb_indexed_heap_check(self, handle))
+		return FALSE;
+
+	return __trb_indexed_heap_remove(self, handle, ret);
+}
+
+bool trb_indexed_heap_pop_front(TrbIndexedHeap *self, void *ret, usize *handle)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+
+	if (self->len == 0) {
+		trb_msg_warn("heap is empty!");
+		return FALSE;
+	}
+
+	usize top = __trb_indexed_heap_handle(self, 0);
+
+	if (!__trb_indexed_heap_remove(self, top, ret))
+		return FALSE;
+
+	if (handle != NULL)
+		*handle = top;
+
+	return TRUE;
+}
+
+const void *trb_indexed_heap_top(const TrbIndexedHeap *self, usize *handle)
+{
+	trb_return_val_if_fail(self != NULL, NULL);
+
+	if (self->len == 0)
+		return NULL;
+
+	usize top = __trb_indexed_heap_handle(self, 0);
+
+	if (handle != NULL)
+		*handle = top;
+
+	return __trb_indexed_heap_slot(self, top);
+}
+
+bool trb_indexed_heap_contains(const TrbIndexedHeap *self, usize handle)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	return __trb_indexed_heap_contains(self, handle);
+}
+
+void *trb_indexed_heap_ptr(TrbIndexedHeap *self, usize handle)
+{
+	trb_return_val_if_fail(self != NULL, NULL);
+
+	if (!__trb_indexed_heap_check(self, handle))
+		return NULL;
+
+	return __trb_indexed_heap_slot(self, handle);
+}
+
+void trb_indexed_heap_destroy(TrbIndexedHeap *self, TrbFreeFunc free_func)
+{
+	trb_return_if_fail(self != NULL);
+
+	if (free_func != NULL) {
+		for (usize i = 0; i < self->len; ++i)
+			free_func(__trb_indexed_heap_slot(self, __trb_indexed_heap_handle(self, i)));
+	}
+
+	trb_vector_destroy(&self->slots, NULL);
+	trb_vector_destroy(&self->heap, NULL);
+	trb_vector_destroy(&self->pos, NULL);
+	trb_vector_destroy(&self->free, NULL);
+
+	self->len = 0;
+}
+
+void trb_indexed_heap_free(TrbIndexedHeap *self, TrbFreeFunc free_func)
+{
+	trb_return_if_fail(self != NULL);
+
+	trb_indexed_heap_destroy(self, free_func);
+	free(self);
+}
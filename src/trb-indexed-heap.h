@@ -0,0 +1,184 @@
+#ifndef INDEXED_HEAP_H_T5HW9NEL
+#define INDEXED_HEAP_H_T5HW9NEL
+
+#include "trb-types.h"
+#include "trb-vector.h"
+
+typedef struct _TrbIndexedHeap TrbIndexedHeap;
+
+/**
+ * TrbIndexedHeap:
+ * @cmp_func: The function for comparing elements.
+ * @cmpd_func: The function for comparing elements using user data.
+ * @data: User data.
+ * @with_data: Indicates whether #TrbIndexedHeap has been initialized with data or not.
+ * @len: The number of elements in the heap.
+ *
+ * A max-heap that gives each element a handle.
+ *
+ * Elements stay in their slots while they are in the heap, so their handles are stable.
+ * The heap itself is an array of handles, and a position map tracks where each handle is in it.
+ * This allows changing or removing any element by its handle in O(log n).
+ * The slots are stored in a growing array, so the addresses of elements are not stable,
+ * see trb_indexed_heap_ptr().
+ *
+ * Handles of removed elements are reused by subsequent insertions.
+ **/
+struct _TrbIndexedHeap {
+	/* <private> */
+	TrbVector slots;
+	TrbVector heap;
+	TrbVector pos;
+	TrbVector free;
+
+	/* <public> */
+	union {
+		TrbCmpFunc cmp_func;
+		TrbCmpDataFunc cmpd_func;
+	};
+
+	void *data;
+	bool with_data;
+	usize len;
+};
+
+/**
+ * trb_indexed_heap_init:
+ * @self: (nullable): The pointer to the #TrbIndexedHeap to be initialized.
+ * @elemsize: The size of each element in bytes.
+ * @cmp_func: The function for comparing elements.
+ *
+ * Creates a new #TrbIndexedHeap.
+ *
+ * Returns: A new #TrbIndexedHeap. Can return %NULL if an error occurs.
+ **/
+TrbIndexedHeap *trb_indexed_heap_init(TrbIndexedHeap *self, usize elemsize, TrbCmpFunc cmp_func);
+
+/**
+ * trb_indexed_heap_init_data:
+ * @self: (nullable): The pointer to the #TrbIndexedHeap to be initialized.
+ * @elemsize: The size of each element in bytes.
+ * @cmpd_func: The function for comparing elements.
+ * @data: User data.
+ *
+ * Creates a new #TrbIndexedHeap with the comparison function that accepts user data.
+ *
+ * Returns: A new #TrbIndexedHeap. Can return %NULL if an error occurs.
+ **/
+TrbIndexedHeap *trb_indexed_heap_init_data(TrbIndexedHeap *self, usize elemsize, TrbCmpDataFunc cmpd_func, void *data);
+
+/**
+ * trb_indexed_heap_insert:
+ * @self: The heap where to insert the element.
+ * @data: The element to be inserted.
+ * @handle: (optional) (out): The pointer to retrieve the handle of the element.
+ *
+ * Inserts the element in the heap in O(log n).
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_indexed_heap_insert(TrbIndexedHeap *self, const void *data, usize *handle);
+
+/**
+ * trb_indexed_heap_update:
+ * @self: The heap where to update the element.
+ * @handle: The handle of the element.
+ * @data: The new value of the element.
+ *
+ * Replaces the value of the element and moves it up or down the heap in O(log n).
+ * Use it both to increase and to decrease the key of the element.
+ *
+ * Returns: %TRUE on success, %FALSE if @handle is not in the heap.
+ **/
+bool trb_indexed_heap_update(TrbIndexedHeap *self, usize handle, const void *data);
+
+/**
+ * trb_indexed_heap_fix:
+ * @self: The heap where to fix the element.
+ * @handle: The handle of the element.
+ *
+ * Restores the heap ordering after the element has been changed in place
+ * through trb_indexed_heap_ptr(). Runs in O(log n).
+ *
+ * Returns: %TRUE on success, %FALSE if @handle is not in the heap.
+ **/
+bool trb_indexed_heap_fix(TrbIndexedHeap *self, usize handle);
+
+/**
+ * trb_indexed_heap_remove:
+ * @self: The heap where to remove the element.
+ * @handle: The handle of the element.
+ * @ret: (optional) (out): The pointer to retrieve removed data.
+ *
+ * Removes the element from the heap in O(log n). The handle becomes invalid.
+ *
+ * Returns: %TRUE on success, %FALSE if @handle is not in the heap.
+ **/
+bool trb_indexed_heap_remove(TrbIndexedHeap *self, usize handle, void *ret);
+
+/**
+ * trb_indexed_heap_pop_front:
+ * @self: The heap where to remove the element.
+ * @ret: (optional) (out): The pointer to retrieve removed data.
+ * @handle: (optional) (out): The pointer to retrieve the handle of removed element.
+ *
+ * Removes the largest element from the heap in O(log n).
+ *
+ * Returns: %TRUE on success, %FALSE if the heap is empty.
+ **/
+bool trb_indexed_heap_pop_front(TrbIndexedHeap *self, void *ret, usize *handle);
+
+/**
+ * trb_indexed_heap_top:
+ * @self: The heap.
+ * @handle: (optional) (out): The pointer to retrieve the handle of the largest element.
+ *
+ * Gets the largest element of the heap.
+ *
+ * Returns: (nullable): The pointer to the element, or %NULL if the heap is empty.
+ **/
+const void *trb_indexed_heap_top(const TrbIndexedHeap *self, usize *handle);
+
+/**
+ * trb_indexed_heap_contains:
+ * @self: The heap.
+ * @handle: The handle to be checked.
+ *
+ * Checks whether the element with the handle is in the heap.
+ *
+ * Returns: %TRUE if the element is in the heap, %FALSE if not.
+ **/
+bool trb_indexed_heap_contains(const TrbIndexedHeap *self, usize handle);
+
+/**
+ * trb_indexed_heap_ptr:
+ * @self: The heap.
+ * @handle: The handle of the element.
+ *
+ * Gets the pointer to the element. The pointer stays valid until the element is removed
+ * or another element is inserted. If the element is changed through the pointer,
+ * trb_indexed_heap_fix() must be called.
+ *
+ * Returns: (nullable): The pointer to the element, or %NULL if @handle is not in the heap.
+ **/
+void *trb_indexed_heap_ptr(TrbIndexedHeap *self, usize handle);
+
+/**
+ * trb_indexed_heap_destroy:
+ * @self: The heap which buffers are to be freed.
+ * @free_func: (scope call) (nullable): The function for freeing elements.
+ *
+ * Frees the heap buffers.
+ **/
+void trb_indexed_heap_destroy(TrbIndexedHeap *self, TrbFreeFunc free_func);
+
+/**
+ * trb_indexed_heap_free:
+ * @self: The heap to be freed.
+ * @free_func: (scope call) (nullable): The function for freeing elements.
+ *
+ * Frees the heap completely.
+ **/
+void trb_indexed_heap_free(TrbIndexedHeap *self, TrbFreeFunc free_func);
+
+#endif /* end of include guard: INDEXED_HEAP_H_T5HW9NEL */
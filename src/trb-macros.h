@@ -4,6 +4,7 @@
 #include "trb-types.h"
 
 #include <malloc.h>
+#include <string.h>
 
 /**
  * trb_talloc:
@@ -29,6 +30,100 @@
 #define trb_array_cell(m, e, i) ((void *) &((char *) (m))[(i) * (e)])
 #define trb_array_get(m, t, i) ((t *) (array_cell((m), sizeof(t), (i))))
 
+/* Swaps two objects of the given type through registers */
+#define __trb_memswap_type(type, a, b)    \
+	do {                                  \
+		type __ta, __tb;                  \
+		memcpy(&__ta, (a), sizeof(type)); \
+		memcpy(&__tb, (b), sizeof(type)); \
+		memcpy((a), &__tb, sizeof(type)); \
+		memcpy((b), &__ta, sizeof(type)); \
+	} while (0)
+
+typedef struct {
+	u64 w[2];
+} __TrbSwap16;
+
+typedef struct {
+	u64 w[4];
+} __TrbSwap32;
+
+static inline void __trb_memswap(void *a, void *b, usize size)
+{
+	char *ca = a;
+	char *cb = b;
+
+	switch (size) {
+	case 0:
+		return;
+	case 1:
+		__trb_memswap_type(u8, ca, cb);
+		return;
+	case 2:
+		__trb_memswap_type(u16, ca, cb);
+		return;
+	case 4:
+		__trb_memswap_type(u32, ca, cb);
+		return;
+	case 8:
+		__trb_memswap_type(u64, ca, cb);
+		return;
+	case 16:
+		__trb_memswap_type(__TrbSwap16, ca, cb);
+		return;
+	case 32:
+		__trb_memswap_type(__TrbSwap32, ca, cb);
+		return;
+	default:
+		break;
+	}
+
+	for (; size >= sizeof(__TrbSwap32); size -= sizeof(__TrbSwap32)) {
+		__trb_memswap_type(__TrbSwap32, ca, cb);
+		ca += sizeof(__TrbSwap32);
+		cb += sizeof(__TrbSwap32);
+	}
+
+	for (; size >= sizeof(u64); size -= sizeof(u64)) {
+		__trb_memswap_type(u64, ca, cb);
+		ca += sizeof(u64);
+		cb += sizeof(u64);
+	}
+
+	for (; size != 0; --size) {
+		__trb_memswap_type(u8, ca, cb);
+		ca++;
+		cb++;
+	}
+}
+
+static inline void __trb_memcopy(void *dst, const void *src, usize size)
+{
+	switch (size) {
+	case 1:
+		memcpy(dst, src, 1);
+		return;
+	case 2:
+		memcpy(dst, src, 2);
+		return;
+	case 4:
+		memcpy(dst, src, 4);
+		return;
+	case 8:
+		memcpy(dst, src, 8);
+		return;
+	case 16:
+		memcpy(dst, src, 16);
+		return;
+	case 32:
+		memcpy(dst, src, 32);
+		return;
+	default:
+		memcpy(dst, src, size);
+		return;
+	}
+}
+
 /**
  * trb_memswap:
  * @a: The first pointer.
@@ -36,18 +131,25 @@
  * @size: The amount of bytes to be swapped.
  *
  * Swaps @size bytes in @a and @b.
+ *
+ * Sizes of 1, 2, 4, 8, 16 and 32 bytes are swapped with a single
+ * pair of loads and stores, larger sizes are swapped in 32-byte blocks.
+ * @a and @b must either be equal or not overlap.
  **/
-#define trb_memswap(a, b, size) \
-	{                           \
-		usize __size = (size);  \
-		char *__a = (a);        \
-		char *__b = (b);        \
-		do {                    \
-			char __tmp = *__a;  \
-			*__a++ = *__b;      \
-			*__b++ = __tmp;     \
-		} while (--__size > 0); \
-	}
+#define trb_memswap(a, b, size) (__trb_memswap((a), (b), (size)))
+
+/**
+ * trb_memcopy:
+ * @dst: The destination pointer.
+ * @src: The source pointer.
+ * @size: The amount of bytes to be copied.
+ *
+ * Copies @size bytes from @src to @dst.
+ *
+ * It is analogous to `memcpy()`, except common element sizes
+ * are copied inline without calling into the C library.
+ **/
+#define trb_memcopy(dst, src, size) (__trb_memcopy((dst), (src), (size)))
 
 #ifndef offsetof
 	#define offsetof(type, member) ((usize) & ((type *) 0)->member)
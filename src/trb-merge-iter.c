@@ -0,0 +1,265 @@
+#include "trb-merge-iter.h"
+
+#include "trb-macros.h"
+#include "trb-math.h"
+#include "trb-messages.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct _TrbMergeSource {
+	TrbSlice slice;
+	usize pos;
+	usize len;
+};
+
+static inline i32 __trb_merge_iter_cmp(const TrbMergeIter *self, const void *a, const void *b)
+{
+	if (self->with_data)
+		return self->cmpd_func(a, b, self->data);
+
+	return self->cmp_func(a, b);
+}
+
+/* Exhausted sources lose to everything, ties are broken by the source index */
+static inline bool __trb_merge_iter_beats(const TrbMergeIter *self, usize a, usize b)
+{
+	const void *ha = self->heads[a];
+	const void *hb = self->heads[b];
+
+	if (ha == NULL)
+		return FALSE;
+
+	if (hb == NULL)
+		return TRUE;
+
+	i32 res = __trb_merge_iter_cmp(self, ha, hb);
+	return res < 0 || (res == 0 && a < b);
+}
+
+static inline void __trb_merge_iter_advance(TrbMergeIter *self, usize index)
+{
+	TrbMergeSource *source = &self->sources[index];
+
+	if (++source->pos == source->len) {
+		self->heads[index] = NULL;
+		return;
+	}
+
+	const TrbSlice *slice = &source->slice;
+
+	if (slice->contiguous)
+		self->heads[index] += slice->elemsize;
+	else
+		self->heads[index] = slice->at(slice, source->pos);
+}
+
+/* Leaves are the nodes n_slices .. 2 * n_slices - 1, the internal nodes store the losers */
+static usize __trb_merge_iter_build(TrbMergeIter *self, usize node)
+{
+	if (node >= self->n_slices)
+		return node - self->n_slices;
+
+	usize left = __trb_merge_iter_build(self, 2 * node);
+	usize right = __trb_merge_iter_build(self, 2 * node + 1);
+
+	if (__trb_merge_iter_beats(self, right, left)) {
+		self->tree[node] = left;
+		return right;
+	}
+
+	self->tree[node] = right;
+	return left;
+}
+
+static void __trb_merge_iter_replay(TrbMergeIter *self, usize winner)
+{
+	usize *tree = self->tree;
+
+	for (usize node = (self->n_slices + winner) >> 1; node != 0; node >>= 1) {
+		if (__trb_merge_iter_beats(self, tree[node], winner)) {
+			usize loser = winner;
+			winner = tree[node];
+			tree[node] = loser;
+		}
+	}
+
+	tree[0] = winner;
+}
+
+static TrbMergeIter *__trb_merge_iter_init(TrbMergeIter *self, const TrbSlice *slices, usize n_slices)
+{
+	for (usize i = 1; i < n_slices; ++i) {
+		if (slices[i].elemsize != slices[0].elemsize) {
+			trb_msg_error("slices have different element sizes!");
+			return NULL;
+		}
+	}
+
+	bool was_allocated = FALSE;
+
+	if (self == NULL) {
+		self = trb_talloc(TrbMergeIter, 1);
+
+		if (self == NULL) {
+			trb_msg_error("couldn't allocate memory for the merge iterator!");
+			return NULL;
+		}
+
+		was_allocated = TRUE;
+	}
+
+	usize n_nodes = trb_max(n_slices, 1);
+
+	self->sources = trb_talloc(TrbMergeSource, n_nodes);
+	self->heads = trb_talloc(const char *, n_nodes);
+	self->tree = trb_talloc(usize, n_nodes);
+
+	if (self->sources == NULL || self->heads == NULL || self->tree == NULL) {
+		trb_msg_error("couldn't allocate memory for the merge iterator!");
+
+		free(self->sources);
+		free(self->heads);
+		free(self->tree);
+
+		if (was_allocated)
+			free(self);
+
+		return NULL;
+	}
+
+	self->n_slices = n_slices;
+	self->remaining = 0;
+
+	for (usize i = 0; i < n_slices; ++i) {
+		TrbMergeSource *source = &self->sources[i];
+
+		source->slice = slices[i];
+		source->pos = 0;
+		source->len = trb_slice_len(&slices[i]);
+		self->heads[i] = (source->len != 0) ? slices[i].at(&slices[i], 0) : NULL;
+
+		self->remaining += source->len;
+	}
+
+	return self;
+}
+
+TrbMergeIter *trb_merge_iter_init(TrbMergeIter *self, const TrbSlice *slices, usize n_slices, TrbCmpFunc cmp_func)
+{
+	trb_return_val_if_fail(slices != NULL || n_slices == 0, NULL);
+	trb_return_val_if_fail(cmp_func != NULL, NULL);
+
+	self = __trb_merge_iter_init(self, slices, n_slices);
+
+	if (self == NULL)
+		return NULL;
+
+	self->cmp_func = cmp_func;
+	self->data = NULL;
+	self->with_data = FALSE;
+
+	if (n_slices != 0)
+		self->tree[0] = __trb_merge_iter_build(self, 1);
+
+	return self;
+}
+
+TrbMergeIter *trb_merge_iter_init_data(
+	TrbMergeIter *self,
+	const TrbSlice *slices,
+	usize n_slices,
+	TrbCmpDataFunc cmpd_func,
+	void *data
+)
+{
+	trb_return_val_if_fail(slices != NULL || n_slices == 0, NULL);
+	trb_return_val_if_fail(cmpd_func != NULL, NULL);
+
+	self = __trb_merge_iter_init(self, slices, n_slices);
+
+	if (self == NULL)
+		return NULL;
+
+	self->cmpd_func = cmpd_func;
+	self->data = data;
+	self->with_data = TRUE;
+
+	if (n_slices != 0)
+		self->tree[0] = __trb_merge_iter_build(self, 1);
+
+	return self;
+}
+
+bool trb_merge_iter_next(TrbMergeIter *self, const void **elem, usize *source)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+
+	if (self->remaining == 0)
+		return FALSE;
+
+	usize winner = self->tree[0];
+
+	if (elem != NULL)
+		*elem = self->heads[winner];
+
+	if (source != NULL)
+		*source = winner;
+
+	__trb_merge_iter_advance(self, winner);
+	__trb_merge_iter_replay(self, winner);
+	self->remaining--;
+
+	return TRUE;
+}
+
+usize trb_merge_iter_next_many(TrbMergeIter *self, void *out, usize n)
+{
+	trb_return_val_if_fail(self != NULL, 0);
+	trb_return_val_if_fail(out != NULL || n == 0, 0);
+
+	n = trb_min(n, self->remaining);
+
+	if (n == 0)
+		return 0;
+
+	usize elemsize = self->sources[0].slice.elemsize;
+	char *dst = out;
+
+	for (usize i = 0; i < n; ++i) {
+		usize winner = self->tree[0];
+
+		trb_memcopy(dst, self->heads[winner], elemsize);
+		dst += elemsize;
+
+		__trb_merge_iter_advance(self, winner);
+		__trb_merge_iter_replay(self, winner);
+	}
+
+	self->remaining -= n;
+
+	return n;
+}
+
+void trb_merge_iter_destroy(TrbMergeIter *self)
+{
+	trb_return_if_fail(self != NULL);
+
+	free(self->sources);
+	free(self->heads);
+	free(self->tree);
+
+	self->sources = NULL;
+	self->heads = NULL;
+	self->tree = NULL;
+	self->n_slices = 0;
+	self->remaining = 0;
+}
+
+void trb_merge_iter_free(TrbMergeIter *self)
+{
+	trb_return_if_fail(self != NULL);
+
+	trb_merge_iter_destroy(self);
+	free(self);
+}
@@ -0,0 +1,139 @@
+#ifndef MERGE_ITER_H_B8QJZ3LU
+#define MERGE_ITER_H_B8QJZ3LU
+
+#include "trb-slice.h"
+#include "trb-types.h"
+
+typedef struct _TrbMergeIter TrbMergeIter;
+typedef struct _TrbMergeSource TrbMergeSource;
+
+/**
+ * TrbMergeIter:
+ * @cmp_func: The function for comparing elements.
+ * @cmpd_func: The function for comparing elements using user data.
+ * @data: User data.
+ * @with_data: Indicates whether #TrbMergeIter has been initialized with data or not.
+ * @n_slices: The number of merged slices.
+ * @remaining: The number of elements that haven't been yielded yet.
+ *
+ * An iterator that merges sorted slices into one sorted sequence.
+ *
+ * The iterator keeps a loser tree over the heads of the slices: each internal node
+ * holds the slice that lost the comparison there, and the root holds the overall winner.
+ * Yielding an element replays only the path from the winner's leaf to the root,
+ * so it takes log2(n_slices) comparisons and doesn't move any elements.
+ *
+ * The merge is stable: equal elements are yielded in the order of their slices.
+ * The elements are not copied, so the data of the slices must stay valid while the iterator is used.
+ *
+ * This example shows how to merge sorted arrays:
+ * ```c
+ * i32 a[] = { 1, 4, 9 };
+ * i32 b[] = { 2, 3, 10, 11 };
+ *
+ * TrbSlice slices[2];
+ * trb_slice_init(&slices[0], a, sizeof(i32), 0, 3);
+ * trb_slice_init(&slices[1], b, sizeof(i32), 0, 4);
+ *
+ * TrbMergeIter iter;
+ * trb_merge_iter_init(&iter, slices, 2, (TrbCmpFunc) trb_i32cmp);
+ *
+ * i32 out[7];
+ * trb_merge_iter_next_many(&iter, out, 7);
+ *
+ * trb_merge_iter_destroy(&iter);
+ * ```
+ **/
+struct _TrbMergeIter {
+	/* <private> */
+	TrbMergeSource *sources;
+	const char **heads;
+	usize *tree;
+
+	/* <public> */
+	union {
+		TrbCmpFunc cmp_func;
+		TrbCmpDataFunc cmpd_func;
+	};
+
+	void *data;
+	bool with_data;
+	usize n_slices;
+	usize remaining;
+};
+
+/**
+ * trb_merge_iter_init:
+ * @self: (nullable): The pointer to the #TrbMergeIter to be initialized.
+ * @slices: The sorted slices to be merged. All slices must have the same element size.
+ * @n_slices: The number of slices.
+ * @cmp_func: The function for comparing elements.
+ *
+ * Creates a new #TrbMergeIter.
+ *
+ * Returns: A new #TrbMergeIter. Can return %NULL if an error occurs.
+ **/
+TrbMergeIter *trb_merge_iter_init(TrbMergeIter *self, const TrbSlice *slices, usize n_slices, TrbCmpFunc cmp_func);
+
+/**
+ * trb_merge_iter_init_data:
+ * @self: (nullable): The pointer to the #TrbMergeIter to be initialized.
+ * @slices: The sorted slices to be merged. All slices must have the same element size.
+ * @n_slices: The number of slices.
+ * @cmpd_func: The function for comparing elements.
+ * @data: User data.
+ *
+ * Creates a new #TrbMergeIter with the comparison function that accepts user data.
+ *
+ * Returns: A new #TrbMergeIter. Can return %NULL if an error occurs.
+ **/
+TrbMergeIter *trb_merge_iter_init_data(
+	TrbMergeIter *self,
+	const TrbSlice *slices,
+	usize n_slices,
+	TrbCmpDataFunc cmpd_func,
+	void *data
+);
+
+/**
+ * trb_merge_iter_next:
+ * @self: The merge iterator.
+ * @elem: (optional) (out): The pointer to retrieve the pointer to the element in its slice.
+ * @source: (optional) (out): The pointer to retrieve the index of the slice the element is from.
+ *
+ * Yields the next element in sorted order.
+ *
+ * Returns: %TRUE on success, %FALSE if all elements have been yielded.
+ **/
+bool trb_merge_iter_next(TrbMergeIter *self, const void **elem, usize *source);
+
+/**
+ * trb_merge_iter_next_many:
+ * @self: The merge iterator.
+ * @out: The buffer to copy the elements to.
+ * @n: The maximum number of elements to be copied.
+ *
+ * Copies up to @n next elements in sorted order to @out.
+ * This avoids the per-call overhead of trb_merge_iter_next().
+ *
+ * Returns: The number of copied elements. Zero means all elements have been yielded.
+ **/
+usize trb_merge_iter_next_many(TrbMergeIter *self, void *out, usize n);
+
+/**
+ * trb_merge_iter_destroy:
+ * @self: The merge iterator which buffers are to be freed.
+ *
+ * Frees the iterator buffers.
+ **/
+void trb_merge_iter_destroy(TrbMergeIter *self);
+
+/**
+ * trb_merge_iter_free:
+ * @self: The merge iterator to be freed.
+ *
+ * Frees the iterator completely.
+ **/
+void trb_merge_iter_free(TrbMergeIter *self);
+
+#endif /* end of include guard: MERGE_ITER_H_B8QJZ3LU */
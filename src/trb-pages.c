@@ -0,0 +1,126 @@
+#ifdef __linux__
+	#define _GNU_SOURCE
+#endif
+
+#include "trb-pages.h"
+
+#include "trb-checked.h"
+#include "trb-math.h"
+#include "trb-messages.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+#ifdef __linux__
+
+static bool __trb_pages_round(usize size, usize *res)
+{
+	usize page_size = (usize) sysconf(_SC_PAGESIZE);
+
+	if (trb_chk_add(size, page_size - 1, res))
+		return FALSE;
+
+	*res &= ~(page_size - 1);
+
+	return TRUE;
+}
+
+static void *__trb_pages_map(usize size, bool hugepages)
+{
+	usize len;
+
+	if (!__trb_pages_round(size, &len))
+		return NULL;
+
+	void *data = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (data == MAP_FAILED)
+		return NULL;
+
+	if (hugepages)
+		madvise(data, len, MADV_HUGEPAGE);
+
+	return data;
+}
+
+static void *__trb_pages_remap(void *ptr, usize old_size, usize new_size, bool hugepages)
+{
+	usize old_len, new_len;
+
+	if (!__trb_pages_round(old_size, &old_len) || !__trb_pages_round(new_size, &new_len))
+		return NULL;
+
+	void *data = mremap(ptr, old_len, new_len, MREMAP_MAYMOVE);
+
+	if (data == MAP_FAILED)
+		return NULL;
+
+	/* Keep the tail of the last page zeroed, growing relies on it */
+	if (new_size < old_size)
+		memset((char *) data + new_size, 0, trb_min(new_len, old_size) - new_size);
+
+	if (hugepages && new_len > old_len)
+		madvise(data, new_len, MADV_HUGEPAGE);
+
+	return data;
+}
+
+#endif
+
+void *trb_pages_realloc(void *ptr, usize old_size, usize new_size, usize threshold, bool hugepages, bool *mapped)
+{
+	trb_return_val_if_fail(new_size != 0, NULL);
+	trb_return_val_if_fail(mapped != NULL, NULL);
+
+#ifdef __linux__
+	if (*mapped)
+		return __trb_pages_remap(ptr, old_size, new_size, hugepages);
+
+	if (threshold != 0 && new_size >= threshold) {
+		void *data = __trb_pages_map(new_size, hugepages);
+
+		if (data == NULL)
+			return NULL;
+
+		if (ptr != NULL) {
+			memcpy(data, ptr, trb_min(old_size, new_size));
+			free(ptr);
+		}
+
+		*mapped = TRUE;
+
+		return data;
+	}
+#else
+	(void) old_size;
+	(void) threshold;
+	(void) hugepages;
+#endif
+
+	return realloc(ptr, new_size);
+}
+
+void trb_pages_free(void *ptr, usize size, bool mapped)
+{
+	if (ptr == NULL)
+		return;
+
+#ifdef __linux__
+	if (mapped) {
+		usize len;
+		__trb_pages_round(size, &len);
+		munmap(ptr, len);
+		return;
+	}
+#else
+	(void) size;
+	(void) mapped;
+#endif
+
+	free(ptr);
+}
@@ -0,0 +1,43 @@
+#ifndef PAGES_H_H2WQ9RLE
+#define PAGES_H_H2WQ9RLE
+
+#include "trb-types.h"
+
+/**
+ * trb_pages_realloc:
+ * @ptr: (nullable): The buffer to be resized.
+ * @old_size: The current size of the buffer in bytes.
+ * @new_size: The new size of the buffer in bytes.
+ * @threshold: The size starting from which the buffer is mapped. Zero disables mapping.
+ * @hugepages: %TRUE if the mapped buffer should be backed by transparent huge pages.
+ * @mapped: (inout): Indicates whether the buffer is mapped.
+ *
+ * Resizes the container buffer.
+ *
+ * Buffers smaller than @threshold are resized with `realloc()`.
+ * Once the buffer reaches @threshold, it is moved to an anonymous mapping,
+ * which is then resized with `mremap()`. The kernel moves the pages
+ * instead of copying the data, so growing a huge buffer neither copies it
+ * nor needs memory for two copies at once.
+ *
+ * Mapping is only supported on Linux. Elsewhere the buffer is always resized with `realloc()`.
+ *
+ * The memory past @old_size is zero-filled if the buffer ends up mapped.
+ * A mapped buffer must be freed with trb_pages_free().
+ *
+ * Returns: (nullable): The resized buffer.
+ * Can return %NULL if an error occurs, in which case @ptr is left intact.
+ **/
+void *trb_pages_realloc(void *ptr, usize old_size, usize new_size, usize threshold, bool hugepages, bool *mapped);
+
+/**
+ * trb_pages_free:
+ * @ptr: (nullable): The buffer to be freed.
+ * @size: The size of the buffer in bytes.
+ * @mapped: Indicates whether the buffer is mapped.
+ *
+ * Frees the container buffer allocated with trb_pages_realloc().
+ **/
+void trb_pages_free(void *ptr, usize size, bool mapped);
+
+#endif /* end of include guard: PAGES_H_H2WQ9RLE */
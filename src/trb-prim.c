@@ -0,0 +1,759 @@
+#include "trb-prim.h"
+
+#include "trb-math.h"
+#include "trb-messages.h"
+#include "trb-types.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define PRIM_AVX2 1
+	#include <immintrin.h>
+#endif
+
+#define PRIM_NETWORK_32 16
+#define PRIM_NETWORK_64 8
+#define PRIM_INSSORT_THRESHOLD 16
+
+/* Unsigned and float arrays are sorted through their order-preserving signed images */
+typedef i32 __attribute__((may_alias)) PrimI32;
+typedef i64 __attribute__((may_alias)) PrimI64;
+
+/* Scans read arbitrary elements through integers of the same size */
+typedef u32 __attribute__((may_alias)) PrimU32;
+typedef u64 __attribute__((may_alias)) PrimU64;
+
+#define PRIM_SORT_DEFINE(name, type)                                                              \
+	static inline void __trb_prim_swap_##name(type *a, type *b)                                   \
+	{                                                                                             \
+		type tmp = *a;                                                                            \
+		*a = *b;                                                                                  \
+		*b = tmp;                                                                                 \
+	}                                                                                             \
+                                                                                                  \
+	static void __trb_prim_inssort_##name(type *arr, usize len)                                   \
+	{                                                                                             \
+		for (usize i = 1; i < len; ++i) {                                                         \
+			type tmp = arr[i];                                                                    \
+			usize j = i;                                                                          \
+                                                                                                  \
+			for (; j > 0 && arr[j - 1] > tmp; --j)                                                \
+				arr[j] = arr[j - 1];                                                              \
+                                                                                                  \
+			arr[j] = tmp;                                                                         \
+		}                                                                                         \
+	}                                                                                             \
+                                                                                                  \
+	static void __trb_prim_sift_##name(type *arr, usize root, usize len)                          \
+	{                                                                                             \
+		type tmp = arr[root];                                                                     \
+                                                                                                  \
+		while (root * 2 + 1 < len) {                                                              \
+			usize child = root * 2 + 1;                                                           \
+                                                                                                  \
+			if (child + 1 < len && arr[child] < arr[child + 1])                                   \
+				child++;                                                                          \
+                                                                                                  \
+			if (!(tmp < arr[child]))                                                              \
+				break;                                                                            \
+                                                                                                  \
+			arr[root] = arr[child];                                                               \
+			root = child;                                                                         \
+		}                                                                                         \
+                                                                                                  \
+		arr[root] = tmp;                                                                          \
+	}                                                                                             \
+                                                                                                  \
+	static void __trb_prim_heapsort_##name(type *arr, usize len)                                  \
+	{                                                                                             \
+		for (usize i = len / 2; i > 0; --i)                                                       \
+			__trb_prim_sift_##name(arr, i - 1, len);                                              \
+                                                                                                  \
+		for (usize i = len - 1; i > 0; --i) {                                                     \
+			__trb_prim_swap_##name(&arr[0], &arr[i]);                                             \
+			__trb_prim_sift_##name(arr, 0, i);                                                    \
+		}                                                                                         \
+	}                                                                                             \
+                                                                                                  \
+	/* Introsort: median of three Hoare partitioning, heapsort on bad pivots, leaves to the leaf sort */ \
+	static void __trb_prim_sort_##name(                                                           \
+		type *arr, usize len, usize depth, void (*leaf)(type *, usize), usize leaf_len            \
+	)                                                                                             \
+	{                                                                                             \
+		while (len > leaf_len) {                                                                  \
+			if (depth == 0) {                                                                     \
+				__trb_prim_heapsort_##name(arr, len);                                             \
+				return;                                                                           \
+			}                                                                                     \
+                                                                                                  \
+			depth--;                                                                              \
+                                                                                                  \
+			usize mid = len / 2;                                                                  \
+                                                                                                  \
+			if (arr[mid] < arr[0])                                                                \
+				__trb_prim_swap_##name(&arr[mid], &arr[0]);                                       \
+                                                                                                  \
+			if (arr[len - 1] < arr[mid]) {                                                        \
+				__trb_prim_swap_##name(&arr[len - 1], &arr[mid]);                                 \
+                                                                                                  \
+				if (arr[mid] < arr[0])                                                            \
+					__trb_prim_swap_##name(&arr[mid], &arr[0]);                                   \
+			}                                                                                     \
+                                                                                                  \
+			__trb_prim_swap_##name(&arr[0], &arr[mid]);                                           \
+                                                                                                  \
+			type pivot = arr[0];                                                                  \
+			usize i = 0;                                                                          \
+			usize j = len;                                                                        \
+                                                                                                  \
+			while (1) {                                                                           \
+				while (arr[i] < pivot)                                                            \
+					i++;                                                                          \
+                                                                                                  \
+				do                                                                                \
+					j--;                                                                          \
+				while (pivot < arr[j]);                                                           \
+                                                                                                  \
+				if (i >= j)                                                                       \
+					break;                                                                        \
+                                                                                                  \
+				__trb_prim_swap_##name(&arr[i], &arr[j]);                                         \
+				i++;                                                                              \
+			}                                                                                     \
+                                                                                                  \
+			/* Recurse into the smaller part */                                                   \
+			usize left = j + 1;                                                                   \
+                                                                                                  \
+			if (left < len - left) {                                                              \
+				__trb_prim_sort_##name(arr, left, depth, leaf, leaf_len);                         \
+				arr += left;                                                                      \
+				len -= left;                                                                      \
+			} else {                                                                              \
+				__trb_prim_sort_##name(arr + left, len - left, depth, leaf, leaf_len);            \
+				len = left;                                                                       \
+			}                                                                                     \
+		}                                                                                         \
+                                                                                                  \
+		leaf(arr, len);                                                                           \
+	}
+
+PRIM_SORT_DEFINE(i32, PrimI32)
+PRIM_SORT_DEFINE(i64, PrimI64)
+
+#undef PRIM_SORT_DEFINE
+
+#ifdef PRIM_AVX2
+
+/*
+ * Bitonic sorting networks. Each layer compares every lane with its partner
+ * given by the permutation; lanes set in the mask keep the maximum.
+ */
+	#define PRIM_LAYER_I32(v, mask, p0, p1, p2, p3, p4, p5, p6, p7)                                  \
+		do {                                                                                     \
+			__m256i __p = _mm256_permutevar8x32_epi32((v), _mm256_setr_epi32(p0, p1, p2, p3, p4, p5, p6, p7)); \
+			(v) = _mm256_blend_epi32(_mm256_min_epi32((v), __p), _mm256_max_epi32((v), __p), (mask)); \
+		} while (0)
+
+/*
+ * AVX2 has no 64-bit min/max. The blend goes through the double variant:
+ * GCC folds _mm256_blendv_epi8 incorrectly when built with -funsigned-char.
+ */
+	#define PRIM_BLENDV_I64(a, b, mask) \
+		(_mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _mm256_castsi256_pd(mask))))
+
+	#define PRIM_MINMAX_I64(a, b, min, max)                    \
+		do {                                                   \
+			__m256i __gt = _mm256_cmpgt_epi64((a), (b));       \
+			(min) = PRIM_BLENDV_I64((a), (b), __gt);           \
+			(max) = PRIM_BLENDV_I64((b), (a), __gt);           \
+		} while (0)
+
+	#define PRIM_LAYER_I64(v, mask, perm)                      \
+		do {                                                   \
+			__m256i __p = _mm256_permute4x64_epi64((v), (perm)); \
+			__m256i __min, __max;                              \
+			PRIM_MINMAX_I64((v), __p, __min, __max);           \
+			(v) = _mm256_blend_epi32(__min, __max, (mask));    \
+		} while (0)
+
+__attribute__((target("avx2"))) static inline __m256i __trb_prim_merge8_i32(__m256i v)
+{
+	PRIM_LAYER_I32(v, 0xF0, 4, 5, 6, 7, 0, 1, 2, 3);
+	PRIM_LAYER_I32(v, 0xCC, 2, 3, 0, 1, 6, 7, 4, 5);
+	PRIM_LAYER_I32(v, 0xAA, 1, 0, 3, 2, 5, 4, 7, 6);
+	return v;
+}
+
+__attribute__((target("avx2"))) static inline __m256i __trb_prim_sort8_i32(__m256i v)
+{
+	PRIM_LAYER_I32(v, 0x66, 1, 0, 3, 2, 5, 4, 7, 6);
+	PRIM_LAYER_I32(v, 0x3C, 2, 3, 0, 1, 6, 7, 4, 5);
+	PRIM_LAYER_I32(v, 0x5A, 1, 0, 3, 2, 5, 4, 7, 6);
+	return __trb_prim_merge8_i32(v);
+}
+
+__attribute__((target("avx2"))) static void __trb_prim_network_i32(PrimI32 *arr, usize len)
+{
+	if (len <= 1)
+		return;
+
+	_Alignas(32) i32 buf[PRIM_NETWORK_32];
+
+	memcpy(buf, arr, len * sizeof(i32));
+	for (usize i = len; i < PRIM_NETWORK_32; ++i)
+		buf[i] = I32_MAX;
+
+	__m256i a = _mm256_load_si256((__m256i *) &buf[0]);
+	a = __trb_prim_sort8_i32(a);
+
+	if (len > 8) {
+		__m256i b = _mm256_load_si256((__m256i *) &buf[8]);
+		b = __trb_prim_sort8_i32(b);
+		b = _mm256_permutevar8x32_epi32(b, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+
+		__m256i lo = _mm256_min_epi32(a, b);
+		__m256i hi = _mm256_max_epi32(a, b);
+
+		a = __trb_prim_merge8_i32(lo);
+		b = __trb_prim_merge8_i32(hi);
+
+		_mm256_store_si256((__m256i *) &buf[8], b);
+	}
+
+	_mm256_store_si256((__m256i *) &buf[0], a);
+	memcpy(arr, buf, len * sizeof(i32));
+}
+
+__attribute__((target("avx2"))) static inline __m256i __trb_prim_merge4_i64(__m256i v)
+{
+	PRIM_LAYER_I64(v, 0xF0, 0x4E);
+	PRIM_LAYER_I64(v, 0xCC, 0xB1);
+	return v;
+}
+
+__attribute__((target("avx2"))) static inline __m256i __trb_prim_sort4_i64(__m256i v)
+{
+	PRIM_LAYER_I64(v, 0x3C, 0xB1);
+	return __trb_prim_merge4_i64(v);
+}
+
+__attribute__((target("avx2"))) static void __trb_prim_network_i64(PrimI64 *arr, usize len)
+{
+	if (len <= 1)
+		return;
+
+	_Alignas(32) i64 buf[PRIM_NETWORK_64];
+
+	memcpy(buf, arr, len * sizeof(i64));
+	for (usize i = len; i < PRIM_NETWORK_64; ++i)
+		buf[i] = I64_MAX;
+
+	__m256i a = _mm256_load_si256((__m256i *) &buf[0]);
+	a = __trb_prim_sort4_i64(a);
+
+	if (len > 4) {
+		__m256i b = _mm256_load_si256((__m256i *) &buf[4]);
+		b = __trb_prim_sort4_i64(b);
+		b = _mm256_permute4x64_epi64(b, 0x1B);
+
+		__m256i lo, hi;
+		PRIM_MINMAX_I64(a, b, lo, hi);
+
+		a = __trb_prim_merge4_i64(lo);
+		b = __trb_prim_merge4_i64(hi);
+
+		_mm256_store_si256((__m256i *) &buf[4], b);
+	}
+
+	_mm256_store_si256((__m256i *) &buf[0], a);
+	memcpy(arr, buf, len * sizeof(i64));
+}
+
+	#undef PRIM_LAYER_I32
+	#undef PRIM_BLENDV_I64
+	#undef PRIM_MINMAX_I64
+	#undef PRIM_LAYER_I64
+
+#endif
+
+static bool __trb_prim_has_avx2(void)
+{
+#ifdef PRIM_AVX2
+	return __builtin_cpu_supports("avx2");
+#else
+	return FALSE;
+#endif
+}
+
+static void __trb_prim_sort_i32_entry(PrimI32 *arr, usize len)
+{
+	if (len <= 1)
+		return;
+
+	usize depth = 2 * (USIZE_WIDTH - trb_clz(len));
+
+#ifdef PRIM_AVX2
+	if (__trb_prim_has_avx2()) {
+		__trb_prim_sort_i32(arr, len, depth, __trb_prim_network_i32, PRIM_NETWORK_32);
+		return;
+	}
+#endif
+
+	__trb_prim_sort_i32(arr, len, depth, __trb_prim_inssort_i32, PRIM_INSSORT_THRESHOLD);
+}
+
+static void __trb_prim_sort_i64_entry(PrimI64 *arr, usize len)
+{
+	if (len <= 1)
+		return;
+
+	usize depth = 2 * (USIZE_WIDTH - trb_clz(len));
+
+#ifdef PRIM_AVX2
+	if (__trb_prim_has_avx2()) {
+		__trb_prim_sort_i64(arr, len, depth, __trb_prim_network_i64, PRIM_NETWORK_64);
+		return;
+	}
+#endif
+
+	__trb_prim_sort_i64(arr, len, depth, __trb_prim_inssort_i64, PRIM_INSSORT_THRESHOLD);
+}
+
+void trb_sort_i32(i32 *arr, usize len)
+{
+	trb_return_if_fail(arr != NULL || len == 0);
+	__trb_prim_sort_i32_entry((PrimI32 *) arr, len);
+}
+
+void trb_sort_u32(u32 *arr, usize len)
+{
+	trb_return_if_fail(arr != NULL || len == 0);
+
+	PrimI32 *keys = (PrimI32 *) arr;
+
+	for (usize i = 0; i < len; ++i)
+		keys[i] ^= I32_MIN;
+
+	__trb_prim_sort_i32_entry(keys, len);
+
+	for (usize i = 0; i < len; ++i)
+		keys[i] ^= I32_MIN;
+}
+
+void trb_sort_f32(f32 *arr, usize len)
+{
+	trb_return_if_fail(arr != NULL || len == 0);
+
+	PrimI32 *keys = (PrimI32 *) arr;
+
+	/* Flipping the magnitude bits of negative floats orders them as signed integers */
+	for (usize i = 0; i < len; ++i)
+		keys[i] ^= (keys[i] >> 31) & I32_MAX;
+
+	__trb_prim_sort_i32_entry(keys, len);
+
+	for (usize i = 0; i < len; ++i)
+		keys[i] ^= (keys[i] >> 31) & I32_MAX;
+}
+
+void trb_sort_i64(i64 *arr, usize len)
+{
+	trb_return_if_fail(arr != NULL || len == 0);
+	__trb_prim_sort_i64_entry((PrimI64 *) arr, len);
+}
+
+void trb_sort_u64(u64 *arr, usize len)
+{
+	trb_return_if_fail(arr != NULL || len == 0);
+
+	PrimI64 *keys = (PrimI64 *) arr;
+
+	for (usize i = 0; i < len; ++i)
+		keys[i] ^= I64_MIN;
+
+	__trb_prim_sort_i64_entry(keys, len);
+
+	for (usize i = 0; i < len; ++i)
+		keys[i] ^= I64_MIN;
+}
+
+void trb_sort_f64(f64 *arr, usize len)
+{
+	trb_return_if_fail(arr != NULL || len == 0);
+
+	PrimI64 *keys = (PrimI64 *) arr;
+
+	for (usize i = 0; i < len; ++i)
+		keys[i] ^= (keys[i] >> 63) & I64_MAX;
+
+	__trb_prim_sort_i64_entry(keys, len);
+
+	for (usize i = 0; i < len; ++i)
+		keys[i] ^= (keys[i] >> 63) & I64_MAX;
+}
+
+#define PRIM_COUNT_BLOCK ((usize) 1 << 24)
+
+#define PRIM_SCAN_DEFINE(bits)                                                                    \
+	static usize __trb_prim_find##bits##_scalar(const PrimU##bits *arr, usize len, u##bits value)    \
+	{                                                                                             \
+		for (usize i = 0; i < len; ++i) {                                                         \
+			if (arr[i] == value)                                                                  \
+				return i;                                                                         \
+		}                                                                                         \
+                                                                                                  \
+		return len;                                                                               \
+	}                                                                                             \
+                                                                                                  \
+	static usize __trb_prim_count##bits##_scalar(const PrimU##bits *arr, usize len, u##bits value)   \
+	{                                                                                             \
+		usize count = 0;                                                                          \
+                                                                                                  \
+		for (usize i = 0; i < len; ++i)                                                           \
+			count += arr[i] == value;                                                             \
+                                                                                                  \
+		return count;                                                                             \
+	}
+
+PRIM_SCAN_DEFINE(32)
+PRIM_SCAN_DEFINE(64)
+
+#undef PRIM_SCAN_DEFINE
+
+#if defined(PRIM_AVX2) && defined(__SSE2__)
+	#define PRIM_SSE2 1
+#endif
+
+#ifdef PRIM_SSE2
+
+static usize __trb_prim_find32_sse2(const PrimU32 *arr, usize len, u32 value)
+{
+	__m128i needle = _mm_set1_epi32((i32) value);
+	usize i = 0;
+
+	for (; i + 4 <= len; i += 4) {
+		__m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) &arr[i]), needle);
+		u32 mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+
+		if (mask != 0)
+			return i + __builtin_ctz(mask);
+	}
+
+	return i + __trb_prim_find32_scalar(&arr[i], len - i, value);
+}
+
+/* SSE2 has no 64-bit compare: both 32-bit halves of a lane must be equal */
+static inline __m128i __trb_prim_cmpeq64_sse2(__m128i a, __m128i b)
+{
+	__m128i eq = _mm_cmpeq_epi32(a, b);
+	return _mm_and_si128(eq, _mm_shuffle_epi32(eq, 0xB1));
+}
+
+static usize __trb_prim_find64_sse2(const PrimU64 *arr, usize len, u64 value)
+{
+	__m128i needle = _mm_set1_epi64x((i64) value);
+	usize i = 0;
+
+	for (; i + 2 <= len; i += 2) {
+		__m128i eq = __trb_prim_cmpeq64_sse2(_mm_loadu_si128((const __m128i *) &arr[i]), needle);
+		u32 mask = _mm_movemask_pd(_mm_castsi128_pd(eq));
+
+		if (mask != 0)
+			return i + __builtin_ctz(mask);
+	}
+
+	return i + __trb_prim_find64_scalar(&arr[i], len - i, value);
+}
+
+static usize __trb_prim_count32_sse2(const PrimU32 *arr, usize len, u32 value)
+{
+	__m128i needle = _mm_set1_epi32((i32) value);
+	usize count = 0;
+	usize i = 0;
+
+	/* 32-bit lane counters are flushed before they can overflow */
+	while (i + 4 <= len) {
+		usize end = i + trb_min(len - i, PRIM_COUNT_BLOCK) / 4 * 4;
+		__m128i acc = _mm_setzero_si128();
+
+		for (; i < end; i += 4)
+			acc = _mm_sub_epi32(acc, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) &arr[i]), needle));
+
+		_Alignas(16) u32 lanes[4];
+		_mm_store_si128((__m128i *) lanes, acc);
+		count += (usize) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+
+	return count + __trb_prim_count32_scalar(&arr[i], len - i, value);
+}
+
+static usize __trb_prim_count64_sse2(const PrimU64 *arr, usize len, u64 value)
+{
+	__m128i needle = _mm_set1_epi64x((i64) value);
+	__m128i acc = _mm_setzero_si128();
+	usize i = 0;
+
+	for (; i + 2 <= len; i += 2)
+		acc = _mm_sub_epi64(acc, __trb_prim_cmpeq64_sse2(_mm_loadu_si128((const __m128i *) &arr[i]), needle));
+
+	_Alignas(16) u64 lanes[2];
+	_mm_store_si128((__m128i *) lanes, acc);
+
+	return lanes[0] + lanes[1] + __trb_prim_count64_scalar(&arr[i], len - i, value);
+}
+
+#endif
+
+#ifdef PRIM_AVX2
+
+/* Four vectors are checked per iteration to keep a single branch per cache line pair */
+__attribute__((target("avx2"))) static usize __trb_prim_find32_avx2(const PrimU32 *arr, usize len, u32 value)
+{
+	__m256i needle = _mm256_set1_epi32((i32) value);
+	usize i = 0;
+
+	for (; i + 32 <= len; i += 32) {
+		__m256i a = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) &arr[i]), needle);
+		__m256i b = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) &arr[i + 8]), needle);
+		__m256i c = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) &arr[i + 16]), needle);
+		__m256i d = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) &arr[i + 24]), needle);
+		__m256i any = _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d));
+
+		if (!_mm256_testz_si256(any, any))
+			break;
+	}
+
+	for (; i + 8 <= len; i += 8) {
+		__m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) &arr[i]), needle);
+		u32 mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+
+		if (mask != 0)
+			return i + __builtin_ctz(mask);
+	}
+
+	return i + __trb_prim_find32_scalar(&arr[i], len - i, value);
+}
+
+__attribute__((target("avx2"))) static usize __trb_prim_find64_avx2(const PrimU64 *arr, usize len, u64 value)
+{
+	__m256i needle = _mm256_set1_epi64x((i64) value);
+	usize i = 0;
+
+	for (; i + 16 <= len; i += 16) {
+		__m256i a = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) &arr[i]), needle);
+		__m256i b = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) &arr[i + 4]), needle);
+		__m256i c = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) &arr[i + 8]), needle);
+		__m256i d = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) &arr[i + 12]), needle);
+		__m256i any = _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d));
+
+		if (!_mm256_testz_si256(any, any))
+			break;
+	}
+
+	for (; i + 4 <= len; i += 4) {
+		__m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) &arr[i]), needle);
+		u32 mask = _mm256_movemask_pd(_mm256_castsi256_pd(eq));
+
+		if (mask != 0)
+			return i + __builtin_ctz(mask);
+	}
+
+	return i + __trb_prim_find64_scalar(&arr[i], len - i, value);
+}
+
+__attribute__((target("avx2"))) static usize __trb_prim_count32_avx2(const PrimU32 *arr, usize len, u32 value)
+{
+	__m256i needle = _mm256_set1_epi32((i32) value);
+	usize count = 0;
+	usize i = 0;
+
+	while (i + 8 <= len) {
+		usize end = i + trb_min(len - i, PRIM_COUNT_BLOCK) / 8 * 8;
+		__m256i acc = _mm256_setzero_si256();
+
+		for (; i < end; i += 8)
+			acc = _mm256_sub_epi32(acc, _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) &arr[i]), needle));
+
+		_Alignas(32) u32 lanes[8];
+		_mm256_store_si256((__m256i *) lanes, acc);
+
+		for (usize j = 0; j < 8; ++j)
+			count += lanes[j];
+	}
+
+	return count + __trb_prim_count32_scalar(&arr[i], len - i, value);
+}
+
+__attribute__((target("avx2"))) static usize __trb_prim_count64_avx2(const PrimU64 *arr, usize len, u64 value)
+{
+	__m256i needle = _mm256_set1_epi64x((i64) value);
+	__m256i acc = _mm256_setzero_si256();
+	usize i = 0;
+
+	for (; i + 4 <= len; i += 4)
+		acc = _mm256_sub_epi64(acc, _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) &arr[i]), needle));
+
+	_Alignas(32) u64 lanes[4];
+	_mm256_store_si256((__m256i *) lanes, acc);
+
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + __trb_prim_count64_scalar(&arr[i], len - i, value);
+}
+
+#endif
+
+#if defined(PRIM_AVX2) && defined(PRIM_SSE2)
+	#define PRIM_SCAN_DISPATCH(kernel, arr, len, value) \
+		(__trb_prim_has_avx2() ? kernel##_avx2(arr, len, value) : kernel##_sse2(arr, len, value))
+#elif defined(PRIM_AVX2)
+	#define PRIM_SCAN_DISPATCH(kernel, arr, len, value) \
+		(__trb_prim_has_avx2() ? kernel##_avx2(arr, len, value) : kernel##_scalar(arr, len, value))
+#else
+	#define PRIM_SCAN_DISPATCH(kernel, arr, len, value) (kernel##_scalar(arr, len, value))
+#endif
+
+static usize __trb_prim_find32(const PrimU32 *arr, usize len, u32 value)
+{
+	return PRIM_SCAN_DISPATCH(__trb_prim_find32, arr, len, value);
+}
+
+static usize __trb_prim_find64(const PrimU64 *arr, usize len, u64 value)
+{
+	return PRIM_SCAN_DISPATCH(__trb_prim_find64, arr, len, value);
+}
+
+static usize __trb_prim_count32(const PrimU32 *arr, usize len, u32 value)
+{
+	return PRIM_SCAN_DISPATCH(__trb_prim_count32, arr, len, value);
+}
+
+static usize __trb_prim_count64(const PrimU64 *arr, usize len, u64 value)
+{
+	return PRIM_SCAN_DISPATCH(__trb_prim_count64, arr, len, value);
+}
+
+#undef PRIM_SCAN_DISPATCH
+
+/* Non-contiguous slices are scanned element by element */
+static bool __trb_prim_find_at(const TrbSlice *slice, const void *target, usize *index)
+{
+	usize len = trb_slice_len(slice);
+
+	for (usize i = 0; i < len; ++i) {
+		if (memcmp(slice->at(slice, i), target, slice->elemsize) == 0) {
+			if (index != NULL)
+				*index = i;
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static usize __trb_prim_count_at(const TrbSlice *slice, const void *target)
+{
+	usize len = trb_slice_len(slice);
+	usize count = 0;
+
+	for (usize i = 0; i < len; ++i)
+		count += memcmp(slice->at(slice, i), target, slice->elemsize) == 0;
+
+	return count;
+}
+
+#define PRIM_FIND_DEFINE(name, type, bits)                                                        \
+	bool trb_find_##name(const TrbSlice *slice, type value, usize *index)                        \
+	{                                                                                             \
+		trb_return_val_if_fail(slice != NULL, FALSE);                                             \
+		trb_return_val_if_fail(slice->elemsize == sizeof(type), FALSE);                           \
+                                                                                                  \
+		usize len = trb_slice_len(slice);                                                         \
+		if (len == 0)                                                                             \
+			return FALSE;                                                                         \
+                                                                                                  \
+		if (!slice->contiguous)                                                                   \
+			return __trb_prim_find_at(slice, &value, index);                                      \
+                                                                                                  \
+		u##bits key;                                                                              \
+		memcpy(&key, &value, sizeof(key));                                                        \
+                                                                                                  \
+		usize pos = __trb_prim_find##bits(slice->at(slice, 0), len, key);                         \
+		if (pos == len)                                                                           \
+			return FALSE;                                                                         \
+                                                                                                  \
+		if (index != NULL)                                                                        \
+			*index = pos;                                                                         \
+                                                                                                  \
+		return TRUE;                                                                              \
+	}                                                                                             \
+                                                                                                  \
+	usize trb_count_##name(const TrbSlice *slice, type value)                                     \
+	{                                                                                             \
+		trb_return_val_if_fail(slice != NULL, 0);                                                 \
+		trb_return_val_if_fail(slice->elemsize == sizeof(type), 0);                               \
+                                                                                                  \
+		usize len = trb_slice_len(slice);                                                         \
+		if (len == 0)                                                                             \
+			return 0;                                                                             \
+                                                                                                  \
+		if (!slice->contiguous)                                                                   \
+			return __trb_prim_count_at(slice, &value);                                            \
+                                                                                                  \
+		u##bits key;                                                                              \
+		memcpy(&key, &value, sizeof(key));                                                        \
+                                                                                                  \
+		return __trb_prim_count##bits(slice->at(slice, 0), len, key);                             \
+	}
+
+PRIM_FIND_DEFINE(i32, i32, 32)
+PRIM_FIND_DEFINE(u32, u32, 32)
+PRIM_FIND_DEFINE(f32, f32, 32)
+PRIM_FIND_DEFINE(i64, i64, 64)
+PRIM_FIND_DEFINE(u64, u64, 64)
+PRIM_FIND_DEFINE(f64, f64, 64)
+
+#undef PRIM_FIND_DEFINE
+
+bool trb_find_bytes(const TrbSlice *slice, const void *target, usize *index)
+{
+	trb_return_val_if_fail(slice != NULL, FALSE);
+	trb_return_val_if_fail(target != NULL, FALSE);
+
+	usize len = trb_slice_len(slice);
+	if (len == 0)
+		return FALSE;
+
+	if (!slice->contiguous)
+		return __trb_prim_find_at(slice, target, index);
+
+	const char *data = slice->at(slice, 0);
+	usize elemsize = slice->elemsize;
+	usize pos = len;
+
+	usize addr = (usize) data;
+
+	if (elemsize == sizeof(u32) && addr % _Alignof(u32) == 0) {
+		u32 key;
+		memcpy(&key, target, sizeof(key));
+		pos = __trb_prim_find32((const PrimU32 *) data, len, key);
+	} else if (elemsize == sizeof(u64) && addr % _Alignof(u64) == 0) {
+		u64 key;
+		memcpy(&key, target, sizeof(key));
+		pos = __trb_prim_find64((const PrimU64 *) data, len, key);
+	} else if (elemsize == 1) {
+		const char *found = memchr(data, *(const char *) target, len);
+		pos = (found != NULL) ? (usize) (found - data) : len;
+	} else {
+		for (pos = 0; pos < len; ++pos) {
+			if (memcmp(&data[pos * elemsize], target, elemsize) == 0)
+				break;
+		}
+	}
+
+	if (pos == len)
+		return FALSE;
+
+	if (index != NULL)
+		*index = pos;
+
+	return TRUE;
+}
@@ -0,0 +1,237 @@
+#ifndef PRIM_H_K3VQ8ZRM
+#define PRIM_H_K3VQ8ZRM
+
+#include "trb-slice.h"
+#include "trb-types.h"
+
+/**
+ * SECTION: Primitive arrays
+ *
+ * Kernels for plain arrays of primitive types. They compare elements inline
+ * instead of calling a #TrbCmpFunc and use SIMD instructions when the CPU
+ * supports them.
+ *
+ * Floats are ordered by their bit pattern: negative NaNs go first,
+ * then -inf, negative numbers, -0.0, +0.0, positive numbers, +inf and positive NaNs.
+ * Likewise, floats are equal only if their bit patterns are equal,
+ * so NaNs can be found and -0.0 doesn't match +0.0.
+ **/
+
+/**
+ * trb_sort_i32:
+ * @arr: The array to be sorted.
+ * @len: The number of elements in the array.
+ *
+ * Sorts the array of #i32 in ascending order.
+ * Small partitions are sorted with AVX2 sorting networks if the CPU supports them.
+ **/
+void trb_sort_i32(i32 *arr, usize len);
+
+/**
+ * trb_sort_u32:
+ * @arr: The array to be sorted.
+ * @len: The number of elements in the array.
+ *
+ * Sorts the array of #u32 in ascending order. See trb_sort_i32().
+ **/
+void trb_sort_u32(u32 *arr, usize len);
+
+/**
+ * trb_sort_f32:
+ * @arr: The array to be sorted.
+ * @len: The number of elements in the array.
+ *
+ * Sorts the array of #f32 in ascending order. See trb_sort_i32().
+ **/
+void trb_sort_f32(f32 *arr, usize len);
+
+/**
+ * trb_sort_i64:
+ * @arr: The array to be sorted.
+ * @len: The number of elements in the array.
+ *
+ * Sorts the array of #i64 in ascending order.
+ * Small partitions are sorted with AVX2 sorting networks if the CPU supports them.
+ **/
+void trb_sort_i64(i64 *arr, usize len);
+
+/**
+ * trb_sort_u64:
+ * @arr: The array to be sorted.
+ * @len: The number of elements in the array.
+ *
+ * Sorts the array of #u64 in ascending order. See trb_sort_i64().
+ **/
+void trb_sort_u64(u64 *arr, usize len);
+
+/**
+ * trb_sort_f64:
+ * @arr: The array to be sorted.
+ * @len: The number of elements in the array.
+ *
+ * Sorts the array of #f64 in ascending order. See trb_sort_i64().
+ **/
+void trb_sort_f64(f64 *arr, usize len);
+
+/**
+ * trb_find_u32:
+ * @slice: The slice where to search.
+ * @value: The value to be found.
+ * @index: (optional) (out): The pointer to retrieve the index of the first match in the slice.
+ *
+ * Searches for the first element of the slice equal to @value.
+ * The element size of @slice must be equal to the size of #u32.
+ *
+ * Contiguous slices are scanned with AVX2 or SSE2 instructions,
+ * so long scans are bound by the memory bandwidth.
+ * Other slices are scanned element by element.
+ *
+ * Returns: %TRUE if found, %FALSE if not.
+ **/
+bool trb_find_u32(const TrbSlice *slice, u32 value, usize *index);
+
+/**
+ * trb_find_i32:
+ * @slice: The slice where to search.
+ * @value: The value to be found.
+ * @index: (optional) (out): The pointer to retrieve the index of the first match in the slice.
+ *
+ * Searches for the first #i32 equal to @value. See trb_find_u32().
+ *
+ * Returns: %TRUE if found, %FALSE if not.
+ **/
+bool trb_find_i32(const TrbSlice *slice, i32 value, usize *index);
+
+/**
+ * trb_find_f32:
+ * @slice: The slice where to search.
+ * @value: The value to be found.
+ * @index: (optional) (out): The pointer to retrieve the index of the first match in the slice.
+ *
+ * Searches for the first #f32 bitwise equal to @value. See trb_find_u32().
+ *
+ * Returns: %TRUE if found, %FALSE if not.
+ **/
+bool trb_find_f32(const TrbSlice *slice, f32 value, usize *index);
+
+/**
+ * trb_find_u64:
+ * @slice: The slice where to search.
+ * @value: The value to be found.
+ * @index: (optional) (out): The pointer to retrieve the index of the first match in the slice.
+ *
+ * Searches for the first #u64 equal to @value. See trb_find_u32().
+ *
+ * Returns: %TRUE if found, %FALSE if not.
+ **/
+bool trb_find_u64(const TrbSlice *slice, u64 value, usize *index);
+
+/**
+ * trb_find_i64:
+ * @slice: The slice where to search.
+ * @value: The value to be found.
+ * @index: (optional) (out): The pointer to retrieve the index of the first match in the slice.
+ *
+ * Searches for the first #i64 equal to @value. See trb_find_u32().
+ *
+ * Returns: %TRUE if found, %FALSE if not.
+ **/
+bool trb_find_i64(const TrbSlice *slice, i64 value, usize *index);
+
+/**
+ * trb_find_f64:
+ * @slice: The slice where to search.
+ * @value: The value to be found.
+ * @index: (optional) (out): The pointer to retrieve the index of the first match in the slice.
+ *
+ * Searches for the first #f64 bitwise equal to @value. See trb_find_u32().
+ *
+ * Returns: %TRUE if found, %FALSE if not.
+ **/
+bool trb_find_f64(const TrbSlice *slice, f64 value, usize *index);
+
+/**
+ * trb_count_u32:
+ * @slice: The slice where to count.
+ * @value: The value to be counted.
+ *
+ * Counts the elements of the slice equal to @value.
+ * The element size of @slice must be equal to the size of #u32.
+ * Contiguous slices are scanned with AVX2 or SSE2 instructions.
+ *
+ * Returns: The number of matches.
+ **/
+usize trb_count_u32(const TrbSlice *slice, u32 value);
+
+/**
+ * trb_count_i32:
+ * @slice: The slice where to count.
+ * @value: The value to be counted.
+ *
+ * Counts the #i32 elements equal to @value. See trb_count_u32().
+ *
+ * Returns: The number of matches.
+ **/
+usize trb_count_i32(const TrbSlice *slice, i32 value);
+
+/**
+ * trb_count_f32:
+ * @slice: The slice where to count.
+ * @value: The value to be counted.
+ *
+ * Counts the #f32 elements bitwise equal to @value. See trb_count_u32().
+ *
+ * Returns: The number of matches.
+ **/
+usize trb_count_f32(const TrbSlice *slice, f32 value);
+
+/**
+ * trb_count_u64:
+ * @slice: The slice where to count.
+ * @value: The value to be counted.
+ *
+ * Counts the #u64 elements equal to @value. See trb_count_u32().
+ *
+ * Returns: The number of matches.
+ **/
+usize trb_count_u64(const TrbSlice *slice, u64 value);
+
+/**
+ * trb_count_i64:
+ * @slice: The slice where to count.
+ * @value: The value to be counted.
+ *
+ * Counts the #i64 elements equal to @value. See trb_count_u32().
+ *
+ * Returns: The number of matches.
+ **/
+usize trb_count_i64(const TrbSlice *slice, i64 value);
+
+/**
+ * trb_count_f64:
+ * @slice: The slice where to count.
+ * @value: The value to be counted.
+ *
+ * Counts the #f64 elements bitwise equal to @value. See trb_count_u32().
+ *
+ * Returns: The number of matches.
+ **/
+usize trb_count_f64(const TrbSlice *slice, f64 value);
+
+/**
+ * trb_find_bytes:
+ * @slice: The slice where to search.
+ * @target: The pointer to the element to be found.
+ * @index: (optional) (out): The pointer to retrieve the index of the first match in the slice.
+ *
+ * Searches for the first element of the slice which bytes are equal to the bytes of @target.
+ * Suitable for plain data without padding only.
+ *
+ * Aligned 4- and 8-byte elements are scanned with the kernels of trb_find_u32() and trb_find_u64(),
+ * single bytes with `memchr()`.
+ *
+ * Returns: %TRUE if found, %FALSE if not.
+ **/
+bool trb_find_bytes(const TrbSlice *slice, const void *target, usize *index);
+
+#endif /* end of include guard: PRIM_H_K3VQ8ZRM */
@@ -0,0 +1,259 @@
+#include "trb-seg-vector.h"
+
+#include "trb-checked.h"
+#include "trb-macros.h"
+#include "trb-messages.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SEG_VECTOR_MIN_SHIFT 3
+#define SEG_VECTOR_MIN_SEGMENT_SIZE 256
+
+TrbSegVector *trb_seg_vector_init(TrbSegVector *self, bool clear, usize elemsize)
+{
+	trb_return_val_if_fail(elemsize != 0, NULL);
+
+	usize shift = SEG_VECTOR_MIN_SHIFT;
+
+	while ((elemsize << shift) < SEG_VECTOR_MIN_SEGMENT_SIZE)
+		shift++;
+
+	if (trb_chk_mul(elemsize, (usize) 1 << shift, NULL)) {
+		trb_msg_error("segment size overflow!");
+		return NULL;
+	}
+
+	if (self == NULL) {
+		self = trb_talloc(TrbSegVector, 1);
+
+		if (self == NULL) {
+			trb_msg_error("couldn't allocate memory for the vector!");
+			return NULL;
+		}
+	}
+
+	self->n_segments = 0;
+	self->shift = shift;
+	self->len = 0;
+	self->capacity = 0;
+	self->elemsize = elemsize;
+	self->clear = clear;
+
+	return self;
+}
+
+static bool __trb_seg_vector_add_segment(TrbSegVector *self)
+{
+	usize n_elems = (usize) 1 << (self->shift + self->n_segments);
+	usize size;
+
+	if (
+		self->shift + self->n_segments >= USIZE_WIDTH - 1 ||
+		trb_chk_mul(n_elems, self->elemsize, &size) ||
+		trb_chk_add(self->capacity, n_elems, NULL)
+	) {
+		trb_msg_error("vector capacity overflow!");
+		return FALSE;
+	}
+
+	void *segment;
+
+	if (self->clear)
+		segment = calloc(n_elems, self->elemsize);
+	else
+		segment = malloc(size);
+
+	if (segment == NULL) {
+		trb_msg_error("couldn't allocate memory for the vector segment!");
+		return FALSE;
+	}
+
+	self->segments[self->n_segments++] = segment;
+	self->capacity += n_elems;
+
+	return TRUE;
+}
+
+bool trb_seg_vector_require(TrbSegVector *self, usize newcap)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+
+	while (self->capacity < newcap) {
+		if (!__trb_seg_vector_add_segment(self))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+void *trb_seg_vector_emplace_back(TrbSegVector *self)
+{
+	trb_return_val_if_fail(self != NULL, NULL);
+
+	if (self->len == self->capacity && !__trb_seg_vector_add_segment(self))
+		return NULL;
+
+	return __trb_seg_vector_cell(self, self->len++);
+}
+
+bool trb_seg_vector_push_back(TrbSegVector *self, const void *data)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+
+	void *cell = trb_seg_vector_emplace_back(self);
+
+	if (cell == NULL)
+		return FALSE;
+
+	if (data == NULL)
+		memset(cell, 0, self->elemsize);
+	else
+		trb_memcopy(cell, data, self->elemsize);
+
+	return TRUE;
+}
+
+bool trb_seg_vector_push_back_many(TrbSegVector *self, const void *data, usize len)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+
+	usize newlen;
+
+	if (trb_chk_add(self->len, len, &newlen)) {
+		trb_msg_error("vector length overflow!");
+		return FALSE;
+	}
+
+	if (!trb_seg_vector_require(self, newlen))
+		return FALSE;
+
+	const char *cdata = data;
+	usize index = self->len;
+	self->len = newlen;
+
+	while (index != newlen) {
+		void *chunk;
+		usize n = trb_min(trb_seg_vector_chunk(self, index, &chunk), newlen - index);
+
+		if (cdata == NULL) {
+			memset(chunk, 0, n * self->elemsize);
+		} else {
+			memcpy(chunk, cdata, n * self->elemsize);
+			cdata += n * self->elemsize;
+		}
+
+		index += n;
+	}
+
+	return TRUE;
+}
+
+bool trb_seg_vector_pop_back(TrbSegVector *self, void *ret)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+
+	if (self->len == 0) {
+		trb_msg_warn("vector is empty!");
+		return FALSE;
+	}
+
+	self->len--;
+
+	if (ret != NULL)
+		memcpy(ret, __trb_seg_vector_cell(self, self->len), self->elemsize);
+
+	return TRUE;
+}
+
+usize trb_seg_vector_chunk(const TrbSegVector *self, usize index, void **chunk)
+{
+	trb_return_val_if_fail(self != NULL, 0);
+	trb_return_val_if_fail(chunk != NULL, 0);
+
+	if (index >= self->len)
+		return 0;
+
+	usize pos = index + ((usize) 1 << self->shift);
+	usize msb = (USIZE_WIDTH - 1) - trb_clz(pos);
+	usize segment_end = ((usize) 1 << (msb + 1)) - ((usize) 1 << self->shift);
+
+	*chunk = __trb_seg_vector_cell(self, index);
+
+	return trb_min(segment_end, self->len) - index;
+}
+
+static void *__trb_seg_vector_slice_at(const TrbSlice *self, usize index)
+{
+	TrbSegVector *vector = self->data;
+
+	usize len = trb_slice_len(self);
+	if (index >= len)
+		index = len;
+
+	usize pos = self->start + index;
+
+	/* The end of the slice may be past the last allocated segment */
+	if (pos == vector->capacity) {
+		if (pos == 0)
+			return NULL;
+
+		return (char *) __trb_seg_vector_cell(vector, pos - 1) + vector->elemsize;
+	}
+
+	return __trb_seg_vector_cell(vector, pos);
+}
+
+TrbSlice *trb_seg_vector_slice(TrbSegVector *self, TrbSlice *slice, usize start, usize end)
+{
+	trb_return_val_if_fail(self != NULL, NULL);
+	trb_return_val_if_fail(start <= end, NULL);
+
+	if (end > self->len) {
+		trb_msg_warn("interval [%zu:%zu) is out of bounds!", start, end);
+		return NULL;
+	}
+
+	if (slice == NULL) {
+		slice = trb_talloc(TrbSlice, 1);
+
+		if (slice == NULL) {
+			trb_msg_error("couldn't allocate memory for the slice!");
+			return NULL;
+		}
+	}
+
+	slice->at = __trb_seg_vector_slice_at;
+	slice->data = self;
+	slice->start = start;
+	slice->end = end;
+	slice->elemsize = self->elemsize;
+	slice->contiguous = FALSE;
+
+	return slice;
+}
+
+void trb_seg_vector_destroy(TrbSegVector *self, TrbFreeFunc free_func)
+{
+	trb_return_if_fail(self != NULL);
+
+	if (free_func != NULL) {
+		for (usize i = 0; i < self->len; ++i)
+			free_func(__trb_seg_vector_cell(self, i));
+	}
+
+	for (usize i = 0; i < self->n_segments; ++i)
+		free(self->segments[i]);
+
+	self->n_segments = 0;
+	self->len = 0;
+	self->capacity = 0;
+}
+
+void trb_seg_vector_free(TrbSegVector *self, TrbFreeFunc free_func)
+{
+	trb_return_if_fail(self != NULL);
+
+	trb_seg_vector_destroy(self, free_func);
+	free(self);
+}
@@ -0,0 +1,202 @@
+#ifndef SEG_VECTOR_H_5RKD1MVT
+#define SEG_VECTOR_H_5RKD1MVT
+
+#include "trb-math.h"
+#include "trb-slice.h"
+#include "trb-types.h"
+
+typedef struct _TrbSegVector TrbSegVector;
+
+/**
+ * TrbSegVector:
+ * @len: The size of the vector.
+ * @capacity: The number of elements the allocated segments can hold.
+ * @elemsize: The size of each element.
+ * @clear: Indicates whether elements should be cleared to 0 when allocated or not.
+ *
+ * A dynamic size array that never moves its elements.
+ *
+ * The elements are stored in segments which sizes are powers of two:
+ * every new segment is twice as large as the previous one.
+ * Growing the vector allocates a new segment and never copies the elements,
+ * so pointers to the elements stay valid until the elements are removed.
+ *
+ * The segment and the position of an element are computed
+ * from its index with a single count-leading-zeros instruction.
+ * Use trb_seg_vector_chunk() to process the elements segment by segment.
+ *
+ * This example shows how to sum the elements chunk by chunk:
+ * ```c
+ * u64 sum = 0;
+ * u32 *chunk;
+ *
+ * for (usize i = 0, n; (n = trb_seg_vector_chunk(&vec, i, (void **) &chunk)) != 0; i += n) {
+ *     for (usize j = 0; j < n; ++j)
+ *         sum += chunk[j];
+ * }
+ * ```
+ **/
+struct _TrbSegVector {
+	/* <private> */
+	void *segments[USIZE_WIDTH];
+	usize n_segments;
+	usize shift;
+
+	/* <public> */
+	usize len;
+	usize capacity;
+	usize elemsize;
+	bool clear;
+};
+
+/**
+ * trb_seg_vector_init:
+ * @self: (nullable): The pointer to the #TrbSegVector to be initialized.
+ * @clear: %TRUE if elements should be cleared to 0 when allocated.
+ * @elemsize: The size of each element in bytes.
+ *
+ * Creates a new segmented vector. Doesn't allocate memory for the elements.
+ *
+ * Returns: (nullable): A new segmented vector.
+ * Can return %NULL if an error occurs.
+ **/
+TrbSegVector *trb_seg_vector_init(TrbSegVector *self, bool clear, usize elemsize);
+
+/**
+ * trb_seg_vector_push_back:
+ * @self: The vector where to add the element.
+ * @data: The pointer to the data to be added.
+ *
+ * Adds the element to the end of the vector.
+ * If @data is %NULL, adds a zero to the end of the vector.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_seg_vector_push_back(TrbSegVector *self, const void *data);
+
+/**
+ * trb_seg_vector_push_back_many:
+ * @self: The vector where to add the elements.
+ * @data: The pointer to the data to be added.
+ * @len: The number of elements to be added.
+ *
+ * Adds the elements to the end of the vector.
+ * If @data is %NULL, adds @len zeros to the end of the vector.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_seg_vector_push_back_many(TrbSegVector *self, const void *data, usize len);
+
+/**
+ * trb_seg_vector_emplace_back:
+ * @self: The vector where to add the element.
+ *
+ * Adds an uninitialized element to the end of the vector
+ * and returns the pointer to it. The pointer stays valid
+ * until the element is removed.
+ *
+ * Returns: (nullable): The pointer to the added element.
+ * Can return %NULL if an error occurs.
+ **/
+void *trb_seg_vector_emplace_back(TrbSegVector *self);
+
+/**
+ * trb_seg_vector_pop_back:
+ * @self: The vector where to remove.
+ * @ret: (optional) (out): The pointer to retrieve removed data.
+ *
+ * Removes the last element of the vector.
+ * The memory of the element is kept for the next elements.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_seg_vector_pop_back(TrbSegVector *self, void *ret);
+
+/**
+ * trb_seg_vector_require:
+ * @self: The vector which capacity is to be increased.
+ * @newcap: The required capacity.
+ *
+ * Allocates segments until the vector can hold @newcap elements.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_seg_vector_require(TrbSegVector *self, usize newcap);
+
+/**
+ * trb_seg_vector_chunk:
+ * @self: The vector.
+ * @index: The index of the first element of the chunk.
+ * @chunk: (out): The pointer to retrieve the pointer to the first element of the chunk.
+ *
+ * Gets the longest run of contiguous elements starting at @index.
+ * The run ends at the end of a segment or at the end of the vector.
+ *
+ * Returns: The number of elements in the chunk. Zero if @index is out of bounds.
+ **/
+usize trb_seg_vector_chunk(const TrbSegVector *self, usize index, void **chunk);
+
+/**
+ * trb_seg_vector_slice:
+ * @self: The vector to be sliced.
+ * @slice: (nullable): The pointer to the slice to be initialized.
+ * @start: The start position in the vector.
+ * @end: The end position in the vector.
+ *
+ * Slices the #TrbSegVector. The slice isn't contiguous.
+ * If allocated on the heap, use `free()` to release the allocated memory.
+ *
+ * Returns: (nullable): A new #TrbSlice.
+ * Can return %NULL if an error occurs.
+ **/
+TrbSlice *trb_seg_vector_slice(TrbSegVector *self, TrbSlice *slice, usize start, usize end);
+
+/**
+ * trb_seg_vector_destroy:
+ * @self: The vector which segments are to be freed.
+ * @free_func: (scope call) (nullable): The function for freeing elements.
+ *
+ * Frees the vector segments.
+ **/
+void trb_seg_vector_destroy(TrbSegVector *self, TrbFreeFunc free_func);
+
+/**
+ * trb_seg_vector_free:
+ * @self: The vector to be freed.
+ * @free_func: (scope call) (nullable): The function for freeing elements.
+ *
+ * Frees the vector completely.
+ **/
+void trb_seg_vector_free(TrbSegVector *self, TrbFreeFunc free_func);
+
+/* Segment k holds 2^(shift + k) elements starting at index 2^shift * (2^k - 1) */
+static inline void *__trb_seg_vector_cell(const TrbSegVector *self, usize index)
+{
+	usize pos = index + ((usize) 1 << self->shift);
+	usize msb = (USIZE_WIDTH - 1) - trb_clz(pos);
+	usize segment = msb - self->shift;
+
+	return &((char *) self->segments[segment])[(pos - ((usize) 1 << msb)) * self->elemsize];
+}
+
+/**
+ * trb_seg_vector_ptr:
+ * @self: The vector where to get.
+ * @type: The type of the element.
+ * @index: The position of the entry.
+ *
+ * Gets the pointer to the entry in the vector at the given index.
+ **/
+#define trb_seg_vector_ptr(self, type, index) ((type *) __trb_seg_vector_cell((self), (index)))
+
+/**
+ * trb_seg_vector_get:
+ * @self: The vector where to get.
+ * @type: The type of the element.
+ * @index: The position of the entry.
+ *
+ * Gets the value of the entry in the vector at the given index.
+ **/
+#define trb_seg_vector_get(self, type, index) (*trb_seg_vector_ptr(self, type, index))
+
+#endif /* end of include guard: SEG_VECTOR_H_5RKD1MVT */
@@ -34,6 +34,7 @@ TrbSlice *trb_slice_init(TrbSlice *self, void *data, usize elemsize, usize start
 	self->elemsize = elemsize;
 	self->start = start;
 	self->end = end;
+	self->contiguous = TRUE;
 
 	return self;
 }
@@ -63,6 +64,7 @@ TrbSlice *trb_slice_reslice(TrbSlice *src, TrbSlice *dst, usize start, usize end
 	dst->elemsize = src->elemsize;
 	dst->start = src->start + start;
 	dst->end = src->start + end;
+	dst->contiguous = src->contiguous;
 
 	return dst;
 }
@@ -12,6 +12,9 @@ typedef struct _TrbSlice TrbSlice;
  * @elemsize: The size of each element in the slice.
  * @start: The start position in the slice data.
  * @end: The end position in the slice data.
+ * @contiguous: Indicates whether elements of the slice are stored contiguously.
+ * If %TRUE, algorithms obtain the first element with @at and address
+ * the others directly instead of calling @at for each element.
  *
  * It is a data structure that is used to represent a portion
  * of the data in any container whose elements can be directly accessed.
@@ -41,6 +44,7 @@ struct _TrbSlice {
 	usize elemsize;
 	usize start;
 	usize end;
+	bool contiguous;
 };
 
 /**
@@ -0,0 +1,318 @@
+#include "trb-small-vector.h"
+
+#include "trb-checked.h"
+#include "trb-math.h"
+#include "trb-messages.h"
+#include "trb-utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define trb_small_vector_cell(a, i) ((void *) &((char *) trb_small_vector_data(a))[(i) * (a)->elemsize])
+
+TrbSmallVector *trb_small_vector_init(TrbSmallVector *self, bool clear, usize elemsize)
+{
+	trb_return_val_if_fail(elemsize != 0, NULL);
+
+	if (self == NULL) {
+		self = trb_talloc(TrbSmallVector, 1);
+
+		if (self == NULL) {
+			trb_msg_error("couldn't allocate memory for the vector!");
+			return NULL;
+		}
+	}
+
+	if (clear)
+		memset(self->inline_buf, 0, TRB_SMALL_VECTOR_INLINE_SIZE);
+
+	self->heap = NULL;
+	self->len = 0;
+	self->capacity = TRB_SMALL_VECTOR_INLINE_SIZE / elemsize;
+	self->elemsize = elemsize;
+	self->clear = clear;
+	self->growth = TRB_GROWTH_1_5X;
+	self->growth_func = NULL;
+
+	return self;
+}
+
+void trb_small_vector_set_growth(TrbSmallVector *self, TrbGrowth growth, TrbGrowthFunc growth_func)
+{
+	trb_return_if_fail(self != NULL);
+	trb_return_if_fail(growth != TRB_GROWTH_CUSTOM || growth_func != NULL);
+
+	self->growth = growth;
+	self->growth_func = growth_func;
+}
+
+static bool __trb_small_vector_newcap(TrbSmallVector *self, usize newcap)
+{
+	if (!trb_growth_capacity(self->growth, self->growth_func, self->capacity, newcap, &newcap)) {
+		trb_msg_error("vector capacity overflow!");
+		return FALSE;
+	}
+
+	if (trb_chk_mul(newcap, self->elemsize, NULL)) {
+		trb_msg_error("vector capacity overflow!");
+		return FALSE;
+	}
+
+	void *data;
+
+	if (self->heap == NULL) {
+		data = malloc(newcap * self->elemsize);
+
+		if (data != NULL)
+			memcpy(data, self->inline_buf, self->len * self->elemsize);
+	} else {
+		data = realloc(self->heap, newcap * self->elemsize);
+	}
+
+	if (data == NULL) {
+		trb_msg_error("couldn't allocate memory for the vector buffer!");
+		return FALSE;
+	}
+
+	self->heap = data;
+
+	if (self->clear) {
+		memset(
+			trb_small_vector_cell(self, self->len), 0,
+			(newcap - self->len) * self->elemsize
+		);
+	}
+
+	self->capacity = newcap;
+
+	return TRUE;
+}
+
+static bool __trb_small_vector_make_room(TrbSmallVector *self, usize index, usize len)
+{
+	usize newlen;
+
+	if (trb_chk_add(trb_max(index, self->len), len, &newlen)) {
+		trb_msg_error("vector index/length overflow!");
+		return FALSE;
+	}
+
+	if (newlen > self->capacity) {
+		if (__trb_small_vector_newcap(self, newlen) == FALSE)
+			return FALSE;
+	}
+
+	if (index < self->len) {
+		memmove(
+			trb_small_vector_cell(self, index + len),
+			trb_small_vector_cell(self, index),
+			(self->len - index) * self->elemsize
+		);
+	}
+
+	self->len = newlen;
+
+	return TRUE;
+}
+
+static bool __trb_small_vector_insert_many(TrbSmallVector *self, usize index, const void *data, usize len)
+{
+	if (len == 0)
+		return TRUE;
+
+	if (!__trb_small_vector_make_room(self, index, len))
+		return FALSE;
+
+	if (data == NULL)
+		memset(trb_small_vector_cell(self, index), 0, len * self->elemsize);
+	else
+		memcpy(trb_small_vector_cell(self, index), data, len * self->elemsize);
+
+	return TRUE;
+}
+
+bool trb_small_vector_push_back(TrbSmallVector *self, const void *data)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	return __trb_small_vector_insert_many(self, self->len, data, 1);
+}
+
+bool trb_small_vector_push_back_many(TrbSmallVector *self, const void *data, usize len)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	return __trb_small_vector_insert_many(self, self->len, data, len);
+}
+
+bool trb_small_vector_insert(TrbSmallVector *self, usize index, const void *data)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	return __trb_small_vector_insert_many(self, index, data, 1);
+}
+
+bool trb_small_vector_insert_many(TrbSmallVector *self, usize index, const void *data, usize len)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	return __trb_small_vector_insert_many(self, index, data, len);
+}
+
+void *trb_small_vector_emplace_back(TrbSmallVector *self, usize len)
+{
+	trb_return_val_if_fail(self != NULL, NULL);
+	trb_return_val_if_fail(len != 0, NULL);
+
+	usize index = self->len;
+
+	if (!__trb_small_vector_make_room(self, index, len))
+		return NULL;
+
+	return trb_small_vector_cell(self, index);
+}
+
+static bool __trb_small_vector_remove_range(TrbSmallVector *self, usize index, usize len, void *ret)
+{
+	if (len == 0)
+		return TRUE;
+
+	if (trb_chk_add(index, len, NULL)) {
+		trb_msg_error("vector index overflow!");
+		return FALSE;
+	}
+
+	if (index + len > self->len) {
+		if (len == 1) {
+			trb_msg_warn("element at [%zu] is out of bounds!", index);
+		} else {
+			trb_msg_warn("range [%zu:%zu] is out of bounds!", index, index + len - 1);
+		}
+
+		return FALSE;
+	}
+
+	if (ret != NULL)
+		memcpy(ret, trb_small_vector_cell(self, index), len * self->elemsize);
+
+	if (index + len != self->len) {
+		memmove(
+			trb_small_vector_cell(self, index),
+			trb_small_vector_cell(self, index + len),
+			(self->len - len - index) * self->elemsize
+		);
+	}
+
+	self->len -= len;
+
+	return TRUE;
+}
+
+bool trb_small_vector_remove(TrbSmallVector *self, usize index, void *ret)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+
+	if (self->len == 0) {
+		trb_msg_warn("vector is empty!");
+		return FALSE;
+	}
+
+	return __trb_small_vector_remove_range(self, index, 1, ret);
+}
+
+bool trb_small_vector_remove_range(TrbSmallVector *self, usize index, usize len, void *ret)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	return __trb_small_vector_remove_range(self, index, len, ret);
+}
+
+bool trb_small_vector_pop_back(TrbSmallVector *self, void *ret)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+
+	if (self->len == 0) {
+		trb_msg_warn("vector is empty!");
+		return FALSE;
+	}
+
+	return __trb_small_vector_remove_range(self, self->len - 1, 1, ret);
+}
+
+bool trb_small_vector_require(TrbSmallVector *self, usize newcap)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+
+	if (newcap <= self->capacity)
+		return TRUE;
+
+	return __trb_small_vector_newcap(self, newcap);
+}
+
+bool trb_small_vector_is_inline(const TrbSmallVector *self)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	return self->heap == NULL;
+}
+
+static void *__trb_small_vector_slice_at(const TrbSlice *self, usize index)
+{
+	TrbSmallVector *vector = self->data;
+
+	usize len = trb_slice_len(self);
+	if (index >= len)
+		return trb_small_vector_cell(vector, self->end);
+
+	return trb_small_vector_cell(vector, self->start + index);
+}
+
+TrbSlice *trb_small_vector_slice(TrbSmallVector *self, TrbSlice *slice, usize start, usize end)
+{
+	trb_return_val_if_fail(self != NULL, NULL);
+	trb_return_val_if_fail(start <= end, NULL);
+
+	if (end > self->len) {
+		trb_msg_warn("interval [%zu:%zu) is out of bounds!", start, end);
+		return NULL;
+	}
+
+	if (slice == NULL) {
+		slice = trb_talloc(TrbSlice, 1);
+
+		if (slice == NULL) {
+			trb_msg_error("couldn't allocate memory for the slice!");
+			return NULL;
+		}
+	}
+
+	slice->at = __trb_small_vector_slice_at;
+	slice->data = self;
+	slice->start = start;
+	slice->end = end;
+	slice->elemsize = self->elemsize;
+	slice->contiguous = TRUE;
+
+	return slice;
+}
+
+void trb_small_vector_destroy(TrbSmallVector *self, TrbFreeFunc free_func)
+{
+	trb_return_if_fail(self != NULL);
+
+	if (free_func != NULL) {
+		for (usize i = 0; i < self->len; ++i)
+			free_func(trb_small_vector_cell(self, i));
+	}
+
+	free(self->heap);
+
+	if (self->clear)
+		memset(self->inline_buf, 0, TRB_SMALL_VECTOR_INLINE_SIZE);
+
+	self->heap = NULL;
+	self->len = 0;
+	self->capacity = TRB_SMALL_VECTOR_INLINE_SIZE / self->elemsize;
+}
+
+void trb_small_vector_free(TrbSmallVector *self, TrbFreeFunc free_func)
+{
+	trb_return_if_fail(self != NULL);
+
+	trb_small_vector_destroy(self, free_func);
+	free(self);
+}
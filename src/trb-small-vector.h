@@ -0,0 +1,261 @@
+#ifndef SMALL_VECTOR_H_J3VWQ8ZR
+#define SMALL_VECTOR_H_J3VWQ8ZR
+
+#include "trb-growth.h"
+#include "trb-slice.h"
+#include "trb-types.h"
+
+#include <stddef.h>
+
+/**
+ * TRB_SMALL_VECTOR_INLINE_SIZE:
+ *
+ * The size of the inline storage of #TrbSmallVector in bytes.
+ **/
+#define TRB_SMALL_VECTOR_INLINE_SIZE 64
+
+typedef struct _TrbSmallVector TrbSmallVector;
+
+/**
+ * TrbSmallVector:
+ * @len: The size of the vector.
+ * @capacity: The capacity of the vector.
+ * @elemsize: The size of each element.
+ * @clear: Indicates whether elements should be cleared to 0 when allocated or not.
+ * @growth: The policy for growing the capacity of the heap buffer.
+ * @growth_func: The growth function used if @growth is %TRB_GROWTH_CUSTOM.
+ *
+ * A dynamic size array that stores its first elements inside the structure.
+ *
+ * As many elements as fit into %TRB_SMALL_VECTOR_INLINE_SIZE bytes
+ * are stored inline, so small vectors don't allocate at all.
+ * The elements are moved to the heap once the vector grows past that.
+ *
+ * The heap buffer pointer is %NULL while the elements are inline,
+ * so the structure can be copied with `memcpy()` or assignment
+ * without leaving a pointer to the old inline storage behind.
+ * Use trb_small_vector_data() to get the elements.
+ **/
+struct _TrbSmallVector {
+	/* <private> */
+	void *heap;
+
+	_Alignas(max_align_t) u8 inline_buf[TRB_SMALL_VECTOR_INLINE_SIZE];
+
+	/* <public> */
+	usize len;
+	usize capacity;
+	usize elemsize;
+	bool clear;
+	TrbGrowth growth;
+	TrbGrowthFunc growth_func;
+};
+
+/**
+ * trb_small_vector_init:
+ * @self: (nullable): The pointer to the #TrbSmallVector to be initialized.
+ * @clear: %TRUE if elements should be cleared to 0 when allocated.
+ * @elemsize: The size of each element in bytes.
+ *
+ * Creates a new small vector. Doesn't allocate memory for the elements.
+ *
+ * Returns: (nullable): A new small vector.
+ * Can return %NULL if an error occurs.
+ **/
+TrbSmallVector *trb_small_vector_init(TrbSmallVector *self, bool clear, usize elemsize);
+
+/**
+ * trb_small_vector_set_growth:
+ * @self: The vector which growth policy is to be set.
+ * @growth: The growth policy.
+ * @growth_func: (nullable): The growth function. Must not be %NULL if @growth is %TRB_GROWTH_CUSTOM.
+ *
+ * Sets the policy for growing the capacity of the heap buffer.
+ * The default policy is %TRB_GROWTH_1_5X.
+ **/
+void trb_small_vector_set_growth(TrbSmallVector *self, TrbGrowth growth, TrbGrowthFunc growth_func);
+
+/**
+ * trb_small_vector_push_back:
+ * @self: The vector where to add the element.
+ * @data: The pointer to the data to be added.
+ *
+ * Adds the element to the end of the vector.
+ * If @data is %NULL, adds a zero to the end of the vector.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_small_vector_push_back(TrbSmallVector *self, const void *data);
+
+/**
+ * trb_small_vector_push_back_many:
+ * @self: The vector where to add the elements.
+ * @data: The pointer to the data to be added.
+ * @len: The number of elements to be added.
+ *
+ * Adds the elements to the end of the vector.
+ * If @data is %NULL, adds @len zeros to the end of the vector.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_small_vector_push_back_many(TrbSmallVector *self, const void *data, usize len);
+
+/**
+ * trb_small_vector_insert:
+ * @self: The vector where to insert.
+ * @index: The position to place the element at.
+ * @data: The pointer to the data to be inserted.
+ *
+ * Inserts the element into the vector at the given index.
+ * If @data is %NULL, inserts a zero into the vector.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_small_vector_insert(TrbSmallVector *self, usize index, const void *data);
+
+/**
+ * trb_small_vector_insert_many:
+ * @self: The vector where to insert.
+ * @index: The position to place the elements at.
+ * @data: The pointer to the data to be inserted.
+ * @len: The number of elements to be inserted.
+ *
+ * Inserts the elements into the vector at the given index.
+ * If @data is %NULL, inserts @len zeros into the vector.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_small_vector_insert_many(TrbSmallVector *self, usize index, const void *data, usize len);
+
+/**
+ * trb_small_vector_emplace_back:
+ * @self: The vector where to add the elements.
+ * @len: The number of elements to be added.
+ *
+ * Adds @len uninitialized elements to the end of the vector
+ * and returns the pointer to them. See trb_vector_emplace_back().
+ *
+ * Returns: (nullable): The pointer to the first added element.
+ * Can return %NULL if an error occurs.
+ **/
+void *trb_small_vector_emplace_back(TrbSmallVector *self, usize len);
+
+/**
+ * trb_small_vector_remove:
+ * @self: The vector where to remove.
+ * @index: The index of the element to be removed.
+ * @ret: (optional) (out): The pointer to retrieve removed data.
+ *
+ * Removes the element from the vector at the given index.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_small_vector_remove(TrbSmallVector *self, usize index, void *ret);
+
+/**
+ * trb_small_vector_remove_range:
+ * @self: The vector where to remove.
+ * @index: The index of the first element to be removed.
+ * @len: The number of elements to be removed.
+ * @ret: (optional) (out): The pointer to retrieve removed data.
+ *
+ * Removes @len elements from the vector starting at the given index.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_small_vector_remove_range(TrbSmallVector *self, usize index, usize len, void *ret);
+
+/**
+ * trb_small_vector_pop_back:
+ * @self: The vector where to remove.
+ * @ret: (optional) (out): The pointer to retrieve removed data.
+ *
+ * Removes the last element of the vector.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_small_vector_pop_back(TrbSmallVector *self, void *ret);
+
+/**
+ * trb_small_vector_require:
+ * @self: The vector which capacity is to be increased.
+ * @newcap: The required capacity.
+ *
+ * Makes sure the vector can hold @newcap elements without reallocating.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_small_vector_require(TrbSmallVector *self, usize newcap);
+
+/**
+ * trb_small_vector_is_inline:
+ * @self: The vector.
+ *
+ * Returns: %TRUE if the elements are stored inline.
+ **/
+bool trb_small_vector_is_inline(const TrbSmallVector *self);
+
+/**
+ * trb_small_vector_slice:
+ * @self: The vector to be sliced.
+ * @slice: (nullable): The pointer to the slice to be initialized.
+ * @start: The start position in the vector.
+ * @end: The end position in the vector.
+ *
+ * Slices the #TrbSmallVector.
+ * If allocated on the heap, use `free()` to release the allocated memory.
+ *
+ * Returns: (nullable): A new #TrbSlice.
+ * Can return %NULL if an error occurs.
+ **/
+TrbSlice *trb_small_vector_slice(TrbSmallVector *self, TrbSlice *slice, usize start, usize end);
+
+/**
+ * trb_small_vector_destroy:
+ * @self: The vector which buffer is to be freed.
+ * @free_func: (scope call) (nullable): The function for freeing elements.
+ *
+ * Frees the heap buffer of the vector, if any, and makes the vector empty.
+ * The vector can be used again afterwards.
+ **/
+void trb_small_vector_destroy(TrbSmallVector *self, TrbFreeFunc free_func);
+
+/**
+ * trb_small_vector_free:
+ * @self: The vector to be freed.
+ * @free_func: (scope call) (nullable): The function for freeing elements.
+ *
+ * Frees the vector completely.
+ **/
+void trb_small_vector_free(TrbSmallVector *self, TrbFreeFunc free_func);
+
+/**
+ * trb_small_vector_data:
+ * @self: The vector.
+ *
+ * Gets the pointer to the elements of the vector.
+ * The pointer is valid until the vector is modified or moved.
+ **/
+#define trb_small_vector_data(self) ((void *) ((self)->heap != NULL ? (self)->heap : (self)->inline_buf))
+
+/**
+ * trb_small_vector_ptr:
+ * @self: The vector where to get.
+ * @type: The type of the element.
+ * @index: The position of the entry.
+ *
+ * Gets the pointer to the entry in the vector at the given index.
+ **/
+#define trb_small_vector_ptr(self, type, index) ((type *) &((char *) trb_small_vector_data(self))[(index) * (self)->elemsize])
+
+/**
+ * trb_small_vector_get:
+ * @self: The vector where to get.
+ * @type: The type of the element.
+ * @index: The position of the entry.
+ *
+ * Gets the value of the entry in the vector at the given index.
+ **/
+#define trb_small_vector_get(self, type, index) (*trb_small_vector_ptr(self, type, index))
+
+#endif /* end of include guard: SMALL_VECTOR_H_J3VWQ8ZR */
@@ -2,6 +2,7 @@
 
 #include "trb-checked.h"
 #include "trb-messages.h"
+#include "trb-pages.h"
 #include "trb-utils.h"
 
 #include <errno.h>
@@ -22,6 +23,12 @@ TrbString *trb_string_init0(TrbString *self)
 	self->data = NULL;
 	self->len = 0;
 	self->capacity = 0;
+	self->growth = TRB_GROWTH_1_5X;
+	self->growth_func = NULL;
+	self->map_threshold = 0;
+	self->map_hugepages = FALSE;
+	self->mapped = FALSE;
+	self->refs = NULL;
 
 	return self;
 }
@@ -66,6 +73,12 @@ TrbString *trb_string_init(TrbString *self, const char *c_str)
 
 	self->len = len;
 	self->capacity = capacity;
+	self->growth = TRB_GROWTH_1_5X;
+	self->growth_func = NULL;
+	self->map_threshold = 0;
+	self->map_hugepages = FALSE;
+	self->mapped = FALSE;
+	self->refs = NULL;
 
 	return self;
 }
@@ -106,6 +119,12 @@ TrbString *trb_string_init_len(TrbString *self, const char *str, usize len)
 
 	self->len = len;
 	self->capacity = capacity;
+	self->growth = TRB_GROWTH_1_5X;
+	self->growth_func = NULL;
+	self->map_threshold = 0;
+	self->map_hugepages = FALSE;
+	self->mapped = FALSE;
+	self->refs = NULL;
 
 	return self;
 }
@@ -139,6 +158,12 @@ TrbString *trb_string_init_sized(TrbString *self, usize cap)
 
 	self->len = 0;
 	self->capacity = cap;
+	self->growth = TRB_GROWTH_1_5X;
+	self->growth_func = NULL;
+	self->map_threshold = 0;
+	self->map_hugepages = FALSE;
+	self->mapped = FALSE;
+	self->refs = NULL;
 
 	return self;
 }
@@ -178,16 +203,146 @@ TrbString *trb_string_init_vfmt(TrbString *self, const char *fmt, va_list args)
 	return result;
 }
 
-static bool __trb_string_newcap(TrbString *self, usize newcap)
+void trb_string_set_growth(TrbString *self, TrbGrowth growth, TrbGrowthFunc growth_func)
 {
-	usize new_allocated = (newcap >> 3) + (newcap < 9 ? 3 : 6);
+	trb_return_if_fail(self != NULL);
+	trb_return_if_fail(growth != TRB_GROWTH_CUSTOM || growth_func != NULL);
+
+	self->growth = growth;
+	self->growth_func = growth_func;
+}
+
+void trb_string_set_mmap(TrbString *self, usize threshold, bool hugepages)
+{
+	trb_return_if_fail(self != NULL);
+
+	self->map_threshold = threshold;
+	self->map_hugepages = hugepages;
+}
+
+/* Drops a reference to the buffer. Returns TRUE if it was the last one */
+static bool __trb_string_unref(TrbString *self)
+{
+	if (self->refs == NULL)
+		return TRUE;
+
+	if (__atomic_sub_fetch(self->refs, 1, __ATOMIC_ACQ_REL) != 0)
+		return FALSE;
+
+	free(self->refs);
+	self->refs = NULL;
+
+	return TRUE;
+}
+
+/* A buffer which other strings have released is taken back without copying */
+static bool __trb_string_is_shared(TrbString *self)
+{
+	if (self->refs == NULL)
+		return FALSE;
+
+	if (__atomic_load_n(self->refs, __ATOMIC_ACQUIRE) != 1)
+		return TRUE;
+
+	free(self->refs);
+	self->refs = NULL;
+
+	return FALSE;
+}
+
+/* Moves the string to a private buffer of the given capacity */
+static bool __trb_string_detach(TrbString *self, usize newcap)
+{
+	bool mapped = FALSE;
+
+	char *data = trb_pages_realloc(NULL, 0, newcap, self->map_threshold, self->map_hugepages, &mapped);
+
+	if (data == NULL) {
+		trb_msg_error("couldn't allocate memory for a private buffer of the string!");
+		return FALSE;
+	}
 
-	if (trb_chk_add(newcap, new_allocated, &newcap)) {
+	memcpy(data, self->data, self->len + 1);
+
+	if (__trb_string_unref(self))
+		trb_pages_free(self->data, self->capacity, self->mapped);
+
+	self->data = data;
+	self->capacity = newcap;
+	self->mapped = mapped;
+	self->refs = NULL;
+
+	return TRUE;
+}
+
+bool trb_string_unshare(TrbString *self)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+
+	if (!__trb_string_is_shared(self))
+		return TRUE;
+
+	return __trb_string_detach(self, self->capacity);
+}
+
+TrbString *trb_string_copy_cow(TrbString *src, TrbString *dst)
+{
+	trb_return_val_if_fail(src != NULL, NULL);
+
+	if (src->data == NULL) {
+		trb_msg_warn("source string buffer is NULL!");
+		return NULL;
+	}
+
+	bool was_allocated = FALSE;
+
+	if (dst == NULL) {
+		dst = trb_talloc(TrbString, 1);
+
+		if (dst == NULL) {
+			trb_msg_error("couldn't allocate memory for a copy of the string!");
+			return NULL;
+		}
+
+		was_allocated = TRUE;
+	}
+
+	if (src->refs == NULL) {
+		src->refs = trb_talloc(usize, 1);
+
+		if (src->refs == NULL) {
+			if (was_allocated)
+				free(dst);
+
+			trb_msg_error("couldn't allocate memory for the reference count of the string buffer!");
+			return NULL;
+		}
+
+		*src->refs = 1;
+	}
+
+	__atomic_add_fetch(src->refs, 1, __ATOMIC_RELAXED);
+
+	*dst = *src;
+
+	return dst;
+}
+
+static bool __trb_string_newcap(TrbString *self, usize newcap)
+{
+	if (!trb_growth_capacity(self->growth, self->growth_func, self->capacity, newcap, &newcap)) {
 		trb_msg_error("string capacity overflow!");
 		return FALSE;
 	}
 
-	char *data = (void *) realloc(self->data, newcap);
+	/* A shared buffer is copied straight into the grown one */
+	if (__trb_string_is_shared(self))
+		return __trb_string_detach(self, newcap);
+
+	char *data = trb_pages_realloc(
+		self->data, self->capacity, newcap,
+		self->map_threshold, self->map_hugepages, &self->mapped
+	);
 
 	if (data == NULL) {
 		trb_msg_error("couldn't reallocate memory for the string buffer!");
@@ -215,6 +370,9 @@ static bool __trb_string_insert_c(TrbString *self, usize index, char c)
 			return FALSE;
 	}
 
+	if (!trb_string_unshare(self))
+		return FALSE;
+
 	if (index >= self->len) {
 		self->len = index + 1;
 	} else {
@@ -251,6 +409,9 @@ static bool __trb_string_insert(TrbString *self, usize index, const char *str, u
 			return FALSE;
 	}
 
+	if (!trb_string_unshare(self))
+		return FALSE;
+
 	if (index >= self->len) {
 		self->len = index + len;
 	} else {
@@ -286,6 +447,31 @@ static bool __trb_string_insert_vfmt(TrbString *self, usize index, const char *f
 	return res;
 }
 
+char *trb_string_emplace_back(TrbString *self, usize len)
+{
+	trb_return_val_if_fail(self != NULL, NULL);
+
+	if (trb_chk_add(self->len, len, NULL) || trb_chk_add(self->len + len, 1, NULL)) {
+		trb_msg_error("string length overflow!");
+		return NULL;
+	}
+
+	if (self->len + len + 1 > self->capacity) {
+		if (__trb_string_newcap(self, self->len + len + 1) == FALSE)
+			return NULL;
+	}
+
+	if (!trb_string_unshare(self))
+		return NULL;
+
+	char *ret = &self->data[self->len];
+
+	self->len += len;
+	self->data[self->len] = '\0';
+
+	return ret;
+}
+
 bool trb_string_push_back(TrbString *self, const char *c_str)
 {
 	trb_return_val_if_fail(self != NULL, FALSE);
@@ -423,6 +609,9 @@ static bool __trb_string_erase(TrbString *self, usize index, usize len, char *re
 	if (ret != NULL)
 		memcpy(ret, &self->data[index], len);
 
+	if (!trb_string_unshare(self))
+		return FALSE;
+
 	if (index + len != self->len)
 		memmove(&self->data[index], &self->data[index + len], (self->len + 1) - len - index);
 	else
@@ -472,6 +661,9 @@ static bool __trb_string_overwrite(TrbString *self, usize index, const char *str
 			return FALSE;
 	}
 
+	if (!trb_string_unshare(self))
+		return FALSE;
+
 	if (index + len > self->len) {
 		self->len = index + len;
 		self->data[self->len] = '\0';
@@ -549,6 +741,9 @@ bool trb_string_overwrite_c(TrbString *self, usize index, char c)
 			return FALSE;
 	}
 
+	if (!trb_string_unshare(self))
+		return FALSE;
+
 	if (index + 1 > self->len) {
 		self->len = index + 1;
 		self->data[self->len] = '\0';
@@ -566,6 +761,9 @@ static bool __trb_string_assign(TrbString *self, const char *str, usize len)
 			return FALSE;
 	}
 
+	if (!trb_string_unshare(self))
+		return FALSE;
+
 	self->len = len;
 	self->data[self->len] = '\0';
 
@@ -639,6 +837,11 @@ bool trb_string_assign_fmt(TrbString *self, const char *fmt, ...)
 		}
 	}
 
+	if (!trb_string_unshare(self)) {
+		free(buf);
+		return FALSE;
+	}
+
 	memcpy(self->data, buf, len + 1);
 	self->len = len;
 
@@ -667,6 +870,11 @@ bool trb_string_assign_vfmt(TrbString *self, const char *fmt, va_list args)
 		}
 	}
 
+	if (!trb_string_unshare(self)) {
+		free(buf);
+		return FALSE;
+	}
+
 	memcpy(self->data, buf, len + 1);
 	self->len = len;
 
@@ -675,6 +883,31 @@ bool trb_string_assign_vfmt(TrbString *self, const char *fmt, va_list args)
 	return TRUE;
 }
 
+/* Stolen buffers are released with free(), so mapped ones are copied to the heap */
+static char *__trb_string_steal_buffer(TrbString *self)
+{
+	if (!trb_string_unshare(self))
+		return NULL;
+
+	if (!self->mapped)
+		return self->data;
+
+	char *ret = malloc(self->len + 1);
+
+	if (ret == NULL) {
+		trb_msg_error("couldn't allocate memory for the stolen string buffer!");
+		return NULL;
+	}
+
+	memcpy(ret, self->data, self->len + 1);
+	trb_pages_free(self->data, self->capacity, TRUE);
+
+	self->data = NULL;
+	self->mapped = FALSE;
+
+	return ret;
+}
+
 char *trb_string_steal(TrbString *self, usize *len)
 {
 	trb_return_val_if_fail(self != NULL, FALSE);
@@ -684,7 +917,10 @@ char *trb_string_steal(TrbString *self, usize *len)
 		return FALSE;
 	}
 
-	char *ret = self->data;
+	char *ret = __trb_string_steal_buffer(self);
+
+	if (ret == NULL)
+		return NULL;
 
 	if (len != NULL)
 		*len = self->len;
@@ -711,7 +947,10 @@ char *trb_string_steal0(TrbString *self, usize *len)
 		return FALSE;
 	}
 
-	char *ret = self->data;
+	char *ret = __trb_string_steal_buffer(self);
+
+	if (ret == NULL)
+		return NULL;
 
 	if (len != NULL)
 		*len = self->len;
@@ -730,11 +969,14 @@ void trb_string_destroy(TrbString *self)
 	if (self->data == NULL)
 		return;
 
-	free(self->data);
+	if (__trb_string_unref(self))
+		trb_pages_free(self->data, self->capacity, self->mapped);
 
 	self->data = NULL;
 	self->len = 0;
 	self->capacity = 0;
+	self->mapped = FALSE;
+	self->refs = NULL;
 }
 
 void trb_string_free(TrbString *self)
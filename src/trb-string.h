@@ -1,6 +1,7 @@
 #ifndef STRING_H_WW4E6R5D
 #define STRING_H_WW4E6R5D
 
+#include "trb-growth.h"
 #include "trb-macros.h"
 #include "trb-types.h"
 
@@ -13,6 +14,12 @@ typedef struct _TrbString TrbString;
  * @data: The string buffer.
  * @len: The string length.
  * @capacity: The capacity of the string buffer.
+ * @growth: The policy for growing the capacity of the string buffer.
+ * @growth_func: The growth function used if @growth is %TRB_GROWTH_CUSTOM.
+ * @map_threshold: The buffer size in bytes starting from which the buffer is mapped. Zero disables mapping.
+ * @map_hugepages: Indicates whether the mapped buffer should be backed by huge pages or not.
+ * @mapped: Indicates whether the buffer is mapped or not.
+ * @refs: The reference count of the buffer shared by trb_string_copy_cow(). %NULL if the buffer isn't shared.
  *
  * A dynamic size string.
  *
@@ -35,6 +42,12 @@ struct _TrbString {
 	char *data;
 	usize len;
 	usize capacity;
+	TrbGrowth growth;
+	TrbGrowthFunc growth_func;
+	usize map_threshold;
+	bool map_hugepages;
+	bool mapped;
+	usize *refs;
 };
 
 /**
@@ -111,6 +124,56 @@ TrbString *trb_string_init_fmt(TrbString *self, const char *fmt, ...) TRB_FORMAT
  **/
 TrbString *trb_string_init_vfmt(TrbString *self, const char *fmt, va_list args) TRB_FORMAT(printf, 2, 0);
 
+/**
+ * trb_string_copy_cow:
+ * @src: The string to be copied.
+ * @dst: (nullable): The pointer to the destination string.
+ *
+ * Creates a copy of the string that shares the buffer with @src.
+ * The buffer is copied on the first modification of either string.
+ * See trb_vector_copy_cow().
+ *
+ * Returns: (nullable): A copy of the string.
+ * Can return %NULL if an allocation error occurs.
+ **/
+TrbString *trb_string_copy_cow(TrbString *src, TrbString *dst);
+
+/**
+ * trb_string_unshare:
+ * @self: The string which buffer is to be detached.
+ *
+ * Makes the string the only owner of its buffer, copying the buffer
+ * if it is shared with other strings created by trb_string_copy_cow().
+ * Call it before writing to @data directly.
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_string_unshare(TrbString *self);
+
+/**
+ * trb_string_set_growth:
+ * @self: The string which growth policy is to be set.
+ * @growth: The growth policy.
+ * @growth_func: (nullable): The growth function. Must not be %NULL if @growth is %TRB_GROWTH_CUSTOM.
+ *
+ * Sets the policy for growing the capacity of the string buffer.
+ * The default policy is %TRB_GROWTH_1_5X.
+ **/
+void trb_string_set_growth(TrbString *self, TrbGrowth growth, TrbGrowthFunc growth_func);
+
+/**
+ * trb_string_set_mmap:
+ * @self: The string which allocation strategy is to be set.
+ * @threshold: The buffer size in bytes starting from which the buffer is mapped. Zero disables mapping.
+ * @hugepages: %TRUE if the mapped buffer should be backed by transparent huge pages.
+ *
+ * Makes the string move its buffer to an anonymous mapping once the buffer
+ * reaches @threshold bytes. See trb_vector_set_mmap().
+ *
+ * Mapping is disabled by default.
+ **/
+void trb_string_set_mmap(TrbString *self, usize threshold, bool hugepages);
+
 /**
  * trb_string_push_back:
  * @self: The string where to add the other string.
@@ -122,6 +185,23 @@ TrbString *trb_string_init_vfmt(TrbString *self, const char *fmt, va_list args)
  **/
 bool trb_string_push_back(TrbString *self, const char *c_str);
 
+/**
+ * trb_string_emplace_back:
+ * @self: The string where to add the bytes.
+ * @len: The number of bytes to be added.
+ *
+ * Adds @len uninitialized bytes to the end of the string
+ * and returns the pointer to them, so they can be written in place,
+ * for example by `read()`. The string stays null-terminated.
+ *
+ * If fewer bytes get written, remove the rest with trb_string_erase().
+ * The pointer is valid until the string is modified.
+ *
+ * Returns: (nullable): The pointer to the first added byte.
+ * Can return %NULL if an error occurs.
+ **/
+char *trb_string_emplace_back(TrbString *self, usize len);
+
 /**
  * trb_string_push_back_len:
  * @self: The string where to add the other string.
@@ -447,6 +527,7 @@ bool trb_string_assign_vfmt(TrbString *self, const char *fmt, va_list args) TRB_
  *
  * Steals the string buffer.
  * TrbString's buffer becomes %NULL.
+ * A mapped buffer is copied to the heap first, so the result can be released with `free()`.
  *
  * Returns: (transfer full) (nullable): The buffer on success.
  * Can return %NULL on failure.
@@ -460,6 +541,7 @@ char *trb_string_steal0(TrbString *self, usize *len);
  *
  * Steals the string buffer.
  * TrbString creates a new buffer.
+ * A mapped buffer is copied to the heap first, so the result can be released with `free()`.
  *
  * Returns: (transfer full) (nullable): The buffer on success.
  * Can return %NULL on failure.
@@ -471,6 +553,7 @@ char *trb_string_steal(TrbString *self, usize *len);
  * @self: The string which buffer is to be freed.
  *
  * Frees the string buffer.
+ * A buffer shared by trb_string_copy_cow() is freed only when the last string that holds it is destroyed.
  **/
 void trb_string_destroy(TrbString *self);
 
@@ -0,0 +1,226 @@
+#include "trb-timer-wheel.h"
+
+#include "trb-macros.h"
+#include "trb-math.h"
+#include "trb-messages.h"
+
+#include <stdlib.h>
+
+#define TIMER_WHEEL_MASK (TRB_TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_RANGE ((u64) 1 << (TRB_TIMER_WHEEL_BITS * TRB_TIMER_WHEEL_LEVELS))
+#define TIMER_NONE USIZE_MAX
+
+void trb_timer_init(TrbTimer *timer)
+{
+	trb_return_if_fail(timer != NULL);
+
+	trb_list_node_init(&timer->node);
+	timer->expires = 0;
+	timer->slot = TIMER_NONE;
+}
+
+bool trb_timer_pending(const TrbTimer *timer)
+{
+	trb_return_val_if_fail(timer != NULL, FALSE);
+	return timer->slot != TIMER_NONE;
+}
+
+TrbTimerWheel *trb_timer_wheel_init(TrbTimerWheel *self, u64 now)
+{
+	if (self == NULL) {
+		self = trb_talloc(TrbTimerWheel, 1);
+
+		if (self == NULL) {
+			trb_msg_error("couldn't allocate memory for the timer wheel!");
+			return NULL;
+		}
+	}
+
+	for (usize l = 0; l < TRB_TIMER_WHEEL_LEVELS; ++l) {
+		for (usize i = 0; i < TRB_TIMER_WHEEL_SLOTS; ++i)
+			trb_list_node_init(&self->slots[l][i]);
+
+		self->occupied[l] = 0;
+	}
+
+	self->now = now;
+	self->len = 0;
+
+	return self;
+}
+
+/* Puts the timer into the slot that covers the tick, the tick must not be in the past */
+static void __trb_timer_wheel_place(TrbTimerWheel *self, TrbTimer *timer, u64 tick)
+{
+	u64 delta = tick - self->now;
+	usize level = 0;
+
+	if (delta >= TIMER_WHEEL_RANGE) {
+		level = TRB_TIMER_WHEEL_LEVELS - 1;
+		tick = self->now + TIMER_WHEEL_RANGE - 1;
+	} else if (delta >= TRB_TIMER_WHEEL_SLOTS) {
+		level = (63 - trb_clz64(delta)) / TRB_TIMER_WHEEL_BITS;
+	}
+
+	usize index = (tick >> (level * TRB_TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK;
+
+	trb_list_push_back(&self->slots[level][index], &timer->node);
+	self->occupied[level] |= (u64) 1 << index;
+	timer->slot = level * TRB_TIMER_WHEEL_SLOTS + index;
+}
+
+void trb_timer_wheel_add(TrbTimerWheel *self, TrbTimer *timer, u64 expires)
+{
+	trb_return_if_fail(self != NULL);
+	trb_return_if_fail(timer != NULL);
+	trb_return_if_fail(timer->slot == TIMER_NONE);
+
+	/* The timer may still be in the list of expired timers */
+	trb_list_remove(&timer->node);
+
+	timer->expires = expires;
+	__trb_timer_wheel_place(self, timer, trb_max(expires, self->now + 1));
+	self->len++;
+}
+
+bool trb_timer_wheel_cancel(TrbTimerWheel *self, TrbTimer *timer)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	trb_return_val_if_fail(timer != NULL, FALSE);
+
+	if (timer->slot == TIMER_NONE) {
+		trb_list_remove(&timer->node);
+		return FALSE;
+	}
+
+	usize level = timer->slot / TRB_TIMER_WHEEL_SLOTS;
+	usize index = timer->slot % TRB_TIMER_WHEEL_SLOTS;
+
+	trb_list_remove(&timer->node);
+
+	if (trb_list_empty(&self->slots[level][index]))
+		self->occupied[level] &= ~((u64) 1 << index);
+
+	timer->slot = TIMER_NONE;
+	self->len--;
+
+	return TRUE;
+}
+
+static void __trb_timer_wheel_cascade(TrbTimerWheel *self, usize level, usize index)
+{
+	TrbList *slot = &self->slots[level][index];
+
+	if (trb_list_empty(slot))
+		return;
+
+	TrbList timers;
+	trb_list_init(&timers);
+	trb_list_splice(slot, &timers);
+	self->occupied[level] &= ~((u64) 1 << index);
+
+	TrbList *node;
+
+	while ((node = trb_list_pop_front(&timers)) != NULL) {
+		TrbTimer *timer = trb_container_of(node, TrbTimer, node);
+		__trb_timer_wheel_place(self, timer, timer->expires);
+	}
+}
+
+static usize __trb_timer_wheel_expire(TrbTimerWheel *self, usize index, TrbList *expired)
+{
+	TrbList *slot = &self->slots[0][index];
+	TrbList *node;
+	usize n = 0;
+
+	trb_list_foreach (node, slot) {
+		trb_container_of(node, TrbTimer, node)->slot = TIMER_NONE;
+		n++;
+	}
+
+	trb_list_splice(slot, expired->prev);
+	self->occupied[0] &= ~((u64) 1 << index);
+	self->len -= n;
+
+	return n;
+}
+
+/*
+ * A slot at level l is processed at the ticks that are multiples of 64^l
+ * and have its index in the digit l: level 0 expires it, the upper levels cascade it.
+ * Finds the first such tick after the current one for the occupied slots of the level.
+ */
+static u64 __trb_timer_wheel_next_at(const TrbTimerWheel *self, usize level)
+{
+	u64 occupied = self->occupied[level];
+
+	if (occupied == 0)
+		return U64_MAX;
+
+	usize shift = level * TRB_TIMER_WHEEL_BITS;
+	u64 unit = (self->now >> shift) + 1;
+	u64 ahead = occupied & ~(((u64) 1 << (unit & TIMER_WHEEL_MASK)) - 1);
+
+	if (ahead != 0)
+		unit = (unit & ~(u64) TIMER_WHEEL_MASK) + __builtin_ctzll(ahead);
+	else
+		unit = (unit | TIMER_WHEEL_MASK) + 1 + __builtin_ctzll(occupied);
+
+	if (unit > (U64_MAX >> shift))
+		return U64_MAX;
+
+	return unit << shift;
+}
+
+/* Finds the next tick up to the target that has timers or cascades a non-empty slot */
+static u64 __trb_timer_wheel_next(const TrbTimerWheel *self, u64 target)
+{
+	u64 next = target;
+
+	for (usize l = 0; l < TRB_TIMER_WHEEL_LEVELS; ++l)
+		next = trb_min(next, __trb_timer_wheel_next_at(self, l));
+
+	return next;
+}
+
+usize trb_timer_wheel_advance(TrbTimerWheel *self, u64 now, TrbList *expired)
+{
+	trb_return_val_if_fail(self != NULL, 0);
+	trb_return_val_if_fail(expired != NULL, 0);
+	trb_return_val_if_fail(now >= self->now, 0);
+
+	usize n = 0;
+
+	while (self->now < now) {
+		if (self->len == 0) {
+			self->now = now;
+			break;
+		}
+
+		u64 tick = __trb_timer_wheel_next(self, now);
+		self->now = tick;
+
+		if ((tick & TIMER_WHEEL_MASK) == 0) {
+			for (usize l = 1; l < TRB_TIMER_WHEEL_LEVELS; ++l) {
+				usize index = (tick >> (l * TRB_TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK;
+				__trb_timer_wheel_cascade(self, l, index);
+
+				if (index != 0)
+					break;
+			}
+		}
+
+		usize index = tick & TIMER_WHEEL_MASK;
+
+		if (self->occupied[0] & ((u64) 1 << index))
+			n += __trb_timer_wheel_expire(self, index, expired);
+	}
+
+	return n;
+}
+
+void trb_timer_wheel_free(TrbTimerWheel *self)
+{
+	trb_return_if_fail(self != NULL);
+	free(self);
+}
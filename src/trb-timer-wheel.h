@@ -0,0 +1,152 @@
+#ifndef TIMER_WHEEL_H_C2PDX8VA
+#define TIMER_WHEEL_H_C2PDX8VA
+
+#include "trb-list.h"
+#include "trb-types.h"
+
+/**
+ * TRB_TIMER_WHEEL_BITS:
+ *
+ * The number of bits of the expiry tick that each level of #TrbTimerWheel covers.
+ **/
+#define TRB_TIMER_WHEEL_BITS 6
+
+/**
+ * TRB_TIMER_WHEEL_SLOTS:
+ *
+ * The number of slots in each level of #TrbTimerWheel.
+ **/
+#define TRB_TIMER_WHEEL_SLOTS (1 << TRB_TIMER_WHEEL_BITS)
+
+/**
+ * TRB_TIMER_WHEEL_LEVELS:
+ *
+ * The number of levels of #TrbTimerWheel. Timers more than 2^48 ticks
+ * in the future are kept in the last level until they come into range.
+ **/
+#define TRB_TIMER_WHEEL_LEVELS 8
+
+typedef struct _TrbTimer TrbTimer;
+typedef struct _TrbTimerWheel TrbTimerWheel;
+
+/**
+ * TrbTimer:
+ * @node: The list node. While the timer is scheduled it belongs to the wheel,
+ * after expiry it belongs to the list of expired timers.
+ * @expires: The tick at which the timer expires.
+ *
+ * A timer to be embedded into the structure it belongs to.
+ * Use trb_container_of() to get the structure back.
+ **/
+struct _TrbTimer {
+	/* <public> */
+	TrbList node;
+	u64 expires;
+
+	/* <private> */
+	usize slot;
+};
+
+/**
+ * TrbTimerWheel:
+ * @now: The current tick.
+ * @len: The number of scheduled timers.
+ *
+ * A hierarchical timing wheel.
+ *
+ * Each level has %TRB_TIMER_WHEEL_SLOTS slots, and a slot at level l holds the timers
+ * expiring within the same 64^l ticks. Adding and cancelling a timer is O(1).
+ * When the lower level wraps around, the timers of the next slot of the upper level
+ * are cascaded down, so each timer is moved at most once per level.
+ *
+ * The wheel doesn't own the timers and doesn't allocate memory after initialization.
+ **/
+struct _TrbTimerWheel {
+	/* <private> */
+	TrbList slots[TRB_TIMER_WHEEL_LEVELS][TRB_TIMER_WHEEL_SLOTS];
+	u64 occupied[TRB_TIMER_WHEEL_LEVELS];
+
+	/* <public> */
+	u64 now;
+	usize len;
+};
+
+/**
+ * trb_timer_init:
+ * @timer: The timer to be initialized.
+ *
+ * Initializes the timer as not scheduled.
+ **/
+void trb_timer_init(TrbTimer *timer);
+
+/**
+ * trb_timer_pending:
+ * @timer: The timer to be checked.
+ *
+ * Checks whether the timer is scheduled in a wheel.
+ *
+ * Returns: %TRUE if the timer is scheduled, %FALSE if not.
+ **/
+bool trb_timer_pending(const TrbTimer *timer);
+
+/**
+ * trb_timer_wheel_init:
+ * @self: (nullable): The pointer to the #TrbTimerWheel to be initialized.
+ * @now: The current tick.
+ *
+ * Creates a new #TrbTimerWheel.
+ *
+ * Returns: A new #TrbTimerWheel. Can return %NULL if an error occurs.
+ **/
+TrbTimerWheel *trb_timer_wheel_init(TrbTimerWheel *self, u64 now);
+
+/**
+ * trb_timer_wheel_add:
+ * @self: The wheel.
+ * @timer: The initialized timer that is not scheduled.
+ * @expires: The tick at which the timer expires.
+ * Timers that are already due expire on the next tick.
+ *
+ * Schedules the timer in O(1).
+ **/
+void trb_timer_wheel_add(TrbTimerWheel *self, TrbTimer *timer, u64 expires);
+
+/**
+ * trb_timer_wheel_cancel:
+ * @self: The wheel.
+ * @timer: The timer.
+ *
+ * Cancels the timer in O(1). If the timer has already expired,
+ * it is removed from the list of expired timers.
+ *
+ * Returns: %TRUE if the timer was scheduled, %FALSE if not.
+ **/
+bool trb_timer_wheel_cancel(TrbTimerWheel *self, TrbTimer *timer);
+
+/**
+ * trb_timer_wheel_advance:
+ * @self: The wheel.
+ * @now: The new current tick. Must not be less than the current one.
+ * @expired: The list where to append the expired timers.
+ *
+ * Advances the wheel to @now and moves all timers that expire at or before @now
+ * to @expired in one batch. The timers are appended slot by slot,
+ * so they are ordered by their expiry tick, but timers with the same tick are not ordered.
+ *
+ * Idle ticks are skipped using the bitmaps of occupied slots of all levels,
+ * so the wheel jumps straight to the next tick that expires timers or cascades them,
+ * and an empty wheel advances in O(1).
+ *
+ * Returns: The number of expired timers.
+ **/
+usize trb_timer_wheel_advance(TrbTimerWheel *self, u64 now, TrbList *expired);
+
+/**
+ * trb_timer_wheel_free:
+ * @self: The wheel to be freed.
+ *
+ * Frees the heap-allocated #TrbTimerWheel. Scheduled timers are left as they are.
+ **/
+void trb_timer_wheel_free(TrbTimerWheel *self);
+
+#endif /* end of include guard: TIMER_WHEEL_H_C2PDX8VA */
@@ -110,9 +110,9 @@ typedef uintptr_t usize;
 #define U64_WIDTH 64
 
 #if USIZE_MAX == U16_MAX
-	#define USUZE_WUDTH 16
+	#define USIZE_WIDTH 16
 #elif USIZE_MAX == U32_MAX
-	#define USUZE_WUDTH 32
+	#define USIZE_WIDTH 32
 #elif USIZE_MAX == U64_MAX
 	#define USIZE_WIDTH 64
 #endif
@@ -181,6 +181,17 @@ typedef i32 (*TrbCmpFunc)(const void *a, const void *b);
  **/
 typedef i32 (*TrbCmpDataFunc)(const void *a, const void *b, void *data);
 
+/**
+ * TrbPredFunc:
+ * @data: The value to be tested.
+ * @userdata: User data.
+ *
+ * The function for testing values.
+ *
+ * Returns: %TRUE if @data satisfies the predicate.
+ **/
+typedef bool (*TrbPredFunc)(const void *data, void *userdata);
+
 typedef void *(*TrbCopyFunc)(const void *src);
 
 typedef void (*TrbFreeFunc)(void *ptr);
@@ -1,13 +1,31 @@
 #include "trb-utils.h"
 
+#include "trb-math.h"
 #include "trb-messages.h"
 #include "trb-types.h"
 
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
-#define SORT_LEN_THRESHOLD 16
+#define SORT_TMP_SIZE 256
+
+#define PDQ_INSSORT_THRESHOLD 24
+#define PDQ_NINTHER_THRESHOLD 128
+#define PDQ_PARTIAL_INSSORT_LIMIT 8
+#define PDQ_BLOCK_SIZE 64
+
+#define STABLE_MIN_MERGE 64
+#define STABLE_MIN_GALLOP 7
+#define STABLE_MAX_RUNS 128
+
+#define RADIX_INSSORT_THRESHOLD 64
+
+#define PARALLEL_MIN_CHUNK 16384
+#define PARALLEL_MAX_THREADS 256
 
 usize trb_strfmt(char **buf, const char *fmt, ...)
 {
@@ -118,109 +136,153 @@ char *trb_strdup_vfmt(const char *fmt, va_list args)
 	return result;
 }
 
-/* Insertion sort */
-static void __trb_inssort(TrbSlice *slice, TrbCmpFunc cmp_func)
-{
-	usize len = trb_slice_len(slice);
+/* Sort context */
+typedef struct {
+	TrbSlice *slice;
+	char *base;
+	usize elemsize;
 
-	for (usize i = 1; i < len; ++i) {
-		usize cur = i;
+	union {
+		TrbCmpFunc cmp_func;
+		TrbCmpDataFunc cmpd_func;
+	};
 
-		for (usize j = i - 1;; --j) {
-			if (cmp_func(slice->at(slice, j), slice->at(slice, cur)) <= 0)
-				break;
+	void *data;
+	bool with_data;
+} TrbSortCtx;
 
-			trb_memswap(slice->at(slice, j), slice->at(slice, cur), slice->elemsize);
+static inline void __trb_sort_ctx_init(TrbSortCtx *ctx, const TrbSlice *slice)
+{
+	ctx->slice = (TrbSlice *) slice;
+	ctx->elemsize = slice->elemsize;
 
-			cur = j;
+	if (slice->contiguous && trb_slice_len(slice) != 0)
+		ctx->base = slice->at(slice, 0);
+	else
+		ctx->base = NULL;
+}
 
-			if (j == 0)
-				break;
-		}
-	}
+static inline void __trb_sort_ctx_init_cmp(TrbSortCtx *ctx, const TrbSlice *slice, TrbCmpFunc cmp_func)
+{
+	__trb_sort_ctx_init(ctx, slice);
+	ctx->cmp_func = cmp_func;
+	ctx->data = NULL;
+	ctx->with_data = FALSE;
 }
 
-void trb_inssort(TrbSlice *slice, TrbCmpFunc cmp_func)
+static inline void __trb_sort_ctx_init_data(TrbSortCtx *ctx, const TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data)
 {
-	trb_return_if_fail(slice != NULL);
-	trb_return_if_fail(cmp_func != NULL);
+	__trb_sort_ctx_init(ctx, slice);
+	ctx->cmpd_func = cmpd_func;
+	ctx->data = data;
+	ctx->with_data = TRUE;
+}
 
-	usize len = trb_slice_len(slice);
-	if (len <= 1)
-		return;
+static inline void *__trb_sort_at(const TrbSortCtx *ctx, usize index)
+{
+	if (ctx->base != NULL)
+		return ctx->base + index * ctx->elemsize;
 
-	__trb_inssort(slice, cmp_func);
+	return ctx->slice->at(ctx->slice, index);
 }
 
-/* Insertion sort with data */
-static void __trb_inssort_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data)
+static inline i32 __trb_sort_cmp(const TrbSortCtx *ctx, const void *a, const void *b)
 {
-	usize len = trb_slice_len(slice);
+	if (ctx->with_data)
+		return ctx->cmpd_func(a, b, ctx->data);
+
+	return ctx->cmp_func(a, b);
+}
 
-	for (usize i = 1; i < len; ++i) {
-		usize cur = i;
+static inline i32 __trb_sort_cmp_at(const TrbSortCtx *ctx, usize a, usize b)
+{
+	return __trb_sort_cmp(ctx, __trb_sort_at(ctx, a), __trb_sort_at(ctx, b));
+}
 
-		for (usize j = i - 1;; --j) {
-			if (cmpd_func(slice->at(slice, j), slice->at(slice, cur), data) <= 0)
-				break;
+static inline void __trb_sort_swap(const TrbSortCtx *ctx, usize a, usize b)
+{
+	trb_memswap(__trb_sort_at(ctx, a), __trb_sort_at(ctx, b), ctx->elemsize);
+}
 
-			trb_memswap(slice->at(slice, j), slice->at(slice, cur), slice->elemsize);
+static void __trb_sort_copy_out(const TrbSortCtx *ctx, char *dst, usize src, usize n)
+{
+	if (ctx->base != NULL) {
+		memcpy(dst, __trb_sort_at(ctx, src), n * ctx->elemsize);
+		return;
+	}
 
-			cur = j;
+	for (usize i = 0; i < n; ++i)
+		trb_memcopy(dst + i * ctx->elemsize, __trb_sort_at(ctx, src + i), ctx->elemsize);
+}
 
-			if (j == 0)
-				break;
-		}
+static void __trb_sort_copy_in(const TrbSortCtx *ctx, usize dst, const char *src, usize n)
+{
+	if (ctx->base != NULL) {
+		memcpy(__trb_sort_at(ctx, dst), src, n * ctx->elemsize);
+		return;
 	}
+
+	for (usize i = 0; i < n; ++i)
+		trb_memcopy(__trb_sort_at(ctx, dst + i), src + i * ctx->elemsize, ctx->elemsize);
 }
 
-void trb_inssort_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data)
+static void __trb_sort_move(const TrbSortCtx *ctx, usize dst, usize src, usize n)
 {
-	trb_return_if_fail(slice != NULL);
-	trb_return_if_fail(cmpd_func != NULL);
+	if (n == 0 || dst == src)
+		return;
 
-	usize len = trb_slice_len(slice);
-	if (len <= 1)
+	if (ctx->base != NULL) {
+		memmove(__trb_sort_at(ctx, dst), __trb_sort_at(ctx, src), n * ctx->elemsize);
 		return;
+	}
 
-	__trb_inssort_data(slice, cmpd_func, data);
+	if (dst < src) {
+		for (usize i = 0; i < n; ++i)
+			trb_memcopy(__trb_sort_at(ctx, dst + i), __trb_sort_at(ctx, src + i), ctx->elemsize);
+	} else {
+		for (usize i = n; i > 0; --i)
+			trb_memcopy(__trb_sort_at(ctx, dst + i - 1), __trb_sort_at(ctx, src + i - 1), ctx->elemsize);
+	}
 }
 
-/* Heapsort */
-static void __trb_heap(TrbSlice *slice, usize start, usize end, TrbCmpFunc cmp_func)
+/* Insertion sort */
+static void __trb_inssort(const TrbSortCtx *ctx, usize left, usize right)
 {
-	usize root = start;
+	usize elemsize = ctx->elemsize;
 
-	while ((root << 1) < end) {
-		usize child = (root << 1) + 1;
+	if (elemsize > SORT_TMP_SIZE) {
+		for (usize i = left + 1; i <= right; ++i) {
+			for (usize j = i; j > left; --j) {
+				if (__trb_sort_cmp_at(ctx, j - 1, j) <= 0)
+					break;
 
-		if ((child < end) && cmp_func(slice->at(slice, child), slice->at(slice, child + 1)) < 0)
-			child++;
+				__trb_sort_swap(ctx, j - 1, j);
+			}
+		}
 
-		if (cmp_func(slice->at(slice, root), slice->at(slice, child)) < 0) {
-			trb_memswap(slice->at(slice, root), slice->at(slice, child), slice->elemsize);
-			root = child;
-		} else
-			return;
+		return;
 	}
-}
 
-static void __trb_heapify(TrbSlice *slice, TrbCmpFunc cmp_func)
-{
-	usize len = trb_slice_len(slice);
-	usize start = (len - 1) >> 1;
+	_Alignas(16) char tmp[SORT_TMP_SIZE];
 
-	while (1) {
-		__trb_heap(slice, start, len - 1, cmp_func);
+	for (usize i = left + 1; i <= right; ++i) {
+		if (__trb_sort_cmp_at(ctx, i - 1, i) <= 0)
+			continue;
 
-		if (start == 0)
-			break;
+		trb_memcopy(tmp, __trb_sort_at(ctx, i), elemsize);
 
-		start--;
+		usize j = i;
+
+		do {
+			trb_memcopy(__trb_sort_at(ctx, j), __trb_sort_at(ctx, j - 1), elemsize);
+			j--;
+		} while (j > left && __trb_sort_cmp(ctx, __trb_sort_at(ctx, j - 1), tmp) > 0);
+
+		trb_memcopy(__trb_sort_at(ctx, j), tmp, elemsize);
 	}
 }
 
-void trb_heapify(TrbSlice *slice, TrbCmpFunc cmp_func)
+void trb_inssort(TrbSlice *slice, TrbCmpFunc cmp_func)
 {
 	trb_return_if_fail(slice != NULL);
 	trb_return_if_fail(cmp_func != NULL);
@@ -229,61 +291,51 @@ void trb_heapify(TrbSlice *slice, TrbCmpFunc cmp_func)
 	if (len <= 1)
 		return;
 
-	__trb_heapify(slice, cmp_func);
-}
-
-static void __trb_heapsort(TrbSlice *slice, TrbCmpFunc cmp_func)
-{
-	usize len = trb_slice_len(slice);
-	usize end = len - 1;
-
-	__trb_heapify(slice, cmp_func);
-
-	while (end > 0) {
-		trb_memswap(slice->at(slice, 0), slice->at(slice, end), slice->elemsize);
-		end--;
-		__trb_heap(slice, 0, end, cmp_func);
-	}
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_cmp(&ctx, slice, cmp_func);
+	__trb_inssort(&ctx, 0, len - 1);
 }
 
-void trb_heapsort(TrbSlice *slice, TrbCmpFunc cmp_func)
+void trb_inssort_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data)
 {
 	trb_return_if_fail(slice != NULL);
-	trb_return_if_fail(cmp_func != NULL);
+	trb_return_if_fail(cmpd_func != NULL);
 
 	usize len = trb_slice_len(slice);
 	if (len <= 1)
 		return;
 
-	__trb_heapsort(slice, cmp_func);
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, cmpd_func, data);
+	__trb_inssort(&ctx, 0, len - 1);
 }
 
-/* Heapsort with data */
-static void __trb_heap_data(TrbSlice *slice, usize start, usize end, TrbCmpDataFunc cmpd_func, void *data)
+/* Heapsort */
+static void __trb_heap(const TrbSortCtx *ctx, usize left, usize start, usize end)
 {
 	usize root = start;
 
 	while ((root << 1) < end) {
 		usize child = (root << 1) + 1;
 
-		if ((child < end) && cmpd_func(slice->at(slice, child), slice->at(slice, child + 1), data) < 0)
+		if ((child < end) && __trb_sort_cmp_at(ctx, left + child, left + child + 1) < 0)
 			child++;
 
-		if (cmpd_func(slice->at(slice, root), slice->at(slice, child), data) < 0) {
-			trb_memswap(slice->at(slice, root), slice->at(slice, child), slice->elemsize);
+		if (__trb_sort_cmp_at(ctx, left + root, left + child) < 0) {
+			__trb_sort_swap(ctx, left + root, left + child);
 			root = child;
 		} else
 			return;
 	}
 }
 
-static void __trb_heapify_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data)
+static void __trb_heapify(const TrbSortCtx *ctx, usize left, usize right)
 {
-	usize len = trb_slice_len(slice);
+	usize len = right - left + 1;
 	usize start = (len - 1) >> 1;
 
 	while (1) {
-		__trb_heap_data(slice, start, len - 1, cmpd_func, data);
+		__trb_heap(ctx, left, start, len - 1);
 
 		if (start == 0)
 			break;
@@ -292,6 +344,33 @@ static void __trb_heapify_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *
 	}
 }
 
+static void __trb_heapsort(const TrbSortCtx *ctx, usize left, usize right)
+{
+	usize end = right - left;
+
+	__trb_heapify(ctx, left, right);
+
+	while (end > 0) {
+		__trb_sort_swap(ctx, left, left + end);
+		end--;
+		__trb_heap(ctx, left, 0, end);
+	}
+}
+
+void trb_heapify(TrbSlice *slice, TrbCmpFunc cmp_func)
+{
+	trb_return_if_fail(slice != NULL);
+	trb_return_if_fail(cmp_func != NULL);
+
+	usize len = trb_slice_len(slice);
+	if (len <= 1)
+		return;
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_cmp(&ctx, slice, cmp_func);
+	__trb_heapify(&ctx, 0, len - 1);
+}
+
 void trb_heapify_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data)
 {
 	trb_return_if_fail(slice != NULL);
@@ -301,21 +380,23 @@ void trb_heapify_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data)
 	if (len <= 1)
 		return;
 
-	__trb_heapify_data(slice, cmpd_func, data);
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, cmpd_func, data);
+	__trb_heapify(&ctx, 0, len - 1);
 }
 
-static void __trb_heapsort_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data)
+void trb_heapsort(TrbSlice *slice, TrbCmpFunc cmp_func)
 {
-	usize len = trb_slice_len(slice);
-	usize end = len - 1;
+	trb_return_if_fail(slice != NULL);
+	trb_return_if_fail(cmp_func != NULL);
 
-	__trb_heapify_data(slice, cmpd_func, data);
+	usize len = trb_slice_len(slice);
+	if (len <= 1)
+		return;
 
-	while (end > 0) {
-		trb_memswap(slice->at(slice, 0), slice->at(slice, end), slice->elemsize);
-		end--;
-		__trb_heap_data(slice, 0, end, cmpd_func, data);
-	}
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_cmp(&ctx, slice, cmp_func);
+	__trb_heapsort(&ctx, 0, len - 1);
 }
 
 void trb_heapsort_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data)
@@ -327,102 +408,312 @@ void trb_heapsort_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data)
 	if (len <= 1)
 		return;
 
-	__trb_heapsort_data(slice, cmpd_func, data);
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, cmpd_func, data);
+	__trb_heapsort(&ctx, 0, len - 1);
 }
 
-/* Based on Knuth vol. 3 */
-static usize __trb_quicksort_partition(TrbSlice *slice, usize left, usize right, usize pivot, TrbCmpFunc cmp_func)
+/*
+ * Pattern-defeating quicksort by Orson Peters.
+ * https://arxiv.org/abs/2106.05123
+ *
+ * Ranges are [begin, end). The pivot stays at begin during partitioning,
+ * so elements are only ever swapped and no temporary storage is needed.
+ */
+static inline void __trb_pdq_sort2(const TrbSortCtx *ctx, usize a, usize b)
 {
-	usize i = left + 1;
-	usize j = right;
+	if (__trb_sort_cmp_at(ctx, b, a) < 0)
+		__trb_sort_swap(ctx, a, b);
+}
 
-	if (pivot != left)
-		trb_memswap(slice->at(slice, left), slice->at(slice, pivot), slice->elemsize);
+static inline void __trb_pdq_sort3(const TrbSortCtx *ctx, usize a, usize b, usize c)
+{
+	__trb_pdq_sort2(ctx, a, b);
+	__trb_pdq_sort2(ctx, b, c);
+	__trb_pdq_sort2(ctx, a, b);
+}
 
-	while (1) {
-		while (cmp_func(slice->at(slice, i), slice->at(slice, left)) < 0)
-			i++;
+/* Insertion sort that gives up after PDQ_PARTIAL_INSSORT_LIMIT moves */
+static bool __trb_pdq_partial_inssort(const TrbSortCtx *ctx, usize begin, usize end)
+{
+	if (end - begin <= 1)
+		return TRUE;
 
-		while (cmp_func(slice->at(slice, left), slice->at(slice, j)) < 0)
-			j--;
+	usize elemsize = ctx->elemsize;
+	usize limit = 0;
+
+	_Alignas(16) char tmp[SORT_TMP_SIZE];
 
-		if (j <= i) {
-			trb_memswap(slice->at(slice, j), slice->at(slice, left), slice->elemsize);
-			return j;
+	for (usize cur = begin + 1; cur < end; ++cur) {
+		if (__trb_sort_cmp_at(ctx, cur, cur - 1) >= 0)
+			continue;
+
+		usize sift = cur;
+
+		if (elemsize > SORT_TMP_SIZE) {
+			do {
+				__trb_sort_swap(ctx, sift - 1, sift);
+				sift--;
+			} while (sift != begin && __trb_sort_cmp_at(ctx, sift, sift - 1) < 0);
+		} else {
+			trb_memcopy(tmp, __trb_sort_at(ctx, cur), elemsize);
+
+			do {
+				trb_memcopy(__trb_sort_at(ctx, sift), __trb_sort_at(ctx, sift - 1), elemsize);
+				sift--;
+			} while (sift != begin && __trb_sort_cmp(ctx, tmp, __trb_sort_at(ctx, sift - 1)) < 0);
+
+			trb_memcopy(__trb_sort_at(ctx, sift), tmp, elemsize);
 		}
 
-		trb_memswap(slice->at(slice, i), slice->at(slice, j), slice->elemsize);
+		limit += cur - sift;
 
-		i++;
-		j--;
+		if (limit > PDQ_PARTIAL_INSSORT_LIMIT)
+			return FALSE;
 	}
 
-	return 0;
+	return TRUE;
 }
 
-static usize __trb_find_median(TrbSlice *slice, usize a, usize b, usize c, TrbCmpFunc cmp_func)
+/*
+ * Partitions [begin, end) around the pivot at begin. Elements equal to the pivot
+ * go to the right partition. Returns the final position of the pivot and sets
+ * @already_partitioned if no elements had to be moved.
+ */
+static usize __trb_pdq_partition_right(const TrbSortCtx *ctx, usize begin, usize end, bool *already_partitioned)
 {
-	if (cmp_func(slice->at(slice, a), slice->at(slice, b)) > 0) {
-		if (cmp_func(slice->at(slice, b), slice->at(slice, c)) > 0)
-			return b;
-		else if (cmp_func(slice->at(slice, a), slice->at(slice, c)) > 0)
-			return c;
-		else
-			return a;
+	const void *pivot = __trb_sort_at(ctx, begin);
+
+	usize first = begin;
+	usize last = end;
+
+	while (__trb_sort_cmp(ctx, __trb_sort_at(ctx, ++first), pivot) < 0)
+		;
+
+	if (first - 1 == begin) {
+		while (first < last && __trb_sort_cmp(ctx, __trb_sort_at(ctx, --last), pivot) >= 0)
+			;
 	} else {
-		if (cmp_func(slice->at(slice, a), slice->at(slice, c)) > 0)
-			return a;
-		else if (cmp_func(slice->at(slice, b), slice->at(slice, c)) > 0)
-			return c;
-		else
-			return b;
+		while (__trb_sort_cmp(ctx, __trb_sort_at(ctx, --last), pivot) >= 0)
+			;
+	}
+
+	*already_partitioned = first >= last;
+
+	if (!*already_partitioned) {
+		__trb_sort_swap(ctx, first, last);
+		first++;
+
+		/* Branchless block partitioning, based on BlockQuicksort by Edelkamp and Weiß */
+		u8 offsets_l[PDQ_BLOCK_SIZE];
+		u8 offsets_r[PDQ_BLOCK_SIZE];
+
+		usize offsets_l_base = first;
+		usize offsets_r_base = last;
+		usize num_l = 0, num_r = 0;
+		usize start_l = 0, start_r = 0;
+
+		while (first < last) {
+			usize num_unknown = last - first;
+			usize left_split = (num_l == 0) ? ((num_r == 0) ? num_unknown / 2 : num_unknown) : 0;
+			usize right_split = (num_r == 0) ? (num_unknown - left_split) : 0;
+
+			left_split = trb_min(left_split, PDQ_BLOCK_SIZE);
+			right_split = trb_min(right_split, PDQ_BLOCK_SIZE);
+
+			for (usize i = 0; i < left_split; ++i) {
+				offsets_l[num_l] = i;
+				num_l += __trb_sort_cmp(ctx, __trb_sort_at(ctx, first), pivot) >= 0;
+				first++;
+			}
+
+			for (usize i = 0; i < right_split;) {
+				offsets_r[num_r] = ++i;
+				num_r += __trb_sort_cmp(ctx, __trb_sort_at(ctx, --last), pivot) < 0;
+			}
+
+			usize num = trb_min(num_l, num_r);
+
+			for (usize i = 0; i < num; ++i) {
+				__trb_sort_swap(
+					ctx,
+					offsets_l_base + offsets_l[start_l + i],
+					offsets_r_base - offsets_r[start_r + i]
+				);
+			}
+
+			num_l -= num;
+			num_r -= num;
+			start_l += num;
+			start_r += num;
+
+			if (num_l == 0) {
+				start_l = 0;
+				offsets_l_base = first;
+			}
+
+			if (num_r == 0) {
+				start_r = 0;
+				offsets_r_base = last;
+			}
+		}
+
+		if (num_l != 0) {
+			while (num_l-- != 0)
+				__trb_sort_swap(ctx, offsets_l_base + offsets_l[start_l + num_l], --last);
+
+			first = last;
+		}
+
+		if (num_r != 0) {
+			while (num_r-- != 0)
+				__trb_sort_swap(ctx, offsets_r_base - offsets_r[start_r + num_r], first++);
+		}
 	}
+
+	usize pivot_pos = first - 1;
+	__trb_sort_swap(ctx, begin, pivot_pos);
+
+	return pivot_pos;
 }
 
-static void __trb_quicksort_recursive(TrbSlice *slice, usize left, usize right, TrbCmpFunc cmp_func)
+/*
+ * Partitions [begin, end) around the pivot at begin. Elements equal to the pivot
+ * go to the left partition. Used when the pivot equals the element preceding
+ * the range, which means the whole left partition consists of equal elements.
+ */
+static usize __trb_pdq_partition_left(const TrbSortCtx *ctx, usize begin, usize end)
 {
-	usize mid;
-	usize pivot;
-	usize new_pivot;
+	const void *pivot = __trb_sort_at(ctx, begin);
+
+	usize first = begin;
+	usize last = end;
+
+	while (__trb_sort_cmp(ctx, pivot, __trb_sort_at(ctx, --last)) < 0)
+		;
+
+	if (last + 1 == end) {
+		while (first < last && __trb_sort_cmp(ctx, pivot, __trb_sort_at(ctx, ++first)) >= 0)
+			;
+	} else {
+		while (__trb_sort_cmp(ctx, pivot, __trb_sort_at(ctx, ++first)) >= 0)
+			;
+	}
+
+	while (first < last) {
+		__trb_sort_swap(ctx, first, last);
+
+		while (__trb_sort_cmp(ctx, pivot, __trb_sort_at(ctx, --last)) < 0)
+			;
 
-	usize loop_count = 0;
-	usize max_loops = 32 - __builtin_clzl(right - left);
+		while (__trb_sort_cmp(ctx, pivot, __trb_sort_at(ctx, ++first)) >= 0)
+			;
+	}
+
+	__trb_sort_swap(ctx, begin, last);
+
+	return last;
+}
 
+static void __trb_pdqsort_loop(const TrbSortCtx *ctx, usize begin, usize end, usize bad_allowed, bool leftmost)
+{
 	while (1) {
-		if (right <= left)
-			return;
+		usize size = end - begin;
+
+		if (size < PDQ_INSSORT_THRESHOLD) {
+			if (size > 1)
+				__trb_inssort(ctx, begin, end - 1);
 
-		if ((right - left + 1) <= SORT_LEN_THRESHOLD) {
-			TrbSlice part_slice;
-			trb_slice_reslice(slice, &part_slice, left, right + 1);
-			__trb_inssort(&part_slice, cmp_func);
 			return;
 		}
 
-		if (++loop_count >= max_loops) {
-			TrbSlice part_slice;
-			trb_slice_reslice(slice, &part_slice, left, right + 1);
-			__trb_heapsort(&part_slice, cmp_func);
-			return;
+		/* Choose the pivot as the median of 3 or the pseudomedian of 9 */
+		usize s2 = size / 2;
+
+		if (size > PDQ_NINTHER_THRESHOLD) {
+			__trb_pdq_sort3(ctx, begin, begin + s2, end - 1);
+			__trb_pdq_sort3(ctx, begin + 1, begin + (s2 - 1), end - 2);
+			__trb_pdq_sort3(ctx, begin + 2, begin + (s2 + 1), end - 3);
+			__trb_pdq_sort3(ctx, begin + (s2 - 1), begin + s2, begin + (s2 + 1));
+			__trb_sort_swap(ctx, begin, begin + s2);
+		} else {
+			__trb_pdq_sort3(ctx, begin + s2, begin, end - 1);
 		}
 
-		mid = left + ((right - left) >> 1);
-		pivot = __trb_find_median(slice, left, mid, right, cmp_func);
-		new_pivot = __trb_quicksort_partition(slice, left, right, pivot, cmp_func);
+		/*
+		 * If the element before the range is not less than the pivot,
+		 * the range contains many equal elements: put them all to the left
+		 * and never look at them again.
+		 */
+		if (!leftmost && __trb_sort_cmp_at(ctx, begin - 1, begin) >= 0) {
+			begin = __trb_pdq_partition_left(ctx, begin, end) + 1;
+			continue;
+		}
 
-		if (new_pivot == 0)
+		bool already_partitioned;
+		usize pivot_pos = __trb_pdq_partition_right(ctx, begin, end, &already_partitioned);
+
+		usize l_size = pivot_pos - begin;
+		usize r_size = end - (pivot_pos + 1);
+		bool highly_unbalanced = l_size < size / 8 || r_size < size / 8;
+
+		if (highly_unbalanced) {
+			/* Too many bad partitions, guarantee O(n log n) */
+			if (--bad_allowed == 0) {
+				__trb_heapsort(ctx, begin, end - 1);
+				return;
+			}
+
+			/* Break up patterns that may have caused the bad partition */
+			if (l_size >= PDQ_INSSORT_THRESHOLD) {
+				__trb_sort_swap(ctx, begin, begin + l_size / 4);
+				__trb_sort_swap(ctx, pivot_pos - 1, pivot_pos - l_size / 4);
+
+				if (l_size > PDQ_NINTHER_THRESHOLD) {
+					__trb_sort_swap(ctx, begin + 1, begin + (l_size / 4 + 1));
+					__trb_sort_swap(ctx, begin + 2, begin + (l_size / 4 + 2));
+					__trb_sort_swap(ctx, pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+					__trb_sort_swap(ctx, pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+				}
+			}
+
+			if (r_size >= PDQ_INSSORT_THRESHOLD) {
+				__trb_sort_swap(ctx, pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+				__trb_sort_swap(ctx, end - 1, end - r_size / 4);
+
+				if (r_size > PDQ_NINTHER_THRESHOLD) {
+					__trb_sort_swap(ctx, pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+					__trb_sort_swap(ctx, pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+					__trb_sort_swap(ctx, end - 2, end - (1 + r_size / 4));
+					__trb_sort_swap(ctx, end - 3, end - (2 + r_size / 4));
+				}
+			}
+		} else if (
+			already_partitioned &&
+			__trb_pdq_partial_inssort(ctx, begin, pivot_pos) &&
+			__trb_pdq_partial_inssort(ctx, pivot_pos + 1, end)
+		) {
+			/* The range was already partitioned and both halves were (nearly) sorted */
 			return;
-
-		if ((new_pivot - left - 1) > (right - new_pivot - 1)) {
-			__trb_quicksort_recursive(slice, new_pivot + 1, right, cmp_func);
-			right = new_pivot - 1;
-		} else {
-			__trb_quicksort_recursive(slice, left, new_pivot - 1, cmp_func);
-			left = new_pivot + 1;
 		}
+
+		/* Recurse into the left partition and loop over the right one */
+		__trb_pdqsort_loop(ctx, begin, pivot_pos, bad_allowed, leftmost);
+
+		begin = pivot_pos + 1;
+		leftmost = FALSE;
 	}
 }
 
+static void __trb_pdqsort(const TrbSortCtx *ctx, usize begin, usize end)
+{
+	if (end - begin <= 1)
+		return;
+
+	usize bad_allowed = USIZE_WIDTH - trb_clz((usize) (end - begin));
+	__trb_pdqsort_loop(ctx, begin, end, bad_allowed, TRUE);
+}
+
 void trb_quicksort(TrbSlice *slice, TrbCmpFunc cmp_func)
 {
 	trb_return_if_fail(slice != NULL);
@@ -432,197 +723,1535 @@ void trb_quicksort(TrbSlice *slice, TrbCmpFunc cmp_func)
 	if (len <= 1)
 		return;
 
-	__trb_quicksort_recursive(slice, 0, len - 1, cmp_func);
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_cmp(&ctx, slice, cmp_func);
+	__trb_pdqsort(&ctx, 0, len);
 }
 
-/* Quicksort with data */
-static usize __trb_quicksort_partition_data(
-	TrbSlice *slice,
-	usize left,
-	usize right,
-	usize pivot,
-	TrbCmpDataFunc cmpd_func,
-	void *data
-)
+void trb_quicksort_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data)
 {
-	usize i = left + 1;
-	usize j = right;
+	trb_return_if_fail(slice != NULL);
+	trb_return_if_fail(cmpd_func != NULL);
 
-	if (pivot != left)
-		trb_memswap(slice->at(slice, left), slice->at(slice, pivot), slice->elemsize);
+	usize len = trb_slice_len(slice);
+	if (len <= 1)
+		return;
 
-	while (1) {
-		while (cmpd_func(slice->at(slice, i), slice->at(slice, left), data) < 0)
-			i++;
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, cmpd_func, data);
+	__trb_pdqsort(&ctx, 0, len);
+}
 
-		while (cmpd_func(slice->at(slice, left), slice->at(slice, j), data) < 0)
-			j--;
+/* Selection */
 
-		if (j <= i) {
-			trb_memswap(slice->at(slice, j), slice->at(slice, left), slice->elemsize);
-			return j;
-		}
+/* Moves the (nth - begin + 1) smallest elements of [begin, end) to [begin, nth], the largest of them to nth */
+static void __trb_heapselect(const TrbSortCtx *ctx, usize begin, usize end, usize nth)
+{
+	usize last = nth - begin;
 
-		trb_memswap(slice->at(slice, i), slice->at(slice, j), slice->elemsize);
+	__trb_heapify(ctx, begin, nth);
 
-		i++;
-		j--;
+	for (usize i = nth + 1; i < end; ++i) {
+		if (__trb_sort_cmp_at(ctx, i, begin) < 0) {
+			__trb_sort_swap(ctx, i, begin);
+			__trb_heap(ctx, begin, 0, last);
+		}
 	}
 
-	return 0;
-}
-
-static usize __trb_find_median_data(TrbSlice *slice, usize a, usize b, usize c, TrbCmpDataFunc cmpd_func, void *data)
-{
-	if (cmpd_func(slice->at(slice, a), slice->at(slice, b), data) > 0) {
-		if (cmpd_func(slice->at(slice, b), slice->at(slice, c), data) > 0)
-			return b;
-		else if (cmpd_func(slice->at(slice, a), slice->at(slice, c), data) > 0)
-			return c;
-		else
-			return a;
-	} else {
-		if (cmpd_func(slice->at(slice, a), slice->at(slice, c), data) > 0)
-			return a;
-		else if (cmpd_func(slice->at(slice, b), slice->at(slice, c), data) > 0)
-			return c;
-		else
-			return b;
-	}
+	__trb_sort_swap(ctx, begin, nth);
 }
 
-static void __trb_quicksort_recursive_data(TrbSlice *slice, usize left, usize right, TrbCmpDataFunc cmpd_func, void *data)
+/* Introselect: pdqsort partitioning narrowed down to the side containing nth */
+static void __trb_select(const TrbSortCtx *ctx, usize begin, usize end, usize nth)
 {
-	usize mid;
-	usize pivot;
-	usize new_pivot;
+	usize bad_allowed = USIZE_WIDTH - trb_clz((usize) (end - begin));
+	bool leftmost = TRUE;
+
+	while (end - begin >= PDQ_INSSORT_THRESHOLD) {
+		usize size = end - begin;
+		usize s2 = size / 2;
+
+		if (size > PDQ_NINTHER_THRESHOLD) {
+			__trb_pdq_sort3(ctx, begin, begin + s2, end - 1);
+			__trb_pdq_sort3(ctx, begin + 1, begin + (s2 - 1), end - 2);
+			__trb_pdq_sort3(ctx, begin + 2, begin + (s2 + 1), end - 3);
+			__trb_pdq_sort3(ctx, begin + (s2 - 1), begin + s2, begin + (s2 + 1));
+			__trb_sort_swap(ctx, begin, begin + s2);
+		} else {
+			__trb_pdq_sort3(ctx, begin + s2, begin, end - 1);
+		}
 
-	usize loop_count = 0;
-	usize max_loops = 32 - __builtin_clzl(right - left);
+		/* The pivot equals the element before the range: skip all elements equal to it */
+		if (!leftmost && __trb_sort_cmp_at(ctx, begin - 1, begin) >= 0) {
+			usize pivot_pos = __trb_pdq_partition_left(ctx, begin, end);
 
-	while (1) {
-		if (right <= left)
-			return;
+			if (nth <= pivot_pos)
+				return;
 
-		if ((right - left + 1) <= SORT_LEN_THRESHOLD) {
-			TrbSlice part_slice;
-			trb_slice_reslice(slice, &part_slice, left, right + 1);
-			__trb_inssort_data(&part_slice, cmpd_func, data);
-			return;
+			begin = pivot_pos + 1;
+			continue;
 		}
 
-		if (++loop_count >= max_loops) {
-			TrbSlice part_slice;
-			trb_slice_reslice(slice, &part_slice, left, right + 1);
-			__trb_heapsort_data(&part_slice, cmpd_func, data);
+		bool already_partitioned;
+		usize pivot_pos = __trb_pdq_partition_right(ctx, begin, end, &already_partitioned);
+
+		if (pivot_pos == nth)
 			return;
-		}
 
-		mid = left + ((right - left) >> 1);
-		pivot = __trb_find_median_data(slice, left, mid, right, cmpd_func, data);
-		new_pivot = __trb_quicksort_partition_data(slice, left, right, pivot, cmpd_func, data);
+		usize l_size = pivot_pos - begin;
+		usize r_size = end - (pivot_pos + 1);
+
+		if ((l_size < size / 8 || r_size < size / 8) && --bad_allowed == 0) {
+			if (nth < pivot_pos)
+				__trb_heapselect(ctx, begin, pivot_pos, nth);
+			else
+				__trb_heapselect(ctx, pivot_pos + 1, end, nth);
 
-		if (new_pivot == 0)
 			return;
+		}
 
-		if ((new_pivot - left - 1) > (right - new_pivot - 1)) {
-			__trb_quicksort_recursive_data(slice, new_pivot + 1, right, cmpd_func, data);
-			right = new_pivot - 1;
+		if (nth < pivot_pos) {
+			end = pivot_pos;
 		} else {
-			__trb_quicksort_recursive_data(slice, left, new_pivot - 1, cmpd_func, data);
-			left = new_pivot + 1;
+			begin = pivot_pos + 1;
+			leftmost = FALSE;
 		}
 	}
+
+	if (end - begin > 1)
+		__trb_inssort(ctx, begin, end - 1);
 }
 
-void trb_quicksort_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data)
+void trb_nth_element(TrbSlice *slice, usize nth, TrbCmpFunc cmp_func)
+{
+	trb_return_if_fail(slice != NULL);
+	trb_return_if_fail(cmp_func != NULL);
+	trb_return_if_fail(nth < trb_slice_len(slice));
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_cmp(&ctx, slice, cmp_func);
+	__trb_select(&ctx, 0, trb_slice_len(slice), nth);
+}
+
+void trb_nth_element_data(TrbSlice *slice, usize nth, TrbCmpDataFunc cmpd_func, void *data)
 {
 	trb_return_if_fail(slice != NULL);
 	trb_return_if_fail(cmpd_func != NULL);
+	trb_return_if_fail(nth < trb_slice_len(slice));
 
-	usize len = trb_slice_len(slice);
-	if (len <= 1)
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, cmpd_func, data);
+	__trb_select(&ctx, 0, trb_slice_len(slice), nth);
+}
+
+static void __trb_partial_sort(const TrbSortCtx *ctx, usize len, usize k)
+{
+	if (k >= len) {
+		__trb_pdqsort(ctx, 0, len);
+		return;
+	}
+
+	if (k == 0)
 		return;
 
-	__trb_quicksort_recursive_data(slice, 0, len - 1, cmpd_func, data);
+	__trb_select(ctx, 0, len, k - 1);
+	__trb_pdqsort(ctx, 0, k - 1);
 }
 
-void trb_reverse(TrbSlice *slice)
+void trb_partial_sort(TrbSlice *slice, usize k, TrbCmpFunc cmp_func)
 {
 	trb_return_if_fail(slice != NULL);
+	trb_return_if_fail(cmp_func != NULL);
 
-	usize len = trb_slice_len(slice);
-	if (len <= 1)
-		return;
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_cmp(&ctx, slice, cmp_func);
+	__trb_partial_sort(&ctx, trb_slice_len(slice), k);
+}
 
-	for (usize lo = 0, hi = len - 1; lo < hi; ++lo, --hi) {
-		trb_memswap(slice->at(slice, lo), slice->at(slice, hi), slice->elemsize);
-	}
+void trb_partial_sort_data(TrbSlice *slice, usize k, TrbCmpDataFunc cmpd_func, void *data)
+{
+	trb_return_if_fail(slice != NULL);
+	trb_return_if_fail(cmpd_func != NULL);
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, cmpd_func, data);
+	__trb_partial_sort(&ctx, trb_slice_len(slice), k);
 }
 
-/* Binary search */
-bool trb_binary_search(const TrbSlice *slice, const void *target, TrbCmpFunc cmp_func, usize *index)
+/* Keeps the k smallest elements seen so far in a max-heap stored in out */
+static usize __trb_topk(const TrbSortCtx *ctx, usize len, usize k, void *out)
 {
-	trb_return_val_if_fail(slice != NULL, FALSE);
-	trb_return_val_if_fail(cmp_func != NULL, FALSE);
+	k = trb_min(k, len);
 
-	usize len = trb_slice_len(slice);
+	if (k == 0)
+		return 0;
 
-	if (len == 0)
-		return FALSE;
+	TrbSlice out_slice;
+	trb_slice_init(&out_slice, out, ctx->elemsize, 0, k);
 
-	usize left = 0;
-	usize right = len - 1;
+	TrbSortCtx heap = *ctx;
+	heap.slice = &out_slice;
+	heap.base = out;
 
-	while (left <= right) {
-		usize mid = left + ((right - left) >> 1);
+	__trb_sort_copy_out(ctx, out, 0, k);
+	__trb_heapify(&heap, 0, k - 1);
 
-		if (cmp_func(slice->at(slice, mid), target) == 0) {
-			if (index != NULL)
-				*index = mid;
+	for (usize i = k; i < len; ++i) {
+		const void *elem = __trb_sort_at(ctx, i);
 
-			return TRUE;
+		if (__trb_sort_cmp(ctx, elem, out) < 0) {
+			trb_memcopy(out, elem, ctx->elemsize);
+			__trb_heap(&heap, 0, 0, k - 1);
 		}
+	}
 
-		if (cmp_func(slice->at(slice, mid), target) < 0)
-			left = mid + 1;
-		else
-			right = mid - 1;
+	/* Sorting the max-heap in place leaves it in ascending order */
+	for (usize end = k - 1; end > 0; --end) {
+		__trb_sort_swap(&heap, 0, end);
+		__trb_heap(&heap, 0, 0, end - 1);
 	}
 
-	return FALSE;
+	return k;
 }
 
-bool trb_binary_search_data(const TrbSlice *slice, const void *target, TrbCmpDataFunc cmpd_func, void *data, usize *index)
+usize trb_topk(const TrbSlice *slice, usize k, TrbCmpFunc cmp_func, void *out)
 {
-	trb_return_val_if_fail(slice != NULL, FALSE);
-	trb_return_val_if_fail(cmpd_func != NULL, FALSE);
+	trb_return_val_if_fail(slice != NULL, 0);
+	trb_return_val_if_fail(cmp_func != NULL, 0);
+	trb_return_val_if_fail(out != NULL || k == 0, 0);
 
-	usize len = trb_slice_len(slice);
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_cmp(&ctx, slice, cmp_func);
 
-	if (len == 0)
-		return FALSE;
+	return __trb_topk(&ctx, trb_slice_len(slice), k, out);
+}
+
+usize trb_topk_data(const TrbSlice *slice, usize k, TrbCmpDataFunc cmpd_func, void *data, void *out)
+{
+	trb_return_val_if_fail(slice != NULL, 0);
+	trb_return_val_if_fail(cmpd_func != NULL, 0);
+	trb_return_val_if_fail(out != NULL || k == 0, 0);
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, cmpd_func, data);
+
+	return __trb_topk(&ctx, trb_slice_len(slice), k, out);
+}
+
+/*
+ * Stable sort: natural merge sort with galloping, based on Timsort by Tim Peters.
+ * https://github.com/python/cpython/blob/main/Objects/listsort.txt
+ *
+ * Only the shorter of two adjacent runs is copied to the scratch buffer when merging,
+ * so the buffer never needs to hold more than half of the slice.
+ */
+typedef struct {
+	usize start;
+	usize len;
+} TrbStableRun;
+
+typedef struct {
+	const TrbSortCtx *ctx;
+	char *buffer;
+	usize min_gallop;
+	usize n_runs;
+	TrbStableRun runs[STABLE_MAX_RUNS];
+} TrbStableState;
+
+/* Gets the element at the given index either from the buffer or from the slice */
+static inline void *__trb_stable_at(const TrbSortCtx *ctx, const char *buffer, usize index)
+{
+	if (buffer != NULL)
+		return (void *) (buffer + index * ctx->elemsize);
 
-	usize left = 0;
-	usize right = len - 1;
+	return __trb_sort_at(ctx, index);
+}
 
-	while (left <= right) {
-		usize mid = left + ((right - left) >> 1);
+/*
+ * Locates the position at which to insert @key into the sorted run,
+ * starting the search at @hint. Returns k such that run[k - 1] < key <= run[k].
+ */
+static usize __trb_gallop_left(const TrbSortCtx *ctx, const void *key, const char *buffer, usize start, usize n, usize hint)
+{
+	isize lastofs = 0;
+	isize ofs = 1;
+	isize maxofs;
 
-		if (cmpd_func(slice->at(slice, mid), target, data) == 0) {
-			if (index != NULL)
-				*index = mid;
+	if (__trb_sort_cmp(ctx, __trb_stable_at(ctx, buffer, start + hint), key) < 0) {
+		/* run[hint + lastofs] < key <= run[hint + ofs] */
+		maxofs = n - hint;
 
-			return TRUE;
+		while (ofs < maxofs && __trb_sort_cmp(ctx, __trb_stable_at(ctx, buffer, start + hint + ofs), key) < 0) {
+			lastofs = ofs;
+			ofs = (ofs << 1) + 1;
 		}
 
-		if (cmpd_func(slice->at(slice, mid), target, data) < 0)
-			left = mid + 1;
-		else
-			right = mid - 1;
-	}
+		if (ofs > maxofs)
+			ofs = maxofs;
+
+		lastofs += hint;
+		ofs += hint;
+	} else {
+		/* run[hint - ofs] < key <= run[hint - lastofs] */
+		maxofs = hint + 1;
+
+		while (ofs < maxofs && __trb_sort_cmp(ctx, __trb_stable_at(ctx, buffer, start + hint - ofs), key) >= 0) {
+			lastofs = ofs;
+			ofs = (ofs << 1) + 1;
+		}
+
+		if (ofs > maxofs)
+			ofs = maxofs;
+
+		isize k = lastofs;
+		lastofs = hint - ofs;
+		ofs = hint - k;
+	}
+
+	lastofs++;
+
+	while (lastofs < ofs) {
+		isize mid = lastofs + ((ofs - lastofs) >> 1);
+
+		if (__trb_sort_cmp(ctx, __trb_stable_at(ctx, buffer, start + mid), key) < 0)
+			lastofs = mid + 1;
+		else
+			ofs = mid;
+	}
+
+	return ofs;
+}
+
+/*
+ * Like __trb_gallop_left(), except that if there are elements equal to @key,
+ * returns the position after them. Returns k such that run[k - 1] <= key < run[k].
+ */
+static usize __trb_gallop_right(const TrbSortCtx *ctx, const void *key, const char *buffer, usize start, usize n, usize hint)
+{
+	isize lastofs = 0;
+	isize ofs = 1;
+	isize maxofs;
+
+	if (__trb_sort_cmp(ctx, key, __trb_stable_at(ctx, buffer, start + hint)) < 0) {
+		/* run[hint - ofs] <= key < run[hint - lastofs] */
+		maxofs = hint + 1;
+
+		while (ofs < maxofs && __trb_sort_cmp(ctx, key, __trb_stable_at(ctx, buffer, start + hint - ofs)) < 0) {
+			lastofs = ofs;
+			ofs = (ofs << 1) + 1;
+		}
+
+		if (ofs > maxofs)
+			ofs = maxofs;
+
+		isize k = lastofs;
+		lastofs = hint - ofs;
+		ofs = hint - k;
+	} else {
+		/* run[hint + lastofs] <= key < run[hint + ofs] */
+		maxofs = n - hint;
+
+		while (ofs < maxofs && __trb_sort_cmp(ctx, key, __trb_stable_at(ctx, buffer, start + hint + ofs)) >= 0) {
+			lastofs = ofs;
+			ofs = (ofs << 1) + 1;
+		}
+
+		if (ofs > maxofs)
+			ofs = maxofs;
+
+		lastofs += hint;
+		ofs += hint;
+	}
+
+	lastofs++;
+
+	while (lastofs < ofs) {
+		isize mid = lastofs + ((ofs - lastofs) >> 1);
+
+		if (__trb_sort_cmp(ctx, key, __trb_stable_at(ctx, buffer, start + mid)) < 0)
+			ofs = mid;
+		else
+			lastofs = mid + 1;
+	}
+
+	return ofs;
+}
+
+/* Merges runs [a, a + na) and [b, b + nb) where na <= nb, the first run goes to the buffer */
+static void __trb_merge_lo(TrbStableState *ms, usize a, usize na, usize b, usize nb)
+{
+	const TrbSortCtx *ctx = ms->ctx;
+	usize elemsize = ctx->elemsize;
+	char *buf = ms->buffer;
+
+	__trb_sort_copy_out(ctx, buf, a, na);
+
+	usize dest = a;
+	usize pa = 0;
+	usize min_gallop = ms->min_gallop;
+
+	trb_memcopy(__trb_sort_at(ctx, dest++), __trb_sort_at(ctx, b++), elemsize);
+
+	if (--nb == 0)
+		goto succeed;
+
+	if (na == 1)
+		goto copy_b;
+
+	while (1) {
+		usize acount = 0;
+		usize bcount = 0;
+
+		/* Plain merge until one run wins consistently */
+		while (1) {
+			if (__trb_sort_cmp(ctx, __trb_sort_at(ctx, b), buf + pa * elemsize) < 0) {
+				trb_memcopy(__trb_sort_at(ctx, dest++), __trb_sort_at(ctx, b++), elemsize);
+				bcount++;
+				acount = 0;
+
+				if (--nb == 0)
+					goto succeed;
+
+				if (bcount >= min_gallop)
+					break;
+			} else {
+				trb_memcopy(__trb_sort_at(ctx, dest++), buf + (pa++) * elemsize, elemsize);
+				acount++;
+				bcount = 0;
+
+				if (--na == 1)
+					goto copy_b;
+
+				if (acount >= min_gallop)
+					break;
+			}
+		}
+
+		/* Galloping mode */
+		min_gallop++;
+
+		do {
+			min_gallop -= min_gallop > 1;
+			ms->min_gallop = min_gallop;
+
+			usize k = __trb_gallop_right(ctx, __trb_sort_at(ctx, b), buf, pa, na, 0);
+			acount = k;
+
+			if (k != 0) {
+				__trb_sort_copy_in(ctx, dest, buf + pa * elemsize, k);
+				dest += k;
+				pa += k;
+				na -= k;
+
+				if (na == 1)
+					goto copy_b;
+
+				if (na == 0)
+					goto succeed;
+			}
+
+			trb_memcopy(__trb_sort_at(ctx, dest++), __trb_sort_at(ctx, b++), elemsize);
+
+			if (--nb == 0)
+				goto succeed;
+
+			k = __trb_gallop_left(ctx, buf + pa * elemsize, NULL, b, nb, 0);
+			bcount = k;
+
+			if (k != 0) {
+				__trb_sort_move(ctx, dest, b, k);
+				dest += k;
+				b += k;
+				nb -= k;
+
+				if (nb == 0)
+					goto succeed;
+			}
+
+			trb_memcopy(__trb_sort_at(ctx, dest++), buf + (pa++) * elemsize, elemsize);
+
+			if (--na == 1)
+				goto copy_b;
+		} while (acount >= STABLE_MIN_GALLOP || bcount >= STABLE_MIN_GALLOP);
+
+		min_gallop++;
+		ms->min_gallop = min_gallop;
+	}
+
+succeed:
+	if (na != 0)
+		__trb_sort_copy_in(ctx, dest, buf + pa * elemsize, na);
+
+	return;
+
+copy_b:
+	/* The last element of the first run belongs at the end of the merge */
+	__trb_sort_move(ctx, dest, b, nb);
+	trb_memcopy(__trb_sort_at(ctx, dest + nb), buf + pa * elemsize, elemsize);
+}
+
+/* Merges runs [a, a + na) and [b, b + nb) where na >= nb, the second run goes to the buffer */
+static void __trb_merge_hi(TrbStableState *ms, usize a, usize na, usize b, usize nb)
+{
+	const TrbSortCtx *ctx = ms->ctx;
+	usize elemsize = ctx->elemsize;
+	char *buf = ms->buffer;
+
+	__trb_sort_copy_out(ctx, buf, b, nb);
+
+	/* Positions are one past the element to be taken next */
+	usize dest = b + nb;
+	usize pa = a + na;
+	usize pb = nb;
+	usize min_gallop = ms->min_gallop;
+
+	trb_memcopy(__trb_sort_at(ctx, --dest), __trb_sort_at(ctx, --pa), elemsize);
+
+	if (--na == 0)
+		goto succeed;
+
+	if (nb == 1)
+		goto copy_a;
+
+	while (1) {
+		usize acount = 0;
+		usize bcount = 0;
+
+		/* Plain merge until one run wins consistently */
+		while (1) {
+			if (__trb_sort_cmp(ctx, buf + (pb - 1) * elemsize, __trb_sort_at(ctx, pa - 1)) < 0) {
+				trb_memcopy(__trb_sort_at(ctx, --dest), __trb_sort_at(ctx, --pa), elemsize);
+				acount++;
+				bcount = 0;
+
+				if (--na == 0)
+					goto succeed;
+
+				if (acount >= min_gallop)
+					break;
+			} else {
+				trb_memcopy(__trb_sort_at(ctx, --dest), buf + (--pb) * elemsize, elemsize);
+				bcount++;
+				acount = 0;
+
+				if (--nb == 1)
+					goto copy_a;
+
+				if (bcount >= min_gallop)
+					break;
+			}
+		}
+
+		/* Galloping mode */
+		min_gallop++;
+
+		do {
+			min_gallop -= min_gallop > 1;
+			ms->min_gallop = min_gallop;
+
+			usize k = na - __trb_gallop_right(ctx, buf + (pb - 1) * elemsize, NULL, a, na, na - 1);
+			acount = k;
+
+			if (k != 0) {
+				dest -= k;
+				pa -= k;
+				__trb_sort_move(ctx, dest, pa, k);
+				na -= k;
+
+				if (na == 0)
+					goto succeed;
+			}
+
+			trb_memcopy(__trb_sort_at(ctx, --dest), buf + (--pb) * elemsize, elemsize);
+
+			if (--nb == 1)
+				goto copy_a;
+
+			k = nb - __trb_gallop_left(ctx, __trb_sort_at(ctx, pa - 1), buf, 0, nb, nb - 1);
+			bcount = k;
+
+			if (k != 0) {
+				dest -= k;
+				pb -= k;
+				__trb_sort_copy_in(ctx, dest, buf + pb * elemsize, k);
+				nb -= k;
+
+				if (nb == 1)
+					goto copy_a;
+
+				if (nb == 0)
+					goto succeed;
+			}
+
+			trb_memcopy(__trb_sort_at(ctx, --dest), __trb_sort_at(ctx, --pa), elemsize);
+
+			if (--na == 0)
+				goto succeed;
+		} while (acount >= STABLE_MIN_GALLOP || bcount >= STABLE_MIN_GALLOP);
+
+		min_gallop++;
+		ms->min_gallop = min_gallop;
+	}
+
+succeed:
+	if (nb != 0)
+		__trb_sort_copy_in(ctx, dest - nb, buf, nb);
+
+	return;
+
+copy_a:
+	/* The first element of the second run belongs at the start of the merge */
+	dest -= na;
+	pa -= na;
+	__trb_sort_move(ctx, dest, pa, na);
+	trb_memcopy(__trb_sort_at(ctx, dest - 1), buf, elemsize);
+}
+
+/* Merges the runs at stack indices i and i + 1 */
+static void __trb_merge_at(TrbStableState *ms, usize i)
+{
+	const TrbSortCtx *ctx = ms->ctx;
+
+	usize a = ms->runs[i].start;
+	usize na = ms->runs[i].len;
+	usize b = ms->runs[i + 1].start;
+	usize nb = ms->runs[i + 1].len;
+
+	ms->runs[i].len = na + nb;
+
+	if (i == ms->n_runs - 3)
+		ms->runs[i + 1] = ms->runs[i + 2];
+
+	ms->n_runs--;
+
+	/* Elements of the first run that are not greater than b[0] are already in place */
+	usize k = __trb_gallop_right(ctx, __trb_sort_at(ctx, b), NULL, a, na, 0);
+	a += k;
+	na -= k;
+
+	if (na == 0)
+		return;
+
+	/* Elements of the second run that are not less than a[na - 1] are already in place */
+	nb = __trb_gallop_left(ctx, __trb_sort_at(ctx, a + na - 1), NULL, b, nb, nb - 1);
+
+	if (nb == 0)
+		return;
+
+	if (na <= nb)
+		__trb_merge_lo(ms, a, na, b, nb);
+	else
+		__trb_merge_hi(ms, a, na, b, nb);
+}
+
+/* Keeps run lengths decreasing faster than the Fibonacci sequence */
+static void __trb_merge_collapse(TrbStableState *ms)
+{
+	TrbStableRun *p = ms->runs;
+
+	while (ms->n_runs > 1) {
+		usize n = ms->n_runs - 2;
+
+		if (
+			(n > 0 && p[n - 1].len <= p[n].len + p[n + 1].len) ||
+			(n > 1 && p[n - 2].len <= p[n - 1].len + p[n].len)
+		) {
+			if (p[n - 1].len < p[n + 1].len)
+				n--;
+
+			__trb_merge_at(ms, n);
+		} else if (p[n].len <= p[n + 1].len) {
+			__trb_merge_at(ms, n);
+		} else {
+			break;
+		}
+	}
+}
+
+static void __trb_merge_force_collapse(TrbStableState *ms)
+{
+	TrbStableRun *p = ms->runs;
+
+	while (ms->n_runs > 1) {
+		usize n = ms->n_runs - 2;
+
+		if (n > 0 && p[n - 1].len < p[n + 1].len)
+			n--;
+
+		__trb_merge_at(ms, n);
+	}
+}
+
+static usize __trb_stable_minrun(usize n)
+{
+	usize r = 0;
+
+	while (n >= STABLE_MIN_MERGE) {
+		r |= n & 1;
+		n >>= 1;
+	}
+
+	return n + r;
+}
+
+/* Returns the length of the run starting at lo, reversing it if it is strictly descending */
+static usize __trb_stable_count_run(const TrbSortCtx *ctx, usize lo, usize hi)
+{
+	if (lo + 1 == hi)
+		return 1;
+
+	usize i = lo + 2;
+
+	if (__trb_sort_cmp_at(ctx, lo + 1, lo) < 0) {
+		while (i < hi && __trb_sort_cmp_at(ctx, i, i - 1) < 0)
+			i++;
+
+		for (usize l = lo, h = i - 1; l < h; ++l, --h)
+			__trb_sort_swap(ctx, l, h);
+	} else {
+		while (i < hi && __trb_sort_cmp_at(ctx, i, i - 1) >= 0)
+			i++;
+	}
+
+	return i - lo;
+}
+
+static bool __trb_stablesort(const TrbSortCtx *ctx, usize len, void *buffer)
+{
+	if (len < STABLE_MIN_MERGE) {
+		__trb_inssort(ctx, 0, len - 1);
+		return TRUE;
+	}
+
+	TrbStableState ms;
+	ms.ctx = ctx;
+	ms.buffer = buffer;
+	ms.min_gallop = STABLE_MIN_GALLOP;
+	ms.n_runs = 0;
+
+	if (ms.buffer == NULL) {
+		ms.buffer = malloc((len / 2) * ctx->elemsize);
+
+		if (ms.buffer == NULL) {
+			trb_msg_error("couldn't allocate memory for the merge buffer!");
+			return FALSE;
+		}
+	}
+
+	usize minrun = __trb_stable_minrun(len);
+
+	for (usize lo = 0; lo < len;) {
+		usize n = __trb_stable_count_run(ctx, lo, len);
+
+		/* Extend short runs to minrun elements */
+		if (n < minrun) {
+			usize force = trb_min(minrun, len - lo);
+			__trb_inssort(ctx, lo, lo + force - 1);
+			n = force;
+		}
+
+		ms.runs[ms.n_runs].start = lo;
+		ms.runs[ms.n_runs].len = n;
+		ms.n_runs++;
+
+		__trb_merge_collapse(&ms);
+
+		lo += n;
+	}
+
+	__trb_merge_force_collapse(&ms);
+
+	if (buffer == NULL)
+		free(ms.buffer);
+
+	return TRUE;
+}
+
+bool trb_stablesort(TrbSlice *slice, TrbCmpFunc cmp_func, void *buffer)
+{
+	trb_return_val_if_fail(slice != NULL, FALSE);
+	trb_return_val_if_fail(cmp_func != NULL, FALSE);
+
+	usize len = trb_slice_len(slice);
+	if (len <= 1)
+		return TRUE;
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_cmp(&ctx, slice, cmp_func);
+
+	return __trb_stablesort(&ctx, len, buffer);
+}
+
+bool trb_stablesort_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data, void *buffer)
+{
+	trb_return_val_if_fail(slice != NULL, FALSE);
+	trb_return_val_if_fail(cmpd_func != NULL, FALSE);
+
+	usize len = trb_slice_len(slice);
+	if (len <= 1)
+		return TRUE;
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, cmpd_func, data);
+
+	return __trb_stablesort(&ctx, len, buffer);
+}
+
+/* Parallel sort: chunks are sorted concurrently, then merged in rounds split by merge path */
+typedef struct {
+	usize a;
+	usize na;
+	usize b;
+	usize nb;
+	usize dst;
+	usize k0;
+	usize k1;
+} TrbMergeTask;
+
+typedef struct _TrbParallelSort TrbParallelSort;
+
+struct _TrbParallelSort {
+	TrbSortCtx ctx;
+	char *src;
+	char *dst;
+	bool stable;
+	usize *bounds;
+	TrbMergeTask *tasks;
+	usize n_items;
+	usize next;
+	void (*run_item)(TrbParallelSort *ps, usize index);
+};
+
+static void *__trb_parallel_worker(void *arg)
+{
+	TrbParallelSort *ps = arg;
+	usize index;
+
+	while ((index = __atomic_fetch_add(&ps->next, 1, __ATOMIC_RELAXED)) < ps->n_items)
+		ps->run_item(ps, index);
+
+	return NULL;
+}
+
+/* Runs all items on up to n_threads threads, the calling thread included */
+static void __trb_parallel_run(TrbParallelSort *ps, usize n_threads)
+{
+	pthread_t threads[PARALLEL_MAX_THREADS];
+	usize n_started = 0;
+
+	ps->next = 0;
+	n_threads = trb_min(n_threads, ps->n_items);
+
+	for (usize i = 1; i < n_threads; ++i) {
+		if (pthread_create(&threads[n_started], NULL, __trb_parallel_worker, ps) != 0)
+			break;
+
+		n_started++;
+	}
+
+	__trb_parallel_worker(ps);
+
+	for (usize i = 0; i < n_started; ++i)
+		pthread_join(threads[i], NULL);
+}
+
+static void __trb_parallel_sort_chunk(TrbParallelSort *ps, usize index)
+{
+	usize start = ps->bounds[index];
+	usize len = ps->bounds[index + 1] - start;
+
+	TrbSortCtx ctx = ps->ctx;
+	ctx.base = ps->src + start * ctx.elemsize;
+
+	if (ps->stable)
+		__trb_stablesort(&ctx, len, ps->dst + start * ctx.elemsize);
+	else
+		__trb_pdqsort(&ctx, 0, len);
+}
+
+/* Returns the number of elements taken from the first run among the first k merged elements */
+static usize __trb_merge_corank(const TrbParallelSort *ps, const TrbMergeTask *task, usize k)
+{
+	const TrbSortCtx *ctx = &ps->ctx;
+	usize elemsize = ctx->elemsize;
+
+	const char *a = ps->src + task->a * elemsize;
+	const char *b = ps->src + task->b * elemsize;
+
+	usize lo = (k > task->nb) ? k - task->nb : 0;
+	usize hi = trb_min(k, task->na);
+
+	while (lo < hi) {
+		usize mid = lo + (hi - lo) / 2;
+
+		/* Equal elements are taken from the first run first */
+		if (__trb_sort_cmp(ctx, b + (k - mid - 1) * elemsize, a + mid * elemsize) < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return lo;
+}
+
+static void __trb_parallel_merge(TrbParallelSort *ps, usize index)
+{
+	const TrbMergeTask *task = &ps->tasks[index];
+	const TrbSortCtx *ctx = &ps->ctx;
+	usize elemsize = ctx->elemsize;
+
+	usize i = __trb_merge_corank(ps, task, task->k0);
+	usize j = task->k0 - i;
+	usize iend = __trb_merge_corank(ps, task, task->k1);
+	usize jend = task->k1 - iend;
+
+	const char *a = ps->src + task->a * elemsize;
+	const char *b = ps->src + task->b * elemsize;
+	char *out = ps->dst + (task->dst + task->k0) * elemsize;
+
+	while (i < iend && j < jend) {
+		const char *elem;
+
+		if (__trb_sort_cmp(ctx, b + j * elemsize, a + i * elemsize) < 0)
+			elem = b + (j++) * elemsize;
+		else
+			elem = a + (i++) * elemsize;
+
+		trb_memcopy(out, elem, elemsize);
+		out += elemsize;
+	}
+
+	memcpy(out, a + i * elemsize, (iend - i) * elemsize);
+	out += (iend - i) * elemsize;
+	memcpy(out, b + j * elemsize, (jend - j) * elemsize);
+}
+
+/* Splits the merge of two adjacent runs into tasks of about piece elements */
+static usize __trb_parallel_add_merge(TrbParallelSort *ps, usize n_tasks, usize a, usize na, usize nb, usize piece)
+{
+	usize total = na + nb;
+
+	for (usize k = 0; k < total; k += piece) {
+		TrbMergeTask *task = &ps->tasks[n_tasks++];
+		task->a = a;
+		task->na = na;
+		task->b = a + na;
+		task->nb = nb;
+		task->dst = a;
+		task->k0 = k;
+		task->k1 = trb_min(k + piece, total);
+	}
+
+	return n_tasks;
+}
+
+static bool __trb_parallel_sort(TrbSortCtx *ctx, usize len, usize n_threads, bool stable, void *buffer)
+{
+	if (n_threads == 0) {
+		long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		n_threads = (n_cpus > 0) ? (usize) n_cpus : 1;
+	}
+
+	usize n_chunks = trb_min(n_threads, len / PARALLEL_MIN_CHUNK);
+	n_chunks = trb_min(n_chunks, PARALLEL_MAX_THREADS);
+
+	if (n_chunks <= 1) {
+		if (stable)
+			return __trb_stablesort(ctx, len, buffer);
+
+		__trb_pdqsort(ctx, 0, len);
+		return TRUE;
+	}
+
+	usize elemsize = ctx->elemsize;
+	usize size = len * elemsize;
+	usize n_alloc = (buffer == NULL) + (ctx->base == NULL);
+
+	usize bounds[PARALLEL_MAX_THREADS + 1];
+	TrbMergeTask tasks[2 * PARALLEL_MAX_THREADS + 1];
+	char *alloc = NULL;
+
+	if (n_alloc != 0) {
+		alloc = malloc(n_alloc * size);
+
+		if (alloc == NULL) {
+			trb_msg_error("couldn't allocate memory for the merge buffer!");
+			return FALSE;
+		}
+	}
+
+	char *tmp = (buffer != NULL) ? buffer : alloc;
+	char *data = ctx->base;
+
+	/* Non-contiguous slices are gathered into a contiguous array first */
+	if (data == NULL) {
+		data = (buffer != NULL) ? alloc : alloc + size;
+		__trb_sort_copy_out(ctx, data, 0, len);
+	}
+
+	TrbParallelSort ps;
+	ps.ctx = *ctx;
+	ps.src = data;
+	ps.dst = tmp;
+	ps.stable = stable;
+	ps.bounds = bounds;
+	ps.tasks = tasks;
+
+	for (usize i = 0; i <= n_chunks; ++i)
+		bounds[i] = len * i / n_chunks;
+
+	ps.n_items = n_chunks;
+	ps.run_item = __trb_parallel_sort_chunk;
+	__trb_parallel_run(&ps, n_threads);
+
+	usize piece = (len + n_chunks - 1) / n_chunks;
+	usize n_runs = n_chunks;
+
+	ps.run_item = __trb_parallel_merge;
+
+	while (n_runs > 1) {
+		usize n_tasks = 0;
+		usize r = 0;
+
+		for (; r + 1 < n_runs; r += 2) {
+			usize a = bounds[r];
+			usize na = bounds[r + 1] - a;
+			usize nb = bounds[r + 2] - bounds[r + 1];
+			n_tasks = __trb_parallel_add_merge(&ps, n_tasks, a, na, nb, piece);
+		}
+
+		/* The odd run is copied over */
+		if (r < n_runs)
+			n_tasks = __trb_parallel_add_merge(&ps, n_tasks, bounds[r], bounds[r + 1] - bounds[r], 0, piece);
+
+		ps.n_items = n_tasks;
+		__trb_parallel_run(&ps, n_threads);
+
+		usize n_merged = (n_runs + 1) / 2;
+
+		for (usize i = 0; i <= n_merged; ++i)
+			bounds[i] = bounds[trb_min(2 * i, n_runs)];
+
+		n_runs = n_merged;
+
+		char *swap = ps.src;
+		ps.src = ps.dst;
+		ps.dst = swap;
+	}
+
+	/* Brings the result back to the slice */
+	if (ctx->base == NULL) {
+		__trb_sort_copy_in(ctx, 0, ps.src, len);
+	} else if (ps.src != ctx->base) {
+		ps.dst = ctx->base;
+		ps.n_items = __trb_parallel_add_merge(&ps, 0, 0, len, 0, piece);
+		__trb_parallel_run(&ps, n_threads);
+	}
+
+	free(alloc);
+
+	return TRUE;
+}
+
+bool trb_quicksort_parallel(TrbSlice *slice, TrbCmpFunc cmp_func, usize n_threads)
+{
+	trb_return_val_if_fail(slice != NULL, FALSE);
+	trb_return_val_if_fail(cmp_func != NULL, FALSE);
+
+	usize len = trb_slice_len(slice);
+	if (len <= 1)
+		return TRUE;
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_cmp(&ctx, slice, cmp_func);
+
+	return __trb_parallel_sort(&ctx, len, n_threads, FALSE, NULL);
+}
+
+bool trb_quicksort_parallel_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data, usize n_threads)
+{
+	trb_return_val_if_fail(slice != NULL, FALSE);
+	trb_return_val_if_fail(cmpd_func != NULL, FALSE);
+
+	usize len = trb_slice_len(slice);
+	if (len <= 1)
+		return TRUE;
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, cmpd_func, data);
+
+	return __trb_parallel_sort(&ctx, len, n_threads, FALSE, NULL);
+}
+
+bool trb_stablesort_parallel(TrbSlice *slice, TrbCmpFunc cmp_func, usize n_threads, void *buffer)
+{
+	trb_return_val_if_fail(slice != NULL, FALSE);
+	trb_return_val_if_fail(cmp_func != NULL, FALSE);
+
+	usize len = trb_slice_len(slice);
+	if (len <= 1)
+		return TRUE;
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_cmp(&ctx, slice, cmp_func);
+
+	return __trb_parallel_sort(&ctx, len, n_threads, TRUE, buffer);
+}
+
+bool trb_stablesort_parallel_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data, usize n_threads, void *buffer)
+{
+	trb_return_val_if_fail(slice != NULL, FALSE);
+	trb_return_val_if_fail(cmpd_func != NULL, FALSE);
+
+	usize len = trb_slice_len(slice);
+	if (len <= 1)
+		return TRUE;
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, cmpd_func, data);
+
+	return __trb_parallel_sort(&ctx, len, n_threads, TRUE, buffer);
+}
+
+/* Radix sort */
+typedef struct {
+	TrbKeyType type;
+	usize offset;
+} TrbRadixKey;
+
+/*
+ * Maps the key to an unsigned integer of the same width with the same ordering:
+ * the sign bit of signed integers is flipped, negative floats have all bits flipped
+ * and positive floats have the sign bit flipped.
+ */
+#define RADIX_DEFINE(name, type, utype, to_ukey)                                               \
+	static inline utype __trb_radix_ukey_##name(const char *elem, usize offset)                \
+	{                                                                                           \
+		const utype sign = (utype) 1 << (sizeof(utype) * 8 - 1);                                \
+		utype ukey;                                                                             \
+		memcpy(&ukey, elem + offset, sizeof(type));                                             \
+		(void) sign;                                                                            \
+		return (to_ukey);                                                                       \
+	}                                                                                           \
+                                                                                                \
+	static inline void __trb_radix_scatter_##name(                                             \
+		const char *src, char *dst, usize len, usize elemsize, usize offset, usize shift, usize *count \
+	)                                                                                           \
+	{                                                                                           \
+		for (usize i = 0; i < len; ++i) {                                                       \
+			const char *elem = src + i * elemsize;                                              \
+			utype ukey = __trb_radix_ukey_##name(elem, offset);                                 \
+			trb_memcopy(dst + (count[(ukey >> shift) & 0xff]++) * elemsize, elem, elemsize);    \
+		}                                                                                       \
+	}                                                                                           \
+                                                                                                \
+	static char *__trb_radix_##name(char *src, char *dst, usize len, usize elemsize, usize offset) \
+	{                                                                                           \
+		usize counts[sizeof(type)][256] = { 0 };                                                \
+                                                                                                \
+		for (usize i = 0; i < len; ++i) {                                                       \
+			utype ukey = __trb_radix_ukey_##name(src + i * elemsize, offset);                   \
+			for (usize p = 0; p < sizeof(type); ++p)                                            \
+				counts[p][(ukey >> (p * 8)) & 0xff]++;                                          \
+		}                                                                                       \
+                                                                                                \
+		utype first = __trb_radix_ukey_##name(src, offset);                                     \
+                                                                                                \
+		for (usize p = 0; p < sizeof(type); ++p) {                                              \
+			usize shift = p * 8;                                                                \
+			usize *count = counts[p];                                                           \
+                                                                                                \
+			/* All keys share this digit */                                                     \
+			if (count[(first >> shift) & 0xff] == len)                                          \
+				continue;                                                                       \
+                                                                                                \
+			usize sum = 0;                                                                      \
+			for (usize d = 0; d < 256; ++d) {                                                   \
+				usize c = count[d];                                                             \
+				count[d] = sum;                                                                 \
+				sum += c;                                                                       \
+			}                                                                                   \
+                                                                                                \
+			/* Bare keys get a scatter loop with the element size known at compile time */  \
+			if (elemsize == sizeof(type))                                                       \
+				__trb_radix_scatter_##name(src, dst, len, sizeof(type), 0, shift, count);       \
+			else                                                                                \
+				__trb_radix_scatter_##name(src, dst, len, elemsize, offset, shift, count);      \
+                                                                                                \
+			char *tmp = src;                                                                    \
+			src = dst;                                                                          \
+			dst = tmp;                                                                          \
+		}                                                                                       \
+                                                                                                \
+		return src;                                                                             \
+	}
+
+RADIX_DEFINE(u8, u8, u8, ukey)
+RADIX_DEFINE(u16, u16, u16, ukey)
+RADIX_DEFINE(u32, u32, u32, ukey)
+RADIX_DEFINE(u64, u64, u64, ukey)
+RADIX_DEFINE(i8, i8, u8, ukey ^ sign)
+RADIX_DEFINE(i16, i16, u16, ukey ^ sign)
+RADIX_DEFINE(i32, i32, u32, ukey ^ sign)
+RADIX_DEFINE(i64, i64, u64, ukey ^ sign)
+RADIX_DEFINE(f32, f32, u32, ukey ^ ((ukey & sign) ? (u32) ~0 : sign))
+RADIX_DEFINE(f64, f64, u64, ukey ^ ((ukey & sign) ? (u64) ~0 : sign))
+
+#undef RADIX_DEFINE
+
+static usize __trb_radix_keysize(TrbKeyType type)
+{
+	switch (type) {
+	case TRB_KEY_U8:
+	case TRB_KEY_I8:
+		return 1;
+	case TRB_KEY_U16:
+	case TRB_KEY_I16:
+		return 2;
+	case TRB_KEY_U32:
+	case TRB_KEY_I32:
+	case TRB_KEY_F32:
+		return 4;
+	case TRB_KEY_U64:
+	case TRB_KEY_I64:
+	case TRB_KEY_F64:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+static u64 __trb_radix_ukey(const char *elem, const TrbRadixKey *key)
+{
+	switch (key->type) {
+	case TRB_KEY_U8:
+		return __trb_radix_ukey_u8(elem, key->offset);
+	case TRB_KEY_U16:
+		return __trb_radix_ukey_u16(elem, key->offset);
+	case TRB_KEY_U32:
+		return __trb_radix_ukey_u32(elem, key->offset);
+	case TRB_KEY_U64:
+		return __trb_radix_ukey_u64(elem, key->offset);
+	case TRB_KEY_I8:
+		return __trb_radix_ukey_i8(elem, key->offset);
+	case TRB_KEY_I16:
+		return __trb_radix_ukey_i16(elem, key->offset);
+	case TRB_KEY_I32:
+		return __trb_radix_ukey_i32(elem, key->offset);
+	case TRB_KEY_I64:
+		return __trb_radix_ukey_i64(elem, key->offset);
+	case TRB_KEY_F32:
+		return __trb_radix_ukey_f32(elem, key->offset);
+	default:
+		return __trb_radix_ukey_f64(elem, key->offset);
+	}
+}
+
+static i32 __trb_radix_cmp(const void *a, const void *b, void *data)
+{
+	u64 ka = __trb_radix_ukey(a, data);
+	u64 kb = __trb_radix_ukey(b, data);
+
+	return (ka > kb) - (ka < kb);
+}
+
+static char *__trb_radix(TrbKeyType type, char *src, char *dst, usize len, usize elemsize, usize offset)
+{
+	switch (type) {
+	case TRB_KEY_U8:
+		return __trb_radix_u8(src, dst, len, elemsize, offset);
+	case TRB_KEY_U16:
+		return __trb_radix_u16(src, dst, len, elemsize, offset);
+	case TRB_KEY_U32:
+		return __trb_radix_u32(src, dst, len, elemsize, offset);
+	case TRB_KEY_U64:
+		return __trb_radix_u64(src, dst, len, elemsize, offset);
+	case TRB_KEY_I8:
+		return __trb_radix_i8(src, dst, len, elemsize, offset);
+	case TRB_KEY_I16:
+		return __trb_radix_i16(src, dst, len, elemsize, offset);
+	case TRB_KEY_I32:
+		return __trb_radix_i32(src, dst, len, elemsize, offset);
+	case TRB_KEY_I64:
+		return __trb_radix_i64(src, dst, len, elemsize, offset);
+	case TRB_KEY_F32:
+		return __trb_radix_f32(src, dst, len, elemsize, offset);
+	default:
+		return __trb_radix_f64(src, dst, len, elemsize, offset);
+	}
+}
+
+bool trb_radixsort_by_key(TrbSlice *slice, TrbKeyType key_type, usize offset, void *buffer)
+{
+	trb_return_val_if_fail(slice != NULL, FALSE);
+
+	usize keysize = __trb_radix_keysize(key_type);
+	trb_return_val_if_fail(keysize != 0, FALSE);
+	trb_return_val_if_fail(offset <= slice->elemsize && keysize <= slice->elemsize - offset, FALSE);
+
+	usize len = trb_slice_len(slice);
+	if (len <= 1)
+		return TRUE;
+
+	TrbRadixKey key = { .type = key_type, .offset = offset };
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, __trb_radix_cmp, &key);
+
+	if (len < RADIX_INSSORT_THRESHOLD) {
+		__trb_inssort(&ctx, 0, len - 1);
+		return TRUE;
+	}
+
+	usize size = len * slice->elemsize;
+	usize n_alloc = (buffer == NULL) + (ctx.base == NULL);
+	char *alloc = NULL;
+
+	if (n_alloc != 0) {
+		alloc = malloc(n_alloc * size);
+
+		if (alloc == NULL) {
+			trb_msg_error("couldn't allocate memory for the radix sort buffer!");
+			return FALSE;
+		}
+	}
+
+	char *tmp = (buffer != NULL) ? buffer : alloc;
+	char *data = ctx.base;
+
+	/* Non-contiguous slices are gathered into a contiguous array first */
+	if (data == NULL) {
+		data = (buffer != NULL) ? alloc : alloc + size;
+		__trb_sort_copy_out(&ctx, data, 0, len);
+	}
+
+	char *sorted = __trb_radix(key_type, data, tmp, len, slice->elemsize, offset);
+
+	if (ctx.base == NULL)
+		__trb_sort_copy_in(&ctx, 0, sorted, len);
+	else if (sorted != ctx.base)
+		memcpy(ctx.base, sorted, size);
+
+	free(alloc);
+
+	return TRUE;
+}
+
+bool trb_radixsort_u8(TrbSlice *slice, void *buffer)
+{
+	return trb_radixsort_by_key(slice, TRB_KEY_U8, 0, buffer);
+}
+
+bool trb_radixsort_u16(TrbSlice *slice, void *buffer)
+{
+	return trb_radixsort_by_key(slice, TRB_KEY_U16, 0, buffer);
+}
+
+bool trb_radixsort_u32(TrbSlice *slice, void *buffer)
+{
+	return trb_radixsort_by_key(slice, TRB_KEY_U32, 0, buffer);
+}
+
+bool trb_radixsort_u64(TrbSlice *slice, void *buffer)
+{
+	return trb_radixsort_by_key(slice, TRB_KEY_U64, 0, buffer);
+}
+
+bool trb_radixsort_i8(TrbSlice *slice, void *buffer)
+{
+	return trb_radixsort_by_key(slice, TRB_KEY_I8, 0, buffer);
+}
+
+bool trb_radixsort_i16(TrbSlice *slice, void *buffer)
+{
+	return trb_radixsort_by_key(slice, TRB_KEY_I16, 0, buffer);
+}
+
+bool trb_radixsort_i32(TrbSlice *slice, void *buffer)
+{
+	return trb_radixsort_by_key(slice, TRB_KEY_I32, 0, buffer);
+}
+
+bool trb_radixsort_i64(TrbSlice *slice, void *buffer)
+{
+	return trb_radixsort_by_key(slice, TRB_KEY_I64, 0, buffer);
+}
+
+bool trb_radixsort_f32(TrbSlice *slice, void *buffer)
+{
+	return trb_radixsort_by_key(slice, TRB_KEY_F32, 0, buffer);
+}
+
+bool trb_radixsort_f64(TrbSlice *slice, void *buffer)
+{
+	return trb_radixsort_by_key(slice, TRB_KEY_F64, 0, buffer);
+}
+
+void trb_reverse(TrbSlice *slice)
+{
+	trb_return_if_fail(slice != NULL);
+
+	usize len = trb_slice_len(slice);
+	if (len <= 1)
+		return;
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init(&ctx, slice);
+
+	for (usize lo = 0, hi = len - 1; lo < hi; ++lo, --hi)
+		__trb_sort_swap(&ctx, lo, hi);
+}
+
+/* Binary search */
+/*
+ * Branchless binary search: the range halves on every step regardless of the
+ * comparison, which only selects the base through a conditional move.
+ * Both possible next probes are prefetched for contiguous slices.
+ */
+static usize __trb_bound(const TrbSortCtx *ctx, usize base, usize len, const void *target, bool upper)
+{
+	if (len == 0)
+		return base;
+
+	i32 limit = upper ? 1 : 0;
+
+	while (len > 1) {
+		usize half = len / 2;
+
+		if (ctx->base != NULL) {
+			__builtin_prefetch(ctx->base + (base + half / 2) * ctx->elemsize);
+			__builtin_prefetch(ctx->base + (base + half + half / 2) * ctx->elemsize);
+		}
+
+		base = (__trb_sort_cmp(ctx, __trb_sort_at(ctx, base + half), target) < limit) ? base + half : base;
+		len -= half;
+	}
+
+	return base + (__trb_sort_cmp(ctx, __trb_sort_at(ctx, base), target) < limit);
+}
+
+usize trb_lower_bound(const TrbSlice *slice, const void *target, TrbCmpFunc cmp_func)
+{
+	trb_return_val_if_fail(slice != NULL, 0);
+	trb_return_val_if_fail(cmp_func != NULL, 0);
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_cmp(&ctx, slice, cmp_func);
+
+	return __trb_bound(&ctx, 0, trb_slice_len(slice), target, FALSE);
+}
+
+usize trb_lower_bound_data(const TrbSlice *slice, const void *target, TrbCmpDataFunc cmpd_func, void *data)
+{
+	trb_return_val_if_fail(slice != NULL, 0);
+	trb_return_val_if_fail(cmpd_func != NULL, 0);
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, cmpd_func, data);
+
+	return __trb_bound(&ctx, 0, trb_slice_len(slice), target, FALSE);
+}
+
+usize trb_upper_bound(const TrbSlice *slice, const void *target, TrbCmpFunc cmp_func)
+{
+	trb_return_val_if_fail(slice != NULL, 0);
+	trb_return_val_if_fail(cmp_func != NULL, 0);
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_cmp(&ctx, slice, cmp_func);
+
+	return __trb_bound(&ctx, 0, trb_slice_len(slice), target, TRUE);
+}
+
+usize trb_upper_bound_data(const TrbSlice *slice, const void *target, TrbCmpDataFunc cmpd_func, void *data)
+{
+	trb_return_val_if_fail(slice != NULL, 0);
+	trb_return_val_if_fail(cmpd_func != NULL, 0);
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, cmpd_func, data);
+
+	return __trb_bound(&ctx, 0, trb_slice_len(slice), target, TRUE);
+}
+
+static bool __trb_equal_range(const TrbSortCtx *ctx, usize len, const void *target, usize *start, usize *end)
+{
+	usize first = __trb_bound(ctx, 0, len, target, FALSE);
+
+	/* The upper bound can only be found after the lower one */
+	usize last = __trb_bound(ctx, first, len - first, target, TRUE);
+
+	if (start != NULL)
+		*start = first;
+
+	if (end != NULL)
+		*end = last;
+
+	return first != last;
+}
+
+bool trb_equal_range(const TrbSlice *slice, const void *target, TrbCmpFunc cmp_func, usize *start, usize *end)
+{
+	trb_return_val_if_fail(slice != NULL, FALSE);
+	trb_return_val_if_fail(cmp_func != NULL, FALSE);
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_cmp(&ctx, slice, cmp_func);
+
+	return __trb_equal_range(&ctx, trb_slice_len(slice), target, start, end);
+}
+
+bool trb_equal_range_data(const TrbSlice *slice, const void *target, TrbCmpDataFunc cmpd_func, void *data, usize *start, usize *end)
+{
+	trb_return_val_if_fail(slice != NULL, FALSE);
+	trb_return_val_if_fail(cmpd_func != NULL, FALSE);
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, cmpd_func, data);
+
+	return __trb_equal_range(&ctx, trb_slice_len(slice), target, start, end);
+}
+
+static bool __trb_binary_search(const TrbSortCtx *ctx, const void *target, usize *index)
+{
+	usize len = trb_slice_len(ctx->slice);
+	usize pos = __trb_bound(ctx, 0, len, target, FALSE);
+
+	if (pos == len || __trb_sort_cmp(ctx, __trb_sort_at(ctx, pos), target) != 0)
+		return FALSE;
+
+	if (index != NULL)
+		*index = pos;
+
+	return TRUE;
+}
+
+bool trb_binary_search(const TrbSlice *slice, const void *target, TrbCmpFunc cmp_func, usize *index)
+{
+	trb_return_val_if_fail(slice != NULL, FALSE);
+	trb_return_val_if_fail(cmp_func != NULL, FALSE);
+
+	if (trb_slice_len(slice) == 0)
+		return FALSE;
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_cmp(&ctx, slice, cmp_func);
+
+	return __trb_binary_search(&ctx, target, index);
+}
+
+bool trb_binary_search_data(const TrbSlice *slice, const void *target, TrbCmpDataFunc cmpd_func, void *data, usize *index)
+{
+	trb_return_val_if_fail(slice != NULL, FALSE);
+	trb_return_val_if_fail(cmpd_func != NULL, FALSE);
+
+	if (trb_slice_len(slice) == 0)
+		return FALSE;
+
+	TrbSortCtx ctx;
+	__trb_sort_ctx_init_data(&ctx, slice, cmpd_func, data);
 
-	return FALSE;
+	return __trb_binary_search(&ctx, target, index);
 }
 
 /* Compare functions */
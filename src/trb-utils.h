@@ -7,6 +7,34 @@
 
 #include <stdarg.h>
 
+/**
+ * TrbKeyType:
+ * @TRB_KEY_U8: #u8 key.
+ * @TRB_KEY_U16: #u16 key.
+ * @TRB_KEY_U32: #u32 key.
+ * @TRB_KEY_U64: #u64 key.
+ * @TRB_KEY_I8: #i8 key.
+ * @TRB_KEY_I16: #i16 key.
+ * @TRB_KEY_I32: #i32 key.
+ * @TRB_KEY_I64: #i64 key.
+ * @TRB_KEY_F32: #f32 key.
+ * @TRB_KEY_F64: #f64 key.
+ *
+ * The type of the key used by trb_radixsort_by_key().
+ **/
+typedef enum {
+	TRB_KEY_U8,
+	TRB_KEY_U16,
+	TRB_KEY_U32,
+	TRB_KEY_U64,
+	TRB_KEY_I8,
+	TRB_KEY_I16,
+	TRB_KEY_I32,
+	TRB_KEY_I64,
+	TRB_KEY_F32,
+	TRB_KEY_F64,
+} TrbKeyType;
+
 /**
  * trb_strfmt:
  * @buf: The buffer where the formatted string is to be placed.
@@ -119,8 +147,11 @@ void trb_heapsort_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data);
  * @slice: The slice to be sorted.
  * @cmp_func: (scope call): The function for comparing elements.
  *
- * Sorts the slice using Quicksort by Knuth.
- * [Reference](http://math.utoledo.edu/~codenth/Fall_14/4380/Notes/trb_quicksort.pdf).
+ * Sorts the slice using Pattern-defeating Quicksort by Orson Peters.
+ * [Reference](https://arxiv.org/abs/2106.05123).
+ *
+ * Runs in O(n log n) in the worst case and in O(n) on sorted,
+ * reverse-sorted and all-equal inputs. The sort is not stable.
  **/
 void trb_quicksort(TrbSlice *slice, TrbCmpFunc cmp_func);
 
@@ -130,11 +161,341 @@ void trb_quicksort(TrbSlice *slice, TrbCmpFunc cmp_func);
  * @cmpd_func: (scope call): The function for comparing elements.
  * @data: User data.
  *
- * Sorts the slice using Quicksort by Knuth.
- * [Reference](http://math.utoledo.edu/~codenth/Fall_14/4380/Notes/trb_quicksort.pdf).
+ * Sorts the slice using Pattern-defeating Quicksort by Orson Peters and user data.
+ * [Reference](https://arxiv.org/abs/2106.05123).
+ *
+ * Runs in O(n log n) in the worst case and in O(n) on sorted,
+ * reverse-sorted and all-equal inputs. The sort is not stable.
  **/
 void trb_quicksort_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data);
 
+/**
+ * trb_nth_element:
+ * @slice: The slice to be rearranged.
+ * @nth: The index of the element to be put in its sorted position.
+ * @cmp_func: (scope call): The function for comparing elements.
+ *
+ * Rearranges the slice so that the element at @nth is the one that would be there
+ * if the slice was sorted. No element before @nth is greater than it and
+ * no element after @nth is less than it.
+ *
+ * Uses introselect: quickselect with pattern-defeating quicksort partitioning
+ * that falls back to heap selection. Runs in O(n) on average and O(n log n) in the worst case.
+ **/
+void trb_nth_element(TrbSlice *slice, usize nth, TrbCmpFunc cmp_func);
+
+/**
+ * trb_nth_element_data:
+ * @slice: The slice to be rearranged.
+ * @nth: The index of the element to be put in its sorted position.
+ * @cmpd_func: (scope call): The function for comparing elements.
+ * @data: User data.
+ *
+ * Rearranges the slice so that the element at @nth is the one that would be there
+ * if the slice was sorted, using user data. See trb_nth_element().
+ **/
+void trb_nth_element_data(TrbSlice *slice, usize nth, TrbCmpDataFunc cmpd_func, void *data);
+
+/**
+ * trb_partial_sort:
+ * @slice: The slice to be rearranged.
+ * @k: The number of elements to be sorted.
+ * @cmp_func: (scope call): The function for comparing elements.
+ *
+ * Puts the @k smallest elements of the slice in sorted order at its beginning.
+ * The order of the remaining elements is unspecified.
+ * If @k is not less than the length of the slice, sorts the whole slice.
+ *
+ * Runs in O(n + k log k) on average.
+ **/
+void trb_partial_sort(TrbSlice *slice, usize k, TrbCmpFunc cmp_func);
+
+/**
+ * trb_partial_sort_data:
+ * @slice: The slice to be rearranged.
+ * @k: The number of elements to be sorted.
+ * @cmpd_func: (scope call): The function for comparing elements.
+ * @data: User data.
+ *
+ * Puts the @k smallest elements of the slice in sorted order at its beginning
+ * using user data. See trb_partial_sort().
+ **/
+void trb_partial_sort_data(TrbSlice *slice, usize k, TrbCmpDataFunc cmpd_func, void *data);
+
+/**
+ * trb_topk:
+ * @slice: The slice where to select.
+ * @k: The number of elements to be selected.
+ * @cmp_func: (scope call): The function for comparing elements.
+ * @out: (out): The array of at least @k elements where to copy selected elements.
+ *
+ * Copies the @k smallest elements of the slice to @out in ascending order.
+ * The slice is not modified. Pass a reversed comparison function to select the largest elements.
+ *
+ * Keeps a bounded max-heap of @k elements. Runs in O(n log k) in the worst case
+ * and close to O(n) on random input, since most elements are rejected after one comparison.
+ *
+ * Returns: The number of elements copied, that is the minimum of @k and the length of the slice.
+ **/
+usize trb_topk(const TrbSlice *slice, usize k, TrbCmpFunc cmp_func, void *out);
+
+/**
+ * trb_topk_data:
+ * @slice: The slice where to select.
+ * @k: The number of elements to be selected.
+ * @cmpd_func: (scope call): The function for comparing elements.
+ * @data: User data.
+ * @out: (out): The array of at least @k elements where to copy selected elements.
+ *
+ * Copies the @k smallest elements of the slice to @out in ascending order
+ * using user data. See trb_topk().
+ *
+ * Returns: The number of elements copied, that is the minimum of @k and the length of the slice.
+ **/
+usize trb_topk_data(const TrbSlice *slice, usize k, TrbCmpDataFunc cmpd_func, void *data, void *out);
+
+/**
+ * trb_stablesort:
+ * @slice: The slice to be sorted.
+ * @cmp_func: (scope call): The function for comparing elements.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice) / 2` elements.
+ * If %NULL, the buffer is allocated and freed by the function.
+ *
+ * Sorts the slice using natural merge sort with galloping (Timsort).
+ * Equal elements keep their relative order.
+ *
+ * Runs in O(n log n) in the worst case and in O(n) on inputs
+ * that consist of a few ascending or descending runs.
+ *
+ * Returns: %TRUE on success, %FALSE if the buffer couldn't be allocated.
+ * The slice is left untouched on failure.
+ **/
+bool trb_stablesort(TrbSlice *slice, TrbCmpFunc cmp_func, void *buffer);
+
+/**
+ * trb_stablesort_data:
+ * @slice: The slice to be sorted.
+ * @cmpd_func: (scope call): The function for comparing elements.
+ * @data: User data.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice) / 2` elements.
+ * If %NULL, the buffer is allocated and freed by the function.
+ *
+ * Sorts the slice using natural merge sort with galloping (Timsort) and user data.
+ * Equal elements keep their relative order.
+ *
+ * Runs in O(n log n) in the worst case and in O(n) on inputs
+ * that consist of a few ascending or descending runs.
+ *
+ * Returns: %TRUE on success, %FALSE if the buffer couldn't be allocated.
+ * The slice is left untouched on failure.
+ **/
+bool trb_stablesort_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data, void *buffer);
+
+/**
+ * trb_quicksort_parallel:
+ * @slice: The slice to be sorted.
+ * @cmp_func: (scope call): The function for comparing elements. Must be safe to call from multiple threads.
+ * @n_threads: The maximum number of threads, the calling thread included.
+ * If 0, the number of online processors is used.
+ *
+ * Sorts the slice on several threads: chunks of the slice are sorted concurrently
+ * using pattern-defeating quicksort, then merged in rounds, with each merge split
+ * between the threads. Equal elements may be reordered.
+ *
+ * Falls back to trb_quicksort() if @n_threads is 1 or the slice is too short
+ * to be worth splitting. Otherwise allocates a buffer of `trb_slice_len(slice)` elements.
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ * The slice is left untouched on failure.
+ **/
+bool trb_quicksort_parallel(TrbSlice *slice, TrbCmpFunc cmp_func, usize n_threads);
+
+/**
+ * trb_quicksort_parallel_data:
+ * @slice: The slice to be sorted.
+ * @cmpd_func: (scope call): The function for comparing elements. Must be safe to call from multiple threads.
+ * @data: User data.
+ * @n_threads: The maximum number of threads, the calling thread included.
+ * If 0, the number of online processors is used.
+ *
+ * Sorts the slice on several threads using user data. See trb_quicksort_parallel().
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ * The slice is left untouched on failure.
+ **/
+bool trb_quicksort_parallel_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data, usize n_threads);
+
+/**
+ * trb_stablesort_parallel:
+ * @slice: The slice to be sorted.
+ * @cmp_func: (scope call): The function for comparing elements. Must be safe to call from multiple threads.
+ * @n_threads: The maximum number of threads, the calling thread included.
+ * If 0, the number of online processors is used.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice)` elements.
+ * If %NULL, the buffer is allocated and freed by the function.
+ *
+ * Sorts the slice on several threads: chunks of the slice are sorted concurrently
+ * using trb_stablesort(), then merged in rounds, with each merge split between the threads.
+ * Equal elements keep their relative order.
+ *
+ * Falls back to trb_stablesort() if @n_threads is 1 or the slice is too short
+ * to be worth splitting.
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ * The slice is left untouched on failure.
+ **/
+bool trb_stablesort_parallel(TrbSlice *slice, TrbCmpFunc cmp_func, usize n_threads, void *buffer);
+
+/**
+ * trb_stablesort_parallel_data:
+ * @slice: The slice to be sorted.
+ * @cmpd_func: (scope call): The function for comparing elements. Must be safe to call from multiple threads.
+ * @data: User data.
+ * @n_threads: The maximum number of threads, the calling thread included.
+ * If 0, the number of online processors is used.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice)` elements.
+ * If %NULL, the buffer is allocated and freed by the function.
+ *
+ * Sorts the slice on several threads using user data. See trb_stablesort_parallel().
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ * The slice is left untouched on failure.
+ **/
+bool trb_stablesort_parallel_data(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data, usize n_threads, void *buffer);
+
+/**
+ * trb_radixsort_by_key:
+ * @slice: The slice to be sorted.
+ * @key_type: The type of the key.
+ * @offset: The offset of the key within each element in bytes.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice)` elements.
+ * If %NULL, the buffer is allocated and freed by the function.
+ *
+ * Sorts the slice in ascending order of the key stored at @offset in each element
+ * using least significant digit radix sort. Equal keys keep their relative order.
+ *
+ * Signed keys are ordered numerically. Float keys are ordered by their bit pattern:
+ * -0.0 goes before +0.0, negative NaNs go first and positive NaNs go last.
+ *
+ * Runs in O(n * k), where k is the size of the key in bytes.
+ * Byte positions that are equal across all keys are skipped.
+ * Non-contiguous slices are gathered into a temporary array and need an extra allocation.
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ * The slice is left untouched on failure.
+ **/
+bool trb_radixsort_by_key(TrbSlice *slice, TrbKeyType key_type, usize offset, void *buffer);
+
+/**
+ * trb_radixsort_u8:
+ * @slice: The slice of #u8 to be sorted.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice)` elements.
+ *
+ * Sorts the slice of #u8 using radix sort. See trb_radixsort_by_key().
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ **/
+bool trb_radixsort_u8(TrbSlice *slice, void *buffer);
+
+/**
+ * trb_radixsort_u16:
+ * @slice: The slice of #u16 to be sorted.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice)` elements.
+ *
+ * Sorts the slice of #u16 using radix sort. See trb_radixsort_by_key().
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ **/
+bool trb_radixsort_u16(TrbSlice *slice, void *buffer);
+
+/**
+ * trb_radixsort_u32:
+ * @slice: The slice of #u32 to be sorted.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice)` elements.
+ *
+ * Sorts the slice of #u32 using radix sort. See trb_radixsort_by_key().
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ **/
+bool trb_radixsort_u32(TrbSlice *slice, void *buffer);
+
+/**
+ * trb_radixsort_u64:
+ * @slice: The slice of #u64 to be sorted.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice)` elements.
+ *
+ * Sorts the slice of #u64 using radix sort. See trb_radixsort_by_key().
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ **/
+bool trb_radixsort_u64(TrbSlice *slice, void *buffer);
+
+/**
+ * trb_radixsort_i8:
+ * @slice: The slice of #i8 to be sorted.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice)` elements.
+ *
+ * Sorts the slice of #i8 using radix sort. See trb_radixsort_by_key().
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ **/
+bool trb_radixsort_i8(TrbSlice *slice, void *buffer);
+
+/**
+ * trb_radixsort_i16:
+ * @slice: The slice of #i16 to be sorted.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice)` elements.
+ *
+ * Sorts the slice of #i16 using radix sort. See trb_radixsort_by_key().
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ **/
+bool trb_radixsort_i16(TrbSlice *slice, void *buffer);
+
+/**
+ * trb_radixsort_i32:
+ * @slice: The slice of #i32 to be sorted.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice)` elements.
+ *
+ * Sorts the slice of #i32 using radix sort. See trb_radixsort_by_key().
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ **/
+bool trb_radixsort_i32(TrbSlice *slice, void *buffer);
+
+/**
+ * trb_radixsort_i64:
+ * @slice: The slice of #i64 to be sorted.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice)` elements.
+ *
+ * Sorts the slice of #i64 using radix sort. See trb_radixsort_by_key().
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ **/
+bool trb_radixsort_i64(TrbSlice *slice, void *buffer);
+
+/**
+ * trb_radixsort_f32:
+ * @slice: The slice of #f32 to be sorted.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice)` elements.
+ *
+ * Sorts the slice of #f32 using radix sort. See trb_radixsort_by_key().
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ **/
+bool trb_radixsort_f32(TrbSlice *slice, void *buffer);
+
+/**
+ * trb_radixsort_f64:
+ * @slice: The slice of #f64 to be sorted.
+ * @buffer: (nullable): The scratch buffer of at least `trb_slice_len(slice)` elements.
+ *
+ * Sorts the slice of #f64 using radix sort. See trb_radixsort_by_key().
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurs.
+ **/
+bool trb_radixsort_f64(TrbSlice *slice, void *buffer);
+
 /**
  * trb_reverse:
  * @slice: The slice to be reversed.
@@ -151,6 +512,7 @@ void trb_reverse(TrbSlice *slice);
  * @index: (optional) (out): The pointer to retrieve the index of found value.
  *
  * Searches for the entry in the slice using binary search.
+ * If there are several equal entries, the index of the first one is retrieved.
  *
  * The slice should be sorted if you want to use this function.
  *
@@ -167,6 +529,7 @@ bool trb_binary_search(const TrbSlice *slice, const void *target, TrbCmpFunc cmp
  * @index: (optional) (out): The pointer to retrieve the index of found value.
  *
  * Searches for the entry in the slice using binary search and user data.
+ * If there are several equal entries, the index of the first one is retrieved.
  *
  * The slice should be sorted if you want to use this function.
  *
@@ -174,6 +537,91 @@ bool trb_binary_search(const TrbSlice *slice, const void *target, TrbCmpFunc cmp
  **/
 bool trb_binary_search_data(const TrbSlice *slice, const void *target, TrbCmpDataFunc cmpd_func, void *data, usize *index);
 
+/**
+ * trb_lower_bound:
+ * @slice: The sorted slice to be searched.
+ * @target: The pointer to the data to be found.
+ * @cmp_func: (scope call): The function for comparing elements.
+ *
+ * Finds the first element in the slice that is not less than @target
+ * using branchless binary search.
+ *
+ * Returns: The index of the element, or the length of the slice if there is no such element.
+ **/
+usize trb_lower_bound(const TrbSlice *slice, const void *target, TrbCmpFunc cmp_func);
+
+/**
+ * trb_lower_bound_data:
+ * @slice: The sorted slice to be searched.
+ * @target: The pointer to the data to be found.
+ * @cmpd_func: (scope call): The function for comparing elements.
+ * @data: User data.
+ *
+ * Finds the first element in the slice that is not less than @target
+ * using branchless binary search and user data.
+ *
+ * Returns: The index of the element, or the length of the slice if there is no such element.
+ **/
+usize trb_lower_bound_data(const TrbSlice *slice, const void *target, TrbCmpDataFunc cmpd_func, void *data);
+
+/**
+ * trb_upper_bound:
+ * @slice: The sorted slice to be searched.
+ * @target: The pointer to the data to be found.
+ * @cmp_func: (scope call): The function for comparing elements.
+ *
+ * Finds the first element in the slice that is greater than @target
+ * using branchless binary search.
+ *
+ * Returns: The index of the element, or the length of the slice if there is no such element.
+ **/
+usize trb_upper_bound(const TrbSlice *slice, const void *target, TrbCmpFunc cmp_func);
+
+/**
+ * trb_upper_bound_data:
+ * @slice: The sorted slice to be searched.
+ * @target: The pointer to the data to be found.
+ * @cmpd_func: (scope call): The function for comparing elements.
+ * @data: User data.
+ *
+ * Finds the first element in the slice that is greater than @target
+ * using branchless binary search and user data.
+ *
+ * Returns: The index of the element, or the length of the slice if there is no such element.
+ **/
+usize trb_upper_bound_data(const TrbSlice *slice, const void *target, TrbCmpDataFunc cmpd_func, void *data);
+
+/**
+ * trb_equal_range:
+ * @slice: The sorted slice to be searched.
+ * @target: The pointer to the data to be found.
+ * @cmp_func: (scope call): The function for comparing elements.
+ * @start: (optional) (out): The pointer to retrieve the index of the first equal element.
+ * @end: (optional) (out): The pointer to retrieve the index after the last equal element.
+ *
+ * Finds the range of elements equal to @target.
+ * If there are no such elements, the range is empty and starts at the lower bound.
+ *
+ * Returns: %TRUE if the range is not empty.
+ **/
+bool trb_equal_range(const TrbSlice *slice, const void *target, TrbCmpFunc cmp_func, usize *start, usize *end);
+
+/**
+ * trb_equal_range_data:
+ * @slice: The sorted slice to be searched.
+ * @target: The pointer to the data to be found.
+ * @cmpd_func: (scope call): The function for comparing elements.
+ * @data: User data.
+ * @start: (optional) (out): The pointer to retrieve the index of the first equal element.
+ * @end: (optional) (out): The pointer to retrieve the index after the last equal element.
+ *
+ * Finds the range of elements equal to @target using user data.
+ * If there are no such elements, the range is empty and starts at the lower bound.
+ *
+ * Returns: %TRUE if the range is not empty.
+ **/
+bool trb_equal_range_data(const TrbSlice *slice, const void *target, TrbCmpDataFunc cmpd_func, void *data, usize *start, usize *end);
+
 /**
  * trb_u8cmp:
  * @a: The first value to be compared.
@@ -0,0 +1,165 @@
+#ifndef VECTOR_DEFINE_H_7PLX2QCM
+#define VECTOR_DEFINE_H_7PLX2QCM
+
+#include "trb-checked.h"
+#include "trb-messages.h"
+#include "trb-types.h"
+#include "trb-vector.h"
+
+/**
+ * TRB_VECTOR_DEFINE:
+ * @TypeName: The name of the vector type to be defined.
+ * @prefix: The prefix of the functions to be defined.
+ * @type: The element type.
+ *
+ * Defines a vector type for the elements of @type and inline functions to work with it.
+ *
+ * The type is a union of #TrbVector and a typed view of its buffer,
+ * so the `vector` member can be passed to any trb_vector_*() function.
+ * Pushing and accessing elements doesn't call into the library
+ * unless the buffer has to grow.
+ *
+ * The following functions are defined:
+ * - `TypeName *prefix_init(TypeName *self, bool clear)`: creates a new vector, see trb_vector_init().
+ * - `TypeName *prefix_cast(TrbVector *vector)`: views a #TrbVector with elements of @type as @TypeName.
+ * - `bool prefix_push(TypeName *self, type value)`: adds @value to the end of the vector.
+ * - `bool prefix_push_many(TypeName *self, const type *values, usize n)`: adds @n values to the end of the vector.
+ * - `bool prefix_pop(TypeName *self, type *ret)`: removes the last element.
+ * - `type *prefix_at(TypeName *self, usize index)`: returns the pointer to the element at @index.
+ * - `type prefix_get(const TypeName *self, usize index)`: returns the element at @index.
+ * - `void prefix_set(TypeName *self, usize index, type value)`: sets the element at @index.
+ * - `bool prefix_reserve(TypeName *self, usize n)`: makes room for @n elements in total.
+ * - `void prefix_clear(TypeName *self)`: removes all elements and keeps the buffer.
+ * - `void prefix_destroy(TypeName *self)` and `void prefix_free(TypeName *self)`.
+ *
+ * Accessors don't check bounds, just like trb_vector_ptr().
+ * `prefix_set()` detaches a buffer shared by trb_vector_copy_cow(),
+ * but the buffer must be detached with trb_vector_unshare() before writing through `prefix_at()`.
+ *
+ * This example shows how to define and use a vector of #u32:
+ * ```c
+ * TRB_VECTOR_DEFINE(U32Vector, u32_vector, u32)
+ *
+ * U32Vector vec;
+ * u32_vector_init(&vec, FALSE);
+ *
+ * for (u32 i = 0; i < 100; ++i)
+ *     u32_vector_push(&vec, i);
+ *
+ * trb_vector_pop_front(&vec.vector, NULL);
+ * printf("%u\n", u32_vector_get(&vec, 0));
+ *
+ * u32_vector_destroy(&vec);
+ * ```
+ **/
+#define TRB_VECTOR_DEFINE(TypeName, prefix, type)                                       \
+	typedef union {                                                                     \
+		TrbVector vector;                                                               \
+		struct {                                                                        \
+			type *data;                                                                 \
+			usize len;                                                                  \
+			usize offset;                                                               \
+			usize capacity;                                                             \
+		};                                                                              \
+	} TypeName;                                                                         \
+                                                                                        \
+	static inline TypeName *prefix##_init(TypeName *self, bool clear)                   \
+	{                                                                                   \
+		return (TypeName *) trb_vector_init((TrbVector *) self, clear, sizeof(type));   \
+	}                                                                                   \
+                                                                                        \
+	static inline TypeName *prefix##_cast(TrbVector *vector)                            \
+	{                                                                                   \
+		trb_return_val_if_fail(vector != NULL, NULL);                                   \
+		trb_return_val_if_fail(vector->elemsize == sizeof(type), NULL);                 \
+		return (TypeName *) vector;                                                     \
+	}                                                                                   \
+                                                                                        \
+	static inline bool prefix##_push(TypeName *self, type value)                        \
+	{                                                                                   \
+		trb_return_val_if_fail(self != NULL, FALSE);                                    \
+                                                                                        \
+		usize end = self->offset + self->len;                                           \
+                                                                                        \
+		if (__builtin_expect(end < self->capacity && self->vector.refs == NULL, 1)) {   \
+			self->data[end] = value;                                                    \
+			self->len++;                                                                \
+			return TRUE;                                                                \
+		}                                                                               \
+                                                                                        \
+		return trb_vector_push_back(&self->vector, &value);                             \
+	}                                                                                   \
+                                                                                        \
+	static inline bool prefix##_push_many(TypeName *self, const type *values, usize n)  \
+	{                                                                                   \
+		return trb_vector_push_back_many((TrbVector *) self, values, n);                \
+	}                                                                                   \
+                                                                                        \
+	static inline bool prefix##_pop(TypeName *self, type *ret)                          \
+	{                                                                                   \
+		trb_return_val_if_fail(self != NULL, FALSE);                                    \
+                                                                                        \
+		if (self->len == 0)                                                             \
+			return trb_vector_pop_back(&self->vector, ret);                             \
+                                                                                        \
+		self->len--;                                                                    \
+                                                                                        \
+		if (ret != NULL)                                                                \
+			*ret = self->data[self->offset + self->len];                                \
+                                                                                        \
+		return TRUE;                                                                    \
+	}                                                                                   \
+                                                                                        \
+	static inline type *prefix##_at(TypeName *self, usize index)                        \
+	{                                                                                   \
+		return &self->data[self->offset + index];                                       \
+	}                                                                                   \
+                                                                                        \
+	static inline type prefix##_get(const TypeName *self, usize index)                  \
+	{                                                                                   \
+		return self->data[self->offset + index];                                        \
+	}                                                                                   \
+                                                                                        \
+	static inline void prefix##_set(TypeName *self, usize index, type value)            \
+	{                                                                                   \
+		if (self->vector.refs != NULL && !trb_vector_unshare(&self->vector))            \
+			return;                                                                     \
+                                                                                        \
+		self->data[self->offset + index] = value;                                       \
+	}                                                                                   \
+                                                                                        \
+	static inline bool prefix##_reserve(TypeName *self, usize n)                        \
+	{                                                                                   \
+		trb_return_val_if_fail(self != NULL, FALSE);                                    \
+                                                                                        \
+		usize newcap;                                                                   \
+                                                                                        \
+		if (trb_chk_add(self->offset, n, &newcap)) {                                    \
+			trb_msg_error("vector capacity overflow!");                                 \
+			return FALSE;                                                               \
+		}                                                                               \
+                                                                                        \
+		if (newcap <= self->capacity)                                                   \
+			return TRUE;                                                                \
+                                                                                        \
+		return trb_vector_require(&self->vector, newcap);                               \
+	}                                                                                   \
+                                                                                        \
+	static inline void prefix##_clear(TypeName *self)                                   \
+	{                                                                                   \
+		trb_return_if_fail(self != NULL);                                               \
+		self->len = 0;                                                                  \
+		self->offset = 0;                                                               \
+	}                                                                                   \
+                                                                                        \
+	static inline void prefix##_destroy(TypeName *self)                                 \
+	{                                                                                   \
+		trb_vector_destroy((TrbVector *) self, NULL);                                   \
+	}                                                                                   \
+                                                                                        \
+	static inline void prefix##_free(TypeName *self)                                    \
+	{                                                                                   \
+		trb_vector_free((TrbVector *) self, NULL);                                      \
+	}
+
+#endif /* end of include guard: VECTOR_DEFINE_H_7PLX2QCM */
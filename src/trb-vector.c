@@ -1,7 +1,10 @@
 #include "trb-vector.h"
 
 #include "trb-checked.h"
+#include "trb-math.h"
 #include "trb-messages.h"
+#include "trb-pages.h"
+#include "trb-prim.h"
 #include "trb-types.h"
 #include "trb-utils.h"
 
@@ -53,15 +56,111 @@ TrbVector *trb_vector_init(TrbVector *self, bool clear, usize elemsize)
 	self->capacity = VECTOR_INIT_CAP;
 	self->elemsize = elemsize;
 	self->clear = clear;
+	self->growth = TRB_GROWTH_1_5X;
+	self->growth_func = NULL;
+	self->map_threshold = 0;
+	self->map_hugepages = FALSE;
+	self->mapped = FALSE;
+	self->refs = NULL;
 
 	return self;
 }
 
-static bool __trb_vector_newcap(TrbVector *self, usize newcap)
+void trb_vector_set_growth(TrbVector *self, TrbGrowth growth, TrbGrowthFunc growth_func)
+{
+	trb_return_if_fail(self != NULL);
+	trb_return_if_fail(growth != TRB_GROWTH_CUSTOM || growth_func != NULL);
+
+	self->growth = growth;
+	self->growth_func = growth_func;
+}
+
+void trb_vector_set_mmap(TrbVector *self, usize threshold, bool hugepages)
+{
+	trb_return_if_fail(self != NULL);
+
+	self->map_threshold = threshold;
+	self->map_hugepages = hugepages;
+}
+
+/* Drops a reference to the buffer. Returns TRUE if it was the last one */
+static bool __trb_vector_unref(TrbVector *self)
+{
+	if (self->refs == NULL)
+		return TRUE;
+
+	if (__atomic_sub_fetch(self->refs, 1, __ATOMIC_ACQ_REL) != 0)
+		return FALSE;
+
+	free(self->refs);
+	self->refs = NULL;
+
+	return TRUE;
+}
+
+/* A buffer which other vectors have released is taken back without copying */
+static bool __trb_vector_is_shared(TrbVector *self)
 {
-	usize new_allocated = (newcap >> 3) + (newcap < 9 ? 3 : 6);
+	if (self->refs == NULL)
+		return FALSE;
+
+	if (__atomic_load_n(self->refs, __ATOMIC_ACQUIRE) != 1)
+		return TRUE;
+
+	free(self->refs);
+	self->refs = NULL;
+
+	return FALSE;
+}
+
+/* Moves the vector to a private buffer of the given capacity */
+static bool __trb_vector_detach(TrbVector *self, usize newcap)
+{
+	bool mapped = FALSE;
+	usize elemsize = self->elemsize;
+	usize end = self->offset + self->len;
+
+	char *data = trb_pages_realloc(
+		NULL, 0, newcap * elemsize,
+		self->map_threshold, self->map_hugepages, &mapped
+	);
+
+	if (data == NULL) {
+		trb_msg_error("couldn't allocate memory for a private buffer of the vector!");
+		return FALSE;
+	}
+
+	if (self->clear && !mapped) {
+		memset(data, 0, self->offset * elemsize);
+		memset(&data[end * elemsize], 0, (newcap - end) * elemsize);
+	}
+
+	memcpy(&data[self->offset * elemsize], trb_vector_cell(self, self->offset), self->len * elemsize);
+
+	if (__trb_vector_unref(self))
+		trb_pages_free(self->data, self->capacity * elemsize, self->mapped);
+
+	self->data = data;
+	self->capacity = newcap;
+	self->mapped = mapped;
+	self->refs = NULL;
+
+	return TRUE;
+}
+
+bool trb_vector_unshare(TrbVector *self)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
 
-	if (trb_chk_add(newcap, new_allocated, &newcap)) {
+	if (!__trb_vector_is_shared(self))
+		return TRUE;
+
+	return __trb_vector_detach(self, self->capacity);
+}
+
+static bool __trb_vector_newcap(TrbVector *self, usize newcap)
+{
+	if (!trb_growth_capacity(self->growth, self->growth_func, self->capacity, newcap, &newcap)) {
 		trb_msg_error("vector capacity overflow!");
 		return FALSE;
 	}
@@ -71,7 +170,14 @@ static bool __trb_vector_newcap(TrbVector *self, usize newcap)
 		return FALSE;
 	}
 
-	void *data = realloc(self->data, newcap * self->elemsize);
+	/* A shared buffer is copied straight into the grown one */
+	if (__trb_vector_is_shared(self))
+		return __trb_vector_detach(self, newcap);
+
+	void *data = trb_pages_realloc(
+		self->data, self->capacity * self->elemsize, newcap * self->elemsize,
+		self->map_threshold, self->map_hugepages, &self->mapped
+	);
 
 	if (data == NULL) {
 		trb_msg_error("couldn't reallocate memory for the vector buffer!");
@@ -80,7 +186,7 @@ static bool __trb_vector_newcap(TrbVector *self, usize newcap)
 
 	self->data = data;
 
-	if (self->clear) {
+	if (self->clear && !self->mapped) {
 		memset(
 			trb_vector_cell(self, self->capacity), 0,
 			(newcap - self->capacity) * self->elemsize
@@ -92,11 +198,8 @@ static bool __trb_vector_newcap(TrbVector *self, usize newcap)
 	return TRUE;
 }
 
-static bool __trb_vector_insert_many(TrbVector *self, usize index, const void *data, usize len)
+static bool __trb_vector_make_room(TrbVector *self, usize index, usize len)
 {
-	if (len == 0)
-		return TRUE;
-
 	if (
 		trb_chk_add(index, len, NULL) ||
 		trb_chk_add(index + len, self->offset, NULL) ||
@@ -115,6 +218,9 @@ static bool __trb_vector_insert_many(TrbVector *self, usize index, const void *d
 			return FALSE;
 	}
 
+	if (!trb_vector_unshare(self))
+		return FALSE;
+
 	if (self->offset >= self->len / 2) {
 		memmove(
 			trb_vector_cell(self, 0),
@@ -149,6 +255,17 @@ static bool __trb_vector_insert_many(TrbVector *self, usize index, const void *d
 
 	self->len += len;
 
+	return TRUE;
+}
+
+static bool __trb_vector_insert_many(TrbVector *self, usize index, const void *data, usize len)
+{
+	if (len == 0)
+		return TRUE;
+
+	if (!__trb_vector_make_room(self, index, len))
+		return FALSE;
+
 	if (data == NULL)
 		memset(trb_vector_cell(self, self->offset + index), 0, len * self->elemsize);
 	else
@@ -169,6 +286,30 @@ bool trb_vector_push_back_many(TrbVector *self, const void *data, usize len)
 	return __trb_vector_insert_many(self, self->len, data, len);
 }
 
+void *trb_vector_emplace_back(TrbVector *self, usize len)
+{
+	trb_return_val_if_fail(self != NULL, NULL);
+	trb_return_val_if_fail(len != 0, NULL);
+
+	usize index = self->len;
+
+	if (!__trb_vector_make_room(self, index, len))
+		return NULL;
+
+	return trb_vector_cell(self, self->offset + index);
+}
+
+void *trb_vector_emplace_at(TrbVector *self, usize index, usize len)
+{
+	trb_return_val_if_fail(self != NULL, NULL);
+	trb_return_val_if_fail(len != 0, NULL);
+
+	if (!__trb_vector_make_room(self, index, len))
+		return NULL;
+
+	return trb_vector_cell(self, self->offset + index);
+}
+
 bool trb_vector_push_front(TrbVector *self, const void *data)
 {
 	trb_return_val_if_fail(self != NULL, FALSE);
@@ -219,6 +360,9 @@ static bool __trb_vector_remove_range(TrbVector *self, usize index, usize len, v
 	if (index == 0) {
 		self->offset += len;
 	} else if (index + len != self->len) {
+		if (!trb_vector_unshare(self))
+			return FALSE;
+
 		memmove(
 			trb_vector_cell(self, self->offset + index),
 			trb_vector_cell(self, self->offset + index + len),
@@ -315,6 +459,32 @@ bool trb_vector_remove_range(TrbVector *self, usize index, usize len, void *ret)
 	return __trb_vector_remove_range(self, index, len, ret);
 }
 
+/* Stolen buffers are released with free(), so mapped ones are copied to the heap */
+static void *__trb_vector_steal_buffer(TrbVector *self)
+{
+	if (!trb_vector_unshare(self))
+		return NULL;
+
+	if (!self->mapped)
+		return self->data;
+
+	usize size = trb_max(self->offset + self->len, 1) * self->elemsize;
+	void *ret = malloc(size);
+
+	if (ret == NULL) {
+		trb_msg_error("couldn't allocate memory for the stolen vector buffer!");
+		return NULL;
+	}
+
+	memcpy(ret, self->data, size);
+	trb_pages_free(self->data, self->capacity * self->elemsize, TRUE);
+
+	self->data = NULL;
+	self->mapped = FALSE;
+
+	return ret;
+}
+
 void *trb_vector_steal(TrbVector *self, usize *len, usize *offset)
 {
 	trb_return_val_if_fail(self != NULL, FALSE);
@@ -324,7 +494,10 @@ void *trb_vector_steal(TrbVector *self, usize *len, usize *offset)
 		return NULL;
 	}
 
-	void *ret = self->data;
+	void *ret = __trb_vector_steal_buffer(self);
+
+	if (ret == NULL)
+		return NULL;
 
 	if (len != NULL)
 		*len = self->len;
@@ -356,18 +529,22 @@ void trb_vector_destroy(TrbVector *self, TrbFreeFunc free_func)
 	if (self->data == NULL)
 		return;
 
-	if (free_func != NULL) {
-		for (usize i = 0; i < self->len; ++i) {
-			free_func(trb_vector_cell(self, i));
+	if (__trb_vector_unref(self)) {
+		if (free_func != NULL) {
+			for (usize i = 0; i < self->len; ++i) {
+				free_func(trb_vector_cell(self, i));
+			}
 		}
-	}
 
-	free(self->data);
+		trb_pages_free(self->data, self->capacity * self->elemsize, self->mapped);
+	}
 
 	self->data = NULL;
 	self->capacity = 0;
 	self->len = 0;
 	self->offset = 0;
+	self->mapped = FALSE;
+	self->refs = NULL;
 }
 
 void *trb_vector_steal0(TrbVector *self, usize *len, usize *offset)
@@ -379,7 +556,10 @@ void *trb_vector_steal0(TrbVector *self, usize *len, usize *offset)
 		return NULL;
 	}
 
-	void *ret = self->data;
+	void *ret = __trb_vector_steal_buffer(self);
+
+	if (ret == NULL)
+		return NULL;
 
 	if (len != NULL)
 		*len = self->len;
@@ -402,6 +582,104 @@ void trb_vector_free(TrbVector *self, TrbFreeFunc free_func)
 	free(self);
 }
 
+/* Copies every element and advances the write position only past the retained ones */
+#define VECTOR_COMPACT(data, len, size, pred, userdata, kept) \
+	for (usize __i = 0; __i < (len); ++__i) {                   \
+		char __tmp[size];                                        \
+		const char *__src = &(data)[__i * (size)];               \
+		bool __keep = (pred)(__src, (userdata));                 \
+		memcpy(__tmp, __src, (size));                            \
+		memcpy(&(data)[(kept) * (size)], __tmp, (size));         \
+		(kept) += __keep;                                        \
+	}
+
+usize trb_vector_retain(TrbVector *self, TrbPredFunc pred, void *userdata)
+{
+	trb_return_val_if_fail(self != NULL, 0);
+	trb_return_val_if_fail(pred != NULL, 0);
+
+	if (self->len == 0)
+		return 0;
+
+	if (!trb_vector_unshare(self))
+		return 0;
+
+	char *data = trb_vector_cell(self, self->offset);
+	usize elemsize = self->elemsize;
+	usize len = self->len;
+	usize kept = 0;
+
+	switch (elemsize) {
+	case 1:
+		VECTOR_COMPACT(data, len, 1, pred, userdata, kept);
+		break;
+	case 2:
+		VECTOR_COMPACT(data, len, 2, pred, userdata, kept);
+		break;
+	case 4:
+		VECTOR_COMPACT(data, len, 4, pred, userdata, kept);
+		break;
+	case 8:
+		VECTOR_COMPACT(data, len, 8, pred, userdata, kept);
+		break;
+	case 16:
+		VECTOR_COMPACT(data, len, 16, pred, userdata, kept);
+		break;
+	default:
+		/* Larger elements are moved run by run */
+		for (usize i = 0, run = 0; i <= len; ++i) {
+			if (i < len && pred(&data[i * elemsize], userdata))
+				continue;
+
+			if (run != kept)
+				memmove(&data[kept * elemsize], &data[run * elemsize], (i - run) * elemsize);
+
+			kept += i - run;
+			run = i + 1;
+		}
+		break;
+	}
+
+	self->len = kept;
+
+	return len - kept;
+}
+
+#undef VECTOR_COMPACT
+
+usize trb_vector_dedup_sorted(TrbVector *self, TrbCmpFunc cmp_func)
+{
+	trb_return_val_if_fail(self != NULL, 0);
+	trb_return_val_if_fail(cmp_func != NULL, 0);
+
+	if (self->len <= 1)
+		return 0;
+
+	if (!trb_vector_unshare(self))
+		return 0;
+
+	char *data = trb_vector_cell(self, self->offset);
+	usize elemsize = self->elemsize;
+	usize len = self->len;
+	usize kept = 1;
+
+	for (usize i = 1; i < len; ++i) {
+		char *src = &data[i * elemsize];
+
+		if (cmp_func(&data[(kept - 1) * elemsize], src) == 0)
+			continue;
+
+		if (kept != i)
+			memcpy(&data[kept * elemsize], src, elemsize);
+
+		kept++;
+	}
+
+	self->len = kept;
+
+	return len - kept;
+}
+
 bool trb_vector_search(const TrbVector *self, const void *target, TrbCmpFunc cmp_func, usize *index)
 {
 	trb_return_val_if_fail(self != NULL, FALSE);
@@ -440,6 +718,20 @@ bool trb_vector_search_data(const TrbVector *self, const void *target, TrbCmpDat
 	return FALSE;
 }
 
+bool trb_vector_find_bytes(const TrbVector *self, const void *target, usize *index)
+{
+	trb_return_val_if_fail(self != NULL, FALSE);
+	trb_return_val_if_fail(target != NULL, FALSE);
+
+	if (self->len == 0)
+		return FALSE;
+
+	TrbSlice slice;
+	trb_slice_init(&slice, self->data, self->elemsize, self->offset, self->offset + self->len);
+
+	return trb_find_bytes(&slice, target, index);
+}
+
 static void *__trb_vector_slice_at(const TrbSlice *self, usize index)
 {
 	TrbVector *vector = self->data;
@@ -451,7 +743,7 @@ static void *__trb_vector_slice_at(const TrbSlice *self, usize index)
 	return trb_vector_cell(vector, vector->offset + self->start + index);
 }
 
-TrbSlice *trb_vector_slice(TrbVector *self, TrbSlice *slice, usize start, usize end)
+TrbSlice *trb_vector_slice_const(const TrbVector *self, TrbSlice *slice, usize start, usize end)
 {
 	trb_return_val_if_fail(self != NULL, NULL);
 	trb_return_val_if_fail(start <= end, NULL);
@@ -471,14 +763,25 @@ TrbSlice *trb_vector_slice(TrbVector *self, TrbSlice *slice, usize start, usize
 	}
 
 	slice->at = __trb_vector_slice_at;
-	slice->data = self;
+	slice->data = (TrbVector *) self;
 	slice->start = start;
 	slice->end = end;
 	slice->elemsize = self->elemsize;
+	slice->contiguous = TRUE;
 
 	return slice;
 }
 
+TrbSlice *trb_vector_slice(TrbVector *self, TrbSlice *slice, usize start, usize end)
+{
+	trb_return_val_if_fail(self != NULL, NULL);
+
+	if (!trb_vector_unshare(self))
+		return NULL;
+
+	return trb_vector_slice_const(self, slice, start, end);
+}
+
 TrbVector *trb_vector_copy(const TrbVector *src, TrbVector *dst)
 {
 	trb_return_val_if_fail(src != NULL, NULL);
@@ -519,12 +822,61 @@ TrbVector *trb_vector_copy(const TrbVector *src, TrbVector *dst)
 	dst->offset = src->offset;
 	dst->capacity = src->capacity;
 	dst->clear = src->clear;
+	dst->growth = src->growth;
+	dst->growth_func = src->growth_func;
+	dst->map_threshold = src->map_threshold;
+	dst->map_hugepages = src->map_hugepages;
+	dst->mapped = FALSE;
+	dst->refs = NULL;
 
 	memcpy(dst->data, src->data, dst->len * dst->elemsize);
 
 	return dst;
 }
 
+TrbVector *trb_vector_copy_cow(TrbVector *src, TrbVector *dst)
+{
+	trb_return_val_if_fail(src != NULL, NULL);
+
+	if (src->data == NULL) {
+		trb_msg_warn("source vector buffer is NULL!");
+		return NULL;
+	}
+
+	bool was_allocated = FALSE;
+
+	if (dst == NULL) {
+		dst = trb_talloc(TrbVector, 1);
+
+		if (dst == NULL) {
+			trb_msg_error("couldn't allocate memory for a copy of the vector!");
+			return NULL;
+		}
+
+		was_allocated = TRUE;
+	}
+
+	if (src->refs == NULL) {
+		src->refs = trb_talloc(usize, 1);
+
+		if (src->refs == NULL) {
+			if (was_allocated)
+				free(dst);
+
+			trb_msg_error("couldn't allocate memory for the reference count of the vector buffer!");
+			return NULL;
+		}
+
+		*src->refs = 1;
+	}
+
+	__atomic_add_fetch(src->refs, 1, __ATOMIC_RELAXED);
+
+	*dst = *src;
+
+	return dst;
+}
+
 bool trb_vector_require(TrbVector *self, usize newcap)
 {
 	trb_return_val_if_fail(self != NULL, FALSE);
@@ -545,6 +897,9 @@ bool trb_vector_shrink(TrbVector *self)
 		mincap = VECTOR_INIT_CAP;
 	}
 
+	if (!trb_vector_unshare(self))
+		return FALSE;
+
 	if (self->offset != 0) {
 		memmove(
 			trb_vector_cell(self, 0),
@@ -555,7 +910,10 @@ bool trb_vector_shrink(TrbVector *self)
 		self->offset = 0;
 	}
 
-	void *data = realloc(self->data, mincap * self->elemsize);
+	void *data = trb_pages_realloc(
+		self->data, self->capacity * self->elemsize, mincap * self->elemsize,
+		0, FALSE, &self->mapped
+	);
 
 	if (data == NULL) {
 		trb_msg_error("couldn't shrink memory of the vector buffer!");
@@ -1,6 +1,7 @@
 #ifndef VECTOR_H_KSABYJ3T
 #define VECTOR_H_KSABYJ3T
 
+#include "trb-growth.h"
 #include "trb-slice.h"
 #include "trb-types.h"
 
@@ -14,6 +15,12 @@ typedef struct _TrbVector TrbVector;
  * @capacity: The capacity of the vector buffer.
  * @elemsize: The size of each element.
  * @clear: Indicates whether elements should be cleared to 0 when allocated or not.
+ * @growth: The policy for growing the capacity of the vector buffer.
+ * @growth_func: The growth function used if @growth is %TRB_GROWTH_CUSTOM.
+ * @map_threshold: The buffer size in bytes starting from which the buffer is mapped. Zero disables mapping.
+ * @map_hugepages: Indicates whether the mapped buffer should be backed by huge pages or not.
+ * @mapped: Indicates whether the buffer is mapped or not.
+ * @refs: The reference count of the buffer shared by trb_vector_copy_cow(). %NULL if the buffer isn't shared.
  *
  * A dynamic size array.
  **/
@@ -24,6 +31,12 @@ struct _TrbVector {
 	usize capacity;
 	usize elemsize;
 	bool clear;
+	TrbGrowth growth;
+	TrbGrowthFunc growth_func;
+	usize map_threshold;
+	bool map_hugepages;
+	bool mapped;
+	usize *refs;
 };
 
 /**
@@ -51,6 +64,67 @@ TrbVector *trb_vector_init(TrbVector *self, bool clear, usize elemsize);
  **/
 TrbVector *trb_vector_copy(const TrbVector *src, TrbVector *dst);
 
+/**
+ * trb_vector_copy_cow:
+ * @src: The vector to be copied.
+ * @dst: (optional) (inout): The pointer to the destination array.
+ *
+ * Creates a copy of the vector that shares the buffer with @src.
+ * The copy takes O(1) time, and the first modification of either vector
+ * detaches it by copying the buffer. See trb_vector_unshare().
+ *
+ * The buffer is reference counted with atomic operations, so the copies
+ * can be handed to other threads as read-only snapshots.
+ * Each #TrbVector itself must still be used by one thread at a time.
+ *
+ * The vector of #TrbHeap and the entries of #TrbFlatMap detach the buffer as well.
+ * The vectors of #TrbDeque and #TrbIndexedHeap are written in place and must not be copied with it.
+ *
+ * Returns: (nullable): A copy of the vector.
+ * Can return %NULL if an allocation error occurs.
+ **/
+TrbVector *trb_vector_copy_cow(TrbVector *src, TrbVector *dst);
+
+/**
+ * trb_vector_unshare:
+ * @self: The vector which buffer is to be detached.
+ *
+ * Makes the vector the only owner of its buffer, copying the buffer
+ * if it is shared with other vectors created by trb_vector_copy_cow().
+ *
+ * The vector functions and trb_vector_slice() call it before the buffer can be modified.
+ * Call it yourself before writing to the elements through trb_vector_ptr().
+ *
+ * Returns: %TRUE on success.
+ **/
+bool trb_vector_unshare(TrbVector *self);
+
+/**
+ * trb_vector_set_growth:
+ * @self: The vector which growth policy is to be set.
+ * @growth: The growth policy.
+ * @growth_func: (nullable): The growth function. Must not be %NULL if @growth is %TRB_GROWTH_CUSTOM.
+ *
+ * Sets the policy for growing the capacity of the vector buffer.
+ * The default policy is %TRB_GROWTH_1_5X.
+ **/
+void trb_vector_set_growth(TrbVector *self, TrbGrowth growth, TrbGrowthFunc growth_func);
+
+/**
+ * trb_vector_set_mmap:
+ * @self: The vector which allocation strategy is to be set.
+ * @threshold: The buffer size in bytes starting from which the buffer is mapped. Zero disables mapping.
+ * @hugepages: %TRUE if the mapped buffer should be backed by transparent huge pages.
+ *
+ * Makes the vector move its buffer to an anonymous mapping once the buffer
+ * reaches @threshold bytes. The mapped buffer grows with `mremap()`,
+ * so the data isn't copied and the memory use doesn't double while growing.
+ * See trb_pages_realloc().
+ *
+ * Mapping is disabled by default.
+ **/
+void trb_vector_set_mmap(TrbVector *self, usize threshold, bool hugepages);
+
 /**
  * trb_vector_push_back:
  * @self: The vector where to add the element.
@@ -76,6 +150,36 @@ bool trb_vector_push_back(TrbVector *self, const void *data);
  **/
 bool trb_vector_push_back_many(TrbVector *self, const void *data, usize len);
 
+/**
+ * trb_vector_emplace_back:
+ * @self: The vector where to add the elements.
+ * @len: The number of elements to be added.
+ *
+ * Adds @len uninitialized elements to the end of the vector
+ * and returns the pointer to them, so they can be written in place
+ * instead of being copied from elsewhere.
+ *
+ * The pointer is valid until the vector is modified.
+ *
+ * Returns: (nullable): The pointer to the first added element.
+ * Can return %NULL if an error occurs.
+ **/
+void *trb_vector_emplace_back(TrbVector *self, usize len);
+
+/**
+ * trb_vector_emplace_at:
+ * @self: The vector where to insert the elements.
+ * @index: The position to place the elements at.
+ * @len: The number of elements to be inserted.
+ *
+ * Inserts @len uninitialized elements into the vector at the given index
+ * and returns the pointer to them. See trb_vector_emplace_back().
+ *
+ * Returns: (nullable): The pointer to the first inserted element.
+ * Can return %NULL if an error occurs.
+ **/
+void *trb_vector_emplace_at(TrbVector *self, usize index, usize len);
+
 /**
  * trb_vector_push_front:
  * @self: The vector where to add the element.
@@ -218,6 +322,7 @@ bool trb_vector_remove_all(TrbVector *self, void *ret);
  *
  * Steals the vector buffer.
  * Array creates a new buffer.
+ * A mapped buffer is copied to the heap first, so the result can be released with `free()`.
  *
  * Returns: (transfer full) (nullable): The buffer on success.
  * Can return %NULL on failure.
@@ -232,6 +337,7 @@ void *trb_vector_steal(TrbVector *self, usize *len, usize *offset);
  *
  * Steals the vector buffer.
  * Array's buffer becomes %NULL.
+ * A mapped buffer is copied to the heap first, so the result can be released with `free()`.
  *
  * Returns: (transfer full) (nullable): The buffer on success.
  * Can return %NULL on failure.
@@ -265,6 +371,8 @@ bool trb_vector_shrink(TrbVector *self);
  * @free_func: (scope call) (nullable): The function for freeing elements.
  *
  * Frees the vector buffer.
+ * A buffer shared by trb_vector_copy_cow() and its elements are freed
+ * only when the last vector that holds it is destroyed.
  **/
 void trb_vector_destroy(TrbVector *self, TrbFreeFunc free_func);
 
@@ -277,6 +385,35 @@ void trb_vector_destroy(TrbVector *self, TrbFreeFunc free_func);
  **/
 void trb_vector_free(TrbVector *self, TrbFreeFunc free_func);
 
+/**
+ * trb_vector_retain:
+ * @self: The vector to be filtered.
+ * @pred: (scope call): The predicate for the elements to be kept.
+ * @userdata: User data.
+ *
+ * Removes all elements for which @pred returns %FALSE, keeping the order of the others.
+ * Unlike removing elements one by one, moves each element at most once.
+ *
+ * @pred is called exactly once for each element in order, so it may release
+ * the resources of the elements it drops.
+ * Elements of 1, 2, 4, 8 or 16 bytes are compacted without branching on the result of @pred.
+ *
+ * Returns: The number of removed elements.
+ **/
+usize trb_vector_retain(TrbVector *self, TrbPredFunc pred, void *userdata);
+
+/**
+ * trb_vector_dedup_sorted:
+ * @self: The sorted vector.
+ * @cmp_func: (scope call): The function for comparing values.
+ *
+ * Removes consecutive duplicates from the vector, keeping the first element of each run.
+ * If the vector is sorted with @cmp_func, all the remaining elements are unique.
+ *
+ * Returns: The number of removed elements.
+ **/
+usize trb_vector_dedup_sorted(TrbVector *self, TrbCmpFunc cmp_func);
+
 /**
  * trb_vector_search:
  * @self: The vector where to search.
@@ -304,6 +441,20 @@ bool trb_vector_search(const TrbVector *self, const void *target, TrbCmpFunc cmp
  **/
 bool trb_vector_search_data(const TrbVector *self, const void *target, TrbCmpDataFunc cmpd_func, void *data, usize *index);
 
+/**
+ * trb_vector_find_bytes:
+ * @self: The vector where to search.
+ * @target: The pointer to the data to be found.
+ * @index: (optional) (out): The pointer to retrieve the index of found value.
+ *
+ * Searches for the entry which bytes are equal to the bytes of @target.
+ * Unlike trb_vector_search(), doesn't call a comparison function for each entry,
+ * and scans vectors of 4- and 8-byte entries with SIMD instructions. See trb_find_bytes().
+ *
+ * Returns: %TRUE if found, %FALSE if not.
+ **/
+bool trb_vector_find_bytes(const TrbVector *self, const void *target, usize *index);
+
 /**
  * trb_vector_slice:
  * @self: The vector to be sliced.
@@ -314,11 +465,31 @@ bool trb_vector_search_data(const TrbVector *self, const void *target, TrbCmpDat
  * Slices the #TrbVector.
  * If allocated on the heap, use `free()` to release the allocated memory.
  *
+ * The slice can be written through, so a buffer shared by trb_vector_copy_cow()
+ * is detached first. Use trb_vector_slice_const() to only read the elements.
+ *
  * Returns: (nullable): A new #TrbSlice.
  * Can return %NULL if an error occurs.
  **/
 TrbSlice *trb_vector_slice(TrbVector *self, TrbSlice *slice, usize start, usize end);
 
+/**
+ * trb_vector_slice_const:
+ * @self: The vector to be sliced.
+ * @slice: (nullable): The pointer to the slice to be initialized.
+ * @start: The start position in the vector.
+ * @end: The end position in the vector.
+ *
+ * Slices the #TrbVector for reading, e.g. for searching it.
+ * Unlike trb_vector_slice(), it keeps a buffer shared by trb_vector_copy_cow(),
+ * so the elements must not be modified through the slice.
+ * If allocated on the heap, use `free()` to release the allocated memory.
+ *
+ * Returns: (nullable): A new #TrbSlice.
+ * Can return %NULL if an error occurs.
+ **/
+TrbSlice *trb_vector_slice_const(const TrbVector *self, TrbSlice *slice, usize start, usize end);
+
 /**
  * trb_vector_ptr:
  * @self: The vector where to get.
@@ -326,6 +497,8 @@ TrbSlice *trb_vector_slice(TrbVector *self, TrbSlice *slice, usize start, usize
  * @index: The position of the entry.
  *
  * Gets the pointer to the entry in the vector at the given index.
+ * The buffer of a vector created by trb_vector_copy_cow() must be detached
+ * with trb_vector_unshare() before writing through the pointer.
  **/
 #define trb_vector_ptr(self, type, index) ((type *) &((char *) ((self)->data))[((self)->offset + (index)) * (self)->elemsize])
 
@@ -3,21 +3,33 @@
 
 #include "trb-checked.h"
 #include "trb-deque.h"
+#include "trb-eytzinger.h"
+#include "trb-extsort.h"
+#include "trb-flat-map.h"
+#include "trb-growth.h"
 #include "trb-hash-table-iter.h"
 #include "trb-hash-table.h"
 #include "trb-hash.h"
 #include "trb-heap.h"
+#include "trb-indexed-heap.h"
 #include "trb-list.h"
 #include "trb-macros.h"
 #include "trb-math.h"
+#include "trb-merge-iter.h"
 #include "trb-messages.h"
+#include "trb-pages.h"
+#include "trb-prim.h"
 #include "trb-rand.h"
+#include "trb-seg-vector.h"
 #include "trb-slice.h"
 #include "trb-slist.h"
+#include "trb-small-vector.h"
 #include "trb-string.h"
+#include "trb-timer-wheel.h"
 #include "trb-tree.h"
 #include "trb-types.h"
 #include "trb-utils.h"
+#include "trb-vector-define.h"
 #include "trb-vector.h"
 
 #endif /* end of include guard: TRIBBLE_H_SWHO2NAT */
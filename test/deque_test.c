@@ -0,0 +1,121 @@
+#include "trb-deque.h"
+#include "trb-slice.h"
+
+#include <assert.h>
+
+#define N_ELEMS 10000
+
+void test_emplace()
+{
+	TrbDeque deque;
+	trb_deque_init(&deque, FALSE, sizeof(u32));
+
+	/* Start in the middle of a bucket */
+	for (u32 i = 0; i < 3; ++i)
+		trb_deque_push_front(&deque, &i);
+
+	for (u32 i = 0; i < 3; ++i)
+		trb_deque_pop_front(&deque, NULL);
+
+	u32 next = 0;
+
+	while (next < N_ELEMS) {
+		usize len;
+		u32 *span = trb_deque_emplace_back(&deque, N_ELEMS - next, &len);
+
+		assert(span != NULL);
+		assert(len >= 1 && len <= N_ELEMS - next);
+
+		for (usize i = 0; i < len; ++i)
+			span[i] = next++;
+	}
+
+	assert(deque.len == N_ELEMS);
+
+	/* Spans are handed out in the order of the elements */
+	u32 value;
+	for (u32 i = 0; i < N_ELEMS; ++i) {
+		assert(trb_deque_pop_front(&deque, &value));
+		assert(value == i);
+	}
+
+	/* Emplacing after a push continues right after the last element */
+	value = 42;
+	trb_deque_push_back(&deque, &value);
+
+	usize len;
+	u32 *span = trb_deque_emplace_back(&deque, 1, &len);
+	assert(len == 1);
+	*span = 43;
+
+	TrbSlice slice;
+	trb_deque_slice(&deque, &slice, 0, deque.len);
+	assert(trb_slice_len(&slice) == 2);
+	assert(*(u32 *) slice.at(&slice, 0) == 42 && *(u32 *) slice.at(&slice, 1) == 43);
+
+	trb_deque_destroy(&deque, NULL);
+}
+
+static bool is_odd(const void *data, TRB_UNUSED void *userdata)
+{
+	return *(const u32 *) data % 2 == 1;
+}
+
+static bool is_multiple(const void *data, void *userdata)
+{
+	return *(const u32 *) data % *(u32 *) userdata == 0;
+}
+
+void test_retain()
+{
+	TrbDeque deque;
+	trb_deque_init(&deque, FALSE, sizeof(u32));
+
+	/* Start in the middle of a bucket */
+	for (u32 i = 0; i < 100; ++i)
+		trb_deque_push_back(&deque, &i);
+
+	trb_deque_pop_front_many(&deque, 100, NULL);
+
+	for (u32 i = 0; i < N_ELEMS; ++i)
+		trb_deque_push_back(&deque, &i);
+
+	assert(trb_deque_retain(&deque, is_odd, NULL) == N_ELEMS / 2);
+	assert(deque.len == N_ELEMS / 2);
+
+	u32 value;
+	for (u32 i = 0; i < N_ELEMS / 2; i += 100) {
+		trb_deque_remove(&deque, 0, &value);
+		assert(value == 2 * i + 1);
+		trb_deque_pop_front_many(&deque, 99, NULL);
+	}
+
+	assert(deque.len == 0);
+
+	/* The deque stays usable after the buckets are released */
+	for (u32 i = 0; i < N_ELEMS; ++i)
+		trb_deque_push_back(&deque, &i);
+
+	u32 divisor = 3;
+	assert(trb_deque_retain(&deque, is_multiple, &divisor) == N_ELEMS - (N_ELEMS + 2) / 3);
+
+	for (u32 i = 0; deque.len != 0; i += 3) {
+		assert(trb_deque_pop_front(&deque, &value));
+		assert(value == i);
+	}
+
+	divisor = 1;
+	trb_deque_push_back(&deque, &divisor);
+	assert(trb_deque_retain(&deque, is_multiple, &divisor) == 0);
+	assert(deque.len == 1);
+
+	trb_deque_destroy(&deque, NULL);
+}
+
+int main()
+{
+	test_emplace();
+	test_retain();
+
+	return 0;
+}
@@ -0,0 +1,150 @@
+#include "trb-extsort.h"
+#include "trb-math.h"
+#include "trb-rand.h"
+#include "trb-utils.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+	u64 key;
+	u64 index;
+} Record;
+
+typedef struct {
+	TrbPcg64 rng;
+	usize len;
+	usize pos;
+} Source;
+
+typedef struct {
+	bool *seen;
+	usize len;
+	u64 last_key;
+} Sink;
+
+static i32 record_cmp(const Record *a, const Record *b)
+{
+	return (a->key > b->key) - (a->key < b->key);
+}
+
+static bool source_read(void *buffer, usize n_records, usize *n_read, void *userdata)
+{
+	Source *source = userdata;
+	Record *records = buffer;
+
+	/* Short reads must be handled by the sort */
+	usize chunk = 1 + trb_pcg64_next_u32(&source->rng) % 7;
+	n_records = trb_min(n_records, chunk);
+	n_records = trb_min(n_records, source->len - source->pos);
+
+	for (usize i = 0; i < n_records; ++i) {
+		records[i].key = trb_pcg64_next_u32(&source->rng) % 1000;
+		records[i].index = source->pos++;
+	}
+
+	*n_read = n_records;
+	return TRUE;
+}
+
+static bool sink_write(const void *buffer, usize n_records, void *userdata)
+{
+	Sink *sink = userdata;
+	const Record *records = buffer;
+
+	for (usize i = 0; i < n_records; ++i) {
+		assert(records[i].key >= sink->last_key);
+		assert(!sink->seen[records[i].index]);
+
+		sink->seen[records[i].index] = TRUE;
+		sink->last_key = records[i].key;
+	}
+
+	sink->len += n_records;
+	return TRUE;
+}
+
+void test_extsort()
+{
+	const usize lens[] = { 0, 1, 2, 3, 100, 1000, 20000 };
+	const usize memories[] = { 3, 4, 17, 256, 1 << 16 };
+
+	for (usize l = 0; l < sizeof(lens) / sizeof(lens[0]); ++l) {
+		for (usize m = 0; m < sizeof(memories) / sizeof(memories[0]); ++m) {
+			TrbExtSort sort;
+			assert(trb_extsort_init(&sort, sizeof(Record), memories[m] * sizeof(Record), (TrbCmpFunc) record_cmp) != NULL);
+
+			Source source = { .len = lens[l] };
+			trb_pcg64_init(&source.rng, lens[l] * 31 + m);
+
+			Sink sink = { .seen = calloc(lens[l] + 1, sizeof(bool)) };
+
+			assert(trb_extsort_sort(&sort, source_read, &source, sink_write, &sink));
+			assert(sink.len == lens[l]);
+
+			free(sink.seen);
+		}
+	}
+}
+
+void test_extsort_file()
+{
+	const usize len = 50000;
+
+	FILE *input = tmpfile();
+	FILE *output = tmpfile();
+	assert(input != NULL && output != NULL);
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0);
+
+	u64 sum = 0;
+
+	for (usize i = 0; i < len; ++i) {
+		u64 value = trb_pcg64_next_u64(&rng);
+		fwrite(&value, sizeof(u64), 1, input);
+		sum += value;
+	}
+
+	rewind(input);
+
+	TrbExtSort *sort = trb_extsort_init(NULL, sizeof(u64), 4096, (TrbCmpFunc) trb_u64cmp);
+	assert(sort != NULL);
+	assert(trb_extsort_sort_file(sort, input, output));
+
+	rewind(output);
+
+	u64 prev = 0;
+	u64 value;
+	usize n = 0;
+
+	while (fread(&value, sizeof(u64), 1, output) == 1) {
+		assert(value >= prev);
+		prev = value;
+		sum -= value;
+		n++;
+	}
+
+	assert(n == len);
+	assert(sum == 0);
+
+	/* A trailing partial record is an error */
+	fseek(input, 0, SEEK_END);
+	fwrite(&value, 3, 1, input);
+	rewind(input);
+
+	assert(!trb_extsort_sort_file(sort, input, output));
+
+	trb_extsort_free(sort);
+	fclose(input);
+	fclose(output);
+}
+
+int main()
+{
+	test_extsort();
+	test_extsort_file();
+
+	return 0;
+}
@@ -0,0 +1,231 @@
+#include "trb-flat-map.h"
+#include "trb-macros.h"
+#include "trb-rand.h"
+#include "trb-utils.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_KEYS 20000
+
+static void check_sorted(const TrbFlatMap *map)
+{
+	for (usize i = 1; i < map->len; ++i)
+		assert(*(u64 *) trb_flat_map_key(map, i - 1) < *(u64 *) trb_flat_map_key(map, i));
+}
+
+void test_layout()
+{
+	TrbFlatMap map;
+
+	trb_flat_map_init(&map, sizeof(u8), sizeof(u64), (TrbCmpFunc) trb_u8cmp);
+	assert(map.valueoffset == 8);
+	assert(map.entrysize == 16);
+	trb_flat_map_destroy(&map, NULL, NULL);
+
+	trb_flat_map_init(&map, sizeof(u64), sizeof(u32), (TrbCmpFunc) trb_u64cmp);
+	assert(map.valueoffset == 8);
+	assert(map.entrysize == 16);
+	trb_flat_map_destroy(&map, NULL, NULL);
+
+	/* A set */
+	trb_flat_map_init(&map, sizeof(u32), 0, (TrbCmpFunc) trb_u32cmp);
+	assert(map.entrysize == 4);
+
+	for (u32 i = 10; i > 0; --i)
+		assert(trb_flat_map_add(&map, &i, NULL));
+
+	assert(!trb_flat_map_add(&map, trb_get_ptr(u32, 5), NULL));
+	assert(map.len == 10);
+	assert(*(u32 *) trb_flat_map_key(&map, 0) == 1);
+	assert(trb_flat_map_lookup(&map, trb_get_ptr(u32, 7), NULL));
+
+	trb_flat_map_destroy(&map, NULL, NULL);
+}
+
+void test_insert_remove()
+{
+	TrbFlatMap *map = trb_flat_map_init(NULL, sizeof(u64), sizeof(u64), (TrbCmpFunc) trb_u64cmp);
+
+	for (u64 i = 0; i < 1000; ++i) {
+		u64 key = (i * 7919) % 1000;
+		u64 value = key * 2;
+		assert(trb_flat_map_add(map, &key, &value));
+	}
+
+	assert(map->len == 1000);
+	check_sorted(map);
+
+	u64 value;
+	assert(!trb_flat_map_add(map, trb_get_ptr(u64, 10), trb_get_ptr(u64, 0)));
+	assert(trb_flat_map_lookup(map, trb_get_ptr(u64, 10), &value) && value == 20);
+
+	assert(trb_flat_map_insert(map, trb_get_ptr(u64, 10), trb_get_ptr(u64, 1)));
+	assert(trb_flat_map_lookup(map, trb_get_ptr(u64, 10), &value) && value == 1);
+	assert(map->len == 1000);
+
+	assert(trb_flat_map_remove(map, trb_get_ptr(u64, 500), &value) && value == 1000);
+	assert(!trb_flat_map_remove(map, trb_get_ptr(u64, 500), NULL));
+	assert(!trb_flat_map_lookup(map, trb_get_ptr(u64, 500), NULL));
+	assert(!trb_flat_map_lookup(map, trb_get_ptr(u64, 5000), NULL));
+	assert(map->len == 999);
+
+	/* Bounds and ranges */
+	assert(trb_flat_map_lower_bound(map, trb_get_ptr(u64, 500)) == 500);
+	assert(trb_flat_map_upper_bound(map, trb_get_ptr(u64, 499)) == 500);
+	assert(trb_flat_map_lower_bound(map, trb_get_ptr(u64, 5000)) == map->len);
+
+	usize start;
+	assert(trb_flat_map_range(map, trb_get_ptr(u64, 495), trb_get_ptr(u64, 505), &start) == 9);
+	assert(*(u64 *) trb_flat_map_key(map, start) == 495);
+	assert(trb_flat_map_range(map, trb_get_ptr(u64, 505), trb_get_ptr(u64, 495), &start) == 0);
+
+	trb_flat_map_free(map, NULL, NULL);
+}
+
+void test_insert_many()
+{
+	TrbFlatMap map;
+	trb_flat_map_init(&map, sizeof(u64), sizeof(u64), (TrbCmpFunc) trb_u64cmp);
+
+	/* The reference value of each key, zero if missing */
+	u64 *expected = calloc(N_KEYS, sizeof(u64));
+	u64 *keys = malloc(N_KEYS * sizeof(u64));
+	u64 *values = malloc(N_KEYS * sizeof(u64));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 49);
+
+	for (usize round = 1; round <= 20; ++round) {
+		usize len = trb_pcg64_next_u32(&rng) % 2000;
+
+		for (usize i = 0; i < len; ++i) {
+			keys[i] = trb_pcg64_next_u32(&rng) % N_KEYS;
+			values[i] = round * N_KEYS + i;
+			expected[keys[i]] = values[i];
+		}
+
+		assert(trb_flat_map_insert_many(&map, keys, values, len));
+		check_sorted(&map);
+
+		usize n_expected = 0;
+
+		for (u64 key = 0; key < N_KEYS; ++key) {
+			u64 value;
+
+			if (expected[key] == 0) {
+				assert(!trb_flat_map_lookup(&map, &key, NULL));
+				continue;
+			}
+
+			assert(trb_flat_map_lookup(&map, &key, &value));
+			assert(value == expected[key]);
+			n_expected++;
+		}
+
+		assert(map.len == n_expected);
+	}
+
+	/* Zeroed values */
+	assert(trb_flat_map_insert_many(&map, trb_get_arr(u64, 2, 3, 3), NULL, 2));
+	assert(trb_flat_map_lookup(&map, trb_get_ptr(u64, 3), &values[0]) && values[0] == 0);
+
+	free(expected);
+	free(keys);
+	free(values);
+
+	trb_flat_map_destroy(&map, NULL, NULL);
+}
+
+void test_build()
+{
+	TrbFlatMap map;
+	trb_flat_map_init(&map, sizeof(u64), sizeof(u32), (TrbCmpFunc) trb_u64cmp);
+
+	trb_flat_map_insert(&map, trb_get_ptr(u64, 100), trb_get_ptr(u32, 1));
+
+	u64 keys[] = { 9, 3, 7, 3, 1, 9, 5 };
+	u32 values[] = { 0, 1, 2, 3, 4, 5, 6 };
+
+	assert(trb_flat_map_build_from_unsorted(&map, keys, values, 7));
+	assert(map.len == 5);
+	check_sorted(&map);
+
+	/* The old entries are gone and the last duplicate wins */
+	u32 value;
+	assert(!trb_flat_map_lookup(&map, trb_get_ptr(u64, 100), NULL));
+	assert(trb_flat_map_lookup(&map, trb_get_ptr(u64, 3), &value) && value == 3);
+	assert(trb_flat_map_lookup(&map, trb_get_ptr(u64, 9), &value) && value == 5);
+	assert(trb_flat_map_lookup(&map, trb_get_ptr(u64, 1), &value) && value == 4);
+
+	/* The map stays usable */
+	assert(trb_flat_map_insert(&map, trb_get_ptr(u64, 4), trb_get_ptr(u32, 44)));
+	assert(*(u64 *) trb_flat_map_key(&map, 2) == 4);
+	assert(*(u32 *) trb_flat_map_value(&map, 2) == 44);
+
+	assert(trb_flat_map_build_from_unsorted(&map, NULL, NULL, 0));
+	assert(map.len == 0);
+
+	trb_flat_map_destroy(&map, NULL, NULL);
+}
+
+static i32 reverse_cmp(const void *a, const void *b, void *data)
+{
+	(*(usize *) data)++;
+	return trb_u64cmp(b, a);
+}
+
+void test_data()
+{
+	usize calls = 0;
+
+	TrbFlatMap map;
+	trb_flat_map_init_data(&map, sizeof(u64), 0, reverse_cmp, &calls);
+
+	u64 keys[] = { 1, 5, 3, 4, 2 };
+	assert(trb_flat_map_insert_many(&map, keys, NULL, 5));
+
+	for (usize i = 0; i < 5; ++i)
+		assert(*(u64 *) trb_flat_map_key(&map, i) == 5 - i);
+
+	assert(trb_flat_map_lookup(&map, trb_get_ptr(u64, 2), NULL));
+	assert(calls != 0);
+
+	trb_flat_map_destroy(&map, NULL, NULL);
+}
+
+void test_cow()
+{
+	TrbFlatMap map;
+	trb_flat_map_init(&map, sizeof(u64), sizeof(u64), (TrbCmpFunc) trb_u64cmp);
+
+	for (u64 i = 0; i < 100; ++i)
+		trb_flat_map_insert(&map, &i, &i);
+
+	/* Lookups keep the buffer shared, replacing a value detaches it */
+	TrbVector snap;
+	trb_vector_copy_cow(&map.entries, &snap);
+
+	assert(trb_flat_map_lookup(&map, trb_get_ptr(u64, 7), NULL));
+	assert(snap.data == map.entries.data);
+
+	assert(trb_flat_map_insert(&map, trb_get_ptr(u64, 7), trb_get_ptr(u64, 700)));
+	assert(snap.data != map.entries.data);
+	assert(*(u64 *) (trb_vector_ptr(&snap, char, 7) + map.valueoffset) == 7);
+
+	trb_vector_destroy(&snap, NULL);
+	trb_flat_map_destroy(&map, NULL, NULL);
+}
+
+int main()
+{
+	test_layout();
+	test_insert_remove();
+	test_insert_many();
+	test_build();
+	test_data();
+	test_cow();
+
+	return 0;
+}
@@ -0,0 +1,232 @@
+#include "trb-heap.h"
+#include "trb-rand.h"
+#include "trb-utils.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#define N_ELEMS 10000
+
+static void assert_heap(const TrbHeap *heap)
+{
+	for (usize i = 1; i < heap->vector.len; ++i)
+		assert(trb_heap_get(heap, u32, (i - 1) / trb_heap_arity(heap)) >= trb_heap_get(heap, u32, i));
+}
+
+static void assert_drain(TrbHeap *heap, usize len)
+{
+	u32 prev = U32_MAX;
+	u32 value;
+
+	for (usize i = 0; i < len; ++i) {
+		assert(trb_heap_pop_front(heap, &value));
+		assert(value <= prev);
+		prev = value;
+	}
+
+	assert(heap->vector.len == 0);
+}
+
+void test_insert_pop(usize arity)
+{
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 1);
+
+	TrbHeap heap;
+	trb_heap_init(&heap, sizeof(u32), (TrbCmpFunc) trb_u32cmp);
+	assert(trb_heap_set_arity(&heap, arity));
+
+	for (usize i = 0; i < N_ELEMS; ++i) {
+		u32 value = trb_pcg64_next_u32(&rng) % 1000;
+		assert(trb_heap_insert(&heap, &value));
+	}
+
+	assert_heap(&heap);
+	assert_drain(&heap, N_ELEMS);
+
+	trb_heap_destroy(&heap, NULL);
+}
+
+void test_remove(usize arity)
+{
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 2);
+
+	TrbHeap heap;
+	trb_heap_init(&heap, sizeof(u32), (TrbCmpFunc) trb_u32cmp);
+	assert(trb_heap_set_arity(&heap, arity));
+
+	for (usize i = 0; i < N_ELEMS; ++i) {
+		u32 value = trb_pcg64_next_u32(&rng);
+		trb_heap_insert(&heap, &value);
+	}
+
+	for (usize i = 0; i < N_ELEMS / 2; ++i) {
+		usize index = trb_pcg64_next_u32(&rng) % heap.vector.len;
+		u32 expected = trb_heap_get(&heap, u32, index);
+		u32 value;
+
+		assert(trb_heap_remove(&heap, index, &value));
+		assert(value == expected);
+		assert_heap(&heap);
+	}
+
+	assert(!trb_heap_remove(&heap, heap.vector.len, NULL));
+	assert_drain(&heap, N_ELEMS - N_ELEMS / 2);
+
+	trb_heap_destroy(&heap, NULL);
+}
+
+void test_push_many(usize arity)
+{
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 3);
+
+	u32 *arr = malloc(N_ELEMS * sizeof(u32));
+
+	for (usize i = 0; i < N_ELEMS; ++i)
+		arr[i] = trb_pcg64_next_u32(&rng);
+
+	TrbHeap heap;
+	trb_heap_init(&heap, sizeof(u32), (TrbCmpFunc) trb_u32cmp);
+	assert(trb_heap_set_arity(&heap, arity));
+
+	assert(trb_heap_push_many(&heap, arr, N_ELEMS / 2));
+	assert_heap(&heap);
+
+	assert(trb_heap_push_many(&heap, arr + N_ELEMS / 2, N_ELEMS - N_ELEMS / 2));
+	assert_heap(&heap);
+
+	assert_drain(&heap, N_ELEMS);
+
+	trb_heap_destroy(&heap, NULL);
+	free(arr);
+}
+
+void test_replace_top(usize arity)
+{
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 4);
+
+	TrbHeap heap;
+	trb_heap_init(&heap, sizeof(u32), (TrbCmpFunc) trb_u32cmp);
+	assert(trb_heap_set_arity(&heap, arity));
+
+	u32 value = 0;
+	assert(!trb_heap_replace_top(&heap, &value, NULL));
+
+	for (usize i = 0; i < 100; ++i) {
+		value = trb_pcg64_next_u32(&rng);
+		trb_heap_insert(&heap, &value);
+	}
+
+	for (usize i = 0; i < N_ELEMS; ++i) {
+		u32 top = trb_heap_get(&heap, u32, 0);
+		u32 ret;
+
+		value = trb_pcg64_next_u32(&rng);
+		assert(trb_heap_replace_top(&heap, &value, &ret));
+		assert(ret == top);
+		assert_heap(&heap);
+	}
+
+	assert_drain(&heap, 100);
+
+	trb_heap_destroy(&heap, NULL);
+}
+
+void test_set_arity()
+{
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 5);
+
+	TrbHeap heap;
+	trb_heap_init(&heap, sizeof(u32), (TrbCmpFunc) trb_u32cmp);
+
+	for (usize i = 0; i < N_ELEMS; ++i) {
+		u32 value = trb_pcg64_next_u32(&rng);
+		trb_heap_insert(&heap, &value);
+	}
+
+	assert(!trb_heap_set_arity(&heap, 3));
+	assert(!trb_heap_set_arity(&heap, 1));
+	assert(trb_heap_arity(&heap) == 2);
+
+	assert(trb_heap_set_arity(&heap, 8));
+	assert_heap(&heap);
+
+	assert(trb_heap_set_arity(&heap, 4));
+	assert_heap(&heap);
+
+	assert_drain(&heap, N_ELEMS);
+
+	trb_heap_destroy(&heap, NULL);
+}
+
+void test_find_bytes()
+{
+	TrbHeap heap;
+	trb_heap_init(&heap, sizeof(u64), (TrbCmpFunc) trb_u64cmp);
+
+	for (u64 i = 0; i < 1000; ++i)
+		trb_heap_insert(&heap, trb_get_ptr(u64, i * 3));
+
+	usize index;
+	assert(trb_heap_find_bytes(&heap, trb_get_ptr(u64, 300), &index));
+	assert(trb_heap_get(&heap, u64, index) == 300);
+	assert(!trb_heap_find_bytes(&heap, trb_get_ptr(u64, 301), NULL));
+
+	trb_heap_destroy(&heap, NULL);
+}
+
+void test_cow()
+{
+	TrbHeap heap;
+	trb_heap_init(&heap, sizeof(u32), (TrbCmpFunc) trb_u32cmp);
+
+	for (u32 i = 0; i < 100; ++i)
+		trb_heap_insert(&heap, &i);
+
+	/* Popping, replacing the top and fixing the heap detach the buffer */
+	TrbVector snap;
+	trb_vector_copy_cow(&heap.vector, &snap);
+
+	u32 top = trb_vector_get(&snap, u32, 0);
+	assert(trb_heap_pop_front(&heap, NULL));
+	assert(trb_vector_get(&snap, u32, 0) == top && snap.len == 100);
+	trb_vector_destroy(&snap, NULL);
+
+	trb_vector_copy_cow(&heap.vector, &snap);
+	top = trb_vector_get(&snap, u32, 0);
+	assert(trb_heap_replace_top(&heap, trb_get_ptr(u32, 0), NULL));
+	assert(trb_vector_get(&snap, u32, 0) == top);
+	trb_vector_destroy(&snap, NULL);
+
+	trb_vector_copy_cow(&heap.vector, &snap);
+	assert(trb_heap_set_arity(&heap, 8));
+	assert_heap(&heap);
+
+	for (usize i = 1; i < snap.len; ++i)
+		assert(trb_vector_get(&snap, u32, (i - 1) / 2) >= trb_vector_get(&snap, u32, i));
+
+	trb_vector_destroy(&snap, NULL);
+	trb_heap_destroy(&heap, NULL);
+}
+
+int main()
+{
+	const usize arities[] = { 2, 4, 8, 16 };
+
+	for (usize i = 0; i < sizeof(arities) / sizeof(arities[0]); ++i) {
+		test_insert_pop(arities[i]);
+		test_remove(arities[i]);
+		test_push_many(arities[i]);
+		test_replace_top(arities[i]);
+	}
+
+	test_set_arity();
+	test_find_bytes();
+	test_cow();
+
+	return 0;
+}
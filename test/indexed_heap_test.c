@@ -0,0 +1,155 @@
+#include "trb-indexed-heap.h"
+#include "trb-rand.h"
+#include "trb-utils.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#define N_HANDLES 512
+#define N_OPS 100000
+
+typedef struct {
+	u32 value;
+	bool alive;
+} Model;
+
+static void assert_top(const TrbIndexedHeap *heap, const Model *model, usize n_handles)
+{
+	u32 max = 0;
+	usize len = 0;
+
+	for (usize i = 0; i < n_handles; ++i) {
+		if (model[i].alive) {
+			max = trb_max(max, model[i].value);
+			len++;
+		}
+	}
+
+	assert(heap->len == len);
+
+	usize handle;
+	const u32 *top = trb_indexed_heap_top(heap, &handle);
+
+	if (len == 0) {
+		assert(top == NULL);
+		return;
+	}
+
+	assert(*top == max);
+	assert(model[handle].alive && model[handle].value == max);
+}
+
+void test_random_ops()
+{
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 37);
+
+	TrbIndexedHeap heap;
+	trb_indexed_heap_init(&heap, sizeof(u32), (TrbCmpFunc) trb_u32cmp);
+
+	Model *model = calloc(N_HANDLES, sizeof(Model));
+	usize n_handles = 0;
+
+	for (usize op = 0; op < N_OPS; ++op) {
+		u32 value = trb_pcg64_next_u32(&rng) % 10000;
+		usize handle = (n_handles != 0) ? trb_pcg64_next_u32(&rng) % n_handles : 0;
+		bool alive = handle < n_handles && model[handle].alive;
+
+		switch (trb_pcg64_next_u32(&rng) % 5) {
+		case 0:
+		case 1:
+			if (heap.len == N_HANDLES)
+				break;
+
+			assert(trb_indexed_heap_insert(&heap, &value, &handle));
+			assert(handle < N_HANDLES && !model[handle].alive);
+
+			model[handle] = (Model) { value, TRUE };
+			n_handles = trb_max(n_handles, handle + 1);
+			break;
+		case 2:
+			assert(trb_indexed_heap_update(&heap, handle, &value) == alive);
+
+			if (alive)
+				model[handle].value = value;
+			break;
+		case 3: {
+			u32 ret;
+			assert(trb_indexed_heap_remove(&heap, handle, &ret) == alive);
+
+			if (alive) {
+				assert(ret == model[handle].value);
+				model[handle].alive = FALSE;
+			}
+			break;
+		}
+		case 4: {
+			if (heap.len == 0) {
+				assert(!trb_indexed_heap_pop_front(&heap, NULL, NULL));
+				break;
+			}
+
+			u32 expected = *(const u32 *) trb_indexed_heap_top(&heap, NULL);
+
+			u32 ret;
+			assert(trb_indexed_heap_pop_front(&heap, &ret, &handle));
+			assert(ret == expected);
+			assert(model[handle].alive && model[handle].value == ret);
+
+			model[handle].alive = FALSE;
+			break;
+		}
+		}
+
+		assert(trb_indexed_heap_contains(&heap, handle) == model[handle].alive);
+		assert_top(&heap, model, n_handles);
+	}
+
+	trb_indexed_heap_destroy(&heap, NULL);
+	free(model);
+}
+
+void test_fix()
+{
+	TrbIndexedHeap *heap = trb_indexed_heap_init(NULL, sizeof(u32), (TrbCmpFunc) trb_u32cmp);
+	usize handles[100];
+
+	for (u32 i = 0; i < 100; ++i)
+		trb_indexed_heap_insert(heap, &i, &handles[i]);
+
+	u32 *value = trb_indexed_heap_ptr(heap, handles[10]);
+	assert(value != NULL && *value == 10);
+
+	*value = 1000;
+	assert(trb_indexed_heap_fix(heap, handles[10]));
+
+	usize handle;
+	assert(*(const u32 *) trb_indexed_heap_top(heap, &handle) == 1000);
+	assert(handle == handles[10]);
+
+	value = trb_indexed_heap_ptr(heap, handles[10]);
+	*value = 0;
+	assert(trb_indexed_heap_fix(heap, handles[10]));
+	assert(*(const u32 *) trb_indexed_heap_top(heap, &handle) == 99);
+
+	u32 prev = U32_MAX;
+	u32 ret;
+
+	while (heap->len != 0) {
+		trb_indexed_heap_pop_front(heap, &ret, NULL);
+		assert(ret <= prev);
+		prev = ret;
+	}
+
+	assert(trb_indexed_heap_ptr(heap, handles[0]) == NULL);
+
+	trb_indexed_heap_free(heap, NULL);
+}
+
+int main()
+{
+	test_random_ops();
+	test_fix();
+
+	return 0;
+}
@@ -0,0 +1,158 @@
+#include "trb-deque.h"
+#include "trb-merge-iter.h"
+#include "trb-rand.h"
+#include "trb-slice.h"
+#include "trb-utils.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#define MAX_SLICES 64
+#define MAX_LEN 500
+
+typedef struct {
+	u32 key;
+	u32 source;
+	u32 index;
+} Record;
+
+static i32 record_cmp(const Record *a, const Record *b)
+{
+	return (a->key > b->key) - (a->key < b->key);
+}
+
+/* Equal keys must come in the order of their slices and then of their positions */
+static void assert_merged(const Record *out, usize len)
+{
+	for (usize i = 1; i < len; ++i) {
+		const Record *a = &out[i - 1];
+		const Record *b = &out[i];
+
+		assert(a->key <= b->key);
+
+		if (a->key == b->key)
+			assert(a->source < b->source || (a->source == b->source && a->index < b->index));
+	}
+}
+
+static usize fill_runs(TrbPcg64 *rng, Record **runs, TrbSlice *slices, usize n_slices)
+{
+	usize total = 0;
+
+	for (usize s = 0; s < n_slices; ++s) {
+		usize len = trb_pcg64_next_u32(rng) % MAX_LEN;
+
+		if (s % 5 == 0)
+			len = 0;
+
+		runs[s] = malloc((len ?: 1) * sizeof(Record));
+
+		for (usize i = 0; i < len; ++i)
+			runs[s][i] = (Record) { trb_pcg64_next_u32(rng) % 100, s, i };
+
+		TrbSlice slice;
+		trb_slice_init(&slice, runs[s], sizeof(Record), 0, len ?: 1);
+		slice.end = len;
+		trb_stablesort(&slice, (TrbCmpFunc) record_cmp, NULL);
+
+		slices[s] = slice;
+		total += len;
+	}
+
+	return total;
+}
+
+void test_merge()
+{
+	const usize counts[] = { 0, 1, 2, 3, 5, 8, 17, MAX_SLICES };
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 40);
+
+	Record *runs[MAX_SLICES];
+	TrbSlice slices[MAX_SLICES];
+	Record *out = malloc(MAX_SLICES * MAX_LEN * sizeof(Record));
+
+	for (usize c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+		usize n_slices = counts[c];
+		usize total = fill_runs(&rng, runs, slices, n_slices);
+
+		/* One element at a time */
+		TrbMergeIter iter;
+		assert(trb_merge_iter_init(&iter, slices, n_slices, (TrbCmpFunc) record_cmp) != NULL);
+		assert(iter.remaining == total);
+
+		const Record *elem;
+		usize source;
+		usize len = 0;
+
+		while (trb_merge_iter_next(&iter, (const void **) &elem, &source)) {
+			assert(elem->source == source);
+			out[len++] = *elem;
+		}
+
+		assert(len == total);
+		assert_merged(out, len);
+		trb_merge_iter_destroy(&iter);
+
+		/* In batches of different sizes */
+		TrbMergeIter *batched = trb_merge_iter_init(NULL, slices, n_slices, (TrbCmpFunc) record_cmp);
+		len = 0;
+
+		usize n;
+		while ((n = trb_merge_iter_next_many(batched, out + len, 1 + len % 37)) != 0)
+			len += n;
+
+		assert(len == total);
+		assert(batched->remaining == 0);
+		assert_merged(out, len);
+		trb_merge_iter_free(batched);
+
+		for (usize s = 0; s < n_slices; ++s)
+			free(runs[s]);
+	}
+
+	free(out);
+}
+
+void test_merge_deque()
+{
+	TrbDeque deques[3];
+	TrbSlice slices[3];
+
+	for (usize s = 0; s < 3; ++s) {
+		trb_deque_init(&deques[s], FALSE, sizeof(u32));
+
+		/* Push to the front so that the elements wrap around the deque buffer */
+		for (u32 i = 0; i < 100; ++i) {
+			u32 value = (100 - i) * 3 + s;
+			trb_deque_push_front(&deques[s], &value);
+		}
+
+		trb_deque_slice(&deques[s], &slices[s], 0, deques[s].len);
+	}
+
+	TrbMergeIter iter;
+	trb_merge_iter_init(&iter, slices, 3, (TrbCmpFunc) trb_u32cmp);
+
+	const u32 *value;
+	u32 expected = 3;
+
+	while (trb_merge_iter_next(&iter, (const void **) &value, NULL))
+		assert(*value == expected++);
+
+	assert(expected == 303);
+
+	trb_merge_iter_destroy(&iter);
+
+	for (usize s = 0; s < 3; ++s)
+		trb_deque_destroy(&deques[s], NULL);
+}
+
+int main()
+{
+	test_merge();
+	test_merge_deque();
+
+	return 0;
+}
@@ -0,0 +1,269 @@
+#include "trb-prim.h"
+#include "trb-rand.h"
+#include "trb-seg-vector.h"
+#include "trb-utils.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define N_ELEMS 100000
+
+static const usize lens[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 100, 1000, N_ELEMS };
+
+#define N_LENS (sizeof(lens) / sizeof(lens[0]))
+
+static u64 next_value(TrbPcg64 *rng, usize i, usize pattern)
+{
+	switch (pattern) {
+	case 0: /* sorted */
+		return i;
+	case 1: /* reverse */
+		return N_ELEMS - i;
+	case 2: /* few unique */
+		return trb_pcg64_next_u32(rng) % 4;
+	case 3: /* small */
+		return trb_pcg64_next_u32(rng) % 1000;
+	default:
+		return trb_pcg64_next_u64(rng);
+	}
+}
+
+void test_sort_32()
+{
+	i32 *iarr = malloc(N_ELEMS * sizeof(i32));
+	u32 *uarr = malloc(N_ELEMS * sizeof(u32));
+	i32 *expected = malloc(N_ELEMS * sizeof(i32));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 32);
+
+	for (usize l = 0; l < N_LENS; ++l) {
+		for (usize pattern = 0; pattern < 5; ++pattern) {
+			usize len = lens[l];
+
+			for (usize i = 0; i < len; ++i) {
+				uarr[i] = next_value(&rng, i, pattern);
+				iarr[i] = uarr[i];
+			}
+
+			/* The comparator-based sort is the reference */
+			memcpy(expected, iarr, len * sizeof(i32));
+
+			TrbSlice slice;
+			trb_slice_init(&slice, expected, sizeof(i32), 0, len ?: 1);
+			slice.end = len;
+			trb_quicksort(&slice, (TrbCmpFunc) trb_i32cmp);
+
+			trb_sort_i32(iarr, len);
+			assert(memcmp(iarr, expected, len * sizeof(i32)) == 0);
+
+			trb_sort_u32(uarr, len);
+			for (usize i = 1; i < len; ++i)
+				assert(uarr[i - 1] <= uarr[i]);
+		}
+	}
+
+	free(iarr);
+	free(uarr);
+	free(expected);
+}
+
+void test_sort_64()
+{
+	i64 *iarr = malloc(N_ELEMS * sizeof(i64));
+	u64 *uarr = malloc(N_ELEMS * sizeof(u64));
+	i64 *expected = malloc(N_ELEMS * sizeof(i64));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 64);
+
+	for (usize l = 0; l < N_LENS; ++l) {
+		for (usize pattern = 0; pattern < 5; ++pattern) {
+			usize len = lens[l];
+
+			for (usize i = 0; i < len; ++i) {
+				uarr[i] = next_value(&rng, i, pattern);
+				iarr[i] = uarr[i];
+			}
+
+			memcpy(expected, iarr, len * sizeof(i64));
+
+			TrbSlice slice;
+			trb_slice_init(&slice, expected, sizeof(i64), 0, len ?: 1);
+			slice.end = len;
+			trb_quicksort(&slice, (TrbCmpFunc) trb_i64cmp);
+
+			trb_sort_i64(iarr, len);
+			assert(memcmp(iarr, expected, len * sizeof(i64)) == 0);
+
+			trb_sort_u64(uarr, len);
+			for (usize i = 1; i < len; ++i)
+				assert(uarr[i - 1] <= uarr[i]);
+		}
+	}
+
+	free(iarr);
+	free(uarr);
+	free(expected);
+}
+
+void test_sort_floats()
+{
+	f32 *farr = malloc(N_ELEMS * sizeof(f32));
+	f64 *darr = malloc(N_ELEMS * sizeof(f64));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 3264);
+
+	for (usize l = 0; l < N_LENS; ++l) {
+		usize len = lens[l];
+
+		for (usize i = 0; i < len; ++i) {
+			darr[i] = ((f64) trb_pcg64_next_u32(&rng) - U32_MAX / 2) / (1 + i % 100);
+			farr[i] = darr[i];
+		}
+
+		if (len > 4) {
+			darr[0] = farr[0] = 1.0 / 0.0;
+			darr[1] = farr[1] = -1.0 / 0.0;
+			darr[2] = farr[2] = 0.0;
+			darr[3] = farr[3] = -0.0;
+		}
+
+		trb_sort_f32(farr, len);
+		trb_sort_f64(darr, len);
+
+		for (usize i = 1; i < len; ++i) {
+			assert(farr[i - 1] <= farr[i]);
+			assert(darr[i - 1] <= darr[i]);
+		}
+
+		if (len > 4) {
+			assert(farr[0] == -1.0 / 0.0 && farr[len - 1] == 1.0 / 0.0);
+			assert(darr[0] == -1.0 / 0.0 && darr[len - 1] == 1.0 / 0.0);
+		}
+	}
+
+	free(farr);
+	free(darr);
+}
+
+void test_find()
+{
+	u32 *arr32 = malloc(N_ELEMS * sizeof(u32));
+	u64 *arr64 = malloc(N_ELEMS * sizeof(u64));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 47);
+
+	for (usize l = 0; l < N_LENS; ++l) {
+		usize len = lens[l];
+
+		for (usize i = 0; i < len; ++i) {
+			arr32[i] = trb_pcg64_next_u32(&rng) % 64;
+			arr64[i] = (u64) arr32[i] << 32 | 7;
+		}
+
+		TrbSlice s32, s64;
+		trb_slice_init(&s32, arr32, sizeof(u32), 0, len ?: 1);
+		trb_slice_init(&s64, arr64, sizeof(u64), 0, len ?: 1);
+		s32.end = s64.end = len;
+
+		/* The plain loop is the reference */
+		for (u32 value = 0; value < 66; ++value) {
+			usize first = len, count = 0;
+
+			for (usize i = 0; i < len; ++i) {
+				if (arr32[i] == value) {
+					first = (first == len) ? i : first;
+					count++;
+				}
+			}
+
+			usize index = len;
+			assert(trb_find_u32(&s32, value, &index) == (first != len));
+			assert(index == first);
+			assert(trb_count_u32(&s32, value) == count);
+
+			index = len;
+			assert(trb_find_u64(&s64, (u64) value << 32 | 7, &index) == (first != len));
+			assert(index == first);
+			assert(trb_count_u64(&s64, (u64) value << 32 | 7) == count);
+
+			/* Only one half of a 64-bit element matches */
+			assert(!trb_find_u64(&s64, (u64) value << 32 | 8, NULL));
+			assert(trb_count_u64(&s64, (u64) value << 32) == 0);
+		}
+	}
+
+	/* Float equality is bitwise */
+	f64 floats[] = { 1.5, -0.0, 0.0 / 0.0, 2.5 };
+	TrbSlice fslice;
+	trb_slice_init(&fslice, floats, sizeof(f64), 0, 4);
+
+	usize index;
+	assert(trb_find_f64(&fslice, 0.0, &index) == FALSE);
+	assert(trb_find_f64(&fslice, -0.0, &index) && index == 1);
+	assert(trb_find_f64(&fslice, floats[2], &index) && index == 2);
+	assert(trb_count_f64(&fslice, 2.5) == 1);
+
+	i64 ints[] = { -1, 5, -1, I64_MIN };
+	TrbSlice islice;
+	trb_slice_init(&islice, ints, sizeof(i64), 1, 4);
+
+	assert(trb_find_i64(&islice, -1, &index) && index == 1);
+	assert(trb_count_i64(&islice, -1) == 1);
+	assert(trb_find_i64(&islice, I64_MIN, &index) && index == 2);
+
+	free(arr32);
+	free(arr64);
+}
+
+void test_find_bytes()
+{
+	/* 3-byte elements go through memcmp */
+	u8 triples[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 4, 5, 6 };
+	TrbSlice slice;
+	trb_slice_init(&slice, triples, 3, 0, 4);
+
+	usize index;
+	assert(trb_find_bytes(&slice, (u8[]) { 4, 5, 6 }, &index) && index == 1);
+	assert(!trb_find_bytes(&slice, (u8[]) { 2, 3, 4 }, NULL));
+
+	/* Misaligned 4-byte elements */
+	u8 bytes[4 * 9];
+	for (usize i = 0; i < sizeof(bytes); ++i)
+		bytes[i] = i;
+
+	trb_slice_init(&slice, bytes + 1, 4, 0, 8);
+	assert(trb_find_bytes(&slice, &bytes[1 + 4 * 6], &index) && index == 6);
+
+	trb_slice_init(&slice, bytes, 1, 3, 20);
+	assert(trb_find_bytes(&slice, &bytes[10], &index) && index == 7);
+
+	/* Non-contiguous slices */
+	TrbSegVector vec;
+	trb_seg_vector_init(&vec, FALSE, sizeof(u32));
+
+	for (u32 i = 0; i < 1000; ++i)
+		trb_seg_vector_push_back(&vec, trb_get_ptr(u32, i % 100));
+
+	trb_seg_vector_slice(&vec, &slice, 10, 1000);
+	assert(trb_find_u32(&slice, 5, &index) && index == 95);
+	assert(trb_count_u32(&slice, 5) == 9);
+	assert(trb_find_bytes(&slice, trb_get_ptr(u32, 9), &index) && index == 99);
+
+	trb_seg_vector_destroy(&vec, NULL);
+}
+
+int main()
+{
+	test_sort_32();
+	test_sort_64();
+	test_sort_floats();
+	test_find();
+	test_find_bytes();
+
+	return 0;
+}
@@ -0,0 +1,162 @@
+#include "trb-deque.h"
+#include "trb-eytzinger.h"
+#include "trb-rand.h"
+#include "trb-slice.h"
+#include "trb-utils.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#define N_ELEMS 10000
+
+/* Sorted values with runs of duplicates and gaps */
+static void fill_sorted(u32 *arr, usize len)
+{
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, len);
+
+	u32 value = 1;
+
+	for (usize i = 0; i < len; ++i) {
+		value += trb_pcg64_next_u32(&rng) % 3;
+		arr[i] = value;
+	}
+}
+
+static usize naive_lower_bound(const u32 *arr, usize len, u32 target)
+{
+	usize i = 0;
+
+	while (i < len && arr[i] < target)
+		i++;
+
+	return i;
+}
+
+static usize naive_upper_bound(const u32 *arr, usize len, u32 target)
+{
+	usize i = 0;
+
+	while (i < len && arr[i] <= target)
+		i++;
+
+	return i;
+}
+
+void test_bounds()
+{
+	const usize lens[] = { 0, 1, 2, 3, 7, 8, 100, 1000 };
+	u32 *arr = malloc(1000 * sizeof(u32));
+
+	for (usize l = 0; l < sizeof(lens) / sizeof(lens[0]); ++l) {
+		usize len = lens[l];
+		fill_sorted(arr, len);
+
+		TrbSlice slice;
+		trb_slice_init(&slice, arr, sizeof(u32), 0, len ?: 1);
+		slice.end = len;
+
+		u32 max = (len != 0) ? arr[len - 1] + 2 : 2;
+
+		for (u32 target = 0; target <= max; ++target) {
+			usize lower = naive_lower_bound(arr, len, target);
+			usize upper = naive_upper_bound(arr, len, target);
+
+			assert(trb_lower_bound(&slice, &target, (TrbCmpFunc) trb_u32cmp) == lower);
+			assert(trb_upper_bound(&slice, &target, (TrbCmpFunc) trb_u32cmp) == upper);
+
+			usize start, end;
+			assert(trb_equal_range(&slice, &target, (TrbCmpFunc) trb_u32cmp, &start, &end) == (lower != upper));
+			assert(start == lower && end == upper);
+
+			usize index;
+			assert(trb_binary_search(&slice, &target, (TrbCmpFunc) trb_u32cmp, &index) == (lower != upper));
+
+			if (lower != upper)
+				assert(index == lower);
+		}
+	}
+
+	free(arr);
+}
+
+void test_bounds_deque()
+{
+	TrbDeque deque;
+	trb_deque_init(&deque, FALSE, sizeof(u32));
+
+	u32 *arr = malloc(N_ELEMS * sizeof(u32));
+	fill_sorted(arr, N_ELEMS);
+	trb_deque_push_back_many(&deque, arr, N_ELEMS);
+
+	TrbSlice slice;
+	trb_deque_slice(&deque, &slice, 0, deque.len);
+
+	for (usize i = 0; i < N_ELEMS; i += 37) {
+		u32 target = arr[i];
+		assert(trb_lower_bound(&slice, &target, (TrbCmpFunc) trb_u32cmp) == naive_lower_bound(arr, N_ELEMS, target));
+		assert(trb_upper_bound(&slice, &target, (TrbCmpFunc) trb_u32cmp) == naive_upper_bound(arr, N_ELEMS, target));
+	}
+
+	trb_deque_destroy(&deque, NULL);
+	free(arr);
+}
+
+void test_eytzinger()
+{
+	const usize lens[] = { 0, 1, 2, 3, 15, 16, 17, 1000, N_ELEMS };
+	u32 *arr = malloc(N_ELEMS * sizeof(u32));
+
+	u32 targets[64];
+	const void *results[64];
+
+	for (usize l = 0; l < sizeof(lens) / sizeof(lens[0]); ++l) {
+		usize len = lens[l];
+		fill_sorted(arr, len);
+
+		TrbSlice slice;
+		trb_slice_init(&slice, arr, sizeof(u32), 0, len ?: 1);
+		slice.end = len;
+
+		TrbEytzinger *tree = trb_eytzinger_init(NULL, &slice, (TrbCmpFunc) trb_u32cmp);
+		assert(tree != NULL);
+		assert(tree->len == len);
+
+		u32 max = (len != 0) ? arr[len - 1] + 2 : 2;
+		usize n_targets = 0;
+
+		for (u32 target = 0; target <= max; target += 1 + max / 500) {
+			usize lower = naive_lower_bound(arr, len, target);
+			const u32 *found = trb_eytzinger_lower_bound(tree, &target);
+
+			if (lower == len)
+				assert(found == NULL);
+			else
+				assert(found != NULL && *found == arr[lower]);
+
+			const u32 *exact = trb_eytzinger_search(tree, &target);
+			assert((exact != NULL) == (lower != len && arr[lower] == target));
+
+			if (n_targets < 64)
+				targets[n_targets++] = target;
+		}
+
+		trb_eytzinger_lower_bound_many(tree, targets, n_targets, results);
+
+		for (usize i = 0; i < n_targets; ++i)
+			assert(results[i] == trb_eytzinger_lower_bound(tree, &targets[i]));
+
+		trb_eytzinger_free(tree);
+	}
+
+	free(arr);
+}
+
+int main()
+{
+	test_bounds();
+	test_bounds_deque();
+	test_eytzinger();
+
+	return 0;
+}
@@ -0,0 +1,119 @@
+#include "trb-seg-vector.h"
+#include "trb-utils.h"
+
+#include <assert.h>
+#include <string.h>
+
+void test_stable()
+{
+	TrbSegVector vec;
+	trb_seg_vector_init(&vec, FALSE, sizeof(u32));
+
+	u32 *ptrs[1000];
+
+	for (u32 i = 0; i < 1000; ++i) {
+		assert(trb_seg_vector_push_back(&vec, &i));
+		ptrs[i] = trb_seg_vector_ptr(&vec, u32, i);
+	}
+
+	assert(vec.len == 1000);
+	assert(vec.capacity >= 1000);
+
+	/* Growing never moves the elements */
+	for (u32 i = 0; i < 1000; ++i) {
+		assert(ptrs[i] == trb_seg_vector_ptr(&vec, u32, i));
+		assert(*ptrs[i] == i);
+	}
+
+	u32 *last = trb_seg_vector_emplace_back(&vec);
+	assert(last != NULL);
+	*last = 1000;
+
+	u32 value;
+	assert(trb_seg_vector_pop_back(&vec, &value));
+	assert(value == 1000);
+	assert(trb_seg_vector_pop_back(&vec, NULL));
+	assert(vec.len == 999);
+
+	trb_seg_vector_destroy(&vec, NULL);
+	assert(vec.len == 0);
+	assert(vec.capacity == 0);
+	assert(!trb_seg_vector_pop_back(&vec, NULL));
+}
+
+void test_chunks()
+{
+	TrbSegVector *vec = trb_seg_vector_init(NULL, TRUE, sizeof(u64));
+
+	u64 arr[300];
+	for (u64 i = 0; i < 300; ++i)
+		arr[i] = i;
+
+	assert(trb_seg_vector_push_back_many(vec, arr, 300));
+	assert(trb_seg_vector_push_back_many(vec, NULL, 50));
+	assert(trb_seg_vector_push_back_many(vec, arr, 300));
+	assert(vec->len == 650);
+	assert(trb_seg_vector_get(vec, u64, 320) == 0);
+	assert(trb_seg_vector_get(vec, u64, 649) == 299);
+
+	u64 sum = 0;
+	usize n_chunks = 0;
+	u64 *chunk;
+
+	for (usize i = 0, n; (n = trb_seg_vector_chunk(vec, i, (void **) &chunk)) != 0; i += n) {
+		for (usize j = 0; j < n; ++j)
+			sum += chunk[j];
+
+		n_chunks++;
+	}
+
+	assert(sum == 2 * (299 * 300 / 2));
+	assert(n_chunks > 1);
+
+	/* A chunk ends at the end of the segment */
+	usize n = trb_seg_vector_chunk(vec, 5, (void **) &chunk);
+	assert(chunk == trb_seg_vector_ptr(vec, u64, 5));
+	assert(chunk + n - 1 == trb_seg_vector_ptr(vec, u64, 5 + n - 1));
+	assert(chunk + n != trb_seg_vector_ptr(vec, u64, 5 + n));
+
+	assert(trb_seg_vector_chunk(vec, 650, (void **) &chunk) == 0);
+
+	assert(trb_seg_vector_require(vec, 10000));
+	assert(vec->capacity >= 10000);
+	assert(vec->len == 650);
+
+	trb_seg_vector_free(vec, NULL);
+}
+
+void test_slice()
+{
+	TrbSegVector vec;
+	trb_seg_vector_init(&vec, FALSE, sizeof(i32));
+
+	for (i32 i = 0; i < 500; ++i) {
+		i32 value = (i * 7919) % 500;
+		assert(trb_seg_vector_push_back(&vec, &value));
+	}
+
+	TrbSlice slice;
+	assert(trb_seg_vector_slice(&vec, &slice, 0, vec.len) != NULL);
+	assert(!slice.contiguous);
+
+	trb_heapsort(&slice, (TrbCmpFunc) trb_i32cmp);
+
+	for (i32 i = 0; i < 500; ++i)
+		assert(trb_seg_vector_get(&vec, i32, i) == i);
+
+	assert(trb_seg_vector_slice(&vec, &slice, 0, 501) == NULL);
+
+	trb_seg_vector_destroy(&vec, NULL);
+}
+
+int main()
+{
+	test_stable();
+	test_chunks();
+	test_slice();
+
+	return 0;
+}
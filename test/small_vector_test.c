@@ -0,0 +1,128 @@
+#include "trb-small-vector.h"
+#include "trb-utils.h"
+
+#include <assert.h>
+#include <string.h>
+
+typedef struct {
+	u64 a;
+	u64 b;
+	u64 c;
+	u64 d;
+	u64 e;
+	u64 f;
+	u64 g;
+	u64 h;
+	u64 i;
+} Big;
+
+void test_inline()
+{
+	TrbSmallVector vec;
+	trb_small_vector_init(&vec, FALSE, sizeof(u32));
+
+	assert(vec.capacity == TRB_SMALL_VECTOR_INLINE_SIZE / sizeof(u32));
+
+	for (u32 i = 0; i < vec.capacity; ++i)
+		assert(trb_small_vector_push_back(&vec, &i));
+
+	assert(trb_small_vector_is_inline(&vec));
+
+	/* Copying the structure copies the inline elements too */
+	TrbSmallVector copy = vec;
+	trb_small_vector_get(&vec, u32, 0) = 100;
+	assert(trb_small_vector_get(&copy, u32, 0) == 0);
+	assert(trb_small_vector_get(&copy, u32, 15) == 15);
+
+	/* Growing past the inline storage moves the elements to the heap */
+	u32 value = 16;
+	assert(trb_small_vector_push_back(&vec, &value));
+	assert(!trb_small_vector_is_inline(&vec));
+	assert(vec.len == 17);
+
+	for (u32 i = 1; i < 17; ++i)
+		assert(trb_small_vector_get(&vec, u32, i) == i);
+
+	trb_small_vector_destroy(&vec, NULL);
+	assert(trb_small_vector_is_inline(&vec));
+	assert(vec.len == 0);
+
+	trb_small_vector_destroy(&copy, NULL);
+}
+
+void test_insert_remove()
+{
+	TrbSmallVector *vec = trb_small_vector_init(NULL, TRUE, sizeof(u32));
+
+	u32 arr[] = { 1, 2, 3, 4, 5 };
+	assert(trb_small_vector_push_back_many(vec, arr, 5));
+	assert(trb_small_vector_insert(vec, 0, trb_get_ptr(u32, 0)));
+	assert(trb_small_vector_insert_many(vec, 3, arr, 5));
+
+	/* 0 1 2 1 2 3 4 5 3 4 5 */
+	const u32 expected[] = { 0, 1, 2, 1, 2, 3, 4, 5, 3, 4, 5 };
+	assert(vec->len == 11);
+	assert(memcmp(trb_small_vector_data(vec), expected, sizeof(expected)) == 0);
+
+	/* Inserting past the end fills the gap with zeros */
+	for (u32 i = 0; i < 100; ++i)
+		assert(trb_small_vector_push_back(vec, &i));
+
+	assert(trb_small_vector_insert(vec, 150, trb_get_ptr(u32, 7)));
+	assert(vec->len == 151);
+	assert(trb_small_vector_get(vec, u32, 149) == 0);
+	assert(trb_small_vector_get(vec, u32, 150) == 7);
+
+	u32 removed[5];
+	assert(trb_small_vector_remove_range(vec, 3, 5, removed));
+	assert(memcmp(removed, arr, sizeof(arr)) == 0);
+	assert(trb_small_vector_get(vec, u32, 3) == 3);
+
+	u32 ret;
+	assert(trb_small_vector_remove(vec, 0, &ret) && ret == 0);
+	assert(trb_small_vector_pop_back(vec, &ret) && ret == 7);
+	assert(vec->len == 144);
+
+	assert(!trb_small_vector_remove_range(vec, 140, 10, NULL));
+
+	/* Sorting through a slice */
+	TrbSlice slice;
+	trb_small_vector_slice(vec, &slice, 0, vec->len);
+	trb_quicksort(&slice, (TrbCmpFunc) trb_u32cmp);
+
+	for (usize i = 1; i < vec->len; ++i)
+		assert(trb_small_vector_get(vec, u32, i - 1) <= trb_small_vector_get(vec, u32, i));
+
+	trb_small_vector_free(vec, NULL);
+}
+
+void test_big_elements()
+{
+	/* Elements larger than the inline storage always live on the heap */
+	TrbSmallVector vec;
+	trb_small_vector_init(&vec, FALSE, sizeof(Big));
+	assert(vec.capacity == 0);
+
+	Big *big = trb_small_vector_emplace_back(&vec, 3);
+	assert(big != NULL);
+
+	for (u64 i = 0; i < 3; ++i)
+		big[i] = (Big) { .a = i, .i = i * 10 };
+
+	assert(!trb_small_vector_is_inline(&vec));
+	assert(trb_small_vector_get(&vec, Big, 2).i == 20);
+
+	assert(trb_small_vector_require(&vec, 100));
+	assert(vec.capacity >= 100);
+
+	trb_small_vector_destroy(&vec, NULL);
+}
+
+int main()
+{
+	test_inline();
+	test_insert_remove();
+	test_big_elements();
+
+	return 0;
+}
@@ -0,0 +1,794 @@
+#include "trb-deque.h"
+#include "trb-macros.h"
+#include "trb-math.h"
+#include "trb-rand.h"
+#include "trb-slice.h"
+#include "trb-utils.h"
+#include "trb-vector.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N_ELEMS 5000
+
+typedef void (*SortFunc)(TrbSlice *slice, TrbCmpFunc cmp_func);
+typedef void (*SortDataFunc)(TrbSlice *slice, TrbCmpDataFunc cmpd_func, void *data);
+
+typedef struct {
+	u32 key;
+	u32 seq;
+	u64 payload[3];
+} Record;
+
+static i32 record_cmp(const Record *a, const Record *b)
+{
+	return trb_u32cmp(&a->key, &b->key);
+}
+
+static i32 record_cmp_data(const Record *a, const Record *b, void *data)
+{
+	/* Also used by the parallel sorts */
+	__atomic_fetch_add((usize *) data, 1, __ATOMIC_RELAXED);
+	return trb_u32cmp(&a->key, &b->key);
+}
+
+static i32 u32_cmp_desc(const u32 *a, const u32 *b, void *data)
+{
+	usize *n_calls = data;
+	(*n_calls)++;
+	return trb_u32cmp(b, a);
+}
+
+static SortFunc sort_funcs[] = {
+	trb_inssort,
+	trb_heapsort,
+	trb_quicksort,
+};
+
+static SortDataFunc sort_data_funcs[] = {
+	trb_inssort_data,
+	trb_heapsort_data,
+	trb_quicksort_data,
+};
+
+#define N_SORTS (sizeof(sort_funcs) / sizeof(sort_funcs[0]))
+
+static void fill_u32(u32 *arr, usize len, u64 seed, u32 mod)
+{
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, seed);
+
+	for (usize i = 0; i < len; ++i)
+		arr[i] = trb_pcg64_next_u32(&rng) % mod;
+}
+
+static bool is_sorted_u32(TrbSlice *slice)
+{
+	for (usize i = 1; i < trb_slice_len(slice); ++i) {
+		if (*(u32 *) slice->at(slice, i - 1) > *(u32 *) slice->at(slice, i))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+void test_array_sort()
+{
+	u32 *arr = malloc(N_ELEMS * sizeof(u32));
+
+	for (usize s = 0; s < N_SORTS; ++s) {
+		for (u32 mod = 2; mod <= U32_MAX / 2; mod *= 1000) {
+			fill_u32(arr, N_ELEMS, s + mod, mod);
+
+			TrbSlice slice;
+			trb_slice_init(&slice, arr, sizeof(u32), 0, N_ELEMS);
+			assert(slice.contiguous);
+
+			sort_funcs[s](&slice, (TrbCmpFunc) trb_u32cmp);
+			assert(is_sorted_u32(&slice));
+		}
+	}
+
+	free(arr);
+}
+
+void test_array_sort_data()
+{
+	u32 *arr = malloc(N_ELEMS * sizeof(u32));
+
+	for (usize s = 0; s < N_SORTS; ++s) {
+		fill_u32(arr, N_ELEMS, s, 1000);
+
+		TrbSlice slice;
+		trb_slice_init(&slice, arr, sizeof(u32), 0, N_ELEMS);
+
+		usize n_calls = 0;
+		sort_data_funcs[s](&slice, (TrbCmpDataFunc) u32_cmp_desc, &n_calls);
+
+		assert(n_calls != 0);
+
+		for (usize i = 1; i < N_ELEMS; ++i)
+			assert(arr[i - 1] >= arr[i]);
+	}
+
+	free(arr);
+}
+
+void test_subslice_sort()
+{
+	u32 arr[64];
+	fill_u32(arr, 64, 42, 100);
+
+	u32 copy[64];
+	for (usize i = 0; i < 64; ++i)
+		copy[i] = arr[i];
+
+	TrbSlice slice, sub;
+	trb_slice_init(&slice, arr, sizeof(u32), 0, 64);
+	trb_slice_reslice(&slice, &sub, 10, 50);
+	assert(sub.contiguous);
+
+	trb_quicksort(&sub, (TrbCmpFunc) trb_u32cmp);
+	assert(is_sorted_u32(&sub));
+
+	for (usize i = 0; i < 10; ++i)
+		assert(arr[i] == copy[i]);
+
+	for (usize i = 50; i < 64; ++i)
+		assert(arr[i] == copy[i]);
+}
+
+void test_vector_sort()
+{
+	TrbVector vec;
+	trb_vector_init(&vec, FALSE, sizeof(u32));
+
+	u32 *arr = malloc(N_ELEMS * sizeof(u32));
+	fill_u32(arr, N_ELEMS, 7, 1 << 20);
+
+	trb_vector_push_back_many(&vec, arr, N_ELEMS);
+	trb_vector_pop_front_many(&vec, 100, NULL);
+
+	for (usize s = 0; s < N_SORTS; ++s) {
+		TrbSlice slice;
+		trb_vector_slice(&vec, &slice, 0, vec.len);
+		assert(slice.contiguous);
+
+		trb_reverse(&slice);
+		sort_funcs[s](&slice, (TrbCmpFunc) trb_u32cmp);
+		assert(is_sorted_u32(&slice));
+
+		usize index;
+		u32 target = trb_vector_get(&vec, u32, 1234);
+		assert(trb_binary_search(&slice, &target, (TrbCmpFunc) trb_u32cmp, &index));
+		assert(trb_vector_get(&vec, u32, index) == target);
+	}
+
+	free(arr);
+	trb_vector_destroy(&vec, NULL);
+}
+
+void test_deque_sort()
+{
+	TrbDeque deque;
+	trb_deque_init(&deque, FALSE, sizeof(Record));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0xdeadbeef);
+
+	for (usize i = 0; i < N_ELEMS; ++i) {
+		Record rec = { .key = trb_pcg64_next_u32(&rng) % 1000, .seq = i };
+		trb_deque_push_front(&deque, &rec);
+	}
+
+	for (usize s = 0; s < N_SORTS; ++s) {
+		TrbSlice slice;
+		trb_deque_slice(&deque, &slice, 0, deque.len);
+		assert(!slice.contiguous);
+
+		trb_reverse(&slice);
+		sort_funcs[s](&slice, (TrbCmpFunc) record_cmp);
+
+		for (usize i = 1; i < deque.len; ++i)
+			assert(trb_deque_ptr(&deque, Record, i - 1)->key <= trb_deque_ptr(&deque, Record, i)->key);
+
+		Record target = { .key = trb_deque_ptr(&deque, Record, 777)->key };
+
+		usize index;
+		assert(trb_binary_search(&slice, &target, (TrbCmpFunc) record_cmp, &index));
+		assert(trb_deque_ptr(&deque, Record, index)->key == target.key);
+	}
+
+	trb_deque_destroy(&deque, NULL);
+}
+
+static void fill_pattern(u32 *arr, usize len, usize pattern)
+{
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, pattern);
+
+	for (usize i = 0; i < len; ++i) {
+		switch (pattern) {
+		case 0: /* sorted */
+			arr[i] = i;
+			break;
+		case 1: /* reverse */
+			arr[i] = len - i;
+			break;
+		case 2: /* sawtooth */
+			arr[i] = i % 97;
+			break;
+		case 3: /* few unique */
+			arr[i] = trb_pcg64_next_u32(&rng) % 4;
+			break;
+		case 4: /* organ pipe */
+			arr[i] = (i < len / 2) ? i : len - i;
+			break;
+		case 5: /* all equal */
+			arr[i] = 7;
+			break;
+		case 6: /* sorted with random swaps */
+			arr[i] = i;
+			if (i % 100 == 99) {
+				usize j = trb_pcg64_next_u32(&rng) % i;
+				u32 tmp = arr[i];
+				arr[i] = arr[j];
+				arr[j] = tmp;
+			}
+			break;
+		default:
+			arr[i] = trb_pcg64_next_u32(&rng);
+			break;
+		}
+	}
+}
+
+void test_patterns()
+{
+	const usize lens[] = { 0, 1, 2, 23, 24, 25, 128, 129, 1000, 100000 };
+	u32 *arr = malloc(100000 * sizeof(u32));
+
+	for (usize l = 0; l < sizeof(lens) / sizeof(lens[0]); ++l) {
+		for (usize pattern = 0; pattern < 8; ++pattern) {
+			usize len = lens[l];
+			fill_pattern(arr, len, pattern);
+
+			u64 sum = 0;
+			for (usize i = 0; i < len; ++i)
+				sum += arr[i];
+
+			TrbSlice slice;
+			trb_slice_init(&slice, arr, sizeof(u32), 0, len ?: 1);
+			slice.end = len;
+
+			trb_quicksort(&slice, (TrbCmpFunc) trb_u32cmp);
+			assert(is_sorted_u32(&slice));
+
+			for (usize i = 0; i < len; ++i)
+				sum -= arr[i];
+
+			assert(sum == 0);
+		}
+	}
+
+	free(arr);
+}
+
+typedef struct {
+	u64 key;
+	u8 payload[512];
+} BigRecord;
+
+static i32 big_record_cmp(const BigRecord *a, const BigRecord *b)
+{
+	return trb_u64cmp(&a->key, &b->key);
+}
+
+void test_big_elements()
+{
+	usize len = 3000;
+	BigRecord *arr = malloc(len * sizeof(BigRecord));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 99);
+
+	for (usize s = 0; s < N_SORTS; ++s) {
+		for (usize i = 0; i < len; ++i) {
+			arr[i].key = trb_pcg64_next_u32(&rng) % 500;
+			arr[i].payload[511] = arr[i].key;
+		}
+
+		TrbSlice slice;
+		trb_slice_init(&slice, arr, sizeof(BigRecord), 0, len);
+		sort_funcs[s](&slice, (TrbCmpFunc) big_record_cmp);
+
+		for (usize i = 1; i < len; ++i) {
+			assert(arr[i - 1].key <= arr[i].key);
+			assert(arr[i].payload[511] == (u8) arr[i].key);
+		}
+	}
+
+	free(arr);
+}
+
+void test_reverse()
+{
+	u8 arr[7][3] = { "ab", "cd", "ef", "gh", "ij", "kl", "mn" };
+
+	TrbSlice slice;
+	trb_slice_init(&slice, arr, 3, 0, 7);
+	trb_reverse(&slice);
+
+	assert(arr[0][0] == 'm' && arr[0][1] == 'n');
+	assert(arr[3][0] == 'g' && arr[3][1] == 'h');
+	assert(arr[6][0] == 'a' && arr[6][1] == 'b');
+}
+
+void test_stablesort()
+{
+	const usize lens[] = { 0, 1, 2, 63, 64, 65, 1000, 100000 };
+	u32 *arr = malloc(100000 * sizeof(u32));
+	u32 *buffer = malloc(50000 * sizeof(u32));
+
+	for (usize l = 0; l < sizeof(lens) / sizeof(lens[0]); ++l) {
+		for (usize pattern = 0; pattern < 8; ++pattern) {
+			usize len = lens[l];
+			fill_pattern(arr, len, pattern);
+
+			u64 sum = 0;
+			for (usize i = 0; i < len; ++i)
+				sum += arr[i];
+
+			TrbSlice slice;
+			trb_slice_init(&slice, arr, sizeof(u32), 0, len ?: 1);
+			slice.end = len;
+
+			assert(trb_stablesort(&slice, (TrbCmpFunc) trb_u32cmp, (pattern % 2) ? buffer : NULL));
+			assert(is_sorted_u32(&slice));
+
+			for (usize i = 0; i < len; ++i)
+				sum -= arr[i];
+
+			assert(sum == 0);
+		}
+	}
+
+	free(arr);
+	free(buffer);
+}
+
+void test_stablesort_stability()
+{
+	Record *arr = malloc(N_ELEMS * sizeof(Record));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 31337);
+
+	for (u32 mod = 2; mod <= 2000; mod *= 10) {
+		for (usize i = 0; i < N_ELEMS; ++i) {
+			/* Mix ascending, descending and random stretches to exercise runs and galloping */
+			if (i % 1000 < 300)
+				arr[i].key = (i % 1000) / 10 % mod;
+			else if (i % 1000 < 600)
+				arr[i].key = (1000 - i % 1000) / 10 % mod;
+			else
+				arr[i].key = trb_pcg64_next_u32(&rng) % mod;
+
+			arr[i].seq = i;
+		}
+
+		TrbSlice slice;
+		trb_slice_init(&slice, arr, sizeof(Record), 0, N_ELEMS);
+		assert(trb_stablesort(&slice, (TrbCmpFunc) record_cmp, NULL));
+
+		for (usize i = 1; i < N_ELEMS; ++i) {
+			assert(arr[i - 1].key <= arr[i].key);
+
+			if (arr[i - 1].key == arr[i].key)
+				assert(arr[i - 1].seq < arr[i].seq);
+		}
+	}
+
+	free(arr);
+}
+
+void test_stablesort_deque()
+{
+	TrbDeque deque;
+	trb_deque_init(&deque, FALSE, sizeof(Record));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 0xcafebabe);
+
+	for (usize i = 0; i < N_ELEMS; ++i) {
+		Record rec = { .key = trb_pcg64_next_u32(&rng) % 100, .seq = i };
+		trb_deque_push_back(&deque, &rec);
+	}
+
+	TrbSlice slice;
+	trb_deque_slice(&deque, &slice, 0, deque.len);
+	assert(!slice.contiguous);
+
+	usize n_calls = 0;
+	assert(trb_stablesort_data(&slice, (TrbCmpDataFunc) record_cmp_data, &n_calls, NULL));
+	assert(n_calls != 0);
+
+	for (usize i = 1; i < deque.len; ++i) {
+		Record *prev = trb_deque_ptr(&deque, Record, i - 1);
+		Record *cur = trb_deque_ptr(&deque, Record, i);
+
+		assert(prev->key <= cur->key);
+
+		if (prev->key == cur->key)
+			assert(prev->seq < cur->seq);
+	}
+
+	trb_deque_destroy(&deque, NULL);
+}
+
+void test_radixsort_ints()
+{
+	const usize lens[] = { 0, 1, 63, 64, 1000, 100000 };
+	u64 *arr = malloc(100000 * sizeof(u64));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 2024);
+
+	for (usize l = 0; l < sizeof(lens) / sizeof(lens[0]); ++l) {
+		usize len = lens[l];
+
+		TrbSlice slice;
+		trb_slice_init(&slice, arr, sizeof(u8), 0, 1);
+		slice.end = len;
+
+		for (usize i = 0; i < len; ++i)
+			((u8 *) arr)[i] = trb_pcg64_next_u32(&rng);
+
+		assert(trb_radixsort_u8(&slice, NULL));
+		for (usize i = 1; i < len; ++i)
+			assert(((u8 *) arr)[i - 1] <= ((u8 *) arr)[i]);
+
+		trb_slice_init(&slice, arr, sizeof(i16), 0, 1);
+		slice.end = len;
+
+		for (usize i = 0; i < len; ++i)
+			((i16 *) arr)[i] = trb_pcg64_next_u32(&rng);
+
+		assert(trb_radixsort_i16(&slice, NULL));
+		for (usize i = 1; i < len; ++i)
+			assert(((i16 *) arr)[i - 1] <= ((i16 *) arr)[i]);
+
+		trb_slice_init(&slice, arr, sizeof(i32), 0, 1);
+		slice.end = len;
+
+		for (usize i = 0; i < len; ++i)
+			((i32 *) arr)[i] = (i32) trb_pcg64_next_u32(&rng) >> (i % 24);
+
+		assert(trb_radixsort_i32(&slice, NULL));
+		for (usize i = 1; i < len; ++i)
+			assert(((i32 *) arr)[i - 1] <= ((i32 *) arr)[i]);
+
+		trb_slice_init(&slice, arr, sizeof(u64), 0, 1);
+		slice.end = len;
+
+		/* Timestamp-like keys with constant high bytes */
+		for (usize i = 0; i < len; ++i)
+			arr[i] = 1700000000000000ull + trb_pcg64_next_u32(&rng);
+
+		assert(trb_radixsort_u64(&slice, NULL));
+		for (usize i = 1; i < len; ++i)
+			assert(arr[i - 1] <= arr[i]);
+
+		trb_slice_init(&slice, arr, sizeof(i64), 0, 1);
+		slice.end = len;
+
+		for (usize i = 0; i < len; ++i)
+			arr[i] = trb_pcg64_next_u64(&rng);
+
+		assert(trb_radixsort_i64(&slice, NULL));
+		for (usize i = 1; i < len; ++i)
+			assert(((i64 *) arr)[i - 1] <= ((i64 *) arr)[i]);
+	}
+
+	free(arr);
+}
+
+void test_radixsort_floats()
+{
+	usize len = 10000;
+	f64 *arr = malloc(len * sizeof(f64));
+	f64 *buffer = malloc(len * sizeof(f64));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 4242);
+
+	for (usize i = 0; i < len; ++i)
+		arr[i] = ((f64) trb_pcg64_next_u32(&rng) - U32_MAX / 2) / (1 + i % 1000);
+
+	arr[0] = 1.0 / 0.0;
+	arr[1] = -1.0 / 0.0;
+	arr[2] = 0.0;
+	arr[3] = -0.0;
+
+	TrbSlice slice;
+	trb_slice_init(&slice, arr, sizeof(f64), 0, len);
+	assert(trb_radixsort_f64(&slice, buffer));
+
+	assert(arr[0] == -1.0 / 0.0);
+	assert(arr[len - 1] == 1.0 / 0.0);
+	for (usize i = 1; i < len; ++i)
+		assert(arr[i - 1] <= arr[i]);
+
+	f32 *farr = (f32 *) buffer;
+	for (usize i = 0; i < len; ++i)
+		farr[i] = ((f32) trb_pcg64_next_u32(&rng) - U32_MAX / 2) / (1 + i % 1000);
+
+	trb_slice_init(&slice, farr, sizeof(f32), 0, len);
+	assert(trb_radixsort_f32(&slice, NULL));
+	for (usize i = 1; i < len; ++i)
+		assert(farr[i - 1] <= farr[i]);
+
+	free(arr);
+	free(buffer);
+}
+
+void test_radixsort_by_key()
+{
+	Record *arr = malloc(N_ELEMS * sizeof(Record));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 777);
+
+	for (usize i = 0; i < N_ELEMS; ++i) {
+		arr[i].key = trb_pcg64_next_u32(&rng) % 300;
+		arr[i].seq = i;
+	}
+
+	TrbSlice slice;
+	trb_slice_init(&slice, arr, sizeof(Record), 0, N_ELEMS);
+	assert(trb_radixsort_by_key(&slice, TRB_KEY_U32, offsetof(Record, key), NULL));
+
+	for (usize i = 1; i < N_ELEMS; ++i) {
+		assert(arr[i - 1].key <= arr[i].key);
+
+		if (arr[i - 1].key == arr[i].key)
+			assert(arr[i - 1].seq < arr[i].seq);
+	}
+
+	/* The key must fit into the element */
+	assert(!trb_radixsort_by_key(&slice, TRB_KEY_U64, sizeof(Record) - 4, NULL));
+
+	TrbDeque deque;
+	trb_deque_init(&deque, FALSE, sizeof(Record));
+
+	for (usize i = 0; i < N_ELEMS; ++i) {
+		Record rec = { .key = trb_pcg64_next_u32(&rng), .seq = i };
+		trb_deque_push_front(&deque, &rec);
+	}
+
+	trb_deque_slice(&deque, &slice, 0, deque.len);
+	assert(trb_radixsort_by_key(&slice, TRB_KEY_U32, offsetof(Record, key), arr));
+
+	for (usize i = 1; i < deque.len; ++i)
+		assert(trb_deque_ptr(&deque, Record, i - 1)->key <= trb_deque_ptr(&deque, Record, i)->key);
+
+	trb_deque_destroy(&deque, NULL);
+	free(arr);
+}
+
+void test_parallel_sort()
+{
+	const usize n_threads[] = { 0, 1, 2, 3, 4, 7, 16 };
+	usize len = 200003;
+
+	u32 *arr = malloc(len * sizeof(u32));
+
+	for (usize t = 0; t < sizeof(n_threads) / sizeof(n_threads[0]); ++t) {
+		for (usize pattern = 0; pattern < 8; ++pattern) {
+			fill_pattern(arr, len, pattern);
+
+			u64 sum = 0;
+			for (usize i = 0; i < len; ++i)
+				sum += arr[i];
+
+			TrbSlice slice;
+			trb_slice_init(&slice, arr, sizeof(u32), 0, len);
+			assert(trb_quicksort_parallel(&slice, (TrbCmpFunc) trb_u32cmp, n_threads[t]));
+			assert(is_sorted_u32(&slice));
+
+			for (usize i = 0; i < len; ++i)
+				sum -= arr[i];
+
+			assert(sum == 0);
+		}
+	}
+
+	free(arr);
+}
+
+void test_stablesort_parallel()
+{
+	usize len = 100000;
+
+	Record *arr = malloc(len * sizeof(Record));
+	Record *buffer = malloc(len * sizeof(Record));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 65537);
+
+	for (usize n_threads = 2; n_threads <= 8; n_threads += 3) {
+		for (usize i = 0; i < len; ++i) {
+			arr[i].key = trb_pcg64_next_u32(&rng) % 1000;
+			arr[i].seq = i;
+		}
+
+		TrbSlice slice;
+		trb_slice_init(&slice, arr, sizeof(Record), 0, len);
+
+		usize n_calls = 0;
+		assert(trb_stablesort_parallel_data(&slice, (TrbCmpDataFunc) record_cmp_data, &n_calls, n_threads, buffer));
+
+		for (usize i = 1; i < len; ++i) {
+			assert(arr[i - 1].key <= arr[i].key);
+
+			if (arr[i - 1].key == arr[i].key)
+				assert(arr[i - 1].seq < arr[i].seq);
+		}
+	}
+
+	TrbDeque deque;
+	trb_deque_init(&deque, FALSE, sizeof(Record));
+
+	for (usize i = 0; i < len; ++i) {
+		Record rec = { .key = trb_pcg64_next_u32(&rng) % 1000, .seq = i };
+		trb_deque_push_back(&deque, &rec);
+	}
+
+	TrbSlice slice;
+	trb_deque_slice(&deque, &slice, 0, deque.len);
+	assert(trb_stablesort_parallel(&slice, (TrbCmpFunc) record_cmp, 4, NULL));
+
+	for (usize i = 1; i < deque.len; ++i) {
+		Record *prev = trb_deque_ptr(&deque, Record, i - 1);
+		Record *cur = trb_deque_ptr(&deque, Record, i);
+
+		assert(prev->key <= cur->key);
+
+		if (prev->key == cur->key)
+			assert(prev->seq < cur->seq);
+	}
+
+	trb_deque_destroy(&deque, NULL);
+	free(arr);
+	free(buffer);
+}
+
+void test_nth_element()
+{
+	const usize lens[] = { 1, 2, 23, 24, 129, 1000, 100000 };
+	u32 *arr = malloc(100000 * sizeof(u32));
+
+	for (usize l = 0; l < sizeof(lens) / sizeof(lens[0]); ++l) {
+		for (usize pattern = 0; pattern < 8; ++pattern) {
+			usize len = lens[l];
+			const usize nths[] = { 0, len / 3, len / 2, len - 1 };
+
+			for (usize n = 0; n < 4; ++n) {
+				usize nth = nths[n];
+				fill_pattern(arr, len, pattern);
+
+				TrbSlice slice;
+				trb_slice_init(&slice, arr, sizeof(u32), 0, len);
+				trb_nth_element(&slice, nth, (TrbCmpFunc) trb_u32cmp);
+
+				for (usize i = 0; i < nth; ++i)
+					assert(arr[i] <= arr[nth]);
+
+				for (usize i = nth + 1; i < len; ++i)
+					assert(arr[i] >= arr[nth]);
+			}
+		}
+	}
+
+	free(arr);
+}
+
+void test_partial_sort()
+{
+	usize len = 50000;
+	u32 *arr = malloc(len * sizeof(u32));
+	u32 *sorted = malloc(len * sizeof(u32));
+
+	const usize ks[] = { 0, 1, 10, 100, 49999, 50000, 60000 };
+
+	for (usize i = 0; i < sizeof(ks) / sizeof(ks[0]); ++i) {
+		usize k = ks[i];
+
+		fill_u32(arr, len, k, 10000);
+		fill_u32(sorted, len, k, 10000);
+
+		TrbSlice slice;
+		trb_slice_init(&slice, sorted, sizeof(u32), 0, len);
+		trb_quicksort(&slice, (TrbCmpFunc) trb_u32cmp);
+
+		trb_slice_init(&slice, arr, sizeof(u32), 0, len);
+		trb_partial_sort(&slice, k, (TrbCmpFunc) trb_u32cmp);
+
+		for (usize j = 0; j < trb_min(k, len); ++j)
+			assert(arr[j] == sorted[j]);
+
+		/* The top-k copy must leave the slice untouched */
+		fill_u32(arr, len, k, 10000);
+		u32 first = arr[0];
+
+		trb_slice_init(&slice, arr, sizeof(u32), 0, len);
+		assert(trb_topk(&slice, k, (TrbCmpFunc) trb_u32cmp, sorted) == trb_min(k, len));
+		assert(arr[0] == first);
+
+		trb_quicksort(&slice, (TrbCmpFunc) trb_u32cmp);
+
+		for (usize j = 0; j < trb_min(k, len); ++j)
+			assert(sorted[j] == arr[j]);
+	}
+
+	free(arr);
+	free(sorted);
+}
+
+void test_topk_deque()
+{
+	TrbDeque deque;
+	trb_deque_init(&deque, FALSE, sizeof(Record));
+
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 100);
+
+	for (usize i = 0; i < N_ELEMS; ++i) {
+		Record rec = { .key = trb_pcg64_next_u32(&rng), .seq = i };
+		trb_deque_push_front(&deque, &rec);
+	}
+
+	TrbSlice slice;
+	trb_deque_slice(&deque, &slice, 0, deque.len);
+
+	Record top[100];
+	usize n_calls = 0;
+	assert(trb_topk_data(&slice, 100, (TrbCmpDataFunc) record_cmp_data, &n_calls, top) == 100);
+
+	trb_nth_element(&slice, 99, (TrbCmpFunc) record_cmp);
+	assert(trb_deque_ptr(&deque, Record, 99)->key == top[99].key);
+
+	trb_partial_sort_data(&slice, 100, (TrbCmpDataFunc) record_cmp_data, &n_calls);
+
+	for (usize i = 0; i < 100; ++i)
+		assert(trb_deque_ptr(&deque, Record, i)->key == top[i].key);
+
+	trb_deque_destroy(&deque, NULL);
+}
+
+int main()
+{
+	test_array_sort();
+	test_array_sort_data();
+	test_subslice_sort();
+	test_vector_sort();
+	test_deque_sort();
+	test_patterns();
+	test_big_elements();
+	test_reverse();
+	test_stablesort();
+	test_stablesort_stability();
+	test_stablesort_deque();
+	test_radixsort_ints();
+	test_radixsort_floats();
+	test_radixsort_by_key();
+	test_parallel_sort();
+	test_stablesort_parallel();
+	test_nth_element();
+	test_partial_sort();
+	test_topk_deque();
+
+	return 0;
+}
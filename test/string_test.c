@@ -0,0 +1,106 @@
+#include "trb-string.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+void test_emplace()
+{
+	TrbString str;
+	trb_string_init0(&str);
+
+	for (usize i = 0; i < 1000; ++i) {
+		char *buf = trb_string_emplace_back(&str, 3);
+		assert(buf != NULL);
+		memcpy(buf, "abc", 3);
+	}
+
+	assert(str.len == 3000);
+	assert(strlen(str.data) == 3000);
+	assert(memcmp(&str.data[2997], "abc", 3) == 0);
+
+	/* A short write is trimmed with erase */
+	char *buf = trb_string_emplace_back(&str, 100);
+	memcpy(buf, "xy", 2);
+	trb_string_erase(&str, 3002, 98, NULL);
+
+	assert(str.len == 3002);
+	assert(strcmp(&str.data[2997], "abcxy") == 0);
+
+	trb_string_destroy(&str);
+}
+
+void test_mmap()
+{
+	TrbString str;
+	trb_string_init(&str, "start");
+	trb_string_set_mmap(&str, 1 << 16, FALSE);
+
+	for (usize i = 0; i < 100000; ++i)
+		trb_string_push_back_c(&str, 'a' + i % 26);
+
+	assert(str.mapped);
+	assert(str.len == 100005);
+	assert(strncmp(str.data, "startabc", 8) == 0);
+	assert(str.data[str.len] == '\0');
+
+	usize len;
+	char *data = trb_string_steal0(&str, &len);
+	assert(len == 100005 && strlen(data) == len);
+	free(data);
+
+	trb_string_init(&str, NULL);
+	trb_string_set_mmap(&str, 1 << 12, FALSE);
+	trb_string_emplace_back(&str, 1 << 20);
+	assert(str.mapped);
+	trb_string_destroy(&str);
+}
+
+void test_cow()
+{
+	TrbString str;
+	trb_string_init(&str, "shared");
+
+	TrbString snap;
+	assert(trb_string_copy_cow(&str, &snap) == &snap);
+	assert(snap.data == str.data && *str.refs == 2);
+
+	trb_string_push_back(&str, " buffer");
+	assert(strcmp(str.data, "shared buffer") == 0);
+	assert(strcmp(snap.data, "shared") == 0);
+	assert(str.refs == NULL && *snap.refs == 1);
+
+	TrbString *copy = trb_string_copy_cow(&snap, NULL);
+	trb_string_overwrite_c(copy, 0, 'S');
+	trb_string_erase(&snap, 0, 1, NULL);
+	assert(strcmp(copy->data, "Shared") == 0);
+	assert(strcmp(snap.data, "hared") == 0);
+
+	trb_string_destroy(&snap);
+	trb_string_copy_cow(copy, &snap);
+	trb_string_assign_fmt(copy, "%d", 42);
+	assert(strcmp(copy->data, "42") == 0);
+	assert(strcmp(snap.data, "Shared") == 0);
+
+	/* The buffer outlives the string it was copied from */
+	trb_string_free(copy);
+	copy = trb_string_copy_cow(&snap, NULL);
+	trb_string_destroy(&snap);
+
+	usize len;
+	char *data = trb_string_steal0(copy, &len);
+	assert(len == 6 && strcmp(data, "Shared") == 0);
+	free(data);
+
+	trb_string_free(copy);
+	trb_string_destroy(&str);
+}
+
+int main()
+{
+	test_emplace();
+	test_mmap();
+	test_cow();
+
+	return 0;
+}
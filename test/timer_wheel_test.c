@@ -0,0 +1,177 @@
+#include "trb-list.h"
+#include "trb-macros.h"
+#include "trb-rand.h"
+#include "trb-timer-wheel.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#define N_TIMERS 20000
+
+typedef struct {
+	TrbTimer timer;
+	bool cancelled;
+	bool fired;
+} Conn;
+
+static u64 random_delay(TrbPcg64 *rng)
+{
+	switch (trb_pcg64_next_u32(rng) % 4) {
+	case 0:
+		return 1 + trb_pcg64_next_u32(rng) % 64;
+	case 1:
+		return 1 + trb_pcg64_next_u32(rng) % 4096;
+	case 2:
+		return 1 + trb_pcg64_next_u32(rng) % (1 << 18);
+	default:
+		return 1 + trb_pcg64_next_u32(rng) % (1 << 24);
+	}
+}
+
+void test_expiry()
+{
+	TrbPcg64 rng;
+	trb_pcg64_init(&rng, 11);
+
+	/* Start at an odd tick so that slots don't line up with zero */
+	TrbTimerWheel wheel;
+	trb_timer_wheel_init(&wheel, 123456789);
+
+	Conn *conns = calloc(N_TIMERS, sizeof(Conn));
+	u64 last = 0;
+
+	for (usize i = 0; i < N_TIMERS; ++i) {
+		trb_timer_init(&conns[i].timer);
+		trb_timer_wheel_add(&wheel, &conns[i].timer, wheel.now + random_delay(&rng));
+		assert(trb_timer_pending(&conns[i].timer));
+		last = trb_max(last, conns[i].timer.expires);
+	}
+
+	assert(wheel.len == N_TIMERS);
+
+	for (usize i = 0; i < N_TIMERS; i += 3) {
+		assert(trb_timer_wheel_cancel(&wheel, &conns[i].timer));
+		assert(!trb_timer_pending(&conns[i].timer));
+		assert(!trb_timer_wheel_cancel(&wheel, &conns[i].timer));
+		conns[i].cancelled = TRUE;
+	}
+
+	usize n_fired = 0;
+
+	while (wheel.now < last) {
+		u64 prev = wheel.now;
+		u64 now = trb_min(last, prev + 1 + trb_pcg64_next_u32(&rng) % 5000);
+
+		TrbList expired;
+		trb_list_init(&expired);
+
+		usize n = trb_timer_wheel_advance(&wheel, now, &expired);
+		assert(wheel.now == now);
+		assert(n == trb_list_len(&expired));
+
+		u64 prev_expires = 0;
+		TrbList *node;
+
+		while ((node = trb_list_pop_front(&expired)) != NULL) {
+			Conn *conn = trb_container_of(node, Conn, timer.node);
+
+			assert(!conn->cancelled && !conn->fired);
+			assert(!trb_timer_pending(&conn->timer));
+			assert(conn->timer.expires > prev && conn->timer.expires <= now);
+			assert(conn->timer.expires >= prev_expires);
+
+			prev_expires = conn->timer.expires;
+			conn->fired = TRUE;
+			n_fired++;
+		}
+	}
+
+	assert(wheel.len == 0);
+
+	for (usize i = 0; i < N_TIMERS; ++i)
+		assert(conns[i].fired != conns[i].cancelled);
+
+	assert(n_fired == N_TIMERS - (N_TIMERS + 2) / 3);
+
+	free(conns);
+}
+
+void test_rearm()
+{
+	TrbTimerWheel *wheel = trb_timer_wheel_init(NULL, 0);
+
+	TrbTimer timer;
+	trb_timer_init(&timer);
+
+	/* A timer that is already due expires on the next tick */
+	trb_timer_wheel_add(wheel, &timer, 0);
+
+	TrbList expired;
+	trb_list_init(&expired);
+
+	assert(trb_timer_wheel_advance(wheel, 0, &expired) == 0);
+	assert(trb_timer_wheel_advance(wheel, 1, &expired) == 1);
+	assert(expired.next == &timer.node);
+
+	/* Re-arming takes the timer out of the expired list */
+	trb_timer_wheel_add(wheel, &timer, 100000);
+	assert(trb_list_empty(&expired));
+
+	assert(trb_timer_wheel_advance(wheel, 99999, &expired) == 0);
+	assert(trb_timer_wheel_advance(wheel, 100000, &expired) == 1);
+
+	/* Cancelling an expired timer takes it out of the expired list too */
+	assert(!trb_timer_wheel_cancel(wheel, &timer));
+	assert(trb_list_empty(&expired));
+
+	/* Far timers wait in the last level */
+	trb_timer_wheel_add(wheel, &timer, (u64) 1 << 50);
+	assert(trb_timer_pending(&timer));
+	assert(trb_timer_wheel_cancel(wheel, &timer));
+	assert(wheel->len == 0);
+
+	trb_timer_wheel_free(wheel);
+}
+
+void test_skip()
+{
+	TrbTimerWheel wheel;
+	trb_timer_wheel_init(&wheel, 5);
+
+	TrbTimer near, far, farthest;
+	trb_timer_init(&near);
+	trb_timer_init(&far);
+	trb_timer_init(&farthest);
+
+	/* Stepping through every 64-tick boundary would take hours here */
+	trb_timer_wheel_add(&wheel, &near, 70);
+	trb_timer_wheel_add(&wheel, &far, ((u64) 1 << 36) + 12345);
+	trb_timer_wheel_add(&wheel, &farthest, ((u64) 1 << 52) + 1);
+
+	TrbList expired;
+	trb_list_init(&expired);
+
+	assert(trb_timer_wheel_advance(&wheel, 69, &expired) == 0);
+	assert(trb_timer_wheel_advance(&wheel, (u64) 1 << 36, &expired) == 1);
+	assert(expired.next == &near.node);
+
+	trb_list_init(&expired);
+	assert(trb_timer_wheel_advance(&wheel, ((u64) 1 << 36) + 12344, &expired) == 0);
+	assert(trb_timer_wheel_advance(&wheel, ((u64) 1 << 51), &expired) == 1);
+	assert(expired.next == &far.node);
+
+	trb_list_init(&expired);
+	assert(trb_timer_wheel_advance(&wheel, (u64) 1 << 52, &expired) == 0);
+	assert(trb_timer_wheel_advance(&wheel, U64_MAX, &expired) == 1);
+	assert(expired.next == &farthest.node);
+	assert(wheel.len == 0 && wheel.now == U64_MAX);
+}
+
+int main()
+{
+	test_expiry();
+	test_rearm();
+	test_skip();
+
+	return 0;
+}
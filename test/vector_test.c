@@ -1,5 +1,7 @@
 #include "trb-macros.h"
+#include "trb-prim.h"
 #include "trb-utils.h"
+#include "trb-vector-define.h"
 #include "trb-vector.h"
 
 #include <assert.h>
@@ -7,6 +9,20 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+typedef struct {
+	u64 key;
+	u32 value;
+} Pair;
+
+typedef struct {
+	u64 a;
+	u64 b;
+	u64 c;
+} Triple;
+
+TRB_VECTOR_DEFINE(U32Vector, u32_vector, u32)
+TRB_VECTOR_DEFINE(PairVector, pair_vector, Pair)
+
 void test_push_destroy()
 {
 	TrbVector vec;
@@ -414,23 +430,246 @@ void test_reserve()
 
 	trb_vector_push_back_many(&vec, arr1, 4);
 	assert(vec.len == 4);
-	assert(vec.capacity == 24);
+	assert(vec.capacity == 16);
 
 	trb_vector_push_back_many(&vec, arr2, 4);
 	assert(vec.len == 8);
-	assert(vec.capacity == 24);
+	assert(vec.capacity == 16);
 
 	trb_vector_push_back_many(&vec, arr3, 4);
 	assert(vec.len == 12);
-	assert(vec.capacity == 24);
+	assert(vec.capacity == 16);
 
 	trb_vector_push_back_many(&vec, arr4, 4);
 	assert(vec.len == 16);
+	assert(vec.capacity == 16);
+
+	trb_vector_destroy(&vec, NULL);
+}
+
+static usize add_hundred(TRB_UNUSED usize capacity, usize required)
+{
+	return required + 100;
+}
+
+static usize count_reallocs(TrbVector *vec, usize n)
+{
+	usize n_reallocs = 0;
+
+	for (u32 i = 0; i < n; ++i) {
+		usize capacity = vec->capacity;
+		trb_vector_push_back(vec, &i);
+
+		if (vec->capacity != capacity) {
+			if (vec->growth == TRB_GROWTH_2X)
+				assert(vec->capacity == capacity * 2);
+			else if (vec->growth == TRB_GROWTH_1_5X)
+				assert(vec->capacity == capacity + capacity / 2);
+
+			n_reallocs++;
+		}
+	}
+
+	for (u32 i = 0; i < n; ++i)
+		assert(trb_vector_get(vec, u32, i) == i);
+
+	return n_reallocs;
+}
+
+void test_growth()
+{
+	TrbVector vec;
+
+	/* Geometric growth reallocates a logarithmic number of times */
+	trb_vector_init(&vec, FALSE, 4);
+	assert(vec.growth == TRB_GROWTH_1_5X);
+	assert(count_reallocs(&vec, 1000000) <= 32);
+	trb_vector_destroy(&vec, NULL);
+
+	trb_vector_init(&vec, FALSE, 4);
+	trb_vector_set_growth(&vec, TRB_GROWTH_2X, NULL);
+	assert(count_reallocs(&vec, 1000000) == 17);
+	trb_vector_destroy(&vec, NULL);
+
+	trb_vector_init(&vec, FALSE, 4);
+	trb_vector_set_growth(&vec, TRB_GROWTH_CONSERVATIVE, NULL);
+	assert(count_reallocs(&vec, 1000000) > 60);
+	trb_vector_destroy(&vec, NULL);
+
+	/* The conservative policy grows the required capacity */
+	trb_vector_init(&vec, FALSE, 4);
+	trb_vector_set_growth(&vec, TRB_GROWTH_CONSERVATIVE, NULL);
+	trb_vector_require(&vec, 16);
 	assert(vec.capacity == 24);
 
+	/* Copies keep the policy */
+	trb_vector_set_growth(&vec, TRB_GROWTH_CUSTOM, add_hundred);
+
+	TrbVector copy;
+	trb_vector_copy(&vec, &copy);
+	assert(copy.growth == TRB_GROWTH_CUSTOM);
+
+	trb_vector_require(&copy, 30);
+	assert(copy.capacity == 130);
+
+	trb_vector_destroy(&copy, NULL);
+	trb_vector_destroy(&vec, NULL);
+}
+
+void test_define()
+{
+	U32Vector vec;
+	assert(u32_vector_init(&vec, FALSE) == &vec);
+
+	for (u32 i = 0; i < 1000; ++i)
+		assert(u32_vector_push(&vec, i));
+
+	assert(vec.len == 1000);
+
+	/* The typed view and the generic vector share the buffer */
+	assert(trb_vector_pop_front(&vec.vector, NULL));
+	assert(u32_vector_get(&vec, 0) == 1);
+	assert(trb_vector_get(&vec.vector, u32, 998) == 999);
+
+	u32_vector_set(&vec, 10, 12345);
+	assert(*u32_vector_at(&vec, 10) == 12345);
+	assert(trb_vector_get(&vec.vector, u32, 10) == 12345);
+
+	/* Pushing with an offset appends after the last element */
+	assert(u32_vector_push(&vec, 1000));
+	assert(vec.len == 1000);
+	assert(u32_vector_get(&vec, 999) == 1000);
+
+	u32 last;
+	assert(u32_vector_pop(&vec, &last) && last == 1000);
+	assert(vec.len == 999);
+
+	u32_vector_clear(&vec);
+	assert(!u32_vector_pop(&vec, NULL));
+
+	assert(u32_vector_reserve(&vec, 5000));
+	usize capacity = vec.capacity;
+	assert(capacity >= 5000);
+
+	u32 values[] = { 3, 1, 2 };
+	assert(u32_vector_push_many(&vec, values, 3));
+
+	for (u32 i = 3; i < 5000; ++i)
+		u32_vector_push(&vec, i);
+
+	assert(vec.capacity == capacity);
+	assert(u32_vector_get(&vec, 0) == 3 && u32_vector_get(&vec, 4999) == 4999);
+
+	u32_vector_destroy(&vec);
+
+	/* Generic vectors can be viewed as typed ones */
+	TrbVector *generic = trb_vector_init(NULL, TRUE, sizeof(Pair));
+	assert(u32_vector_cast(generic) == NULL);
+
+	PairVector *pairs = pair_vector_cast(generic);
+	assert(pairs != NULL);
+
+	for (u32 i = 0; i < 100; ++i)
+		pair_vector_push(pairs, (Pair) { (u64) i << 32, i });
+
+	assert(generic->len == 100);
+	assert(trb_vector_get(generic, Pair, 42).value == 42);
+	assert(pair_vector_at(pairs, 99)->key == (u64) 99 << 32);
+
+	pair_vector_free(pairs);
+}
+
+void test_emplace()
+{
+	TrbVector vec;
+	trb_vector_init(&vec, FALSE, sizeof(Pair));
+
+	for (u32 i = 0; i < 100; ++i) {
+		Pair *pair = trb_vector_emplace_back(&vec, 1);
+		pair->key = i;
+		pair->value = i * 2;
+	}
+
+	Pair *pairs = trb_vector_emplace_back(&vec, 50);
+	assert(pairs != NULL);
+	assert(vec.len == 150);
+
+	for (u32 i = 0; i < 50; ++i)
+		pairs[i] = (Pair) { 100 + i, (100 + i) * 2 };
+
+	/* Emplacing in the middle moves the tail */
+	trb_vector_pop_front(&vec, NULL);
+	pairs = trb_vector_emplace_at(&vec, 10, 5);
+
+	for (u32 i = 0; i < 5; ++i)
+		pairs[i] = (Pair) { 1000 + i, 0 };
+
+	/* Emplacing at the front uses the free space before the first element */
+	Pair *front = trb_vector_emplace_at(&vec, 0, 1);
+	*front = (Pair) { 999, 0 };
+
+	assert(vec.len == 155);
+	assert(trb_vector_get(&vec, Pair, 0).key == 999);
+	assert(trb_vector_get(&vec, Pair, 1).key == 1);
+	assert(trb_vector_get(&vec, Pair, 10).key == 10);
+	assert(trb_vector_get(&vec, Pair, 11).key == 1000);
+	assert(trb_vector_get(&vec, Pair, 16).key == 11);
+	assert(trb_vector_get(&vec, Pair, 154).value == 298);
+
+	assert(trb_vector_emplace_back(&vec, 0) == NULL);
+
 	trb_vector_destroy(&vec, NULL);
 }
 
+void test_mmap()
+{
+	TrbVector vec;
+	trb_vector_init(&vec, TRUE, sizeof(u32));
+	trb_vector_set_mmap(&vec, 1 << 16, TRUE);
+
+	for (u32 i = 0; i < 100000; ++i)
+		trb_vector_push_back(&vec, &i);
+
+	assert(vec.mapped);
+
+	/* Memory added by growing a mapped buffer is zeroed too */
+	trb_vector_pop_front(&vec, NULL);
+	trb_vector_shrink(&vec);
+	assert(vec.capacity == 99999);
+
+	trb_vector_require(&vec, 300000);
+	assert(trb_vector_insert(&vec, 299999, trb_get_ptr(u32, 7)));
+
+	for (u32 i = 0; i < 99999; ++i)
+		assert(trb_vector_get(&vec, u32, i) == i + 1);
+
+	for (u32 i = 99999; i < 299999; ++i)
+		assert(trb_vector_get(&vec, u32, i) == 0);
+
+	assert(trb_vector_get(&vec, u32, 299999) == 7);
+
+	/* Copies start on the heap */
+	TrbVector copy;
+	trb_vector_copy(&vec, &copy);
+	assert(!copy.mapped && copy.map_threshold == 1 << 16);
+	assert(trb_vector_get(&copy, u32, 5) == 6);
+	trb_vector_destroy(&copy, NULL);
+
+	/* Stolen buffers can be freed with free() */
+	usize len;
+	u32 *data = trb_vector_steal(&vec, &len, NULL);
+	assert(!vec.mapped && len == 300000);
+	assert(data[0] == 1 && data[299999] == 7);
+	free(data);
+
+	for (u32 i = 0; i < 100000; ++i)
+		trb_vector_push_back(&vec, &i);
+
+	assert(vec.mapped);
+	trb_vector_destroy(&vec, NULL);
+	assert(!vec.mapped);
+}
+
 void test_search()
 {
 	TrbVector vec;
@@ -455,7 +694,184 @@ void test_search()
 
 	assert(trb_vector_search(&vec, trb_get_ptr(u32, 110), (TrbCmpFunc) trb_u32cmp, NULL) == FALSE);
 
+	assert(trb_vector_find_bytes(&vec, trb_get_ptr(u32, 45), &index));
+	assert(index == 11);
+	assert(trb_vector_find_bytes(&vec, trb_get_ptr(u32, 110), NULL) == FALSE);
+
+	/* The search starts at the vector offset */
+	trb_vector_remove_range(&vec, 0, 2, NULL);
+	assert(trb_vector_find_bytes(&vec, trb_get_ptr(u32, 30), &index));
+	assert(index == 0);
+	assert(trb_vector_find_bytes(&vec, trb_get_ptr(u32, 10), NULL) == FALSE);
+
+	trb_vector_destroy(&vec, NULL);
+}
+
+static bool is_even(const void *data, TRB_UNUSED void *userdata)
+{
+	return *(const u64 *) data % 2 == 0;
+}
+
+static bool is_flagged(const void *data, void *userdata)
+{
+	(*(usize *) userdata)++;
+	return ((const Triple *) data)->a % 3 == 0;
+}
+
+void test_retain()
+{
+	TrbVector vec;
+	trb_vector_init(&vec, FALSE, sizeof(u64));
+
+	for (u64 i = 0; i < 1000; ++i)
+		trb_vector_push_back(&vec, &i);
+
+	/* A leading removal moves the offset, the vector must keep it */
+	trb_vector_remove(&vec, 0, NULL);
+
+	assert(trb_vector_retain(&vec, is_even, NULL) == 500);
+	assert(vec.len == 499);
+
+	for (usize i = 0; i < vec.len; ++i)
+		assert(trb_vector_get(&vec, u64, i) == 2 * (i + 1));
+
+	trb_vector_destroy(&vec, NULL);
+
+	/* Large elements are moved run by run */
+	trb_vector_init(&vec, FALSE, sizeof(Triple));
+
+	for (u64 i = 0; i < 100; ++i)
+		trb_vector_push_back(&vec, &(Triple) { .a = i, .c = i * 10 });
+
+	usize calls = 0;
+	assert(trb_vector_retain(&vec, is_flagged, &calls) == 66);
+	assert(calls == 100);
+	assert(vec.len == 34);
+
+	for (usize i = 0; i < vec.len; ++i) {
+		assert(trb_vector_get(&vec, Triple, i).a == 3 * i);
+		assert(trb_vector_get(&vec, Triple, i).c == 30 * i);
+	}
+
+	trb_vector_destroy(&vec, NULL);
+}
+
+void test_dedup_sorted()
+{
+	TrbVector vec;
+	trb_vector_init(&vec, FALSE, sizeof(i32));
+
+	i32 arr[] = { -5, -5, -5, 0, 1, 1, 2, 3, 3, 3, 3, 9 };
+	trb_vector_push_back_many(&vec, arr, sizeof(arr) / sizeof(arr[0]));
+
+	assert(trb_vector_dedup_sorted(&vec, (TrbCmpFunc) trb_i32cmp) == 6);
+
+	const i32 expected[] = { -5, 0, 1, 2, 3, 9 };
+	assert(vec.len == 6);
+	assert(memcmp(trb_vector_ptr(&vec, i32, 0), expected, sizeof(expected)) == 0);
+
+	assert(trb_vector_dedup_sorted(&vec, (TrbCmpFunc) trb_i32cmp) == 0);
+	assert(vec.len == 6);
+
+	trb_vector_destroy(&vec, NULL);
+}
+
+void test_cow()
+{
+	TrbVector vec;
+	trb_vector_init(&vec, TRUE, sizeof(u32));
+
+	for (u32 i = 0; i < 1000; ++i)
+		trb_vector_push_back(&vec, &i);
+
+	/* Snapshots share the buffer */
+	TrbVector snap;
+	assert(trb_vector_copy_cow(&vec, &snap) == &snap);
+	TrbVector *snap2 = trb_vector_copy_cow(&snap, NULL);
+	assert(snap2 != NULL);
+
+	assert(snap.data == vec.data && snap2->data == vec.data);
+	assert(vec.refs != NULL && *vec.refs == 3);
+
+	/* The first mutation detaches the buffer */
+	trb_vector_push_back(&vec, trb_get_ptr(u32, 1000));
+	assert(vec.data != snap.data && vec.refs == NULL);
+	assert(vec.len == 1001 && snap.len == 1000);
+	assert(*snap.refs == 2);
+
+	trb_vector_remove(&snap, 500, NULL);
+	assert(snap.data != snap2->data);
+	assert(trb_vector_get(&snap, u32, 500) == 501);
+	assert(trb_vector_get(snap2, u32, 500) == 500);
+
+	/* The last holder takes the buffer back without copying it */
+	void *data = snap2->data;
+	assert(trb_vector_unshare(snap2));
+	assert(snap2->data == data && snap2->refs == NULL);
+
+	for (u32 i = 0; i < 1000; ++i)
+		assert(trb_vector_get(snap2, u32, i) == i);
+
+	trb_vector_free(snap2, NULL);
+	trb_vector_destroy(&snap, NULL);
+
+	/* Removing from the front only moves the offset */
+	trb_vector_copy_cow(&vec, &snap);
+	trb_vector_pop_front_many(&snap, 10, NULL);
+	assert(snap.data == vec.data);
+	assert(trb_vector_get(&snap, u32, 0) == 10);
+
+	/* Destroying a shared vector keeps the buffer alive for the others */
+	trb_vector_destroy(&vec, NULL);
+	assert(*snap.refs == 1);
+	assert(trb_vector_get(&snap, u32, 990) == 1000);
+
+	usize len, offset;
+	u32 *stolen = trb_vector_steal0(&snap, &len, &offset);
+	assert(len == 991 && offset == 10 && stolen[offset] == 10);
+	free(stolen);
+
+	/* Slices can be written through, so they detach the buffer unless they are read-only */
+	trb_vector_init(&vec, FALSE, sizeof(u32));
+
+	for (u32 i = 0; i < 100; ++i)
+		trb_vector_push_back(&vec, trb_get_ptr(u32, 99 - i));
+
+	trb_vector_copy_cow(&vec, &snap);
+
+	TrbSlice slice;
+	assert(trb_vector_slice_const(&vec, &slice, 0, vec.len) != NULL);
+	usize index;
+	assert(trb_find_u32(&slice, 42, &index) && index == 57);
+	assert(vec.data == snap.data);
+
+	assert(trb_vector_slice(&vec, &slice, 0, vec.len) != NULL);
+	assert(vec.data != snap.data);
+	trb_quicksort(&slice, (TrbCmpFunc) trb_u32cmp);
+	assert(trb_vector_get(&vec, u32, 0) == 0);
+	assert(trb_vector_get(&snap, u32, 0) == 99);
+
 	trb_vector_destroy(&vec, NULL);
+	trb_vector_destroy(&snap, NULL);
+
+	/* Typed vectors detach the buffer on set and on the first push */
+	U32Vector typed, copy;
+	u32_vector_init(&typed, FALSE);
+
+	for (u32 i = 0; i < 10; ++i)
+		u32_vector_push(&typed, i);
+
+	trb_vector_copy_cow(&typed.vector, &copy.vector);
+	u32_vector_set(&copy, 0, 100);
+	assert(u32_vector_get(&typed, 0) == 0 && u32_vector_get(&copy, 0) == 100);
+
+	u32_vector_destroy(&copy);
+	trb_vector_copy_cow(&typed.vector, &copy.vector);
+	u32_vector_push(&typed, 10);
+	assert(typed.data != copy.data && copy.len == 10);
+
+	u32_vector_destroy(&typed);
+	u32_vector_destroy(&copy);
 }
 
 int main()
@@ -470,9 +886,16 @@ int main()
 	test_steal();
 	test_shrink();
 	test_reserve();
+	test_growth();
+	test_define();
+	test_emplace();
+	test_mmap();
 	test_search();
+	test_retain();
+	test_dedup_sorted();
 	test_set_range();
 	test_get_range();
+	test_cow();
 
 	return 0;
 }